@@ -9,11 +9,11 @@ TMR_INCLUDE = -I${TMR_DIR}/src -I${TMR_DIR}/src/interfaces -I${TMR_DIR}/src/topo
 	${TACS_INCLUDE} ${PAROPT_INCLUDE} ${OPENCASCADE_INCLUDE} ${NETGEN_INCLUDE}
 
 # Set the compiler flags for TMR
-TMR_CC_FLAGS = ${TMR_FLAGS} ${TMR_INCLUDE} ${BLOSSOM_INCLUDE} ${TACS_OPT_CC_FLAGS}
-TMR_DEBUG_CC_FLAGS = ${TMR_DEBUG_FLAGS} ${TMR_INCLUDE} ${BLOSSOM_INCLUDE} ${TACS_DEBUG_CC_FLAGS}
+TMR_CC_FLAGS = ${TMR_FLAGS} ${TMR_INCLUDE} ${BLOSSOM_INCLUDE} ${ZLIB_FLAGS} ${TACS_OPT_CC_FLAGS}
+TMR_DEBUG_CC_FLAGS = ${TMR_DEBUG_FLAGS} ${TMR_INCLUDE} ${BLOSSOM_INCLUDE} ${ZLIB_FLAGS} ${TACS_DEBUG_CC_FLAGS}
 
 # Set the compiler flags
-TMR_EXTERN_LIBS = ${BLOSSOM_LIB} ${TACS_LD_FLAGS} ${PAROPT_LD_FLAGS} ${OPENCASCADE_LIB_PATH} ${OPENCASCADE_LIBS} ${NETGEN_LD_FLAGS}
+TMR_EXTERN_LIBS = ${BLOSSOM_LIB} ${TACS_LD_FLAGS} ${PAROPT_LD_FLAGS} ${OPENCASCADE_LIB_PATH} ${OPENCASCADE_LIBS} ${NETGEN_LD_FLAGS} ${ZLIB_LIB}
 TMR_LD_FLAGS = ${TMR_LD_CMD} ${TMR_EXTERN_LIBS}
 
 # This is the one rule that is used to compile all the source
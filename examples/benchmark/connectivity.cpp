@@ -0,0 +1,265 @@
+#include "TMROctForest.h"
+#include "TMRQuadForest.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+/*
+  Benchmark the derivation of the unique edges and faces from the
+  block (or face) to node connectivity in setConnectivity()
+
+  Synthetic connectivities are created with an increasing number of
+  blocks. Two families of meshes are used:
+
+  grid:  a structured nx x ny x nz grid of blocks where each node is
+         shared by at most 8 blocks
+  pole:  a fan of sectors around a central node (an O-grid pole)
+         surrounded by rings of blocks and extruded in the z
+         direction. The nodes on the pole are shared by ntheta
+         faces in 2D and 2*ntheta blocks in 3D.
+
+  The 2D versions of the same meshes are used for the quadtree
+  forest. The node numbers can be randomly permuted to remove any
+  locality in the numbering. The time per block should remain roughly
+  constant as the number of blocks increases.
+
+  Usage:
+
+  ./connectivity max_blocks=1000000 ntheta=64 shuffle
+
+  Arguments:
+
+  max_blocks=N   the largest number of blocks (default 1000000)
+  ntheta=N       the number of sectors around the pole (default 64)
+  shuffle        randomly permute the node numbers
+*/
+
+/*
+  Create the 2D pole mesh with ntheta sectors and nrings rings
+*/
+static void createPoleMesh2D( int ntheta, int nrings,
+                              int *_num_nodes, int *_num_faces,
+                              int **_conn ){
+  int num_ring_nodes = 2*ntheta;
+  int num_nodes = 1 + nrings*num_ring_nodes;
+  int num_faces = ntheta + (nrings-1)*num_ring_nodes;
+  int *conn = new int[ 4*num_faces ];
+
+  // The fan of sectors around the center node
+  int *c = conn;
+  for ( int j = 0; j < ntheta; j++, c += 4 ){
+    c[0] = 0;
+    c[1] = 1 + (2*j) % num_ring_nodes;
+    c[2] = 1 + (2*j + 2) % num_ring_nodes;
+    c[3] = 1 + (2*j + 1) % num_ring_nodes;
+  }
+
+  // The rings of faces around the fan
+  for ( int k = 1; k < nrings; k++ ){
+    for ( int j = 0; j < num_ring_nodes; j++, c += 4 ){
+      c[0] = 1 + (k-1)*num_ring_nodes + j;
+      c[1] = 1 + k*num_ring_nodes + j;
+      c[2] = 1 + (k-1)*num_ring_nodes + (j + 1) % num_ring_nodes;
+      c[3] = 1 + k*num_ring_nodes + (j + 1) % num_ring_nodes;
+    }
+  }
+
+  *_num_nodes = num_nodes;
+  *_num_faces = num_faces;
+  *_conn = conn;
+}
+
+/*
+  Create a structured nx x ny grid of faces
+*/
+static void createGrid2D( int nx, int ny,
+                          int *_num_nodes, int *_num_faces,
+                          int **_conn ){
+  int num_faces = nx*ny;
+  int *conn = new int[ 4*num_faces ];
+  int *c = conn;
+  for ( int j = 0; j < ny; j++ ){
+    for ( int i = 0; i < nx; i++, c += 4 ){
+      c[0] = i + (nx+1)*j;
+      c[1] = i+1 + (nx+1)*j;
+      c[2] = i + (nx+1)*(j+1);
+      c[3] = i+1 + (nx+1)*(j+1);
+    }
+  }
+
+  *_num_nodes = (nx+1)*(ny+1);
+  *_num_faces = num_faces;
+  *_conn = conn;
+}
+
+/*
+  Extrude a 2D mesh through nz layers to create a 3D mesh
+*/
+static void extrudeMesh( int num_nodes2d, int num_faces2d,
+                         const int *conn2d, int nz,
+                         int *_num_nodes, int *_num_blocks,
+                         int **_conn ){
+  int num_blocks = nz*num_faces2d;
+  int *conn = new int[ 8*num_blocks ];
+  int *c = conn;
+  for ( int k = 0; k < nz; k++ ){
+    for ( int i = 0; i < num_faces2d; i++, c += 8 ){
+      for ( int j = 0; j < 4; j++ ){
+        c[j] = conn2d[4*i + j] + k*num_nodes2d;
+        c[j+4] = conn2d[4*i + j] + (k+1)*num_nodes2d;
+      }
+    }
+  }
+
+  *_num_nodes = (nz+1)*num_nodes2d;
+  *_num_blocks = num_blocks;
+  *_conn = conn;
+}
+
+/*
+  Randomly permute the node numbers in the connectivity
+*/
+static void shuffleNodes( int num_nodes, int size, int *conn ){
+  int *perm = new int[ num_nodes ];
+  for ( int i = 0; i < num_nodes; i++ ){
+    perm[i] = i;
+  }
+  for ( int i = num_nodes-1; i > 0; i-- ){
+    int j = rand() % (i+1);
+    int t = perm[i];
+    perm[i] = perm[j];
+    perm[j] = t;
+  }
+  for ( int i = 0; i < size; i++ ){
+    conn[i] = perm[conn[i]];
+  }
+  delete [] perm;
+}
+
+/*
+  Create the mesh and time setConnectivity for one of the forests
+*/
+static void benchConnectivity( int dim, const char *mesh_type,
+                               int target, int ntheta, int shuffle ){
+  int num_nodes2d, num_faces2d, *conn2d;
+  int nz = 1;
+  if (strcmp(mesh_type, "grid") == 0){
+    if (dim == 2){
+      int nx = (int)(sqrt(1.0*target) + 0.5);
+      createGrid2D(nx, nx, &num_nodes2d, &num_faces2d, &conn2d);
+    }
+    else {
+      int nx = (int)(pow(1.0*target, 1.0/3.0) + 0.5);
+      createGrid2D(nx, nx, &num_nodes2d, &num_faces2d, &conn2d);
+      nz = nx;
+    }
+  }
+  else {
+    // Use a fixed number of rings in 3D and extrude the mesh
+    int nrings = (dim == 2 ? target/(2*ntheta) : 4);
+    if (nrings < 1){ nrings = 1; }
+    createPoleMesh2D(ntheta, nrings, &num_nodes2d, &num_faces2d, &conn2d);
+    if (dim == 3){
+      nz = target/num_faces2d;
+      if (nz < 1){ nz = 1; }
+    }
+  }
+
+  int num_nodes = num_nodes2d, num_elems = num_faces2d;
+  int *conn = conn2d;
+  if (dim == 3){
+    extrudeMesh(num_nodes2d, num_faces2d, conn2d, nz,
+                &num_nodes, &num_elems, &conn);
+    delete [] conn2d;
+  }
+
+  int nodes_per_elem = (dim == 3 ? 8 : 4);
+  if (shuffle){
+    shuffleNodes(num_nodes, nodes_per_elem*num_elems, conn);
+  }
+
+  // Find the maximum number of elements sharing a node
+  int *count = new int[ num_nodes ];
+  memset(count, 0, num_nodes*sizeof(int));
+  int max_valence = 0;
+  for ( int i = 0; i < nodes_per_elem*num_elems; i++ ){
+    count[conn[i]]++;
+    if (count[conn[i]] > max_valence){
+      max_valence = count[conn[i]];
+    }
+  }
+  delete [] count;
+
+  int nedges = 0, nfaces = 0;
+  double t = 0.0;
+  if (dim == 3){
+    TMROctForest *forest = new TMROctForest(MPI_COMM_SELF);
+    forest->incref();
+    t = MPI_Wtime();
+    forest->setConnectivity(num_nodes, conn, num_elems);
+    t = MPI_Wtime() - t;
+
+    int nb, nn;
+    const int *bc, *bfc, *bec, *bfi;
+    forest->getConnectivity(&nb, &nfaces, &nedges, &nn,
+                            &bc, &bfc, &bec, &bfi);
+    forest->decref();
+  }
+  else {
+    TMRQuadForest *forest = new TMRQuadForest(MPI_COMM_SELF);
+    forest->incref();
+    t = MPI_Wtime();
+    forest->setConnectivity(num_nodes, conn, num_elems);
+    t = MPI_Wtime() - t;
+
+    int nn;
+    const int *fc, *fec;
+    forest->getConnectivity(&nfaces, &nedges, &nn, &fc, &fec);
+    forest->decref();
+  }
+
+  printf("%3d %-6s %10d %10d %10d %10d %8d %10.4f %10.1f\n",
+         dim, mesh_type, num_elems, num_nodes, nedges, nfaces,
+         max_valence, t, 1e9*t/num_elems);
+  fflush(stdout);
+
+  delete [] conn;
+}
+
+int main( int argc, char *argv[] ){
+  MPI_Init(&argc, &argv);
+  TMRInitialize();
+
+  int max_blocks = 1000000;
+  int ntheta = 64;
+  int shuffle = 0;
+  for ( int k = 0; k < argc; k++ ){
+    if (sscanf(argv[k], "max_blocks=%d", &max_blocks) == 1){
+      if (max_blocks < 1000){ max_blocks = 1000; }
+    }
+    if (sscanf(argv[k], "ntheta=%d", &ntheta) == 1){
+      if (ntheta < 3){ ntheta = 3; }
+    }
+    if (strcmp(argv[k], "shuffle") == 0){
+      shuffle = 1;
+    }
+  }
+
+  printf("%3s %-6s %10s %10s %10s %10s %8s %10s %10s\n",
+         "dim", "mesh", "elements", "nodes", "edges", "faces",
+         "valence", "time", "ns/elem");
+
+  const char *mesh_types[] = {"grid", "pole"};
+  for ( int dim = 2; dim <= 3; dim++ ){
+    for ( int k = 0; k < 2; k++ ){
+      for ( int target = 1000; target <= max_blocks; target *= 10 ){
+        srand(0);
+        benchConnectivity(dim, mesh_types[k], target, ntheta, shuffle);
+      }
+    }
+  }
+
+  TMRFinalize();
+  MPI_Finalize();
+  return 0;
+}
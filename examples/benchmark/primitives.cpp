@@ -0,0 +1,518 @@
+#include "TMROctForest.h"
+#include "TMRQuadForest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <new>
+
+/*
+  Micro-benchmarks for the octant/quadrant primitives and containers
+
+  The comparison functions, contains(), the hash tables, the sorted
+  arrays and queues, and the transformation of nodes between adjacent
+  trees are timed in isolation. The element sets are drawn from three
+  distributions:
+
+  uniform:  all elements at the same level, covering the trees
+  graded:   the leaves of a tree refined towards an interior point
+  random:   random levels and positions in random trees
+
+  The time per operation and the number of heap allocations per
+  operation are reported for each primitive.
+
+  Usage:
+
+  ./primitives n=100000 time=0.2
+
+  Arguments:
+
+  n=N        the number of elements in each set (default 100000)
+  time=t     the minimum time for each measurement (default 0.2 s)
+*/
+
+/*
+  Count the allocations by replacing the global operator new. All of
+  the operator delete overloads, including the sized versions, are
+  replaced so that every allocation is released with free(). The
+  replacements are kept out of line, otherwise the compiler inlines
+  malloc() and free() at the call sites and reports them as
+  mismatched with new and delete.
+*/
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+static long long num_allocs = 0;
+
+BENCH_NOINLINE void* operator new( size_t size ){
+  num_allocs++;
+  void *ptr = malloc(size > 0 ? size : 1);
+  if (!ptr){
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+BENCH_NOINLINE void* operator new[]( size_t size ){
+  num_allocs++;
+  void *ptr = malloc(size > 0 ? size : 1);
+  if (!ptr){
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+BENCH_NOINLINE void operator delete( void *ptr ) noexcept {
+  free(ptr);
+}
+
+BENCH_NOINLINE void operator delete[]( void *ptr ) noexcept {
+  free(ptr);
+}
+
+BENCH_NOINLINE void operator delete( void *ptr, size_t ) noexcept {
+  free(ptr);
+}
+
+BENCH_NOINLINE void operator delete[]( void *ptr, size_t ) noexcept {
+  free(ptr);
+}
+
+// Accumulate the results so that the loops are not optimized away
+static long long bench_sink = 0;
+
+// The number of trees used by the element distributions
+static const int num_trees = 7;
+
+/*
+  Record the time and number of allocations for a benchmark
+*/
+class BenchTimer {
+ public:
+  BenchTimer(){
+    t0 = MPI_Wtime();
+    allocs = num_allocs;
+  }
+  double elapsed(){
+    return MPI_Wtime() - t0;
+  }
+  void report( const char *type, const char *dist, const char *name,
+               long long nops ){
+    double t = MPI_Wtime() - t0;
+    printf("%-10s %-8s %-24s %12.2f %12.3f\n", type, dist, name,
+           1e9*t/nops, (1.0*(num_allocs - allocs))/nops);
+  }
+
+ private:
+  double t0;
+  long long allocs;
+};
+
+/*
+  Set the position of the element
+*/
+inline void setElement( TMROctant *oct, int tree, int level,
+                        int32_t x, int32_t y, int32_t z ){
+  oct->block = tree;
+  oct->level = level;
+  oct->x = x;
+  oct->y = y;
+  oct->z = z;
+  oct->tag = 0;
+  oct->info = 0;
+}
+
+inline void setElement( TMRQuadrant *quad, int tree, int level,
+                        int32_t x, int32_t y, int32_t z ){
+  quad->face = tree;
+  quad->level = level;
+  quad->x = x;
+  quad->y = y;
+  quad->tag = 0;
+  quad->info = 0;
+}
+
+/*
+  Get the z-coordinate of the element (zero for quadrants)
+*/
+inline int32_t getZ( const TMROctant *oct ){
+  return oct->z;
+}
+
+inline int32_t getZ( const TMRQuadrant *quad ){
+  return 0;
+}
+
+/*
+  Add the element to the hash table
+*/
+inline int addToHash( TMROctantHash *hash, TMROctant *oct ){
+  return hash->addOctant(oct);
+}
+
+inline int addToHash( TMRQuadrantHash *hash, TMRQuadrant *quad ){
+  return hash->addQuadrant(quad);
+}
+
+/*
+  Create the elements with the given distribution
+*/
+template <class ElemType>
+ElemType* createElements( int dim, const char *dist, int n ){
+  ElemType *array = new ElemType[ n ];
+
+  if (strcmp(dist, "uniform") == 0){
+    // Find the level such that the trees are covered by n elements
+    int level = 1;
+    while (level < TMR_MAX_LEVEL &&
+           num_trees*(1 << (dim*(level+1))) <= n){
+      level++;
+    }
+    const int32_t h = 1 << (TMR_MAX_LEVEL - level);
+    const int nx = 1 << level;
+    const int per_tree = 1 << (dim*level);
+    for ( int i = 0; i < n; i++ ){
+      int tree = (i/per_tree) % num_trees;
+      int index = i % per_tree;
+      int32_t x = h*(index % nx);
+      int32_t y = h*((index/nx) % nx);
+      int32_t z = (dim == 3 ? h*(index/(nx*nx)) : 0);
+      setElement(&array[i], tree, level, x, y, z);
+    }
+  }
+  else if (strcmp(dist, "graded") == 0){
+    // Refine towards an interior point using a stack of elements
+    const int32_t hmax = 1 << TMR_MAX_LEVEL;
+    const double pt[3] = {0.3*hmax, 0.6*hmax, 0.45*hmax};
+    const int max_stack = 64*TMR_MAX_LEVEL;
+    ElemType *stack = new ElemType[ max_stack ];
+
+    int size = 0;
+    for ( int tree = 0; size < n; tree++ ){
+      int nstack = 1;
+      setElement(&stack[0], tree, 0, 0, 0, 0);
+      while (nstack > 0 && size < n){
+        ElemType e = stack[--nstack];
+        const int32_t h = 1 << (TMR_MAX_LEVEL - e.level);
+        double d2 = 0.0;
+        d2 += (e.x + 0.5*h - pt[0])*(e.x + 0.5*h - pt[0]);
+        d2 += (e.y + 0.5*h - pt[1])*(e.y + 0.5*h - pt[1]);
+        if (dim == 3){
+          d2 += (getZ(&e) + 0.5*h - pt[2])*(getZ(&e) + 0.5*h - pt[2]);
+        }
+        if (e.level < TMR_MAX_LEVEL-1 && d2 < 4.0*h*h &&
+            nstack + (1 << dim) <= max_stack){
+          // Push the children onto the stack
+          for ( int k = 0; k < (1 << dim); k++ ){
+            const int32_t hc = h/2;
+            int32_t x = e.x + hc*(k % 2);
+            int32_t y = e.y + hc*((k/2) % 2);
+            int32_t z = getZ(&e) + hc*(k/4);
+            setElement(&stack[nstack], tree, e.level+1, x, y, z);
+            nstack++;
+          }
+        }
+        else {
+          array[size] = e;
+          size++;
+        }
+      }
+    }
+    delete [] stack;
+  }
+  else {
+    // Random elements with random levels
+    for ( int i = 0; i < n; i++ ){
+      int tree = rand() % num_trees;
+      int level = 1 + rand() % 20;
+      const int32_t h = 1 << (TMR_MAX_LEVEL - level);
+      const int nx = 1 << level;
+      int32_t x = h*(rand() % nx);
+      int32_t y = h*(rand() % nx);
+      int32_t z = (dim == 3 ? h*(rand() % nx) : 0);
+      setElement(&array[i], tree, level, x, y, z);
+    }
+  }
+
+  return array;
+}
+
+/*
+  Run the benchmarks for the primitives and containers
+*/
+template <class ElemType, class ArrayType, class QueueType, class HashType>
+void benchElements( int dim, const char *dist, int n, double min_time ){
+  const char *type = (dim == 3 ? "octant" : "quadrant");
+  ElemType *a = createElements<ElemType>(dim, dist, n);
+
+  // Create a shuffled copy of the elements
+  ElemType *b = new ElemType[ n ];
+  memcpy(b, a, n*sizeof(ElemType));
+  for ( int i = n-1; i > 0; i-- ){
+    int j = rand() % (i+1);
+    ElemType t = b[i];  b[i] = b[j];  b[j] = t;
+  }
+
+  // The comparison functions between adjacent elements
+  long long nops = 0;
+  BenchTimer timer;
+  while (timer.elapsed() < min_time){
+    for ( int i = 0; i < n-1; i++ ){
+      bench_sink += a[i].compare(&a[i+1]);
+    }
+    nops += n-1;
+  }
+  timer.report(type, dist, "compare", nops);
+
+  nops = 0;
+  timer = BenchTimer();
+  while (timer.elapsed() < min_time){
+    for ( int i = 0; i < n-1; i++ ){
+      bench_sink += a[i].comparePosition(&a[i+1]);
+    }
+    nops += n-1;
+  }
+  timer.report(type, dist, "comparePosition", nops);
+
+  nops = 0;
+  timer = BenchTimer();
+  while (timer.elapsed() < min_time){
+    for ( int i = 0; i < n-1; i++ ){
+      bench_sink += a[i].compareNode(&a[i+1]);
+    }
+    nops += n-1;
+  }
+  timer.report(type, dist, "compareNode", nops);
+
+  // Check whether the shuffled elements are contained in the elements
+  nops = 0;
+  timer = BenchTimer();
+  while (timer.elapsed() < min_time){
+    for ( int i = 0; i < n; i++ ){
+      bench_sink += a[i].contains(&b[i]);
+    }
+    nops += n;
+  }
+  timer.report(type, dist, "contains", nops);
+
+  // Add the shuffled elements to the hash table
+  nops = 0;
+  timer = BenchTimer();
+  while (timer.elapsed() < min_time){
+    HashType *hash = new HashType();
+    for ( int i = 0; i < n; i++ ){
+      bench_sink += addToHash(hash, &b[i]);
+    }
+    delete hash;
+    nops += n;
+  }
+  timer.report(type, dist, "hash add", nops);
+
+  // Convert the hash table to an array
+  double t = 0.0;
+  long long allocs = 0;
+  nops = 0;
+  while (t < min_time){
+    HashType *hash = new HashType();
+    for ( int i = 0; i < n; i++ ){
+      addToHash(hash, &b[i]);
+    }
+    BenchTimer toarray;
+    allocs -= num_allocs;
+    ArrayType *list = hash->toArray();
+    allocs += num_allocs;
+    t += toarray.elapsed();
+    delete list;
+    delete hash;
+    nops += n;
+  }
+  printf("%-10s %-8s %-24s %12.2f %12.3f\n", type, dist, "hash toArray",
+         1e9*t/nops, (1.0*allocs)/nops);
+
+  // Sort the shuffled elements
+  t = 0.0;
+  allocs = 0;
+  nops = 0;
+  while (t < min_time){
+    ElemType *c = new ElemType[ n ];
+    memcpy(c, b, n*sizeof(ElemType));
+    ArrayType *list = new ArrayType(c, n);
+    BenchTimer sort;
+    allocs -= num_allocs;
+    list->sort();
+    allocs += num_allocs;
+    t += sort.elapsed();
+    delete list;
+    nops += n;
+  }
+  printf("%-10s %-8s %-24s %12.2f %12.3f\n", type, dist, "array sort",
+         1e9*t/nops, (1.0*allocs)/nops);
+
+  // Search the sorted array for the shuffled elements
+  ElemType *c = new ElemType[ n ];
+  memcpy(c, b, n*sizeof(ElemType));
+  ArrayType *list = new ArrayType(c, n);
+  list->sort();
+  nops = 0;
+  timer = BenchTimer();
+  while (timer.elapsed() < min_time){
+    for ( int i = 0; i < n; i++ ){
+      bench_sink += (list->contains(&b[i]) != NULL);
+    }
+    nops += n;
+  }
+  timer.report(type, dist, "array contains", nops);
+  delete list;
+
+  // Push the elements onto a queue
+  nops = 0;
+  timer = BenchTimer();
+  while (timer.elapsed() < min_time){
+    QueueType *queue = new QueueType();
+    for ( int i = 0; i < n; i++ ){
+      queue->push(&b[i]);
+    }
+    bench_sink += queue->length();
+    delete queue;
+    nops += n;
+  }
+  timer.report(type, dist, "queue push", nops);
+
+  delete [] a;
+  delete [] b;
+}
+
+/*
+  The box connectivity (7 blocks with different orientations)
+*/
+const int box_npts = 16;
+const int box_nelems = 7;
+const int box_conn[] =
+  {0, 1, 2, 3, 4, 5, 6, 7,
+   8, 10, 0, 1, 9, 11, 4, 5,
+   5, 11, 1, 10, 7, 15, 3, 14,
+   7, 15, 3, 14, 6, 13, 2, 12,
+   9, 13, 4, 6, 8, 12, 0, 2,
+   10, 14, 8, 12, 1, 3, 0, 2,
+   4, 5, 6, 7, 9, 11, 13, 15};
+
+/*
+  The surface of a cube (6 faces with different orientations)
+*/
+const int cube_npts = 8;
+const int cube_nfaces = 6;
+const int cube_conn[] =
+  {0, 1, 2, 3,
+   4, 6, 5, 7,
+   0, 4, 1, 5,
+   2, 3, 6, 7,
+   0, 2, 4, 6,
+   5, 7, 1, 3};
+
+/*
+  Create the nodes on the boundaries of the trees. Each node lies on
+  a face, edge or corner of its tree.
+*/
+template <class ElemType>
+ElemType* createBoundaryNodes( int dim, int ntrees, int n ){
+  const int32_t hmax = 1 << TMR_MAX_LEVEL;
+  ElemType *nodes = new ElemType[ n ];
+  for ( int i = 0; i < n; i++ ){
+    int level = 1 + rand() % 20;
+    const int32_t h = 1 << (TMR_MAX_LEVEL - level);
+    const int nx = 1 << level;
+    int32_t X[3];
+    for ( int k = 0; k < 3; k++ ){
+      X[k] = h*(rand() % (nx+1));
+    }
+    // Place the node on a boundary of the tree
+    int d = rand() % dim;
+    X[d] = (rand() % 2 ? hmax : 0);
+    setElement(&nodes[i], rand() % ntrees, level, X[0], X[1],
+               (dim == 3 ? X[2] : 0));
+  }
+  return nodes;
+}
+
+/*
+  Time the transformation of the boundary nodes to the owner tree
+*/
+template <class ForestType, class ElemType>
+void benchTransform( ForestType *forest, int dim, int ntrees,
+                     int n, double min_time ){
+  const char *type = (dim == 3 ? "octant" : "quadrant");
+  ElemType *nodes = createBoundaryNodes<ElemType>(dim, ntrees, n);
+  ElemType *t = new ElemType[ n ];
+
+  long long nops = 0;
+  BenchTimer timer;
+  while (timer.elapsed() < min_time){
+    memcpy(t, nodes, n*sizeof(ElemType));
+    for ( int i = 0; i < n; i++ ){
+      forest->transformNode(&t[i]);
+      bench_sink += t[i].x;
+    }
+    nops += n;
+  }
+  timer.report(type, "boundary", "transformNode", nops);
+
+  delete [] nodes;
+  delete [] t;
+}
+
+int main( int argc, char *argv[] ){
+  MPI_Init(&argc, &argv);
+  TMRInitialize();
+
+  int n = 100000;
+  double min_time = 0.2;
+  for ( int k = 0; k < argc; k++ ){
+    if (sscanf(argv[k], "n=%d", &n) == 1){
+      if (n < 2){ n = 2; }
+    }
+    if (sscanf(argv[k], "time=%lf", &min_time) == 1){
+      if (min_time < 0.0){ min_time = 0.0; }
+    }
+  }
+
+  printf("%-10s %-8s %-24s %12s %12s\n",
+         "type", "dist", "operation", "ns/op", "allocs/op");
+
+  const char *dists[] = {"uniform", "graded", "random"};
+  for ( int k = 0; k < 3; k++ ){
+    srand(0);
+    benchElements<TMROctant, TMROctantArray,
+                  TMROctantQueue, TMROctantHash>(3, dists[k], n, min_time);
+  }
+  for ( int k = 0; k < 3; k++ ){
+    srand(0);
+    benchElements<TMRQuadrant, TMRQuadrantArray,
+                  TMRQuadrantQueue, TMRQuadrantHash>(2, dists[k], n,
+                                                     min_time);
+  }
+
+  // Time the transformations between trees
+  TMROctForest *oct_forest = new TMROctForest(MPI_COMM_SELF);
+  oct_forest->incref();
+  oct_forest->setConnectivity(box_npts, box_conn, box_nelems);
+  benchTransform<TMROctForest, TMROctant>(oct_forest, 3, box_nelems,
+                                          n, min_time);
+  oct_forest->decref();
+
+  TMRQuadForest *quad_forest = new TMRQuadForest(MPI_COMM_SELF);
+  quad_forest->incref();
+  quad_forest->setConnectivity(cube_npts, cube_conn, cube_nfaces);
+  benchTransform<TMRQuadForest, TMRQuadrant>(quad_forest, 2, cube_nfaces,
+                                             n, min_time);
+  quad_forest->decref();
+
+  // Print the sink so that the results are used
+  printf("checksum: %lld\n", bench_sink);
+
+  TMRFinalize();
+  MPI_Finalize();
+  return 0;
+}
@@ -59,9 +59,8 @@ def createProblem(forest, bcs, ordering, mesh_order=2, nlevels=2,
 
     while mesh_order > 2:
         mesh_order = mesh_order-1
-        forest = forests[-1].duplicate()
-        forest.balance(1)
-        forest.setMeshOrder(mesh_order, pttype)
+        # Create a p-level with the same octants and partition
+        forest = forests[-1].duplicate(mesh_order, pttype)
         forests.append(forest)
 
         # Make the creator class
@@ -95,9 +95,8 @@ def createProblem(forest, bcs, ordering, order=2, nlevels=2,
 
     while order > 2:
         order = order-1
-        forest = forests[-1].duplicate()
-        forest.setMeshOrder(order, pttype)
-        forest.balance(1)
+        # Create a p-level with the same quadrants and partition
+        forest = forests[-1].duplicate(order, pttype)
         forests.append(forest)
 
         # Make the creator class
@@ -0,0 +1,510 @@
+#include "TMROctForest.h"
+#include "TMRQuadForest.h"
+#include <stdio.h>
+#include <math.h>
+
+/*
+  Weak and strong scaling benchmark for the forest operations
+
+  The benchmark creates a forest on a parametrized multiblock domain,
+  refines, balances and repartitions it until it reaches a target
+  number of elements and creates the nodes. The time spent in each
+  forest phase is recorded with the built-in phase timers and the
+  maximum time across all processors is written as a row of a CSV
+  file.
+
+  Usage:
+
+  mpirun -np 4 ./scaling dim=3 nx=4 ny=4 nz=4 target=20000 weak csv=out.csv
+
+  Arguments:
+
+  dim=2|3        quadtree or octree forest (default 3)
+  nx= ny= nz=    the number of blocks in each direction (default 2)
+  shell          use a shell topology: a hollow box of blocks in 3D or
+                 the surface of the box of blocks in 2D
+  target=N       the number of elements (default 10000)
+  weak|strong    the target is per processor (weak, the default) or
+                 the total number of elements (strong)
+  random|feature random refinement (the default) or refinement of the
+                 elements that intersect a sphere
+  order=p        the mesh order (default 2)
+  seed=s         the random seed (default 0)
+  csv=file       append the results to the CSV file (the header is
+                 written when the file does not exist)
+  json=file      write the full performance report to a JSON file
+*/
+
+/*
+  Create the connectivity for an nx x ny x nz grid of blocks (dim = 3)
+  or faces (dim = 2). For the shell topology, the interior blocks are
+  removed (dim = 3) or the faces cover the surface of the box (dim =
+  2). The nodes are numbered consecutively and are located at the
+  integer grid locations.
+*/
+void createBlockGrid( int dim, int shell, int nx, int ny, int nz,
+                      int *_num_nodes, int *_num_blocks,
+                      int **_conn, double **_Xpts ){
+  int nodes_per_block = (dim == 3 ? 8 : 4);
+
+  // The index of the grid points
+  int size = (nx+1)*(ny+1)*(nz+1);
+  int *node_index = new int[ size ];
+  for ( int i = 0; i < size; i++ ){
+    node_index[i] = -1;
+  }
+
+  // Allocate enough space for the connectivity
+  int max_blocks = (dim == 3 ? nx*ny*nz : 2*(nx*ny + ny*nz + nx*nz));
+  if (dim == 2 && !shell){
+    max_blocks = nx*ny;
+  }
+  int *conn = new int[ nodes_per_block*max_blocks ];
+  int num_blocks = 0;
+
+  if (dim == 3){
+    for ( int k = 0; k < nz; k++ ){
+      for ( int j = 0; j < ny; j++ ){
+        for ( int i = 0; i < nx; i++ ){
+          if (shell && (i > 0 && i < nx-1) &&
+              (j > 0 && j < ny-1) && (k > 0 && k < nz-1)){
+            continue;
+          }
+          for ( int kk = 0; kk < 2; kk++ ){
+            for ( int jj = 0; jj < 2; jj++ ){
+              for ( int ii = 0; ii < 2; ii++ ){
+                conn[8*num_blocks + ii + 2*jj + 4*kk] =
+                  (i+ii) + (nx+1)*((j+jj) + (ny+1)*(k+kk));
+              }
+            }
+          }
+          num_blocks++;
+        }
+      }
+    }
+  }
+  else if (!shell){
+    for ( int j = 0; j < ny; j++ ){
+      for ( int i = 0; i < nx; i++ ){
+        for ( int jj = 0; jj < 2; jj++ ){
+          for ( int ii = 0; ii < 2; ii++ ){
+            conn[4*num_blocks + ii + 2*jj] = (i+ii) + (nx+1)*(j+jj);
+          }
+        }
+        num_blocks++;
+      }
+    }
+  }
+  else {
+    // Add the faces on each of the six sides of the box. The
+    // direction normal to the side is d, and the side is located
+    // at either the lower or upper grid index.
+    const int n[3] = {nx, ny, nz};
+    for ( int d = 0; d < 3; d++ ){
+      int d1 = (d+1) % 3, d2 = (d+2) % 3;
+      for ( int side = 0; side < 2; side++ ){
+        for ( int b = 0; b < n[d2]; b++ ){
+          for ( int a = 0; a < n[d1]; a++ ){
+            for ( int jj = 0; jj < 2; jj++ ){
+              for ( int ii = 0; ii < 2; ii++ ){
+                int index[3];
+                index[d] = side*n[d];
+                index[d1] = a + ii;
+                index[d2] = b + jj;
+                conn[4*num_blocks + ii + 2*jj] =
+                  index[0] + (nx+1)*(index[1] + (ny+1)*index[2]);
+              }
+            }
+            num_blocks++;
+          }
+        }
+      }
+    }
+  }
+
+  // Number the grid points that are referenced
+  int num_nodes = 0;
+  for ( int i = 0; i < nodes_per_block*num_blocks; i++ ){
+    if (node_index[conn[i]] < 0){
+      node_index[conn[i]] = num_nodes;
+      num_nodes++;
+    }
+  }
+
+  // Set the node locations
+  double *Xpts = new double[ 3*num_nodes ];
+  for ( int k = 0; k <= nz; k++ ){
+    for ( int j = 0; j <= ny; j++ ){
+      for ( int i = 0; i <= nx; i++ ){
+        int node = node_index[i + (nx+1)*(j + (ny+1)*k)];
+        if (node >= 0){
+          Xpts[3*node] = i;
+          Xpts[3*node+1] = j;
+          Xpts[3*node+2] = k;
+        }
+      }
+    }
+  }
+
+  for ( int i = 0; i < nodes_per_block*num_blocks; i++ ){
+    conn[i] = node_index[conn[i]];
+  }
+  delete [] node_index;
+
+  *_num_nodes = num_nodes;
+  *_num_blocks = num_blocks;
+  *_conn = conn;
+  *_Xpts = Xpts;
+}
+
+/*
+  Get the local elements from the forest
+*/
+void getElements( TMROctForest *forest, TMROctant **array, int *size ){
+  TMROctantArray *octants;
+  forest->getOctants(&octants);
+  octants->getArray(array, size);
+}
+
+void getElements( TMRQuadForest *forest, TMRQuadrant **array, int *size ){
+  TMRQuadrantArray *quadrants;
+  forest->getQuadrants(&quadrants);
+  quadrants->getArray(array, size);
+}
+
+/*
+  Get the physical location of the element center and the edge length
+  of the element
+*/
+void getCenter( const TMROctant *oct, const int *conn,
+                const double *Xpts, double X[], double *h ){
+  const int32_t hmax = 1 << TMR_MAX_LEVEL;
+  const int32_t hoct = 1 << (TMR_MAX_LEVEL - oct->level);
+  double u = (oct->x + 0.5*hoct)/hmax;
+  double v = (oct->y + 0.5*hoct)/hmax;
+  double w = (oct->z + 0.5*hoct)/hmax;
+
+  double N[8];
+  N[0] = (1.0 - u)*(1.0 - v)*(1.0 - w);
+  N[1] = u*(1.0 - v)*(1.0 - w);
+  N[2] = (1.0 - u)*v*(1.0 - w);
+  N[3] = u*v*(1.0 - w);
+  N[4] = (1.0 - u)*(1.0 - v)*w;
+  N[5] = u*(1.0 - v)*w;
+  N[6] = (1.0 - u)*v*w;
+  N[7] = u*v*w;
+
+  X[0] = X[1] = X[2] = 0.0;
+  for ( int k = 0; k < 8; k++ ){
+    int node = conn[8*oct->block + k];
+    X[0] += Xpts[3*node]*N[k];
+    X[1] += Xpts[3*node+1]*N[k];
+    X[2] += Xpts[3*node+2]*N[k];
+  }
+  *h = (1.0*hoct)/hmax;
+}
+
+void getCenter( const TMRQuadrant *quad, const int *conn,
+                const double *Xpts, double X[], double *h ){
+  const int32_t hmax = 1 << TMR_MAX_LEVEL;
+  const int32_t hquad = 1 << (TMR_MAX_LEVEL - quad->level);
+  double u = (quad->x + 0.5*hquad)/hmax;
+  double v = (quad->y + 0.5*hquad)/hmax;
+
+  double N[4];
+  N[0] = (1.0 - u)*(1.0 - v);
+  N[1] = u*(1.0 - v);
+  N[2] = (1.0 - u)*v;
+  N[3] = u*v;
+
+  X[0] = X[1] = X[2] = 0.0;
+  for ( int k = 0; k < 4; k++ ){
+    int node = conn[4*quad->face + k];
+    X[0] += Xpts[3*node]*N[k];
+    X[1] += Xpts[3*node+1]*N[k];
+    X[2] += Xpts[3*node+2]*N[k];
+  }
+  *h = (1.0*hquad)/hmax;
+}
+
+/*
+  Refine and balance the forest until the total number of elements
+  exceeds the target. Random refinement refines each element with the
+  probability required to reach the target. Feature refinement
+  refines the elements that intersect a sphere centered within the
+  domain and reverts to random refinement once no element can be
+  refined.
+*/
+template <class ForestType, class ElemType>
+void refineToTarget( MPI_Comm comm, ForestType *forest, int dim,
+                     int feature, int64_t target,
+                     const int *conn, const double *Xpts,
+                     const double center[], double radius ){
+  const int max_iterations = 30;
+  const int children = (dim == 3 ? 8 : 4);
+
+  for ( int iter = 0; iter < max_iterations; iter++ ){
+    int size;
+    ElemType *array;
+    getElements(forest, &array, &size);
+
+    int64_t local = size, total = 0;
+    MPI_Allreduce(&local, &total, 1, MPI_LONG_LONG_INT, MPI_SUM, comm);
+    if (total >= target){
+      break;
+    }
+
+    int *refine = new int[ size ];
+    int num_refine = 0;
+    if (feature){
+      for ( int i = 0; i < size; i++ ){
+        double X[3], h;
+        getCenter(&array[i], conn, Xpts, X, &h);
+        double d = sqrt((X[0] - center[0])*(X[0] - center[0]) +
+                        (X[1] - center[1])*(X[1] - center[1]) +
+                        (X[2] - center[2])*(X[2] - center[2]));
+        refine[i] = 0;
+        if (fabs(d - radius) <= 0.5*sqrt(1.0*dim)*h &&
+            array[i].level < TMR_MAX_LEVEL-1){
+          refine[i] = 1;
+          num_refine++;
+        }
+      }
+    }
+
+    int global_refine = 0;
+    MPI_Allreduce(&num_refine, &global_refine, 1, MPI_INT, MPI_SUM, comm);
+    if (global_refine == 0){
+      // Refine each element with the probability needed to reach the
+      // target number of elements
+      double prob = (1.0*(target - total))/((children - 1.0)*total);
+      if (prob > 1.0){
+        prob = 1.0;
+      }
+      for ( int i = 0; i < size; i++ ){
+        refine[i] = (rand() < prob*RAND_MAX);
+      }
+    }
+
+    // Refine the elements and balance the forest to create the
+    // remaining children
+    forest->refine(refine);
+    delete [] refine;
+    forest->balance(1);
+    forest->repartition();
+  }
+}
+
+/*
+  Run the benchmark for the given forest type and write out the
+  results
+*/
+template <class ForestType, class ElemType>
+void runBenchmark( MPI_Comm comm, int dim, int shell, int nx, int ny,
+                   int nz, int64_t target, int weak, int feature,
+                   int order, const char *csv_file,
+                   const char *json_file ){
+  int mpi_size, mpi_rank;
+  MPI_Comm_size(comm, &mpi_size);
+  MPI_Comm_rank(comm, &mpi_rank);
+
+  int num_nodes, num_blocks;
+  int *conn;
+  double *Xpts;
+  createBlockGrid(dim, shell, nx, ny, nz,
+                  &num_nodes, &num_blocks, &conn, &Xpts);
+
+  int64_t total_target = target;
+  if (weak){
+    total_target = target*mpi_size;
+  }
+
+  TMRResetPerfTimers();
+  TMRSetPerfTimers(1);
+  double t0 = MPI_Wtime();
+
+  ForestType *forest = new ForestType(comm, order);
+  forest->incref();
+  forest->setConnectivity(num_nodes, conn, num_blocks);
+  forest->createTrees(0);
+
+  // Refine to the target number of elements
+  double center[3], radius;
+  center[0] = 0.5*nx;
+  center[1] = 0.5*ny;
+  center[2] = (dim == 3 || shell ? 0.5*nz : 0.0);
+  radius = 0.35*(nx < ny ? nx : ny);
+  refineToTarget<ForestType, ElemType>(comm, forest, dim, feature,
+                                       total_target, conn, Xpts,
+                                       center, radius);
+
+  // Create the nodes
+  forest->createNodes();
+
+  double total_time = MPI_Wtime() - t0;
+  TMRSetPerfTimers(0);
+
+  // Count up the elements and nodes
+  int size;
+  ElemType *array;
+  getElements(forest, &array, &size);
+  int64_t local_elems = size, num_elements = 0;
+  MPI_Reduce(&local_elems, &num_elements, 1, MPI_LONG_LONG_INT,
+             MPI_SUM, 0, comm);
+  const int *range;
+  forest->getOwnedNodeRange(&range);
+  int64_t num_dof = range[mpi_size];
+
+  // The phases up to createInterpolation are forest phases
+  const int num_phases = TMR_PERF_CREATE_INTERPOLATION;
+  double local[TMR_PERF_NUM_PHASES+1];
+  double max_time[TMR_PERF_NUM_PHASES+1];
+  int64_t counts[TMR_PERF_NUM_COUNTERS];
+  int64_t local_counts[2] = {0, 0}, sum_counts[2];
+  for ( int i = 0; i < num_phases; i++ ){
+    TMRGetPerfPhase((TMRPerfPhase)i, NULL, &local[i], counts);
+    local_counts[0] += counts[TMR_PERF_BYTES_SENT];
+    local_counts[1] += counts[TMR_PERF_HASH_PROBES];
+  }
+  local[num_phases] = total_time;
+  MPI_Reduce(local, max_time, num_phases+1, MPI_DOUBLE,
+             MPI_MAX, 0, comm);
+  MPI_Reduce(local_counts, sum_counts, 2, MPI_LONG_LONG_INT,
+             MPI_SUM, 0, comm);
+
+  if (json_file){
+    TMRWritePerfReport(comm, json_file);
+  }
+
+  if (mpi_rank == 0){
+    const char *mode = (weak ? "weak" : "strong");
+    const char *topology = (shell ? "shell" : "grid");
+    const char *refinement = (feature ? "feature" : "random");
+
+    printf("%s scaling: dim = %d, %s, %d blocks, %d procs\n",
+           mode, dim, topology, num_blocks, mpi_size);
+    printf("elements = %lld  nodes = %lld\n",
+           (long long)num_elements, (long long)num_dof);
+    for ( int i = 0; i < num_phases; i++ ){
+      printf("%-28s %12.6f s\n",
+             TMRGetPerfPhaseName((TMRPerfPhase)i), max_time[i]);
+    }
+    printf("%-28s %12.6f s\n", "total", max_time[num_phases]);
+
+    if (csv_file){
+      // Check if the file already exists
+      FILE *fp = fopen(csv_file, "r");
+      int write_header = (fp == NULL);
+      if (fp){ fclose(fp); }
+
+      fp = fopen(csv_file, "a");
+      if (fp){
+        if (write_header){
+          fprintf(fp, "mode,dim,topology,refinement,nprocs,num_blocks,"
+                  "order,target,num_elements,num_nodes");
+          for ( int i = 0; i < num_phases; i++ ){
+            fprintf(fp, ",%s", TMRGetPerfPhaseName((TMRPerfPhase)i));
+          }
+          fprintf(fp, ",total,bytes_sent,hash_probes\n");
+        }
+        fprintf(fp, "%s,%d,%s,%s,%d,%d,%d,%lld,%lld,%lld",
+                mode, dim, topology, refinement, mpi_size, num_blocks,
+                order, (long long)target, (long long)num_elements,
+                (long long)num_dof);
+        for ( int i = 0; i <= num_phases; i++ ){
+          fprintf(fp, ",%e", max_time[i]);
+        }
+        fprintf(fp, ",%lld,%lld\n",
+                (long long)sum_counts[0], (long long)sum_counts[1]);
+        fclose(fp);
+      }
+      else {
+        fprintf(stderr, "scaling: Could not open file %s\n", csv_file);
+      }
+    }
+  }
+
+  forest->decref();
+  delete [] conn;
+  delete [] Xpts;
+}
+
+int main( int argc, char *argv[] ){
+  MPI_Init(&argc, &argv);
+  TMRInitialize();
+
+  MPI_Comm comm = MPI_COMM_WORLD;
+  int mpi_rank;
+  MPI_Comm_rank(comm, &mpi_rank);
+
+  // Set the default arguments
+  int dim = 3;
+  int nx = 2, ny = 2, nz = 2;
+  int shell = 0;
+  int target = 10000;
+  int weak = 1;
+  int feature = 0;
+  int order = 2;
+  int seed = 0;
+  char csv_file[256], json_file[256];
+  csv_file[0] = json_file[0] = '\0';
+
+  for ( int k = 0; k < argc; k++ ){
+    if (sscanf(argv[k], "dim=%d", &dim) == 1){
+      if (dim != 2 && dim != 3){ dim = 3; }
+    }
+    if (sscanf(argv[k], "nx=%d", &nx) == 1){
+      if (nx < 1){ nx = 1; }
+    }
+    if (sscanf(argv[k], "ny=%d", &ny) == 1){
+      if (ny < 1){ ny = 1; }
+    }
+    if (sscanf(argv[k], "nz=%d", &nz) == 1){
+      if (nz < 1){ nz = 1; }
+    }
+    if (sscanf(argv[k], "target=%d", &target) == 1){
+      if (target < 1){ target = 1; }
+    }
+    if (sscanf(argv[k], "order=%d", &order) == 1){
+      if (order < 2){ order = 2; }
+    }
+    sscanf(argv[k], "seed=%d", &seed);
+    sscanf(argv[k], "csv=%255s", csv_file);
+    sscanf(argv[k], "json=%255s", json_file);
+    if (strcmp(argv[k], "shell") == 0){
+      shell = 1;
+    }
+    if (strcmp(argv[k], "weak") == 0){
+      weak = 1;
+    }
+    if (strcmp(argv[k], "strong") == 0){
+      weak = 0;
+    }
+    if (strcmp(argv[k], "random") == 0){
+      feature = 0;
+    }
+    if (strcmp(argv[k], "feature") == 0){
+      feature = 1;
+    }
+  }
+
+  // Seed the random refinement differently on each processor
+  srand(seed + mpi_rank);
+
+  const char *csv = (csv_file[0] ? csv_file : NULL);
+  const char *json = (json_file[0] ? json_file : NULL);
+  if (dim == 3){
+    runBenchmark<TMROctForest, TMROctant>(comm, dim, shell, nx, ny, nz,
+                                          target, weak, feature, order,
+                                          csv, json);
+  }
+  else {
+    runBenchmark<TMRQuadForest, TMRQuadrant>(comm, dim, shell, nx, ny, nz,
+                                             target, weak, feature, order,
+                                             csv, json);
+  }
+
+  TMRFinalize();
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,233 @@
+#include "TMRBspline.h"
+#include "TMRNativeTopology.h"
+#include "TMRMesh.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+/*
+  Check that remeshing after a local change in the feature size gives
+  the same mesh as meshing the geometry from scratch.
+
+  The model consists of a grid of separate planar faces. The geometry
+  is meshed, two boxes are added to the feature size and only the
+  affected entities are remeshed. The result is then compared to a
+  fresh mesh of the same geometry with the same feature size.
+*/
+
+/*
+  Create a model with nx*ny separate square faces
+*/
+TMRModel* createModel( int nx, int ny ){
+  int num_faces = nx*ny;
+  TMRVertex **verts = new TMRVertex*[ 4*num_faces ];
+  TMREdge **edges = new TMREdge*[ 4*num_faces ];
+  TMRFace **faces = new TMRFace*[ num_faces ];
+
+  for ( int k = 0; k < num_faces; k++ ){
+    double x0 = 1.5*(k % nx), y0 = 1.5*(k / nx);
+    TMRPoint pts[4];
+    pts[0].x = x0;      pts[0].y = y0;      pts[0].z = 0.0;
+    pts[1].x = x0+1.0;  pts[1].y = y0;      pts[1].z = 0.0;
+    pts[2].x = x0;      pts[2].y = y0+1.0;  pts[2].z = 0.0;
+    pts[3].x = x0+1.0;  pts[3].y = y0+1.0;  pts[3].z = 0.0;
+    TMRBsplineSurface *surf = new TMRBsplineSurface(2, 2, 2, 2, pts);
+    TMRFace *face = new TMRFaceFromSurface(surf);
+
+    // Create the edges in the parameter space of the face
+    double p1[] = {0.0, 0.0, 1.0, 0.0};
+    double p2[] = {1.0, 0.0, 1.0, 1.0};
+    double p3[] = {1.0, 1.0, 0.0, 1.0};
+    double p4[] = {0.0, 1.0, 0.0, 0.0};
+    TMREdge **e = &edges[4*k];
+    e[0] = new TMREdgeFromFace(face, new TMRBsplinePcurve(2, 2, p1));
+    e[1] = new TMREdgeFromFace(face, new TMRBsplinePcurve(2, 2, p2));
+    e[2] = new TMREdgeFromFace(face, new TMRBsplinePcurve(2, 2, p3));
+    e[3] = new TMREdgeFromFace(face, new TMRBsplinePcurve(2, 2, p4));
+
+    TMRVertex **v = &verts[4*k];
+    for ( int i = 0; i < 4; i++ ){
+      v[i] = new TMRVertexFromEdge(e[i], 0.0);
+    }
+    for ( int i = 0; i < 4; i++ ){
+      e[i]->setVertices(v[i], v[(i+1) % 4]);
+    }
+
+    int dir[4] = {1, 1, 1, 1};
+    face->addEdgeLoop(new TMREdgeLoop(4, e, dir));
+    faces[k] = face;
+  }
+
+  TMRModel *geo = new TMRModel(4*num_faces, verts, 4*num_faces, edges,
+                               num_faces, faces);
+  delete [] verts;
+  delete [] edges;
+  delete [] faces;
+  return geo;
+}
+
+/*
+  Compare the global connectivity and the face meshes. Return the
+  number of differences.
+*/
+int compareMeshes( TMRModel *geo, TMRMesh *mesh,
+                   int nnodes, int nquads, const int *quads,
+                   int ntris, const int *tris,
+                   int *face_npts, TMRPoint **face_X,
+                   int **face_vars ){
+  int fail = 0;
+
+  int n = mesh->getMeshPoints(NULL);
+  int nq, nt;
+  const int *q, *t;
+  mesh->getQuadConnectivity(&nq, &q);
+  mesh->getTriConnectivity(&nt, &t);
+  if (n != nnodes || nq != nquads || nt != ntris){
+    return 1;
+  }
+  if ((nq > 0 && memcmp(q, quads, 4*nq*sizeof(int)) != 0) ||
+      (nt > 0 && memcmp(t, tris, 3*nt*sizeof(int)) != 0)){
+    fail++;
+  }
+
+  int num_faces;
+  TMRFace **faces;
+  geo->getFaces(&num_faces, &faces);
+  for ( int k = 0; k < num_faces; k++ ){
+    TMRFaceMesh *fm;
+    faces[k]->getMesh(&fm);
+    int npts;
+    TMRPoint *X;
+    fm->getMeshPoints(&npts, NULL, &X);
+    const int *vars;
+    fm->getNodeNums(&vars);
+    if (npts != face_npts[k]){
+      fail++;
+      continue;
+    }
+    for ( int i = 0; i < npts; i++ ){
+      if (X[i].x != face_X[k][i].x ||
+          X[i].y != face_X[k][i].y ||
+          X[i].z != face_X[k][i].z ||
+          vars[i] != face_vars[k][i]){
+        fail++;
+        break;
+      }
+    }
+  }
+
+  return fail;
+}
+
+int main( int argc, char *argv[] ){
+  MPI_Init(&argc, &argv);
+  TMRInitialize();
+
+  MPI_Comm comm = MPI_COMM_WORLD;
+  int mpi_rank;
+  MPI_Comm_rank(comm, &mpi_rank);
+
+  const int nx = 6, ny = 4;
+  TMRModel *geo = createModel(nx, ny);
+  geo->incref();
+
+  // The boxes that are added to the feature size. The second box is
+  // smaller than the spacing between the samples of the geometry.
+  TMRPoint b1, b2, c1, c2;
+  b1.x = 7.4;  b1.y = 1.4;  b1.z = -1.0;
+  b2.x = 8.6;  b2.y = 2.6;  b2.z = 1.0;
+  c1.x = 0.505;  c1.y = 0.505;  c1.z = -0.01;
+  c2.x = 0.557;  c2.y = 0.557;  c2.z = 0.01;
+
+  // The domain of the feature size
+  TMRPoint p1, p2;
+  p1.x = p1.y = p1.z = -1.0;
+  p2.x = 10.0;  p2.y = 7.0;  p2.z = 1.0;
+
+  int fail = 0;
+  for ( int k = 0; k < 2; k++ ){
+    TMRMeshOptions options;
+    if (k == 1){
+      options.mesh_type_default = TMR_UNSTRUCTURED;
+    }
+
+    // Mesh the geometry, change the feature size in the boxes and
+    // remesh the affected entities
+    TMRBoxFeatureSize *fs = new TMRBoxFeatureSize(p1, p2, 0.01, 0.1);
+    fs->incref();
+    TMRMesh *mesh = new TMRMesh(comm, geo);
+    mesh->incref();
+    mesh->mesh(options, fs);
+    fs->addBox(b1, b2, 0.04);
+    fs->addBox(c1, c2, 0.003);
+    double t0 = MPI_Wtime();
+    mesh->remesh(options, fs);
+    double tremesh = MPI_Wtime() - t0;
+
+    // Copy the remeshed connectivity and the face meshes
+    int nnodes = mesh->getMeshPoints(NULL);
+    int nquads, ntris;
+    const int *q, *t;
+    mesh->getQuadConnectivity(&nquads, &q);
+    mesh->getTriConnectivity(&ntris, &t);
+    int *quads = new int[ 4*nquads ];
+    int *tris = new int[ 3*ntris ];
+    memcpy(quads, q, 4*nquads*sizeof(int));
+    memcpy(tris, t, 3*ntris*sizeof(int));
+
+    int num_faces;
+    TMRFace **faces;
+    geo->getFaces(&num_faces, &faces);
+    int *face_npts = new int[ num_faces ];
+    TMRPoint **face_X = new TMRPoint*[ num_faces ];
+    int **face_vars = new int*[ num_faces ];
+    for ( int i = 0; i < num_faces; i++ ){
+      TMRFaceMesh *fm;
+      faces[i]->getMesh(&fm);
+      TMRPoint *X;
+      fm->getMeshPoints(&face_npts[i], NULL, &X);
+      const int *vars;
+      fm->getNodeNums(&vars);
+      face_X[i] = new TMRPoint[ face_npts[i] ];
+      face_vars[i] = new int[ face_npts[i] ];
+      for ( int j = 0; j < face_npts[i]; j++ ){
+        face_X[i][j] = X[j];
+        face_vars[i][j] = vars[j];
+      }
+    }
+    mesh->decref();
+
+    // Mesh the geometry from scratch with the modified feature size
+    mesh = new TMRMesh(comm, geo);
+    mesh->incref();
+    t0 = MPI_Wtime();
+    mesh->mesh(options, fs);
+    double tmesh = MPI_Wtime() - t0;
+
+    int diff = compareMeshes(geo, mesh, nnodes, nquads, quads,
+                             ntris, tris, face_npts, face_X, face_vars);
+    if (mpi_rank == 0){
+      printf("%s remesh: nodes %d  remesh %.4f s  mesh %.4f s  %s\n",
+             (k == 0 ? "Structured" : "Unstructured"), nnodes,
+             tremesh, tmesh, (diff ? "FAILED" : "passed"));
+    }
+    fail += diff;
+
+    mesh->decref();
+    fs->decref();
+    for ( int i = 0; i < num_faces; i++ ){
+      delete [] face_X[i];
+      delete [] face_vars[i];
+    }
+    delete [] face_npts;
+    delete [] face_X;
+    delete [] face_vars;
+    delete [] quads;
+    delete [] tris;
+  }
+
+  geo->decref();
+  TMRFinalize();
+  MPI_Finalize();
+  return (fail != 0);
+}
@@ -21,8 +21,10 @@
 #include "TMRBase.h"
 #include "TMRQuadrant.h"
 #include "TMROctant.h"
+#include "predicates.h"
 #include <stddef.h>
 #include <string.h>
+#include <stdio.h>
 
 // Static flag to test if TMR is initialized or not
 static int TMR_is_initialized = 0;
@@ -80,6 +82,11 @@ void TMRInitialize(){
     MPI_Type_create_struct(2, len, disp, types, 
                            &TMRIndexWeight_MPI_type);
     MPI_Type_commit(&TMRIndexWeight_MPI_type);
+
+    // Initialize the constants used by the geometric predicates. This
+    // is done once here since the triangularization may run on
+    // several threads at once.
+    exactinit();
     
     // Set the TMR initialization flag
     TMR_is_initialized = 1;
@@ -103,8 +110,12 @@ void TMRFinalize(){
   MPI_Type_free(&TMRIndexWeight_MPI_type);
 }
 
-TMREntity::TMREntity(): entity_id(entity_id_count){
-  entity_id_count++;
+/*
+  The entity id counter is incremented atomically since entities may
+  be created on several threads at once during meshing
+*/
+TMREntity::TMREntity():
+  entity_id(__sync_fetch_and_add(&entity_id_count, 1)){
   attr = NULL;
   ref_count = 0;
 }
@@ -171,3 +182,411 @@ void TMREntity::getTolerances( double *_eps_dist, double *_eps_cosine ){
   *_eps_dist = eps_dist;
   *_eps_cosine = eps_cosine;
 }
+
+/*
+  Create an empty set of shared arrays
+*/
+TMRSharedArrays::TMRSharedArrays(){
+  num_arrays = 0;
+  bytes = 0;
+}
+
+/*
+  Free the arrays
+*/
+TMRSharedArrays::~TMRSharedArrays(){
+  for ( int i = 0; i < num_arrays; i++ ){
+    if (arrays[i]){ delete [] arrays[i]; }
+  }
+}
+
+/*
+  Add an array of the given length to the set. The object takes
+  ownership of the array.
+*/
+void TMRSharedArrays::add( int *array, int size ){
+  if (num_arrays < MAX_NUM_ARRAYS){
+    arrays[num_arrays] = array;
+    num_arrays++;
+    if (array){
+      bytes += size*sizeof(int);
+    }
+  }
+  else {
+    fprintf(stderr, "TMRSharedArrays: Exceeded maximum number of arrays\n");
+  }
+}
+
+/*
+  Get the memory used by the arrays
+*/
+size_t TMRSharedArrays::getMemoryUsage() const {
+  return bytes;
+}
+
+/*
+  Create an empty memory usage object
+*/
+TMRMemoryUsage::TMRMemoryUsage(){
+  num_entries = 0;
+  num_peaks = 0;
+}
+
+/*
+  Add the bytes to the entry with the given name
+*/
+void TMRMemoryUsage::add( const char *name, size_t _bytes ){
+  for ( int i = 0; i < num_entries; i++ ){
+    if (strcmp(names[i], name) == 0){
+      bytes[i] += _bytes;
+      return;
+    }
+  }
+  if (num_entries < MAX_NUM_ENTRIES){
+    names[num_entries] = name;
+    bytes[num_entries] = _bytes;
+    num_entries++;
+  }
+}
+
+/*
+  Set the high-water mark with the given name
+*/
+void TMRMemoryUsage::addPeak( const char *name, size_t _bytes ){
+  for ( int i = 0; i < num_peaks; i++ ){
+    if (strcmp(peak_names[i], name) == 0){
+      if (_bytes > peak_bytes[i]){
+        peak_bytes[i] = _bytes;
+      }
+      return;
+    }
+  }
+  if (num_peaks < MAX_NUM_ENTRIES){
+    peak_names[num_peaks] = name;
+    peak_bytes[num_peaks] = _bytes;
+    num_peaks++;
+  }
+}
+
+/*
+  Get the total number of bytes currently allocated
+*/
+size_t TMRMemoryUsage::getTotal() const {
+  size_t total = 0;
+  for ( int i = 0; i < num_entries; i++ ){
+    total += bytes[i];
+  }
+  return total;
+}
+
+/*
+  Print the min/max/sum of the entries across all processors in MB.
+
+  This is collective on the communicator, and the entries must be
+  added in the same order on all processors.
+*/
+void TMRMemoryUsage::report( MPI_Comm comm, const char *title ) const {
+  int mpi_rank;
+  MPI_Comm_rank(comm, &mpi_rank);
+
+  // Copy the entries, the total and the high-water marks
+  const int size = num_entries + 1 + num_peaks;
+  double *local = new double[ size ];
+  for ( int i = 0; i < num_entries; i++ ){
+    local[i] = bytes[i];
+  }
+  local[num_entries] = getTotal();
+  for ( int i = 0; i < num_peaks; i++ ){
+    local[num_entries+1+i] = peak_bytes[i];
+  }
+
+  double *min = new double[ 3*size ];
+  double *max = &min[size];
+  double *sum = &min[2*size];
+  MPI_Reduce(local, min, size, MPI_DOUBLE, MPI_MIN, 0, comm);
+  MPI_Reduce(local, max, size, MPI_DOUBLE, MPI_MAX, 0, comm);
+  MPI_Reduce(local, sum, size, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+  if (mpi_rank == 0){
+    const double mb = 1.0/(1024.0*1024.0);
+    if (title){
+      printf("%s\n", title);
+    }
+    printf("%-24s %12s %12s %12s\n", "[MB]", "min", "max", "sum");
+    for ( int i = 0; i < size; i++ ){
+      const char *name = "total";
+      if (i < num_entries){
+        name = names[i];
+      }
+      else if (i > num_entries){
+        name = peak_names[i-num_entries-1];
+      }
+      printf("%-24s %12.3f %12.3f %12.3f\n", name,
+             mb*min[i], mb*max[i], mb*sum[i]);
+    }
+  }
+
+  delete [] local;
+  delete [] min;
+}
+
+/*
+  The global performance timer and counter registry
+*/
+int TMR_perf_timers_enabled = 0;
+
+static const char *TMR_perf_phase_names[] = {
+  "createTrees",
+  "refine",
+  "balance",
+  "repartition",
+  "computeAdjacent",
+  "computeDepFacesAndEdges",
+  "createNodes",
+  "createLocalNodes",
+  "createDependentConn",
+  "evaluateNodeLocations",
+  "createInterpolation",
+  "frontal",
+  "frontalFindEnclosing",
+  "frontalUpdate",
+  "meshEntities"};
+
+static const char *TMR_perf_counter_names[] = {
+  "bytes_sent",
+  "hash_probes",
+  "elements_created"};
+
+// The calls, time and counters for each phase
+static int64_t TMR_perf_calls[TMR_PERF_NUM_PHASES];
+static double TMR_perf_time[TMR_PERF_NUM_PHASES];
+static int64_t TMR_perf_counts[TMR_PERF_NUM_PHASES][TMR_PERF_NUM_COUNTERS];
+
+// The counters added outside of any phase
+static int64_t TMR_perf_untimed_counts[TMR_PERF_NUM_COUNTERS];
+
+// The stack of active phases and their start times. Phases nested
+// deeper than the maximum depth are counted but not timed.
+static const int TMR_PERF_MAX_DEPTH = 16;
+static int TMR_perf_depth = 0;
+static int TMR_perf_stack[TMR_PERF_MAX_DEPTH];
+static double TMR_perf_start[TMR_PERF_MAX_DEPTH];
+
+// Flag set on the worker threads that must not touch the registry
+static __thread int TMR_perf_thread_disabled = 0;
+
+/*
+  Enable or disable the timers and counters
+*/
+void TMRSetPerfTimers( int flag ){
+  TMR_perf_timers_enabled = flag;
+  TMR_perf_depth = 0;
+}
+
+/*
+  Zero all of the timers and counters
+*/
+void TMRResetPerfTimers(){
+  memset(TMR_perf_calls, 0, sizeof(TMR_perf_calls));
+  memset(TMR_perf_time, 0, sizeof(TMR_perf_time));
+  memset(TMR_perf_counts, 0, sizeof(TMR_perf_counts));
+  memset(TMR_perf_untimed_counts, 0, sizeof(TMR_perf_untimed_counts));
+  TMR_perf_depth = 0;
+}
+
+/*
+  Enable or disable the timers and counters on the calling thread.
+  This is used by the worker threads, which would otherwise race on
+  the global registry.
+*/
+void TMRSetPerfThreadTimers( int flag ){
+  TMR_perf_thread_disabled = !flag;
+}
+
+/*
+  Start timing the given phase
+*/
+void TMRPerfBeginPhase( TMRPerfPhase phase ){
+  if (TMR_perf_thread_disabled){
+    return;
+  }
+  TMR_perf_calls[phase]++;
+  if (TMR_perf_depth < TMR_PERF_MAX_DEPTH){
+    TMR_perf_stack[TMR_perf_depth] = phase;
+    TMR_perf_start[TMR_perf_depth] = MPI_Wtime();
+  }
+  TMR_perf_depth++;
+}
+
+/*
+  Stop timing the given phase
+
+  The phase must be the innermost active phase. If it is not, an
+  error is reported and the stack is unwound to the most recent entry
+  for the phase (if any). When a phase is entered recursively, only
+  the outermost entry adds to the time so that it is not counted more
+  than once.
+*/
+void TMRPerfEndPhase( TMRPerfPhase phase ){
+  // The timers may have been enabled within the phase
+  if (TMR_perf_thread_disabled || TMR_perf_depth == 0){
+    return;
+  }
+
+  // This phase is nested too deeply to have been recorded
+  if (TMR_perf_depth > TMR_PERF_MAX_DEPTH){
+    TMR_perf_depth--;
+    return;
+  }
+
+  // Find the entry for this phase on the stack
+  int index = TMR_perf_depth-1;
+  while (index >= 0 && TMR_perf_stack[index] != phase){
+    index--;
+  }
+  if (index != TMR_perf_depth-1){
+    fprintf(stderr, "TMRPerfEndPhase: Ending phase %s but the innermost "
+            "active phase is %s\n", TMR_perf_phase_names[phase],
+            TMR_perf_phase_names[TMR_perf_stack[TMR_perf_depth-1]]);
+    if (index < 0){
+      return;
+    }
+  }
+
+  // Add the time unless the phase is also active further out
+  int outermost = 1;
+  for ( int i = 0; i < index; i++ ){
+    if (TMR_perf_stack[i] == phase){
+      outermost = 0;
+      break;
+    }
+  }
+  if (outermost){
+    TMR_perf_time[phase] += MPI_Wtime() - TMR_perf_start[index];
+  }
+  TMR_perf_depth = index;
+}
+
+/*
+  Add to the counter for the innermost active phase
+*/
+void TMRPerfAddCount( TMRPerfCounter counter, int64_t count ){
+  if (TMR_perf_thread_disabled){
+    return;
+  }
+  if (TMR_perf_depth > 0){
+    int depth = TMR_perf_depth-1;
+    if (depth >= TMR_PERF_MAX_DEPTH){
+      depth = TMR_PERF_MAX_DEPTH-1;
+    }
+    TMR_perf_counts[TMR_perf_stack[depth]][counter] += count;
+  }
+  else {
+    TMR_perf_untimed_counts[counter] += count;
+  }
+}
+
+/*
+  Get the name of the phase
+*/
+const char* TMRGetPerfPhaseName( TMRPerfPhase phase ){
+  return TMR_perf_phase_names[phase];
+}
+
+/*
+  Get the local number of calls, time and counters (an array of
+  length TMR_PERF_NUM_COUNTERS) for the given phase
+*/
+void TMRGetPerfPhase( TMRPerfPhase phase, int64_t *calls, double *time,
+                      int64_t counts[] ){
+  if (calls){ *calls = TMR_perf_calls[phase]; }
+  if (time){ *time = TMR_perf_time[phase]; }
+  if (counts){
+    for ( int j = 0; j < TMR_PERF_NUM_COUNTERS; j++ ){
+      counts[j] = TMR_perf_counts[phase][j];
+    }
+  }
+}
+
+/*
+  Write the min/max/sum across all processors of the calls, time and
+  counters for each phase to a JSON file (or stdout if the filename
+  is NULL) on the root processor.
+
+  This is collective on the communicator.
+
+  returns:  non-zero if the file could not be opened
+*/
+int TMRWritePerfReport( MPI_Comm comm, const char *filename ){
+  int mpi_rank, mpi_size;
+  MPI_Comm_rank(comm, &mpi_rank);
+  MPI_Comm_size(comm, &mpi_size);
+
+  // Pack the values: the calls, time and counters for each phase
+  // followed by the counters outside any phase
+  const int nvals = 2 + TMR_PERF_NUM_COUNTERS;
+  const int size = (TMR_PERF_NUM_PHASES+1)*nvals;
+  double *local = new double[ 4*size ];
+  double *min = &local[size];
+  double *max = &local[2*size];
+  double *sum = &local[3*size];
+  memset(local, 0, size*sizeof(double));
+  for ( int i = 0; i < TMR_PERF_NUM_PHASES; i++ ){
+    local[nvals*i] = TMR_perf_calls[i];
+    local[nvals*i+1] = TMR_perf_time[i];
+    for ( int j = 0; j < TMR_PERF_NUM_COUNTERS; j++ ){
+      local[nvals*i+2+j] = TMR_perf_counts[i][j];
+    }
+  }
+  for ( int j = 0; j < TMR_PERF_NUM_COUNTERS; j++ ){
+    local[nvals*TMR_PERF_NUM_PHASES+2+j] = TMR_perf_untimed_counts[j];
+  }
+
+  MPI_Reduce(local, min, size, MPI_DOUBLE, MPI_MIN, 0, comm);
+  MPI_Reduce(local, max, size, MPI_DOUBLE, MPI_MAX, 0, comm);
+  MPI_Reduce(local, sum, size, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+  int fail = 0;
+  if (mpi_rank == 0){
+    FILE *fp = stdout;
+    if (filename){
+      fp = fopen(filename, "w");
+    }
+    if (fp){
+      fprintf(fp, "{\n  \"mpi_size\": %d,\n  \"phases\": {", mpi_size);
+      for ( int i = 0; i <= TMR_PERF_NUM_PHASES; i++ ){
+        const char *name = "untimed";
+        if (i < TMR_PERF_NUM_PHASES){
+          name = TMR_perf_phase_names[i];
+        }
+        fprintf(fp, "%s\n    \"%s\": {", (i == 0 ? "" : ","), name);
+        for ( int j = 0; j < nvals; j++ ){
+          const char *value = "calls";
+          if (j == 1){
+            value = "time";
+          }
+          else if (j > 1){
+            value = TMR_perf_counter_names[j-2];
+          }
+          int k = nvals*i + j;
+          fprintf(fp, "%s\n      \"%s\": "
+                  "{\"min\": %.9g, \"max\": %.9g, \"sum\": %.9g}",
+                  (j == 0 ? "" : ","), value, min[k], max[k], sum[k]);
+        }
+        fprintf(fp, "\n    }");
+      }
+      fprintf(fp, "\n  }\n}\n");
+      if (filename){
+        fclose(fp);
+      }
+    }
+    else {
+      fprintf(stderr, "TMRWritePerfReport: Could not open file %s\n",
+              filename);
+      fail = 1;
+    }
+  }
+
+  delete [] local;
+  return fail;
+}
@@ -132,6 +132,109 @@ class TMRIndexWeight {
   }
 };
 
+/*
+  The memory usage of an object broken out by category
+
+  Each entry stores the number of bytes currently allocated for a
+  named group of arrays. The high-water marks store the largest
+  number of bytes, including the transient data, allocated during an
+  operation. The names are not copied and must be string literals.
+*/
+class TMRMemoryUsage {
+ public:
+  static const int MAX_NUM_ENTRIES = 32;
+
+  TMRMemoryUsage();
+
+  // Add bytes to an entry or set a high-water mark
+  // ----------------------------------------------
+  void add( const char *name, size_t bytes );
+  void addPeak( const char *name, size_t bytes );
+
+  // Get the total bytes over all entries
+  // ------------------------------------
+  size_t getTotal() const;
+
+  // Print the min/max/sum of each entry across all processors
+  // ---------------------------------------------------------
+  void report( MPI_Comm comm, const char *title=NULL ) const;
+
+  int num_entries, num_peaks;
+  const char *names[MAX_NUM_ENTRIES];
+  size_t bytes[MAX_NUM_ENTRIES];
+  const char *peak_names[MAX_NUM_ENTRIES];
+  size_t peak_bytes[MAX_NUM_ENTRIES];
+};
+
+/*
+  Opt-in phase timers and performance counters
+
+  The timers are disabled by default. When enabled with
+  TMRSetPerfTimers(1), each instrumented phase records the number of
+  calls and the wall time. The counters (bytes sent, hash probes and
+  elements created) are attributed to the innermost active phase. A
+  hash probe is one comparison against an entry in a bucket chain.
+  Nested phases record inclusive times. A phase that is entered
+  recursively is only timed by its outermost entry. The registry is
+  global and is not thread-safe. Worker threads disable the timers for
+  themselves with TMRSetPerfThreadTimers(0), and the threaded region
+  as a whole is timed on the calling thread.
+*/
+enum TMRPerfPhase { TMR_PERF_CREATE_TREES,
+                    TMR_PERF_REFINE,
+                    TMR_PERF_BALANCE,
+                    TMR_PERF_REPARTITION,
+                    TMR_PERF_COMPUTE_ADJACENT,
+                    TMR_PERF_COMPUTE_DEP_FACES_EDGES,
+                    TMR_PERF_CREATE_NODES,
+                    TMR_PERF_CREATE_LOCAL_NODES,
+                    TMR_PERF_CREATE_DEPENDENT_CONN,
+                    TMR_PERF_EVALUATE_NODE_LOCATIONS,
+                    TMR_PERF_CREATE_INTERPOLATION,
+                    TMR_PERF_FRONTAL,
+                    TMR_PERF_FRONTAL_FIND_ENCLOSING,
+                    TMR_PERF_FRONTAL_UPDATE,
+                    TMR_PERF_MESH_ENTITIES,
+                    TMR_PERF_NUM_PHASES };
+
+enum TMRPerfCounter { TMR_PERF_BYTES_SENT,
+                      TMR_PERF_HASH_PROBES,
+                      TMR_PERF_ELEMENTS_CREATED,
+                      TMR_PERF_NUM_COUNTERS };
+
+// Flag indicating whether the timers are active
+extern int TMR_perf_timers_enabled;
+
+// Enable/disable and reset the timers
+void TMRSetPerfTimers( int flag );
+void TMRResetPerfTimers();
+
+// Enable/disable the timers on the calling thread only
+void TMRSetPerfThreadTimers( int flag );
+
+// Start/stop a phase and add to a counter (use the inline versions)
+void TMRPerfBeginPhase( TMRPerfPhase phase );
+void TMRPerfEndPhase( TMRPerfPhase phase );
+void TMRPerfAddCount( TMRPerfCounter counter, int64_t count );
+
+inline void TMRPerfBegin( TMRPerfPhase phase ){
+  if (TMR_perf_timers_enabled){ TMRPerfBeginPhase(phase); }
+}
+inline void TMRPerfEnd( TMRPerfPhase phase ){
+  if (TMR_perf_timers_enabled){ TMRPerfEndPhase(phase); }
+}
+inline void TMRPerfAdd( TMRPerfCounter counter, int64_t count ){
+  if (TMR_perf_timers_enabled){ TMRPerfAddCount(counter, count); }
+}
+
+// Retrieve the local values for a phase
+const char* TMRGetPerfPhaseName( TMRPerfPhase phase );
+void TMRGetPerfPhase( TMRPerfPhase phase, int64_t *calls, double *time,
+                      int64_t counts[]=NULL );
+
+// Write the min/max/sum of the timers across all processors as JSON
+int TMRWritePerfReport( MPI_Comm comm, const char *filename=NULL );
+
 /*
   Reference counted TMR entity
 */
@@ -174,4 +277,31 @@ class TMREntity {
   static int entity_id_count;
 };
 
+/*
+  A reference-counted set of integer arrays
+
+  The arrays must be allocated with new[] and are owned by this
+  object once they are added. This is used to share the block/face
+  connectivity between the forests in a hierarchy so that duplicated
+  and coarsened forests do not store their own copies.
+*/
+class TMRSharedArrays : public TMREntity {
+ public:
+  static const int MAX_NUM_ARRAYS = 24;
+
+  TMRSharedArrays();
+  ~TMRSharedArrays();
+
+  // Add an array (and take ownership of it)
+  void add( int *array, int size );
+
+  // Get the memory used by the arrays
+  size_t getMemoryUsage() const;
+
+ private:
+  int num_arrays;
+  int *arrays[MAX_NUM_ARRAYS];
+  size_t bytes;
+};
+
 #endif // TMR_BASE_H
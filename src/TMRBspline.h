@@ -45,6 +45,9 @@ class TMRBsplineCurve : public TMRCurve {
   // Given the parametric point, evaluate the x,y,z location
   int evalPoint( double t, TMRPoint *X );
 
+  // The evaluation only uses local storage
+  int isThreadSafe(){ return 1; }
+
   // Given the x,y,z location, find the parametric coordinates
   int invEvalPoint( TMRPoint X, double *t );
 
@@ -113,6 +116,9 @@ class TMRBsplineSurface : public TMRSurface {
   // Perform the inverse evaluation
   int invEvalPoint( TMRPoint p, double *u, double *v );
 
+  // The evaluation only uses local storage
+  int isThreadSafe(){ return 1; }
+
   // Given the parametric point, evaluate the first derivative 
   int evalDeriv( double u, double v, 
                  TMRPoint *Xu, TMRPoint *Xv );
@@ -178,6 +184,9 @@ class TMRBsplinePcurve : public TMRPcurve {
   // Evaluate the second derivative
   int eval2ndDeriv( double t, double *utt, double *vtt );
 
+  // The evaluation only uses local storage
+  int isThreadSafe(){ return 1; }
+
   // Refine the knot vector using knot insertion
   TMRBsplinePcurve* refineKnots( const double *Tnew, int nnew );
   
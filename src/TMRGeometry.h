@@ -53,6 +53,9 @@ class TMRCurve : public TMREntity {
 
   // Given the parametric point, evaluate the second derivative
   virtual int eval2ndDeriv( double t, TMRPoint *Xtt );
+
+  // Check whether the evaluation may be called from several threads
+  virtual int isThreadSafe(){ return 0; }
   
   // Write the object to the VTK file
   void writeToVTK( const char *filename );
@@ -85,6 +88,9 @@ class TMRSurface : public TMREntity {
   virtual int eval2ndDeriv( double u, double v,
                             TMRPoint *Xuu, TMRPoint *Xuv, TMRPoint *Xvv );
 
+  // Check whether the evaluation may be called from several threads
+  virtual int isThreadSafe(){ return 0; }
+
   // Write the object to the VTK file
   void writeToVTK( const char *filename );
 
@@ -110,6 +116,9 @@ class TMRPcurve : public TMREntity {
 
   // Given the parametric point, evaluate the derivative 
   virtual int eval2ndDeriv( double t, double *utt, double *vtt ) = 0;
+
+  // Check whether the evaluation may be called from several threads
+  virtual int isThreadSafe(){ return 0; }
 };
 
 #endif // TMR_GEOMETRY_H
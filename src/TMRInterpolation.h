@@ -21,6 +21,9 @@
 #ifndef TMR_INTERPOLATION_FUNCTIONS_H
 #define TMR_INTERPOLATION_FUNCTIONS_H
 
+#include <string.h>
+#include "TMRBase.h"
+
 /*
   The following file defines the inline interpolation functions used
   by TMR.
@@ -97,4 +100,379 @@ inline void lagrange_shape_func_derivative( const int order,
   }
 }
 
+/*
+  Set the parametric points used to evaluate the interpolation from
+  an element to a fine element of the same size, or to one of the
+  two children along each coordinate direction.
+
+  The first order points are the knots themselves, the next order
+  points are the knots of the child with offset 0 and the final
+  order points are the knots of the child with offset 1.
+
+  input:
+  order:  the number of knots on the fine element
+  knots:  the interpolation knots on the fine element
+
+  output:
+  pts:    the parametric points (must be of length 3*order)
+*/
+inline void lagrange_child_knots( const int order,
+                                  const double *knots,
+                                  double *pts ){
+  for ( int k = 0; k < order; k++ ){
+    pts[k] = knots[k];
+    pts[order + k] = -1.0 + 0.5*(1.0 + knots[k]);
+    pts[2*order + k] = 0.5*(1.0 + knots[k]);
+  }
+}
+
+/*
+  Apply a tensor-product interpolation to a 2D element using sum
+  factorization.
+
+  The input values are ordered with the u-direction index varying
+  fastest and the output is added to the values in uout. The 1D
+  tables are stored row-wise so that row n contains the shape
+  functions at the n-th output point.
+
+  input:
+  order:  the number of knots on the input element
+  nout:   the number of output points in each direction
+  Nu:     the nout x order table in the u-direction
+  Nv:     the nout x order table in the v-direction
+  nvars:  the number of variables per node
+  uin:    the input values (order*order*nvars)
+  work:   temporary array of size nout*order*nvars
+
+  output:
+  uout:   the output values (nout*nout*nvars)
+*/
+template <class ScalarType>
+inline void lagrange_tensor_interp_2d( const int order, const int nout,
+                                       const double *Nu, const double *Nv,
+                                       const int nvars,
+                                       const ScalarType *uin,
+                                       ScalarType *uout,
+                                       ScalarType *work ){
+  // Contract the u-direction
+  for ( int j = 0; j < order; j++ ){
+    for ( int n = 0; n < nout; n++ ){
+      ScalarType *t = &work[nvars*(n + nout*j)];
+      for ( int v = 0; v < nvars; v++ ){
+        t[v] = 0.0;
+      }
+      const double *N = &Nu[order*n];
+      const ScalarType *u = &uin[nvars*order*j];
+      for ( int i = 0; i < order; i++ ){
+        for ( int v = 0; v < nvars; v++ ){
+          t[v] += N[i]*u[nvars*i + v];
+        }
+      }
+    }
+  }
+
+  // Contract the v-direction
+  for ( int m = 0; m < nout; m++ ){
+    const double *N = &Nv[order*m];
+    for ( int n = 0; n < nout; n++ ){
+      ScalarType *u = &uout[nvars*(n + nout*m)];
+      for ( int j = 0; j < order; j++ ){
+        const ScalarType *t = &work[nvars*(n + nout*j)];
+        for ( int v = 0; v < nvars; v++ ){
+          u[v] += N[j]*t[v];
+        }
+      }
+    }
+  }
+}
+
+/*
+  Apply a tensor-product interpolation to a 3D element using sum
+  factorization.
+
+  This reduces the cost of evaluating the element interpolant at all
+  nout^3 points from O(nout^3*order^3) to O(nout*order^3 +
+  nout^2*order^2 + nout^3*order).
+
+  input:
+  order:  the number of knots on the input element
+  nout:   the number of output points in each direction
+  Nu:     the nout x order table in the u-direction
+  Nv:     the nout x order table in the v-direction
+  Nw:     the nout x order table in the w-direction
+  nvars:  the number of variables per node
+  uin:    the input values (order*order*order*nvars)
+  work:   temporary array of size (nout*order*(order + nout))*nvars
+
+  output:
+  uout:   the output values (nout*nout*nout*nvars)
+*/
+template <class ScalarType>
+inline void lagrange_tensor_interp_3d( const int order, const int nout,
+                                       const double *Nu, const double *Nv,
+                                       const double *Nw,
+                                       const int nvars,
+                                       const ScalarType *uin,
+                                       ScalarType *uout,
+                                       ScalarType *work ){
+  ScalarType *t1 = work;
+  ScalarType *t2 = &work[nvars*nout*order*order];
+
+  // Contract the u-direction
+  for ( int jk = 0; jk < order*order; jk++ ){
+    for ( int n = 0; n < nout; n++ ){
+      ScalarType *t = &t1[nvars*(n + nout*jk)];
+      for ( int v = 0; v < nvars; v++ ){
+        t[v] = 0.0;
+      }
+      const double *N = &Nu[order*n];
+      const ScalarType *u = &uin[nvars*order*jk];
+      for ( int i = 0; i < order; i++ ){
+        for ( int v = 0; v < nvars; v++ ){
+          t[v] += N[i]*u[nvars*i + v];
+        }
+      }
+    }
+  }
+
+  // Contract the v-direction
+  for ( int k = 0; k < order; k++ ){
+    for ( int m = 0; m < nout; m++ ){
+      const double *N = &Nv[order*m];
+      for ( int n = 0; n < nout; n++ ){
+        ScalarType *t = &t2[nvars*(n + nout*m + nout*nout*k)];
+        for ( int v = 0; v < nvars; v++ ){
+          t[v] = 0.0;
+        }
+        for ( int j = 0; j < order; j++ ){
+          const ScalarType *s = &t1[nvars*(n + nout*j + nout*order*k)];
+          for ( int v = 0; v < nvars; v++ ){
+            t[v] += N[j]*s[v];
+          }
+        }
+      }
+    }
+  }
+
+  // Contract the w-direction
+  for ( int p = 0; p < nout; p++ ){
+    const double *N = &Nw[order*p];
+    for ( int nm = 0; nm < nout*nout; nm++ ){
+      ScalarType *u = &uout[nvars*(nm + nout*nout*p)];
+      for ( int k = 0; k < order; k++ ){
+        const ScalarType *t = &t2[nvars*(nm + nout*nout*k)];
+        for ( int v = 0; v < nvars; v++ ){
+          u[v] += N[k]*t[v];
+        }
+      }
+    }
+  }
+}
+
+/*
+  A cache of the 1D Lagrange shape functions and their derivatives
+  evaluated at fixed sets of parametric points.
+
+  The forests evaluate the same 1D basis at the same points (the
+  nodal knots, the knots of a child element or the knots of an
+  element with a different order) many times. This class stores the
+  npts x order tables for each set of points that is requested so
+  that they are only computed once. Tables are never evicted: the
+  pointers returned by getTable() remain valid until clear() is
+  called, which must be done when the knots change.
+
+  The cache is not thread-safe. Tables must be requested from a
+  single thread, although the returned tables may be read from any
+  thread.
+*/
+class TMRInterpTableCache {
+ public:
+  TMRInterpTableCache(){
+    num_tables = 0;
+    max_num_tables = 0;
+    npts = NULL;
+    orders = NULL;
+    pts = NULL;
+    N = NULL;
+    Nd = NULL;
+  }
+  ~TMRInterpTableCache(){
+    clear();
+    if (npts){ delete [] npts; }
+    if (orders){ delete [] orders; }
+    if (pts){ delete [] pts; }
+    if (N){ delete [] N; }
+    if (Nd){ delete [] Nd; }
+  }
+
+  // Free all the tables in the cache
+  void clear(){
+    for ( int i = 0; i < num_tables; i++ ){
+      delete [] pts[i];
+      delete [] N[i];
+      delete [] Nd[i];
+      npts[i] = 0;
+      orders[i] = 0;
+      pts[i] = NULL;
+      N[i] = NULL;
+      Nd[i] = NULL;
+    }
+    num_tables = 0;
+  }
+
+  // Get the number of bytes allocated for the tables
+  size_t getMemoryUsage(){
+    size_t bytes = sizeof(TMRInterpTableCache);
+    bytes += max_num_tables*(2*sizeof(int) + 3*sizeof(double*));
+    for ( int i = 0; i < num_tables; i++ ){
+      bytes += npts[i]*(1 + 2*orders[i])*sizeof(double);
+    }
+    return bytes;
+  }
+
+  /*
+    Retrieve the tables for the given set of points, computing them
+    if they are not already in the cache
+
+    input:
+    order:    the number of knots
+    knots:    the interpolation knots
+    _npts:    the number of parametric points
+    _pts:     the parametric points
+
+    output:
+    _N:       the npts x order table of shape functions
+    _Nd:      the npts x order table of shape function derivatives
+  */
+  void getTable( const int order, const double *knots,
+                 const int _npts, const double *_pts,
+                 const double **_N, const double **_Nd ){
+    // Search for an existing table with the same points
+    for ( int i = 0; i < num_tables; i++ ){
+      if (npts[i] == _npts && orders[i] == order &&
+          memcmp(pts[i], _pts, _npts*sizeof(double)) == 0){
+        if (_N){ *_N = N[i]; }
+        if (_Nd){ *_Nd = Nd[i]; }
+        return;
+      }
+    }
+
+    // Extend the arrays of tables if they are full. Only the arrays
+    // of pointers are copied, so existing tables are not moved.
+    if (num_tables == max_num_tables){
+      int new_max = 2*max_num_tables;
+      if (new_max < INITIAL_NUM_TABLES){
+        new_max = INITIAL_NUM_TABLES;
+      }
+      int *new_npts = new int[ new_max ];
+      int *new_orders = new int[ new_max ];
+      double **new_pts = new double*[ new_max ];
+      double **new_N = new double*[ new_max ];
+      double **new_Nd = new double*[ new_max ];
+      for ( int i = 0; i < num_tables; i++ ){
+        new_npts[i] = npts[i];
+        new_orders[i] = orders[i];
+        new_pts[i] = pts[i];
+        new_N[i] = N[i];
+        new_Nd[i] = Nd[i];
+      }
+      if (npts){ delete [] npts; }
+      if (orders){ delete [] orders; }
+      if (pts){ delete [] pts; }
+      if (N){ delete [] N; }
+      if (Nd){ delete [] Nd; }
+      npts = new_npts;
+      orders = new_orders;
+      pts = new_pts;
+      N = new_N;
+      Nd = new_Nd;
+      max_num_tables = new_max;
+    }
+
+    // Compute the new table
+    int index = num_tables;
+    npts[index] = _npts;
+    orders[index] = order;
+    pts[index] = new double[ _npts ];
+    N[index] = new double[ _npts*order ];
+    Nd[index] = new double[ _npts*order ];
+    memcpy(pts[index], _pts, _npts*sizeof(double));
+    for ( int n = 0; n < _npts; n++ ){
+      lagrange_shape_func_derivative(order, _pts[n], knots,
+                                     &N[index][order*n],
+                                     &Nd[index][order*n]);
+    }
+    num_tables++;
+
+    if (_N){ *_N = N[index]; }
+    if (_Nd){ *_Nd = Nd[index]; }
+  }
+
+ private:
+  static const int INITIAL_NUM_TABLES = 8;
+  int num_tables, max_num_tables;
+  int *npts, *orders;
+  double **pts;
+  double **N, **Nd;
+};
+
+/*
+  A table of interpolation stencils from the nodes of a fine element
+  to the nodes of an enclosing coarse element.
+
+  The stencil for a fine node depends only on the orders and knots of
+  the two meshes, the local index of the node, the level difference
+  between the elements and the position of the fine element within
+  the coarse element. These stencils are stored as index/weight pairs
+  where the index is the local node number on the coarse element.
+  Each stencil is stored under an integer key chosen by the caller
+  once it has been computed.
+*/
+class TMRInterpStencilTable {
+ public:
+  TMRInterpStencilTable( int _num_stencils, int _max_size ){
+    num_stencils = _num_stencils;
+    max_size = _max_size;
+    len = new int[ num_stencils ];
+    stencils = new TMRIndexWeight*[ num_stencils ];
+    for ( int i = 0; i < num_stencils; i++ ){
+      len[i] = -1;
+      stencils[i] = NULL;
+    }
+    work = new TMRIndexWeight[ max_size ];
+  }
+  ~TMRInterpStencilTable(){
+    for ( int i = 0; i < num_stencils; i++ ){
+      if (stencils[i]){ delete [] stencils[i]; }
+    }
+    delete [] len;
+    delete [] stencils;
+    delete [] work;
+  }
+
+  // Get the stencil with the given key. Returns -1 if the stencil
+  // has not been set.
+  int getStencil( int key, const TMRIndexWeight **_stencil ){
+    *_stencil = stencils[key];
+    return len[key];
+  }
+
+  // Store a copy of the stencil under the given key
+  void setStencil( int key, int size, const TMRIndexWeight *_stencil ){
+    if (stencils[key]){ delete [] stencils[key]; }
+    len[key] = size;
+    stencils[key] = new TMRIndexWeight[ size ];
+    memcpy(stencils[key], _stencil, size*sizeof(TMRIndexWeight));
+  }
+
+  // Get a work array of size max_size used to compute a new stencil
+  TMRIndexWeight* getWorkArray(){ return work; }
+
+ private:
+  int num_stencils, max_size;
+  int *len;
+  TMRIndexWeight **stencils;
+  TMRIndexWeight *work;
+};
+
 #endif // TMR_INTERPOLATION_FUNCTIONS_H
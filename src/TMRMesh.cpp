@@ -27,6 +27,8 @@
 #include "tmrlapack.h"
 #include <math.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <map>
 
 #ifdef TMR_USE_NETGEN
@@ -879,6 +881,24 @@ double integrateEdge( TMREdge *edge, TMRElementFeatureSize *fs,
   return len;
 }
 
+/*
+  The starting value and the prime used by the 64-bit FNV-1a hash
+*/
+static const uint64_t TMR_HASH_OFFSET = 14695981039346656037ULL;
+static const uint64_t TMR_HASH_PRIME = 1099511628211ULL;
+
+/*
+  Add the bytes to the 64-bit FNV-1a hash
+*/
+static uint64_t hash_bytes( uint64_t hash, const void *data, int size ){
+  const unsigned char *c = static_cast<const unsigned char*>(data);
+  for ( int i = 0; i < size; i++ ){
+    hash ^= c[i];
+    hash *= TMR_HASH_PRIME;
+  }
+  return hash;
+}
+
 /*
   Create the element feature size.
 
@@ -899,6 +919,21 @@ double TMRElementFeatureSize::getFeatureSize( TMRPoint pt ){
   return hmin;
 }
 
+/*
+  Add the parameters that set the feature size within the box
+  [lower, upper] to the hash key
+
+  This is used to identify the inputs to the edge and face meshes.
+  The default implementation returns zero since a derived class may
+  override getFeatureSize(). In this case, the feature size is sampled
+  instead.
+*/
+int TMRElementFeatureSize::addParametersToKey( TMRPoint lower,
+                                               TMRPoint upper,
+                                               uint64_t *key ){
+  return 0;
+}
+
 /*
   Create a feature size dependency that is linear but does not
   exceed hmin or hmax anywhere in the domain
@@ -928,6 +963,24 @@ double TMRLinearElementSize::getFeatureSize( TMRPoint pt ){
   return h;
 }
 
+/*
+  Add the coefficients to the hash key. These are global so the box
+  is not used.
+*/
+int TMRLinearElementSize::addParametersToKey( TMRPoint lower,
+                                              TMRPoint upper,
+                                              uint64_t *key ){
+  double params[6];
+  params[0] = hmin;
+  params[1] = hmax;
+  params[2] = c;
+  params[3] = ax;
+  params[4] = ay;
+  params[5] = az;
+  *key = hash_bytes(*key, params, 6*sizeof(double));
+  return 1;
+}
+
 /*
   Create the feature size within a box
 */
@@ -1013,6 +1066,39 @@ double TMRBoxFeatureSize::getFeatureSize( TMRPoint pt ){
   return h;
 }
 
+/*
+  Add the bounds and the boxes that intersect [lower, upper] to the
+  hash key
+
+  The feature size at a point only depends on the boxes that contain
+  it, so boxes away from [lower, upper] do not change the key.
+*/
+int TMRBoxFeatureSize::addParametersToKey( TMRPoint lower,
+                                           TMRPoint upper,
+                                           uint64_t *key ){
+  double bounds[2];
+  bounds[0] = hmin;
+  bounds[1] = hmax;
+  *key = hash_bytes(*key, bounds, 2*sizeof(double));
+
+  for ( BoxList *list = list_root; list; list = list->next ){
+    int size = MAX_LIST_BOXES;
+    if (list == list_current){
+      size = num_boxes;
+    }
+    for ( int i = 0; i < size; i++ ){
+      BoxSize *box = &list->boxes[i];
+      if (box->intersects(lower, upper)){
+        *key = hash_bytes(*key, &box->m, sizeof(TMRPoint));
+        *key = hash_bytes(*key, &box->d, sizeof(TMRPoint));
+        *key = hash_bytes(*key, &box->h, sizeof(double));
+      }
+    }
+  }
+
+  return 1;
+}
+
 /*
   Check if the box contains the point
 */
@@ -1034,6 +1120,19 @@ int TMRBoxFeatureSize::BoxSize::contains( TMRPoint p ){
   return 0;
 }
 
+/*
+  Check if the box intersects the box [lower, upper]
+*/
+int TMRBoxFeatureSize::BoxSize::intersects( TMRPoint lower,
+                                            TMRPoint upper ){
+  if ((m.x - d.x <= upper.x && m.x + d.x >= lower.x) &&
+      (m.y - d.y <= upper.y && m.y + d.y >= lower.y) &&
+      (m.z - d.z <= upper.z && m.z + d.z >= lower.z)){
+    return 1;
+  }
+  return 0;
+}
+
 /*
   Create the box node and allocate a single box (for now)
 */
@@ -1204,6 +1303,248 @@ void TMRBoxFeatureSize::BoxNode::getSize( TMRPoint p, double *hval ){
   }
 }
 
+/*
+  The number of samples along each parametric direction used to
+  fingerprint the geometry and the feature size for the mesh cache
+*/
+static const int TMR_CACHE_NUM_SAMPLES = 17;
+
+/*
+  Add the feature size over a grid of sampled points to the hash key
+
+  The points are stored as X[i + j*nu] for an nu by nv grid. The
+  feature size parameters are added for the bounding box of the
+  points, expanded by the largest distance between adjacent points so
+  that the box also covers the entity between the samples. If the
+  feature size does not provide its parameters, the feature size at
+  the points is added instead.
+*/
+static uint64_t hash_feature_size( uint64_t key, TMRElementFeatureSize *fs,
+                                   int nu, int nv, const TMRPoint *X ){
+  TMRPoint lower = X[0], upper = X[0];
+  double dmax = 0.0;
+  for ( int j = 0; j < nv; j++ ){
+    for ( int i = 0; i < nu; i++ ){
+      const TMRPoint *p = &X[i + j*nu];
+      if (p->x < lower.x){ lower.x = p->x; }
+      if (p->y < lower.y){ lower.y = p->y; }
+      if (p->z < lower.z){ lower.z = p->z; }
+      if (p->x > upper.x){ upper.x = p->x; }
+      if (p->y > upper.y){ upper.y = p->y; }
+      if (p->z > upper.z){ upper.z = p->z; }
+
+      // Find the distance to the previous point in each direction
+      for ( int k = 0; k < 2; k++ ){
+        const TMRPoint *q = NULL;
+        if (k == 0 && i > 0){ q = &X[i-1 + j*nu]; }
+        if (k == 1 && j > 0){ q = &X[i + (j-1)*nu]; }
+        if (q){
+          TMRPoint d;
+          d.x = p->x - q->x;
+          d.y = p->y - q->y;
+          d.z = p->z - q->z;
+          double dist = sqrt(d.dot(d));
+          if (dist > dmax){ dmax = dist; }
+        }
+      }
+    }
+  }
+  lower.x -= dmax;  lower.y -= dmax;  lower.z -= dmax;
+  upper.x += dmax;  upper.y += dmax;  upper.z += dmax;
+
+  if (!fs->addParametersToKey(lower, upper, &key)){
+    for ( int i = 0; i < nu*nv; i++ ){
+      double h = fs->getFeatureSize(X[i]);
+      key = hash_bytes(key, &h, sizeof(double));
+    }
+  }
+
+  return key;
+}
+
+/*
+  Identify the cache files and their format version
+*/
+static const char TMR_CACHE_MAGIC[8] = {'T', 'M', 'R', 'M', 'E', 'S', 'H', '1'};
+
+/*
+  Create the mesh cache that uses the given directory. The directory
+  must already exist.
+*/
+TMRMeshCache::TMRMeshCache( const char *_dir ){
+  dir = new char[ strlen(_dir)+1 ];
+  strcpy(dir, _dir);
+  num_hits = 0;
+  num_misses = 0;
+}
+
+TMRMeshCache::~TMRMeshCache(){
+  delete [] dir;
+}
+
+/*
+  Get the name of the cache file for the given key
+*/
+void TMRMeshCache::getFileName( const char *prefix, uint64_t key,
+                                char *name ){
+  sprintf(name, "%s/%s_%016llx.bin", dir, prefix,
+          (unsigned long long)key);
+}
+
+/*
+  Load the packed mesh data with the given key
+
+  The data is returned in a new array that must be freed by the
+  caller. The getUnpackedSize() function returns the number of bytes
+  that will be unpacked from the data, or -1 if the data is not
+  valid. NULL is returned if no valid cache file exists or if this
+  does not match the size of the data in the file. This function may
+  be called from several threads at once.
+*/
+char* TMRMeshCache::load( const char *prefix, uint64_t key, int *size,
+                          int (*getUnpackedSize)( const char*, int ) ){
+  char *name = new char[ strlen(dir) + strlen(prefix) + 32 ];
+  getFileName(prefix, key, name);
+  FILE *fp = fopen(name, "rb");
+  delete [] name;
+
+  char *data = NULL;
+  if (fp){
+    // Check the header before reading the data
+    char magic[8];
+    uint64_t file_key = 0;
+    int file_size = -1;
+    if (fread(magic, 1, 8, fp) == 8 &&
+        memcmp(magic, TMR_CACHE_MAGIC, 8) == 0 &&
+        fread(&file_key, sizeof(uint64_t), 1, fp) == 1 &&
+        file_key == key &&
+        fread(&file_size, sizeof(int), 1, fp) == 1 &&
+        file_size >= 0){
+      data = new char[ file_size ];
+      if (fread(data, 1, file_size, fp) == (size_t)file_size &&
+          getUnpackedSize(data, file_size) == file_size){
+        *size = file_size;
+      }
+      else {
+        delete [] data;
+        data = NULL;
+      }
+    }
+    fclose(fp);
+  }
+
+  if (data){
+    __sync_fetch_and_add(&num_hits, 1);
+  }
+  else {
+    __sync_fetch_and_add(&num_misses, 1);
+  }
+
+  return data;
+}
+
+/*
+  Store the packed mesh data with the given key
+
+  The data is first written to a temporary file that is then renamed
+  so that a partially written file is never read.
+*/
+void TMRMeshCache::store( const char *prefix, uint64_t key,
+                          const char *data, int size ){
+  char *name = new char[ strlen(dir) + strlen(prefix) + 32 ];
+  char *temp = new char[ strlen(dir) + strlen(prefix) + 64 ];
+  getFileName(prefix, key, name);
+
+  // Make the temporary file name unique across threads and processes
+  static int temp_count = 0;
+  int count = __sync_fetch_and_add(&temp_count, 1);
+  sprintf(temp, "%s.%d.%d.tmp", name, (int)getpid(), count);
+
+  FILE *fp = fopen(temp, "wb");
+  if (fp){
+    int fail = (fwrite(TMR_CACHE_MAGIC, 1, 8, fp) != 8 ||
+                fwrite(&key, sizeof(uint64_t), 1, fp) != 1 ||
+                fwrite(&size, sizeof(int), 1, fp) != 1 ||
+                fwrite(data, 1, size, fp) != (size_t)size);
+    fclose(fp);
+    if (fail || rename(temp, name) != 0){
+      fprintf(stderr, "TMRMeshCache: Failed to write %s\n", name);
+      remove(temp);
+    }
+  }
+  else {
+    fprintf(stderr, "TMRMeshCache: Failed to open %s\n", temp);
+  }
+
+  delete [] name;
+  delete [] temp;
+}
+
+/*
+  Get the number of cache hits and misses
+*/
+void TMRMeshCache::getStatistics( int *_num_hits, int *_num_misses ){
+  if (_num_hits){ *_num_hits = num_hits; }
+  if (_num_misses){ *_num_misses = num_misses; }
+}
+
+/*
+  Reset the number of cache hits and misses
+*/
+void TMRMeshCache::resetStatistics(){
+  num_hits = 0;
+  num_misses = 0;
+}
+
+/*
+  Get the number of bytes that unpackMesh() reads from a buffer
+  containing a packed edge mesh, or -1 if the header is not valid
+*/
+static int getUnpackedEdgeSize( const char *buffer, int size ){
+  int npts;
+  if (size < (int)sizeof(int)){
+    return -1;
+  }
+  memcpy(&npts, buffer, sizeof(int));
+  if (npts < 0 || npts > size){
+    return -1;
+  }
+  size_t len = sizeof(int) + npts*(sizeof(double) + sizeof(TMRPoint));
+  if (len > (size_t)size){
+    return -1;
+  }
+  return len;
+}
+
+/*
+  Get the number of bytes that unpackMesh() reads from a buffer
+  containing a packed face mesh, or -1 if the header is not valid
+*/
+static int getUnpackedFaceSize( const char *buffer, int size ){
+  int header[5];
+  if (size < (int)(5*sizeof(int))){
+    return -1;
+  }
+  memcpy(header, buffer, 5*sizeof(int));
+  int num_points = header[1];
+  int num_fixed_pts = header[2];
+  int num_quads = header[3];
+  int num_tris = header[4];
+  if (num_points < 0 || num_points > size ||
+      num_fixed_pts < 0 || num_fixed_pts > num_points ||
+      num_quads < 0 || num_quads > size ||
+      num_tris < 0 || num_tris > size){
+    return -1;
+  }
+  size_t len = 5*sizeof(int) + 2*num_points*sizeof(double) +
+    num_points*sizeof(TMRPoint) + 4*num_quads*sizeof(int) +
+    3*num_tris*sizeof(int);
+  if (len > (size_t)size){
+    return -1;
+  }
+  return len;
+}
+
 /*
   Create a mesh along curve
 */
@@ -1211,6 +1552,7 @@ TMREdgeMesh::TMREdgeMesh( MPI_Comm _comm, TMREdge *_edge ){
   comm = _comm;
   edge = _edge;
   edge->incref();
+  cache = NULL;
 
   npts = 0;
   pts = NULL;
@@ -1223,6 +1565,7 @@ TMREdgeMesh::TMREdgeMesh( MPI_Comm _comm, TMREdge *_edge ){
 */
 TMREdgeMesh::~TMREdgeMesh(){
   edge->decref();
+  if (cache){ cache->decref(); }
   if (pts){ delete [] pts; }
   if (X){ delete [] X; }
   if (vars){ delete [] vars; }
@@ -1243,113 +1586,291 @@ void TMREdgeMesh::mesh( TMRMeshOptions options,
 
   // Figure out if there is a source edge and whether or not it has
   // been meshed.
-  npts = -1;
   if (source && source != edge){
     TMREdgeMesh *mesh;
     source->getMesh(&mesh);
     if (!mesh){
       mesh = new TMREdgeMesh(comm, source);
+      mesh->setMeshCache(cache);
       mesh->mesh(options, fs);
       source->setMesh(mesh);
     }
-
-    // Retrieve the number of points along the source edge
-    mesh->getMeshPoints(&npts, NULL, NULL);
   }
 
+  // Compute the mesh on the root processor
   if (mpi_rank == 0){
-    // Get the limits of integration that will be used
-    double tmin, tmax;
-    edge->getRange(&tmin, &tmax);
+    computeMesh(options, fs);
+  }
 
-    // Get the associated vertices
-    TMRVertex *v1, *v2;
-    edge->getVertices(&v1, &v2);
+  if (mpi_size > 1){
+    broadcastMesh();
+  }
+}
 
-    if (!edge->isDegenerate()){
-      // Set the integration error tolerance
-      double integration_eps = 1e-8;
-
-      // Integrate along the curve to obtain the distance function such
-      // that dist(tvals[i]) = int_{tmin}^{tvals[i]} ||d{C(t)}dt||_{2} dt
-      int nvals;
-      double *dist, *tvals;
-      integrateEdge(edge, fs, tmin, tmax, integration_eps,
-                    &tvals, &dist, &nvals);
-
-      // Only compute the number of points if there is no source edge
-      if (npts < 0){
-        // Compute the number of points along this curve
-        npts = (int)(ceil(dist[nvals-1]));
-        if (npts < 2){ npts = 2; }
-
-        // If we have an even number of points, increment by one to ensure
-        // that we have an even number of segments along the boundary
-        if (npts % 2 != 1){ npts++; }
-
-        // If the start/end vertex are the same, then the minimum number
-        // of points is 5
-        if ((v1 == v2) && npts < 5){
-          npts = 5;
-        }
+/*
+  Compute the points along the edge on this processor only
+
+  If the edge has a source edge, its mesh must already exist. The
+  number of points is taken from the source mesh.
+*/
+void TMREdgeMesh::computeMesh( TMRMeshOptions options,
+                               TMRElementFeatureSize *fs ){
+  // Retrieve the number of points from the source edge (if any)
+  TMREdge *source;
+  edge->getSource(&source);
+  npts = -1;
+  if (source && source != edge){
+    TMREdgeMesh *mesh;
+    source->getMesh(&mesh);
+    if (mesh){
+      mesh->getMeshPoints(&npts, NULL, NULL);
+    }
+  }
+
+  // Try to load the mesh from the cache
+  uint64_t key = 0;
+  if (cache){
+    key = computeMeshKey(fs);
+    int size;
+    char *data = cache->load("edge", key, &size, getUnpackedEdgeSize);
+    if (data){
+      unpackMesh(data);
+      delete [] data;
+      return;
+    }
+  }
+
+  // Get the limits of integration that will be used
+  double tmin, tmax;
+  edge->getRange(&tmin, &tmax);
+
+  // Get the associated vertices
+  TMRVertex *v1, *v2;
+  edge->getVertices(&v1, &v2);
+
+  if (!edge->isDegenerate()){
+    // Set the integration error tolerance
+    double integration_eps = 1e-8;
+
+    // Integrate along the curve to obtain the distance function such
+    // that dist(tvals[i]) = int_{tmin}^{tvals[i]} ||d{C(t)}dt||_{2} dt
+    int nvals;
+    double *dist, *tvals;
+    integrateEdge(edge, fs, tmin, tmax, integration_eps,
+                  &tvals, &dist, &nvals);
+
+    // Only compute the number of points if there is no source edge
+    if (npts < 0){
+      // Compute the number of points along this curve
+      npts = (int)(ceil(dist[nvals-1]));
+      if (npts < 2){ npts = 2; }
+
+      // If we have an even number of points, increment by one to ensure
+      // that we have an even number of segments along the boundary
+      if (npts % 2 != 1){ npts++; }
+
+      // If the start/end vertex are the same, then the minimum number
+      // of points is 5
+      if ((v1 == v2) && npts < 5){
+        npts = 5;
       }
+    }
 
-      // The average non-dimensional distance between points
-      double d = dist[nvals-1]/(npts-1);
+    // The average non-dimensional distance between points
+    double d = dist[nvals-1]/(npts-1);
 
-      // Allocate the parametric points that will be used
-      pts = new double[ npts ];
+    // Allocate the parametric points that will be used
+    pts = new double[ npts ];
 
-      // Set the starting/end location of the points
-      pts[0] = tmin;
-      pts[npts-1] = tmax;
+    // Set the starting/end location of the points
+    pts[0] = tmin;
+    pts[npts-1] = tmax;
 
-      // Perform the integration so that the points are evenly spaced
-      // along the curve
-      for ( int j = 1, k = 1; (j < nvals && k < npts-1); j++ ){
-        while ((k < npts-1) &&
-               (dist[j-1] <= d*k && d*k < dist[j])){
-          double u = 0.0;
-          if (dist[j] > dist[j-1]){
-            u = (d*k - dist[j-1])/(dist[j] - dist[j-1]);
-          }
-          pts[k] = tvals[j-1] + (tvals[j] - tvals[j-1])*u;
-          k++;
+    // Perform the integration so that the points are evenly spaced
+    // along the curve
+    for ( int j = 1, k = 1; (j < nvals && k < npts-1); j++ ){
+      while ((k < npts-1) &&
+             (dist[j-1] <= d*k && d*k < dist[j])){
+        double u = 0.0;
+        if (dist[j] > dist[j-1]){
+          u = (d*k - dist[j-1])/(dist[j] - dist[j-1]);
         }
+        pts[k] = tvals[j-1] + (tvals[j] - tvals[j-1])*u;
+        k++;
       }
-
-      // Free the integration result
-      delete [] tvals;
-      delete [] dist;
-    }
-    else {
-      // This is a degenerate edge
-      npts = 2;
-      pts = new double[ npts ];
-      pts[0] = tmin;
-      pts[1] = tmax;
     }
 
-    // Allocate the points
-    X = new TMRPoint[ npts ];
-    for ( int i = 0; i < npts; i++ ){
-      edge->evalPoint(pts[i], &X[i]);
-    }
+    // Free the integration result
+    delete [] tvals;
+    delete [] dist;
+  }
+  else {
+    // This is a degenerate edge
+    npts = 2;
+    pts = new double[ npts ];
+    pts[0] = tmin;
+    pts[1] = tmax;
   }
 
-  if (mpi_size > 1){
-    // Broadcast the number of points to all the processors
-    MPI_Bcast(&npts, 1, MPI_INT, 0, comm);
+  // Allocate the points
+  X = new TMRPoint[ npts ];
+  for ( int i = 0; i < npts; i++ ){
+    edge->evalPoint(pts[i], &X[i]);
+  }
+
+  // Store the new mesh in the cache
+  if (cache){
+    int size = getPackedSize();
+    char *data = new char[ size ];
+    packMesh(data);
+    cache->store("edge", key, data, size);
+    delete [] data;
+  }
+}
+
+/*
+  Compute the key that identifies the inputs to the edge mesh
+
+  The key depends on the parameter range of the edge, the number of
+  points set by the source edge (if any), the points sampled along
+  the edge and the feature size near the edge. The key is used by the
+  mesh cache and to detect the edges that must be remeshed.
+*/
+uint64_t TMREdgeMesh::computeMeshKey( TMRElementFeatureSize *fs ){
+  uint64_t key = TMR_HASH_OFFSET;
 
-    if (mpi_rank != 0){
-      pts = new double[ npts ];
-      X = new TMRPoint[ npts ];
+  // Get the number of points set by the source edge (if any)
+  int source_npts = -1;
+  TMREdge *source;
+  edge->getSource(&source);
+  if (source && source != edge){
+    TMREdgeMesh *mesh;
+    source->getMesh(&mesh);
+    if (mesh){
+      mesh->getMeshPoints(&source_npts, NULL, NULL);
     }
+  }
+
+  double tmin, tmax;
+  edge->getRange(&tmin, &tmax);
+  TMRVertex *v1, *v2;
+  edge->getVertices(&v1, &v2);
+  int flags[3];
+  flags[0] = source_npts;
+  flags[1] = edge->isDegenerate();
+  flags[2] = (v1 == v2);
+  key = hash_bytes(key, flags, 3*sizeof(int));
+  key = hash_bytes(key, &tmin, sizeof(double));
+  key = hash_bytes(key, &tmax, sizeof(double));
+
+  // Sample the points along the edge
+  TMRPoint Xs[TMR_CACHE_NUM_SAMPLES];
+  for ( int i = 0; i < TMR_CACHE_NUM_SAMPLES; i++ ){
+    double t = tmin + (tmax - tmin)*i/(TMR_CACHE_NUM_SAMPLES-1);
+    edge->evalPoint(t, &Xs[i]);
+  }
+  key = hash_bytes(key, Xs, TMR_CACHE_NUM_SAMPLES*sizeof(TMRPoint));
+  key = hash_feature_size(key, fs, TMR_CACHE_NUM_SAMPLES, 1, Xs);
+
+  return key;
+}
+
+/*
+  Copy the points into a byte buffer and return the position after the
+  last point. The buffer is not aligned for TMRPoint, so the
+  coordinates are copied through a temporary array.
+*/
+static char *pack_points( char *buffer, int npts, const TMRPoint *X ){
+  for ( int i = 0; i < npts; i++ ){
+    double x[3];
+    x[0] = X[i].x;
+    x[1] = X[i].y;
+    x[2] = X[i].z;
+    memcpy(buffer, x, 3*sizeof(double));
+    buffer += 3*sizeof(double);
+  }
+  return buffer;
+}
+
+/*
+  Copy the points out of a byte buffer and return the position after
+  the last point
+*/
+static const char *unpack_points( const char *buffer, int npts,
+                                  TMRPoint *X ){
+  for ( int i = 0; i < npts; i++ ){
+    double x[3];
+    memcpy(x, buffer, 3*sizeof(double));
+    X[i].x = x[0];
+    X[i].y = x[1];
+    X[i].z = x[2];
+    buffer += 3*sizeof(double);
+  }
+  return buffer;
+}
+
+/*
+  Get the number of bytes required to pack the edge mesh
+*/
+int TMREdgeMesh::getPackedSize(){
+  return sizeof(int) + npts*(sizeof(double) + sizeof(TMRPoint));
+}
+
+/*
+  Pack the edge mesh into the buffer. The buffer must be at least
+  getPackedSize() bytes.
+*/
+void TMREdgeMesh::packMesh( char *buffer ){
+  memcpy(buffer, &npts, sizeof(int));
+  buffer += sizeof(int);
+  memcpy(buffer, pts, npts*sizeof(double));
+  buffer += npts*sizeof(double);
+  pack_points(buffer, npts, X);
+}
+
+/*
+  Unpack the edge mesh from the buffer and return the number of bytes
+  that were read
+*/
+int TMREdgeMesh::unpackMesh( const char *buffer ){
+  memcpy(&npts, buffer, sizeof(int));
+  const char *ptr = buffer + sizeof(int);
+  pts = new double[ npts ];
+  memcpy(pts, ptr, npts*sizeof(double));
+  ptr += npts*sizeof(double);
+  X = new TMRPoint[ npts ];
+  ptr = unpack_points(ptr, npts, X);
+
+  return ptr - buffer;
+}
+
+/*
+  Set the cache used to load and store the edge mesh
+*/
+void TMREdgeMesh::setMeshCache( TMRMeshCache *_cache ){
+  if (_cache){ _cache->incref(); }
+  if (cache){ cache->decref(); }
+  cache = _cache;
+}
+
+/*
+  Broadcast the edge mesh from the root processor to all processors
+*/
+void TMREdgeMesh::broadcastMesh(){
+  int mpi_rank;
+  MPI_Comm_rank(comm, &mpi_rank);
 
-    // Broadcast the parametric locations and points
-    MPI_Bcast(pts, npts, MPI_DOUBLE, 0, comm);
-    MPI_Bcast(X, npts, TMRPoint_MPI_type, 0, comm);
+  // Broadcast the number of points to all the processors
+  MPI_Bcast(&npts, 1, MPI_INT, 0, comm);
+
+  if (mpi_rank != 0){
+    pts = new double[ npts ];
+    X = new TMRPoint[ npts ];
   }
+
+  // Broadcast the parametric locations and points
+  MPI_Bcast(pts, npts, MPI_DOUBLE, 0, comm);
+  MPI_Bcast(X, npts, TMRPoint_MPI_type, 0, comm);
 }
 
 /*
@@ -1392,6 +1913,15 @@ int TMREdgeMesh::getNodeNums( const int **_vars ){
   return npts;
 }
 
+/*
+  Reset the node numbers so that they are assigned again by the next
+  call to setNodeNums
+*/
+void TMREdgeMesh::resetNodeNums(){
+  if (vars){ delete [] vars; }
+  vars = NULL;
+}
+
 /*
   Get the mesh points
 */
@@ -1417,6 +1947,7 @@ TMRFaceMesh::TMRFaceMesh( MPI_Comm _comm, TMRFace *_face ){
   comm = _comm;
   face = _face;
   face->incref();
+  cache = NULL;
   mesh_type = TMR_NO_MESH;
 
   num_fixed_pts = 0;
@@ -1437,6 +1968,7 @@ TMRFaceMesh::TMRFaceMesh( MPI_Comm _comm, TMRFace *_face ){
 */
 TMRFaceMesh::~TMRFaceMesh(){
   face->decref();
+  if (cache){ cache->decref(); }
   if (pts){ delete [] pts; }
   if (X){ delete [] X; }
   if (vars){ delete [] vars; }
@@ -1453,12 +1985,6 @@ void TMRFaceMesh::mesh( TMRMeshOptions options,
   MPI_Comm_size(comm, &mpi_size);
   MPI_Comm_rank(comm, &mpi_rank);
 
-  // Set the default mesh type
-  TMRFaceMeshType _mesh_type = options.mesh_type_default;
-  if (_mesh_type == TMR_NO_MESH){
-    _mesh_type = TMR_STRUCTURED;
-  }
-
   // Get the source face and its orientation relative to this
   // face. Note that the source face may be NULL in which case the
   // source orientation is meaningless.
@@ -1473,11 +1999,38 @@ void TMRFaceMesh::mesh( TMRMeshOptions options,
     source->getMesh(&face_mesh);
     if (!face_mesh){
       face_mesh = new TMRFaceMesh(comm, source);
+      face_mesh->setMeshCache(cache);
       face_mesh->mesh(options, fs);
       source->setMesh(face_mesh);
     }
   }
 
+  // Select the type of mesh used for this face
+  selectMeshType(options);
+
+  // Compute the mesh on the root processor
+  if (mpi_rank == 0){
+    computeMesh(options, fs);
+  }
+
+  if (mpi_size > 1){
+    broadcastMesh();
+  }
+}
+
+/*
+  Select the type of mesh for this face. A structured mesh is only
+  used when the face has a single loop of four non-degenerate edges
+  whose opposite edges have the same number of points. The edge
+  meshes must exist before this is called.
+*/
+void TMRFaceMesh::selectMeshType( TMRMeshOptions options ){
+  // Set the default mesh type
+  TMRFaceMeshType _mesh_type = options.mesh_type_default;
+  if (_mesh_type == TMR_NO_MESH){
+    _mesh_type = TMR_STRUCTURED;
+  }
+
   // First check if the conditions for a structured mesh are satisfied
   if (_mesh_type == TMR_STRUCTURED){
     int nloops = face->getNumEdgeLoops();
@@ -1532,92 +2085,322 @@ void TMRFaceMesh::mesh( TMRMeshOptions options,
 
   // Record the mesh type
   mesh_type = _mesh_type;
+}
 
-  if (mpi_rank == 0){
-    // Count up the number of points and segments from the curves that
-    // bound the surface. Keep track of the number of points = the
-    // number of segments.
-    int total_num_pts = 0;
+/*
+  Compute the face mesh on this processor only
 
-    // Keep track of the number of closed loop cycles in the domain
-    int nloops = face->getNumEdgeLoops();
+  The edge meshes and the mesh for the source face (if any) must
+  already exist on this processor.
+*/
+void TMRFaceMesh::computeMesh( TMRMeshOptions options,
+                               TMRElementFeatureSize *fs ){
+  // Get the source face and its orientation relative to this face
+  int source_dir;
+  TMRVolume *source_volume;
+  TMRFace *source;
+  face->getSource(&source_dir, &source_volume, &source);
 
-    // The number of degenerate edges
-    int num_degen = 0;
+  // Try to load the mesh from the cache
+  uint64_t key = 0;
+  if (cache){
+    key = computeMeshKey(options, fs);
+    int size;
+    char *data = cache->load("face", key, &size, getUnpackedFaceSize);
+    if (data){
+      unpackMesh(data);
+      delete [] data;
+      return;
+    }
+  }
 
-    // The total number of edges in the model
-    int total_nedges = 0;
+  // Count up the number of points and segments from the curves that
+  // bound the surface. Keep track of the number of points = the
+  // number of segments.
+  int total_num_pts = 0;
 
-    // Get all of the edges and count up the mesh points
-    for ( int k = 0; k < nloops; k++ ){
-      TMREdgeLoop *loop;
-      face->getEdgeLoop(k, &loop);
-      int nedges;
-      TMREdge **edges;
-      loop->getEdgeLoop(&nedges, &edges, NULL);
+  // Keep track of the number of closed loop cycles in the domain
+  int nloops = face->getNumEdgeLoops();
 
-      // Keep track of the total number of edges attached to this
-      // surface object
-      total_nedges += nedges;
+  // The number of degenerate edges
+  int num_degen = 0;
 
-      for ( int i = 0; i < nedges; i++ ){
-        // Count whether this edge is degenerate
-        if (edges[i]->isDegenerate()){
-          num_degen++;
-        }
+  // The total number of edges in the model
+  int total_nedges = 0;
 
-        // Check whether the edge mesh exists - it has to!
-        TMREdgeMesh *mesh = NULL;
-        edges[i]->getMesh(&mesh);
-        if (!mesh){
-          fprintf(stderr,
-                  "TMRFaceMesh error: Edge mesh does not exist\n");
-        }
+  // Get all of the edges and count up the mesh points
+  for ( int k = 0; k < nloops; k++ ){
+    TMREdgeLoop *loop;
+    face->getEdgeLoop(k, &loop);
+    int nedges;
+    TMREdge **edges;
+    loop->getEdgeLoop(&nedges, &edges, NULL);
 
-        // Get the number of points associated with the curve
-        int npts;
-        mesh->getMeshPoints(&npts, NULL, NULL);
+    // Keep track of the total number of edges attached to this
+    // surface object
+    total_nedges += nedges;
 
-        // Update the total number of points
-        total_num_pts += npts-1;
+    for ( int i = 0; i < nedges; i++ ){
+      // Count whether this edge is degenerate
+      if (edges[i]->isDegenerate()){
+        num_degen++;
       }
+
+      // Check whether the edge mesh exists - it has to!
+      TMREdgeMesh *mesh = NULL;
+      edges[i]->getMesh(&mesh);
+      if (!mesh){
+        fprintf(stderr,
+                "TMRFaceMesh error: Edge mesh does not exist\n");
+      }
+
+      // Get the number of points associated with the curve
+      int npts;
+      mesh->getMeshPoints(&npts, NULL, NULL);
+
+      // Update the total number of points
+      total_num_pts += npts-1;
     }
+  }
 
-    // The number of holes is equal to the number of loops-1. One loop
-    // bounds the domain, the other loops cut out holes in the domain.
-    // Note that the domain must be contiguous.
-    int nholes = nloops-1;
+  // The number of holes is equal to the number of loops-1. One loop
+  // bounds the domain, the other loops cut out holes in the domain.
+  // Note that the domain must be contiguous.
+  int nholes = nloops-1;
 
-    // All the boundary loops are closed, therefore, the total number
-    // of segments is equal to the total number of points
-    int nsegs = total_num_pts;
+  // All the boundary loops are closed, therefore, the total number
+  // of segments is equal to the total number of points
+  int nsegs = total_num_pts;
 
-    // Allocate the points and the number of segments based on the
-    // number of holes
-    double *params = new double[ 2*(total_num_pts + nholes) ];
-    int *segments = new int[ 2*nsegs ];
+  // Allocate the points and the number of segments based on the
+  // number of holes
+  double *params = new double[ 2*(total_num_pts + nholes) ];
+  int *segments = new int[ 2*nsegs ];
 
-    // Start entering the points from the end of the last hole entry in
-    // the parameter points array.
-    int pt = 0;
+  // Start entering the points from the end of the last hole entry in
+  // the parameter points array.
+  int pt = 0;
 
-    int init_loop_pt = 0; // What point value did this loop start on?
-    int hole_pt = total_num_pts; // What hole are we on?
+  int init_loop_pt = 0; // What point value did this loop start on?
+  int hole_pt = total_num_pts; // What hole are we on?
 
-    // Set up the degenerate edges
-    int *degen = NULL;
-    if (num_degen > 0){
-      degen = new int[ 2*num_degen ];
+  // Set up the degenerate edges
+  int *degen = NULL;
+  if (num_degen > 0){
+    degen = new int[ 2*num_degen ];
+  }
+  num_degen = 0;
+
+  for ( int k = 0; k < nloops; k++ ){
+    // Set the offset to the initial point/segment on this loop
+    init_loop_pt = pt;
+
+    // Get the curve information for this loop segment
+    TMREdgeLoop *loop;
+    face->getEdgeLoop(k, &loop);
+    int nedges;
+    TMREdge **edges;
+    const int *dir;
+    loop->getEdgeLoop(&nedges, &edges, &dir);
+
+    for ( int i = 0; i < nedges; i++ ){
+      // Retrieve the underlying curve mesh
+      TMREdge *edge = edges[i];
+      TMREdgeMesh *mesh = NULL;
+      edge->getMesh(&mesh);
+
+      // Get the mesh points corresponding to this curve
+      int npts;
+      const double *tpts;
+      mesh->getMeshPoints(&npts, &tpts, NULL);
+
+      // Find the point on the curve
+      if (dir[i] > 0){
+        for ( int j = 0; j < npts-1; j++ ){
+          edge->getParamsOnFace(face, tpts[j], dir[i],
+                                &params[2*pt], &params[2*pt+1]);
+          segments[2*pt] = pt;
+          segments[2*pt+1] = pt+1;
+          if (edge->isDegenerate()){
+            degen[2*num_degen] = pt;
+            degen[2*num_degen+1] = pt+1;
+            num_degen++;
+          }
+          pt++;
+        }
+      }
+      else {
+        // Reverse the parameter values on the edge
+        for ( int j = npts-1; j >= 1; j-- ){
+          edge->getParamsOnFace(face, tpts[j], dir[i],
+                                &params[2*pt], &params[2*pt+1]);
+          segments[2*pt] = pt;
+          segments[2*pt+1] = pt+1;
+          if (edge->isDegenerate()){
+            degen[2*num_degen] = pt;
+            degen[2*num_degen+1] = pt+1;
+            num_degen++;
+          }
+          pt++;
+        }
+      }
     }
-    num_degen = 0;
 
-    for ( int k = 0; k < nloops; k++ ){
-      // Set the offset to the initial point/segment on this loop
-      init_loop_pt = pt;
+    // Close off the loop by connecting the segment back to the
+    // initial loop point
+    segments[2*(pt-1)+1] = init_loop_pt;
+
+    // Compute the area enclosed by the loop. If the area is
+    // positive, it is the domain boundary. If the area is negative,
+    // we have a hole!  Note that this assumes that the polygon
+    // creating the hole is not self-intersecting. (In reality we
+    // compute twice the area since we omit the 1/2 factor.)
+    double Area = 0.0;
+    for ( int i = init_loop_pt; i < pt; i++ ){
+      int s1 = segments[2*i];
+      int s2 = segments[2*i+1];
+      const double x1 = params[2*s1];
+      const double y1 = params[2*s1+1];
+      const double x2 = params[2*s2];
+      const double y2 = params[2*s2+1];
+      Area += (x1*y2 - x2*y1);
+    }
 
-      // Get the curve information for this loop segment
+    // Check the area constraint
+    if (Area < 0.0){
+      // This is a hole! Compute an approximate position for the hole.
+      // Note that this may not work in all cases so beware.
+      int s1 = segments[2*init_loop_pt];
+      int s2 = segments[2*init_loop_pt+1];
+      const double x1 = params[2*s1];
+      const double y1 = params[2*s1+1];
+      const double x2 = params[2*s2];
+      const double y2 = params[2*s2+1];
+      const double dx = x2 - x1;
+      const double dy = y2 - y1;
+
+      // This is arbitrary and won't work in general if we have a very
+      // thin sliver for a hole...
+      double frac = 0.01;
+
+      // Set the average location for the hole
+      params[2*hole_pt] = 0.5*(x1 + x2) + frac*dy;
+      params[2*hole_pt+1] = 0.5*(y1 + y2) - frac*dx;
+
+      // Increment the hole pointer
+      hole_pt++;
+    }
+  }
+
+  // Set the total number of fixed points. These are the points that
+  // will not be smoothed and constitute the boundary nodes. Note
+  // that the Triangularize class removes the holes from the domain
+  // automatically.  The boundary points are guaranteed to be
+  // ordered first.
+  num_fixed_pts = total_num_pts - num_degen;
+
+  if (source){
+    // Create the source map of edges and keep track of their local
+    // directions relative to the source surface
+    std::map<TMREdge*, int> source_edges;
+    for ( int k = 0; k < source->getNumEdgeLoops(); k++ ){
+      TMREdgeLoop *loop;
+      source->getEdgeLoop(k, &loop);
+
+      // Get the number of edges/edges from the source loop
+      int nedges;
+      TMREdge **edges;
+      const int *dir;
+      loop->getEdgeLoop(&nedges, &edges, &dir);
+      for ( int j = 0; j < nedges; j++ ){
+        source_edges[edges[j]] = dir[j];
+      }
+    }
+
+    // Create the target map of edges and keep track of their local
+    // directions relative to the target surface
+    std::map<TMREdge*, int> target_edges;
+    for ( int k = 0; k < face->getNumEdgeLoops(); k++ ){
       TMREdgeLoop *loop;
       face->getEdgeLoop(k, &loop);
+
+      // Get the number of edges/edges from the source loop
+      int nedges;
+      TMREdge **edges;
+      const int *dir;
+      loop->getEdgeLoop(&nedges, &edges, &dir);
+      for ( int j = 0; j < nedges; j++ ){
+        target_edges[edges[j]] = dir[j];
+      }
+    }
+
+    // Keep track of the source-to-target edge and target-to-source
+    // edge mappings as well as their relative orientations
+    std::map<TMREdge*, int> target_edge_dir;
+    std::map<TMREdge*, TMREdge*> source_to_target_edge;
+
+    // Loop over the faces that are within the source volume
+    int num_faces;
+    TMRFace **faces;
+    source_volume->getFaces(&num_faces, &faces, NULL);
+
+    for ( int i = 0; i < num_faces; i++ ){
+      // Check that this is not a target or source face
+      if (faces[i] != source && faces[i] != face){
+        // Find the source and target edge shared by the
+        TMREdge *sedge = NULL, *tedge = NULL;
+        int sdir = 0, tdir = 0;
+        for ( int k = 0; k < faces[i]->getNumEdgeLoops(); k++ ){
+          sedge = tedge = NULL;
+          sdir = tdir = 0;
+
+          // Get the edge loop
+          TMREdgeLoop *loop;
+          faces[i]->getEdgeLoop(k, &loop);
+
+          // Get the number of edges/edges from the source loop
+          int nedges;
+          TMREdge **edges;
+          const int *dir;
+          loop->getEdgeLoop(&nedges, &edges, &dir);
+
+          // Determine which edge is shared
+          for ( int j = 0; j < nedges; j++ ){
+            if (target_edges.count(edges[j]) > 0){
+              tedge = edges[j];
+              tdir = dir[j];
+            }
+            if (source_edges.count(edges[j]) > 0){
+              sedge = edges[j];
+              sdir = dir[j];
+            }
+          }
+
+          if (sedge && tedge){
+            break;
+          }
+        }
+
+        if (sedge && tedge){
+          // Compute the relative source-to-target directions
+          int tmp = source_edges[sedge]*target_edges[tedge];
+          target_edge_dir[tedge] = -sdir*tdir*tmp;
+
+          // Source to target and target to source edges
+          source_to_target_edge[sedge] = tedge;
+        }
+      }
+    }
+
+    // Now, count up the number of nodes that the target index must
+    // be offset
+    int target_offset = 0;
+    std::map<TMREdge*, int> target_edge_offset;
+    for ( int k = 0; k < face->getNumEdgeLoops(); k++ ){
+      TMREdgeLoop *loop;
+      face->getEdgeLoop(k, &loop);
+
+      // Get the edges within this loop
       int nedges;
       TMREdge **edges;
       const int *dir;
@@ -1634,767 +2417,735 @@ void TMRFaceMesh::mesh( TMRMeshOptions options,
         const double *tpts;
         mesh->getMeshPoints(&npts, &tpts, NULL);
 
-        // Find the point on the curve
-        if (dir[i] > 0){
-          for ( int j = 0; j < npts-1; j++ ){
-            edge->getParamsOnFace(face, tpts[j], dir[i],
-                                  &params[2*pt], &params[2*pt+1]);
-            segments[2*pt] = pt;
-            segments[2*pt+1] = pt+1;
-            if (edge->isDegenerate()){
-              degen[2*num_degen] = pt;
-              degen[2*num_degen+1] = pt+1;
-              num_degen++;
-            }
-            pt++;
-          }
-        }
-        else {
-          // Reverse the parameter values on the edge
-          for ( int j = npts-1; j >= 1; j-- ){
-            edge->getParamsOnFace(face, tpts[j], dir[i],
-                                  &params[2*pt], &params[2*pt+1]);
-            segments[2*pt] = pt;
-            segments[2*pt+1] = pt+1;
-            if (edge->isDegenerate()){
-              degen[2*num_degen] = pt;
-              degen[2*num_degen+1] = pt+1;
-              num_degen++;
-            }
-            pt++;
-          }
+        target_edge_offset[edge] = target_offset;
+        if (!edge->isDegenerate()){
+          target_offset += npts-1;
         }
       }
+    }
 
-      // Close off the loop by connecting the segment back to the
-      // initial loop point
-      segments[2*(pt-1)+1] = init_loop_pt;
-
-      // Compute the area enclosed by the loop. If the area is
-      // positive, it is the domain boundary. If the area is negative,
-      // we have a hole!  Note that this assumes that the polygon
-      // creating the hole is not self-intersecting. (In reality we
-      // compute twice the area since we omit the 1/2 factor.)
-      double Area = 0.0;
-      for ( int i = init_loop_pt; i < pt; i++ ){
-        int s1 = segments[2*i];
-        int s2 = segments[2*i+1];
-        const double x1 = params[2*s1];
-        const double y1 = params[2*s1+1];
-        const double x2 = params[2*s2];
-        const double y2 = params[2*s2+1];
-        Area += (x1*y2 - x2*y1);
-      }
-
-      // Check the area constraint
-      if (Area < 0.0){
-        // This is a hole! Compute an approximate position for the hole.
-        // Note that this may not work in all cases so beware.
-        int s1 = segments[2*init_loop_pt];
-        int s2 = segments[2*init_loop_pt+1];
-        const double x1 = params[2*s1];
-        const double y1 = params[2*s1+1];
-        const double x2 = params[2*s2];
-        const double y2 = params[2*s2+1];
-        const double dx = x2 - x1;
-        const double dy = y2 - y1;
-
-        // This is arbitrary and won't work in general if we have a very
-        // thin sliver for a hole...
-        double frac = 0.01;
-
-        // Set the average location for the hole
-        params[2*hole_pt] = 0.5*(x1 + x2) + frac*dy;
-        params[2*hole_pt+1] = 0.5*(y1 + y2) - frac*dx;
-
-        // Increment the hole pointer
-        hole_pt++;
-      }
-    }
-
-    // Set the total number of fixed points. These are the points that
-    // will not be smoothed and constitute the boundary nodes. Note
-    // that the Triangularize class removes the holes from the domain
-    // automatically.  The boundary points are guaranteed to be
-    // ordered first.
-    num_fixed_pts = total_num_pts - num_degen;
-
-    if (source){
-      // Create the source map of edges and keep track of their local
-      // directions relative to the source surface
-      std::map<TMREdge*, int> source_edges;
-      for ( int k = 0; k < source->getNumEdgeLoops(); k++ ){
-        TMREdgeLoop *loop;
-        source->getEdgeLoop(k, &loop);
-
-        // Get the number of edges/edges from the source loop
-        int nedges;
-        TMREdge **edges;
-        const int *dir;
-        loop->getEdgeLoop(&nedges, &edges, &dir);
-        for ( int j = 0; j < nedges; j++ ){
-          source_edges[edges[j]] = dir[j];
-        }
-      }
+    // March through the sources loop, and compute the source to
+    // target ordering
+    int *source_to_target = new int[ num_fixed_pts ];
+    int source_offset = 0;
+    for ( int k = 0; k < source->getNumEdgeLoops(); k++ ){
+      TMREdgeLoop *loop;
+      source->getEdgeLoop(k, &loop);
 
-      // Create the target map of edges and keep track of their local
-      // directions relative to the target surface
-      std::map<TMREdge*, int> target_edges;
-      for ( int k = 0; k < face->getNumEdgeLoops(); k++ ){
-        TMREdgeLoop *loop;
-        face->getEdgeLoop(k, &loop);
-
-        // Get the number of edges/edges from the source loop
-        int nedges;
-        TMREdge **edges;
-        const int *dir;
-        loop->getEdgeLoop(&nedges, &edges, &dir);
-        for ( int j = 0; j < nedges; j++ ){
-          target_edges[edges[j]] = dir[j];
-        }
-      }
+      // Get the edges within this loop
+      int nedges;
+      TMREdge **edges;
+      const int *dir;
+      loop->getEdgeLoop(&nedges, &edges, &dir);
 
-      // Keep track of the source-to-target edge and target-to-source
-      // edge mappings as well as their relative orientations
-      std::map<TMREdge*, int> target_edge_dir;
-      std::map<TMREdge*, TMREdge*> source_to_target_edge;
+      for ( int i = 0; i < nedges; i++ ){
+        // Retrieve the underlying mesh
+        TMREdge *edge = edges[i];
+        TMREdge *tedge = source_to_target_edge[edge];
 
-      // Loop over the faces that are within the source volume
-      int num_faces;
-      TMRFace **faces;
-      source_volume->getFaces(&num_faces, &faces, NULL);
+        // Get the offset for the target edge
+        int offset = target_edge_offset[tedge];
 
-      for ( int i = 0; i < num_faces; i++ ){
-        // Check that this is not a target or source face
-        if (faces[i] != source && faces[i] != face){
-          // Find the source and target edge shared by the
-          TMREdge *sedge = NULL, *tedge = NULL;
-          int sdir = 0, tdir = 0;
-          for ( int k = 0; k < faces[i]->getNumEdgeLoops(); k++ ){
-            sedge = tedge = NULL;
-            sdir = tdir = 0;
-
-            // Get the edge loop
-            TMREdgeLoop *loop;
-            faces[i]->getEdgeLoop(k, &loop);
-
-            // Get the number of edges/edges from the source loop
-            int nedges;
-            TMREdge **edges;
-            const int *dir;
-            loop->getEdgeLoop(&nedges, &edges, &dir);
-
-            // Determine which edge is shared
-            for ( int j = 0; j < nedges; j++ ){
-              if (target_edges.count(edges[j]) > 0){
-                tedge = edges[j];
-                tdir = dir[j];
-              }
-              if (source_edges.count(edges[j]) > 0){
-                sedge = edges[j];
-                sdir = dir[j];
-              }
-            }
+        // Retrieve the source mesh
+        TMREdgeMesh *mesh = NULL;
+        edge->getMesh(&mesh);
 
-            if (sedge && tedge){
-              break;
+        // Get the mesh points corresponding to this curve
+        int npts;
+        mesh->getMeshPoints(&npts, NULL, NULL);
+
+        // source:       target:
+        // 0 -- 1 -> 2   6 <- 5 -- 4
+        // |         |   |         |
+        // 7         3   7         3
+        // |         |   |         |
+        // 6 <- 5 -- 4   0 -- 1 -> 2
+
+        if (!edge->isDegenerate()){
+          if (target_edge_dir[tedge] > 0){
+            for ( int j = 0; j < npts-1; j++ ){
+              source_to_target[source_offset + j] = offset + j;
             }
           }
+          else {
+            for ( int j = 0; j < npts-1; j++ ){
+              source_to_target[source_offset + j] = offset + npts-1 - j;
+            }
 
-          if (sedge && tedge){
-            // Compute the relative source-to-target directions
-            int tmp = source_edges[sedge]*target_edges[tedge];
-            target_edge_dir[tedge] = -sdir*tdir*tmp;
-
-            // Source to target and target to source edges
-            source_to_target_edge[sedge] = tedge;
+            // Get the previous target edge in the loop. This will give
+            // the first number from the last edge loop.
+            TMREdge *init_edge = NULL;
+            if (i == 0){
+              init_edge = source_to_target_edge[edges[nedges-1]];
+            }
+            else {
+              init_edge = source_to_target_edge[edges[i-1]];
+            }
+            int init_offset = target_edge_offset[init_edge];
+            source_to_target[source_offset] = init_offset;
           }
+          // Increment the offset to the source
+          source_offset += npts-1;
         }
       }
+    }
+
+    // Create the face mesh
+    TMRFaceMesh *face_mesh;
+    source->getMesh(&face_mesh);
+
+    // Compute the total number of points
+    mesh_type = face_mesh->mesh_type;
+    num_points = face_mesh->num_points;
+    num_fixed_pts = face_mesh->num_fixed_pts;
+    num_quads = face_mesh->num_quads;
+    num_tris = face_mesh->num_tris;
 
-      // Now, count up the number of nodes that the target index must
-      // be offset
-      int target_offset = 0;
-      std::map<TMREdge*, int> target_edge_offset;
-      for ( int k = 0; k < face->getNumEdgeLoops(); k++ ){
-        TMREdgeLoop *loop;
-        face->getEdgeLoop(k, &loop);
-
-        // Get the edges within this loop
-        int nedges;
-        TMREdge **edges;
-        const int *dir;
-        loop->getEdgeLoop(&nedges, &edges, &dir);
-
-        for ( int i = 0; i < nedges; i++ ){
-          // Retrieve the underlying curve mesh
-          TMREdge *edge = edges[i];
-          TMREdgeMesh *mesh = NULL;
-          edge->getMesh(&mesh);
-
-          // Get the mesh points corresponding to this curve
-          int npts;
-          const double *tpts;
-          mesh->getMeshPoints(&npts, &tpts, NULL);
-
-          target_edge_offset[edge] = target_offset;
-          if (!edge->isDegenerate()){
-            target_offset += npts-1;
+    // Allocate the array for the parametric locations
+    pts = new double[ 2*num_points ];
+
+    // Copy the points from around the boundaries
+    for ( int i = 0; i < num_fixed_pts; i++ ){
+      pts[2*i] = params[2*i];
+      pts[2*i+1] = params[2*i+1];
+    }
+
+    // Compute a least squares transformation between the two
+    // surfaces
+    double N[16], A[4];
+    double sc[2], tc[3];
+    memset(N, 0, 16*sizeof(double));
+    memset(A, 0, 4*sizeof(double));
+    sc[0] = sc[1] = 0.0;
+    tc[0] = tc[1] = 0.0;
+
+    for ( int k = 0; k < num_fixed_pts; k++ ){
+      sc[0] += face_mesh->pts[2*k];
+      sc[1] += face_mesh->pts[2*k+1];
+      tc[0] += pts[2*k];
+      tc[1] += pts[2*k+1];
+    }
+    sc[0] = sc[0]/num_fixed_pts;
+    sc[1] = sc[1]/num_fixed_pts;
+    tc[0] = tc[0]/num_fixed_pts;
+    tc[1] = tc[1]/num_fixed_pts;
+
+    for ( int k = 0; k < num_fixed_pts; k++ ){
+      double uS[2], uT[2];
+      uS[0] = face_mesh->pts[2*k] - sc[0];
+      uS[1] = face_mesh->pts[2*k+1] - sc[1];
+
+      // Compute the source->target index number
+      int kt = source_to_target[k];
+      uT[0] = pts[2*kt] - tc[0];
+      uT[1] = pts[2*kt+1] - tc[1];
+
+      // Add the terms to the matrix/right-hand-side
+      for ( int i = 0; i < 4; i++ ){
+        for ( int j = 0; j < 4; j++ ){
+          double B = uS[i % 2]*uS[j % 2];
+          if ((i/2) == (j/2)){
+            N[i + 4*j] += B;
           }
         }
+        A[i] += uS[i % 2]*uT[i/2];
       }
+    }
 
-      // March through the sources loop, and compute the source to
-      // target ordering
-      int *source_to_target = new int[ num_fixed_pts ];
-      int source_offset = 0;
-      for ( int k = 0; k < source->getNumEdgeLoops(); k++ ){
-        TMREdgeLoop *loop;
-        source->getEdgeLoop(k, &loop);
-
-        // Get the edges within this loop
-        int nedges;
-        TMREdge **edges;
-        const int *dir;
-        loop->getEdgeLoop(&nedges, &edges, &dir);
-
-        for ( int i = 0; i < nedges; i++ ){
-          // Retrieve the underlying mesh
-          TMREdge *edge = edges[i];
-          TMREdge *tedge = source_to_target_edge[edge];
+    // Factor the least-squares matrix and perform the transformation
+    int ipiv[4];
+    int n = 4, one = 1, info;
+    TmrLAPACKdgetrf(&n, &n, N, &n, ipiv, &info);
+    TmrLAPACKdgetrs("N", &n, &one, N, &n, ipiv, A, &n, &info);
+
+    // Set the interior points based on the linear transformation
+    for ( int k = num_fixed_pts; k < num_points; k++ ){
+      double uS = face_mesh->pts[2*k] - sc[0];
+      double vS = face_mesh->pts[2*k+1] - sc[1];
+      pts[2*k] = A[0]*uS + A[1]*vS + tc[0];
+      pts[2*k+1] = A[2]*uS + A[3]*vS + tc[1];
+    }
 
-          // Get the offset for the target edge
-          int offset = target_edge_offset[tedge];
+    // Copy the quadrilateral mesh (if any)
+    if (num_quads > 0){
+      quads = new int[ 4*num_quads ];
+      memcpy(quads, face_mesh->quads, 4*num_quads*sizeof(int));
 
-          // Retrieve the source mesh
-          TMREdgeMesh *mesh = NULL;
-          edge->getMesh(&mesh);
+      // Adjust the quadrilateral ordering at the boundary
+      for ( int i = 0; i < 4*num_quads; i++ ){
+        if (quads[i] < num_fixed_pts){
+          quads[i] = source_to_target[quads[i]];
+        }
+      }
 
-          // Get the mesh points corresponding to this curve
-          int npts;
-          mesh->getMeshPoints(&npts, NULL, NULL);
+      // Flip the orientation of the quads to match the orientation
+      // of the face
+      if (source_dir < 0){
+        for ( int i = 0; i < num_quads; i++ ){
+          int tmp = quads[4*i+1];
+          quads[4*i+1] = quads[4*i+3];
+          quads[4*i+3] = tmp;
+        }
+      }
+    }
 
-          // source:       target:
-          // 0 -- 1 -> 2   6 <- 5 -- 4
-          // |         |   |         |
-          // 7         3   7         3
-          // |         |   |         |
-          // 6 <- 5 -- 4   0 -- 1 -> 2
-
-          if (!edge->isDegenerate()){
-            if (target_edge_dir[tedge] > 0){
-              for ( int j = 0; j < npts-1; j++ ){
-                source_to_target[source_offset + j] = offset + j;
-              }
-            }
-            else {
-              for ( int j = 0; j < npts-1; j++ ){
-                source_to_target[source_offset + j] = offset + npts-1 - j;
-              }
+    // Copy the triangular mesh (if any)
+    if (num_tris > 0){
+      tris = new int[ 3*num_tris ];
+      memcpy(tris, face_mesh->tris, 3*num_tris*sizeof(int));
 
-              // Get the previous target edge in the loop. This will give
-              // the first number from the last edge loop.
-              TMREdge *init_edge = NULL;
-              if (i == 0){
-                init_edge = source_to_target_edge[edges[nedges-1]];
-              }
-              else {
-                init_edge = source_to_target_edge[edges[i-1]];
-              }
-              int init_offset = target_edge_offset[init_edge];
-              source_to_target[source_offset] = init_offset;
-            }
-            // Increment the offset to the source
-            source_offset += npts-1;
-          }
+      // Adjust the triangle ordering at the boundary
+      for ( int i = 0; i < 3*num_tris; i++ ){
+        if (tris[i] < num_fixed_pts){
+          tris[i] = source_to_target[tris[i]];
         }
       }
 
-      // Create the face mesh
-      TMRFaceMesh *face_mesh;
-      source->getMesh(&face_mesh);
-
-      // Compute the total number of points
-      mesh_type = face_mesh->mesh_type;
-      num_points = face_mesh->num_points;
-      num_fixed_pts = face_mesh->num_fixed_pts;
-      num_quads = face_mesh->num_quads;
-      num_tris = face_mesh->num_tris;
-
-      // Allocate the array for the parametric locations
-      pts = new double[ 2*num_points ];
-
-      // Copy the points from around the boundaries
-      for ( int i = 0; i < num_fixed_pts; i++ ){
-        pts[2*i] = params[2*i];
-        pts[2*i+1] = params[2*i+1];
-      }
-
-      // Compute a least squares transformation between the two
-      // surfaces
-      double N[16], A[4];
-      double sc[2], tc[3];
-      memset(N, 0, 16*sizeof(double));
-      memset(A, 0, 4*sizeof(double));
-      sc[0] = sc[1] = 0.0;
-      tc[0] = tc[1] = 0.0;
-
-      for ( int k = 0; k < num_fixed_pts; k++ ){
-        sc[0] += face_mesh->pts[2*k];
-        sc[1] += face_mesh->pts[2*k+1];
-        tc[0] += pts[2*k];
-        tc[1] += pts[2*k+1];
-      }
-      sc[0] = sc[0]/num_fixed_pts;
-      sc[1] = sc[1]/num_fixed_pts;
-      tc[0] = tc[0]/num_fixed_pts;
-      tc[1] = tc[1]/num_fixed_pts;
-
-      for ( int k = 0; k < num_fixed_pts; k++ ){
-        double uS[2], uT[2];
-        uS[0] = face_mesh->pts[2*k] - sc[0];
-        uS[1] = face_mesh->pts[2*k+1] - sc[1];
-
-        // Compute the source->target index number
-        int kt = source_to_target[k];
-        uT[0] = pts[2*kt] - tc[0];
-        uT[1] = pts[2*kt+1] - tc[1];
-
-        // Add the terms to the matrix/right-hand-side
-        for ( int i = 0; i < 4; i++ ){
-          for ( int j = 0; j < 4; j++ ){
-            double B = uS[i % 2]*uS[j % 2];
-            if ((i/2) == (j/2)){
-              N[i + 4*j] += B;
-            }
-          }
-          A[i] += uS[i % 2]*uT[i/2];
+      // Flip the orientation of the triangles to match the
+      // orientation of the face
+      if (source_dir < 0){
+        for ( int i = 0; i < num_tris; i++ ){
+          int tmp = tris[3*i+1];
+          tris[4*i+1] = tris[4*i+2];
+          tris[4*i+2] = tmp;
         }
       }
+    }
 
-      // Factor the least-squares matrix and perform the transformation
-      int ipiv[4];
-      int n = 4, one = 1, info;
-      TmrLAPACKdgetrf(&n, &n, N, &n, ipiv, &info);
-      TmrLAPACKdgetrs("N", &n, &one, N, &n, ipiv, A, &n, &info);
+    // Free the data
+    delete [] source_to_target;
+
+    // Evaluate the points
+    X = new TMRPoint[ num_points ];
+    for ( int i = 0; i < num_points; i++ ){
+      face->evalPoint(pts[2*i], pts[2*i+1], &X[i]);
+    }
 
-      // Set the interior points based on the linear transformation
-      for ( int k = num_fixed_pts; k < num_points; k++ ){
-        double uS = face_mesh->pts[2*k] - sc[0];
-        double vS = face_mesh->pts[2*k+1] - sc[1];
-        pts[2*k] = A[0]*uS + A[1]*vS + tc[0];
-        pts[2*k+1] = A[2]*uS + A[3]*vS + tc[1];
+    if (num_quads > 0){
+      // Smooth the copied mesh on the new surface
+      int *pts_to_quad_ptr;
+      int *pts_to_quads;
+      computeNodeToElems(num_points, num_quads, 4, quads,
+                         &pts_to_quad_ptr, &pts_to_quads);
+
+      // Smooth the mesh using a local optimization of node locations
+      quadSmoothing(options.num_smoothing_steps, num_fixed_pts,
+                    num_points, pts_to_quad_ptr, pts_to_quads,
+                    num_quads, quads, pts, X, face);
+
+      // Free the connectivity information
+      delete [] pts_to_quad_ptr;
+      delete [] pts_to_quads;
+    }
+    else if (num_tris > 0){
+      // Compute the triangle edges and neighbors in the dual mesh
+      int num_tri_edges;
+      int *tri_edges, *tri_neighbors, *dual_edges;
+      computeTriEdges(num_points, num_tris, tris,
+                      &num_tri_edges, &tri_edges,
+                      &tri_neighbors, &dual_edges);
+
+      // Smooth the resulting triangular mesh
+      if (options.tri_smoothing_type == TMRMeshOptions::TMR_LAPLACIAN){
+        laplacianSmoothing(options.num_smoothing_steps, num_fixed_pts,
+                           num_tri_edges, tri_edges,
+                           num_points, pts, X, face);
+      }
+      else {
+        double alpha = 0.1;
+        springSmoothing(options.num_smoothing_steps, alpha,
+                        num_fixed_pts, num_tri_edges, tri_edges,
+                        num_points, pts, X, face);
       }
 
-      // Copy the quadrilateral mesh (if any)
-      if (num_quads > 0){
-        quads = new int[ 4*num_quads ];
-        memcpy(quads, face_mesh->quads, 4*num_quads*sizeof(int));
+      delete [] tri_edges;
+      delete [] tri_neighbors;
+      delete [] dual_edges;
+    }
+  }
+  else if (mesh_type == TMR_STRUCTURED){
+    // Use a straightforward interpolation technique to obtain the
+    // structured parametric locations in terms of the boundary
+    // point parametric locations. We do not perform checks here
+    // since we already know that the surface has four edges and the
+    // nodes on those edges can be used for a structured mesh
 
-        // Adjust the quadrilateral ordering at the boundary
-        for ( int i = 0; i < 4*num_quads; i++ ){
-          if (quads[i] < num_fixed_pts){
-            quads[i] = source_to_target[quads[i]];
-          }
-        }
+    // Get the first edge loop and the edges in the loop
+    TMREdgeLoop *loop;
+    face->getEdgeLoop(0, &loop);
 
-        // Flip the orientation of the quads to match the orientation
-        // of the face
-        if (source_dir < 0){
-          for ( int i = 0; i < num_quads; i++ ){
-            int tmp = quads[4*i+1];
-            quads[4*i+1] = quads[4*i+3];
-            quads[4*i+3] = tmp;
-          }
-        }
-      }
+    // Get the edges associated with the edge loop
+    TMREdge **edges;
+    loop->getEdgeLoop(NULL, &edges, NULL);
 
-      // Copy the triangular mesh (if any)
-      if (num_tris > 0){
-        tris = new int[ 3*num_tris ];
-        memcpy(tris, face_mesh->tris, 3*num_tris*sizeof(int));
+    // Get the number of nodes for the x/y edges
+    int nx = 0, ny = 0;
+    TMREdgeMesh *mesh;
+    edges[0]->getMesh(&mesh);
+    mesh->getMeshPoints(&nx, NULL, NULL);
+    edges[1]->getMesh(&mesh);
+    mesh->getMeshPoints(&ny, NULL, NULL);
 
-        // Adjust the triangle ordering at the boundary
-        for ( int i = 0; i < 3*num_tris; i++ ){
-          if (tris[i] < num_fixed_pts){
-            tris[i] = source_to_target[tris[i]];
-          }
-        }
+    // Compute the total number of points
+    num_points = nx*ny;
+    num_quads = (nx-1)*(ny-1);
 
-        // Flip the orientation of the triangles to match the
-        // orientation of the face
-        if (source_dir < 0){
-          for ( int i = 0; i < num_tris; i++ ){
-            int tmp = tris[3*i+1];
-            tris[4*i+1] = tris[4*i+2];
-            tris[4*i+2] = tmp;
-          }
-        }
-      }
+    // Create the connectivity information
+    quads = new int[ 4*num_quads ];
 
-      // Free the data
-      delete [] source_to_target;
-
-      // Evaluate the points
-      X = new TMRPoint[ num_points ];
-      for ( int i = 0; i < num_points; i++ ){
-        face->evalPoint(pts[2*i], pts[2*i+1], &X[i]);
-      }
-
-      if (num_quads > 0){
-        // Smooth the copied mesh on the new surface
-        int *pts_to_quad_ptr;
-        int *pts_to_quads;
-        computeNodeToElems(num_points, num_quads, 4, quads,
-                           &pts_to_quad_ptr, &pts_to_quads);
-
-        // Smooth the mesh using a local optimization of node locations
-        quadSmoothing(options.num_smoothing_steps, num_fixed_pts,
-                      num_points, pts_to_quad_ptr, pts_to_quads,
-                      num_quads, quads, pts, X, face);
-
-        // Free the connectivity information
-        delete [] pts_to_quad_ptr;
-        delete [] pts_to_quads;
-      }
-      else if (num_tris > 0){
-        // Compute the triangle edges and neighbors in the dual mesh
-        int num_tri_edges;
-        int *tri_edges, *tri_neighbors, *dual_edges;
-        computeTriEdges(num_points, num_tris, tris,
-                        &num_tri_edges, &tri_edges,
-                        &tri_neighbors, &dual_edges);
-
-        // Smooth the resulting triangular mesh
-        if (options.tri_smoothing_type == TMRMeshOptions::TMR_LAPLACIAN){
-          laplacianSmoothing(options.num_smoothing_steps, num_fixed_pts,
-                             num_tri_edges, tri_edges,
-                             num_points, pts, X, face);
+    int *q = quads;
+    for ( int j = 0; j < ny-1; j++ ){
+      for ( int i = 0; i < nx-1; i++ ){
+        // Compute the connectivity as if the element is on the
+        // interior of the mesh
+        q[0] = num_fixed_pts + (i-1) + (j-1)*(nx-2);
+        q[1] = num_fixed_pts + i + (j-1)*(nx-2);
+        q[2] = num_fixed_pts + i + j*(nx-2);
+        q[3] = num_fixed_pts + (i-1) + j*(nx-2);
+
+        // Adjust the ordering for the nodes on the boundary
+        if (j == ny-2){
+          q[2] = 2*nx + ny - 4 - i;
+          q[3] = 2*nx + ny - 3 - i;
         }
-        else {
-          double alpha = 0.1;
-          springSmoothing(options.num_smoothing_steps, alpha,
-                          num_fixed_pts, num_tri_edges, tri_edges,
-                          num_points, pts, X, face);
+        if (i == 0){
+          q[0] = 2*nx + 2*ny - 4 - j;
+          q[3] = 2*nx + 2*ny - 5 - j;
+        }
+        if (i == nx-2){
+          q[1] = nx - 1 + j;
+          q[2] = nx - 1 + j+1;
+        }
+        if (j == 0){
+          q[0] = i;
+          q[1] = i+1;
         }
+        q += 4;
+      }
+    }
 
-        delete [] tri_edges;
-        delete [] tri_neighbors;
-        delete [] dual_edges;
+    // Now set the parametric locations on the interior
+    pts = new double[ 2*num_points ];
+
+    // Copy the points from around the boundaries
+    for ( int i = 0; i < num_fixed_pts; i++ ){
+      pts[2*i] = params[2*i];
+      pts[2*i+1] = params[2*i+1];
+    }
+
+    // Use a transfinite interpolation to determine the parametric
+    // points where the interior nodes should be placed.
+    for ( int j = 1; j < ny-1; j++ ){
+      for ( int i = 1; i < nx-1; i++ ){
+        double u = 1.0*i/(nx-1);
+        double v = 1.0*j/(ny-1);
+
+        // Compute the weights on the corners
+        double c1 = (1.0 - u)*(1.0 - v);
+        double c2 = u*(1.0 - v);
+        double c3 = u*v;
+        double c4 = (1.0 - u)*v;
+
+        // Compute the weights on the curves
+        double w1 = (1.0 - v);
+        double w2 = u;
+        double w3 = v;
+        double w4 = (1.0 - u);
+
+        // New parametric point
+        int p = num_fixed_pts + i-1 + (j-1)*(nx-2);
+
+        // Boundary points that we're interpolating from
+        int p1 = i;
+        int p2 = nx-1 + j;
+        int p3 = 2*nx + ny - 3 - i;
+        int p4 = 2*nx + 2*ny - 4 - j;
+
+        // Evaluate the parametric points based on the transfinite
+        // interpolation
+        pts[2*p] =
+          ((w1*pts[2*p1] + w2*pts[2*p2] +
+            w3*pts[2*p3] + w4*pts[2*p4]) -
+           (c1*pts[0] + c2*pts[2*(nx-1)] +
+            c3*pts[2*(nx+ny-2)] + c4*pts[2*(2*nx+ny-3)]));
+
+        pts[2*p+1] =
+          ((w1*pts[2*p1+1] + w2*pts[2*p2+1] +
+            w3*pts[2*p3+1] + w4*pts[2*p4+1]) -
+           (c1*pts[1] + c2*pts[2*(nx-1)+1] +
+            c3*pts[2*(nx+ny-2)+1] + c4*pts[2*(2*nx+ny-3)+1]));
       }
     }
-    else if (mesh_type == TMR_STRUCTURED){
-      // Use a straightforward interpolation technique to obtain the
-      // structured parametric locations in terms of the boundary
-      // point parametric locations. We do not perform checks here
-      // since we already know that the surface has four edges and the
-      // nodes on those edges can be used for a structured mesh
 
-      // Get the first edge loop and the edges in the loop
-      TMREdgeLoop *loop;
-      face->getEdgeLoop(0, &loop);
+    // Allocate and evaluate the new physical point locations
+    X = new TMRPoint[ num_points ];
+    for ( int i = 0; i < num_points; i++ ){
+      face->evalPoint(pts[2*i], pts[2*i+1], &X[i]);
+    }
+  }
+  else {
+    // Here mesh_type == TMR_TRIANGLE or TMR_UNSTRUCTURED
+
+    // Create the triangularization class
+    TMRTriangularize *tri =
+      new TMRTriangularize(total_num_pts + nholes, params, nholes,
+                           nsegs, segments, face);
+    tri->incref();
+
+    // Set the frontal quality factor
+    tri->setFrontalQualityFactor(options.frontal_quality_factor);
+
+    if (options.write_init_domain_triangle){
+      char filename[256];
+      sprintf(filename, "init_domain_triangle%d.vtk",
+              face->getEntityId());
+      tri->writeToVTK(filename);
+    }
 
-      // Get the edges associated with the edge loop
-      TMREdge **edges;
-      loop->getEdgeLoop(NULL, &edges, NULL);
+    // Create the mesh using the frontal algorithm
+    tri->frontal(options, fs);
 
-      // Get the number of nodes for the x/y edges
-      int nx = 0, ny = 0;
-      TMREdgeMesh *mesh;
-      edges[0]->getMesh(&mesh);
-      mesh->getMeshPoints(&nx, NULL, NULL);
-      edges[1]->getMesh(&mesh);
-      mesh->getMeshPoints(&ny, NULL, NULL);
+    // Free the degenerate triangles and reorder the mesh
+    if (num_degen > 0){
+      tri->removeDegenerateEdges(num_degen, degen);
+      delete [] degen;
+    }
 
-      // Compute the total number of points
-      num_points = nx*ny;
-      num_quads = (nx-1)*(ny-1);
+    if (options.write_pre_smooth_triangle){
+      char filename[256];
+      sprintf(filename, "pre_smooth_triangle%d.vtk",
+              face->getEntityId());
+      tri->writeToVTK(filename);
+    }
 
-      // Create the connectivity information
-      quads = new int[ 4*num_quads ];
+    // Extract the triangularization
+    int ntris, *mesh_tris;
+    tri->getMesh(&num_points, &ntris, &mesh_tris, &pts, &X);
+    tri->decref();
 
-      int *q = quads;
-      for ( int j = 0; j < ny-1; j++ ){
-        for ( int i = 0; i < nx-1; i++ ){
-          // Compute the connectivity as if the element is on the
-          // interior of the mesh
-          q[0] = num_fixed_pts + (i-1) + (j-1)*(nx-2);
-          q[1] = num_fixed_pts + i + (j-1)*(nx-2);
-          q[2] = num_fixed_pts + i + j*(nx-2);
-          q[3] = num_fixed_pts + (i-1) + j*(nx-2);
-
-          // Adjust the ordering for the nodes on the boundary
-          if (j == ny-2){
-            q[2] = 2*nx + ny - 4 - i;
-            q[3] = 2*nx + ny - 3 - i;
-          }
-          if (i == 0){
-            q[0] = 2*nx + 2*ny - 4 - j;
-            q[3] = 2*nx + 2*ny - 5 - j;
-          }
-          if (i == nx-2){
-            q[1] = nx - 1 + j;
-            q[2] = nx - 1 + j+1;
-          }
-          if (j == 0){
-            q[0] = i;
-            q[1] = i+1;
-          }
-          q += 4;
-        }
+    if (ntris == 0){
+      fprintf(stderr,
+              "TMRTriangularize warning: No triangles for mesh id %d\n",
+              face->getEntityId());
+    }
+
+    if (ntris > 0){
+      // Compute the triangle edges and neighbors in the dual mesh
+      int num_tri_edges;
+      int *tri_edges, *tri_neighbors, *dual_edges;
+      int *node_to_tri_ptr, *node_to_tris;
+      computeTriEdges(num_points, ntris, mesh_tris,
+                      &num_tri_edges, &tri_edges,
+                      &tri_neighbors, &dual_edges,
+                      &node_to_tri_ptr, &node_to_tris);
+
+      // Smooth the resulting triangular mesh
+      if (options.tri_smoothing_type == TMRMeshOptions::TMR_LAPLACIAN){
+        laplacianSmoothing(options.num_smoothing_steps, num_fixed_pts,
+                           num_tri_edges, tri_edges,
+                           num_points, pts, X, face);
+      }
+      else {
+        double alpha = 0.1;
+        springSmoothing(options.num_smoothing_steps, alpha,
+                        num_fixed_pts, num_tri_edges, tri_edges,
+                        num_points, pts, X, face);
       }
 
-      // Now set the parametric locations on the interior
-      pts = new double[ 2*num_points ];
-
-      // Copy the points from around the boundaries
-      for ( int i = 0; i < num_fixed_pts; i++ ){
-        pts[2*i] = params[2*i];
-        pts[2*i+1] = params[2*i+1];
-      }
-
-      // Use a transfinite interpolation to determine the parametric
-      // points where the interior nodes should be placed.
-      for ( int j = 1; j < ny-1; j++ ){
-        for ( int i = 1; i < nx-1; i++ ){
-          double u = 1.0*i/(nx-1);
-          double v = 1.0*j/(ny-1);
-
-          // Compute the weights on the corners
-          double c1 = (1.0 - u)*(1.0 - v);
-          double c2 = u*(1.0 - v);
-          double c3 = u*v;
-          double c4 = (1.0 - u)*v;
-
-          // Compute the weights on the curves
-          double w1 = (1.0 - v);
-          double w2 = u;
-          double w3 = v;
-          double w4 = (1.0 - u);
-
-          // New parametric point
-          int p = num_fixed_pts + i-1 + (j-1)*(nx-2);
-
-          // Boundary points that we're interpolating from
-          int p1 = i;
-          int p2 = nx-1 + j;
-          int p3 = 2*nx + ny - 3 - i;
-          int p4 = 2*nx + 2*ny - 4 - j;
-
-          // Evaluate the parametric points based on the transfinite
-          // interpolation
-          pts[2*p] =
-            ((w1*pts[2*p1] + w2*pts[2*p2] +
-              w3*pts[2*p3] + w4*pts[2*p4]) -
-             (c1*pts[0] + c2*pts[2*(nx-1)] +
-              c3*pts[2*(nx+ny-2)] + c4*pts[2*(2*nx+ny-3)]));
-
-          pts[2*p+1] =
-            ((w1*pts[2*p1+1] + w2*pts[2*p2+1] +
-              w3*pts[2*p3+1] + w4*pts[2*p4+1]) -
-             (c1*pts[1] + c2*pts[2*(nx-1)+1] +
-              c3*pts[2*(nx+ny-2)+1] + c4*pts[2*(2*nx+ny-3)+1]));
-        }
+      if (options.write_post_smooth_triangle){
+        char filename[256];
+        sprintf(filename, "post_smooth_triangle%d.vtk",
+                face->getEntityId());
+        writeTrisToVTK(filename, ntris, mesh_tris);
       }
 
-      // Allocate and evaluate the new physical point locations
-      X = new TMRPoint[ num_points ];
-      for ( int i = 0; i < num_points; i++ ){
-        face->evalPoint(pts[2*i], pts[2*i+1], &X[i]);
+      if (mesh_type == TMR_TRIANGLE){
+        num_tris = ntris;
+        tris = mesh_tris;
+
+        // Free the allocated data
+        delete [] tri_edges;
+        delete [] tri_neighbors;
+        delete [] dual_edges;
+        delete [] node_to_tri_ptr;
+        delete [] node_to_tris;
       }
-    }
-    else {
-      // Here mesh_type == TMR_TRIANGLE or TMR_UNSTRUCTURED
+      else { // mesh_type == TMR_UNSTRUCTURED
+        // Recombine the mesh into a quadrilateral mesh
+        if (ntris % 2 == 0){
+          recombine(ntris, mesh_tris, tri_neighbors,
+                    node_to_tri_ptr, node_to_tris,
+                    num_tri_edges, dual_edges, &num_quads, &quads, options);
+        }
+        else {
+          fprintf(stderr, "TMRFaceMesh error: Odd number of triangles, \
+cannot perform recombination\n");
+        }
 
-      // Create the triangularization class
-      TMRTriangularize *tri =
-        new TMRTriangularize(total_num_pts + nholes, params, nholes,
-                             nsegs, segments, face);
-      tri->incref();
+        // Free the triangular mesh data
+        delete [] mesh_tris;
+        delete [] tri_edges;
+        delete [] tri_neighbors;
+        delete [] dual_edges;
+        delete [] node_to_tri_ptr;
+        delete [] node_to_tris;
+
+        // Simplify the new quadrilateral mesh by removing points/quads
+        // with poor quality/connectivity
+        simplifyQuads();
 
-      // Set the frontal quality factor
-      tri->setFrontalQualityFactor(options.frontal_quality_factor);
+        // Simplify a second time (for good measure)
+        simplifyQuads();
+      }
 
-      if (options.write_init_domain_triangle){
+      if (options.write_pre_smooth_quad){
         char filename[256];
-        sprintf(filename, "init_domain_triangle%d.vtk",
+        sprintf(filename, "pre_smooth_quad%d.vtk",
                 face->getEntityId());
-        tri->writeToVTK(filename);
+        writeToVTK(filename);
       }
 
-      // Create the mesh using the frontal algorithm
-      tri->frontal(options, fs);
+      int *pts_to_quad_ptr;
+      int *pts_to_quads;
+      computeNodeToElems(num_points, num_quads, 4, quads,
+                         &pts_to_quad_ptr, &pts_to_quads);
 
-      // Free the degenerate triangles and reorder the mesh
-      if (num_degen > 0){
-        tri->removeDegenerateEdges(num_degen, degen);
-        delete [] degen;
-      }
+      // Smooth the mesh using a local optimization of node locations
+      quadSmoothing(options.num_smoothing_steps, num_fixed_pts,
+                    num_points, pts_to_quad_ptr, pts_to_quads,
+                    num_quads, quads, pts, X, face);
 
-      if (options.write_pre_smooth_triangle){
+      // Free the connectivity information
+      delete [] pts_to_quad_ptr;
+      delete [] pts_to_quads;
+
+      if (options.write_post_smooth_quad){
         char filename[256];
-        sprintf(filename, "pre_smooth_triangle%d.vtk",
+        sprintf(filename, "post_smooth_quad%d.vtk",
                 face->getEntityId());
-        tri->writeToVTK(filename);
+        writeToVTK(filename);
       }
 
-      // Extract the triangularization
-      int ntris, *mesh_tris;
-      tri->getMesh(&num_points, &ntris, &mesh_tris, &pts, &X);
-      tri->decref();
+      // Write out the dual of the final quadrilateral mesh
+      if (options.write_quad_dual){
+        int num_quad_edges;
+        int *quad_edges;
+        int *quad_neighbors, *quad_dual;
+        computeQuadEdges(num_points, num_quads, quads,
+                         &num_quad_edges, &quad_edges,
+                         &quad_neighbors, &quad_dual);
 
-      if (ntris == 0){
-        fprintf(stderr,
-                "TMRTriangularize warning: No triangles for mesh id %d\n",
+        char filename[256];
+        sprintf(filename, "quad_dual%d.vtk",
                 face->getEntityId());
+        writeDualToVTK(filename, 4, num_quads, quads,
+                       num_quad_edges, quad_dual, X);
+
+        delete [] quad_edges;
+        delete [] quad_neighbors;
+        delete [] quad_dual;
       }
+    }
+  }
 
-      if (ntris > 0){
-        // Compute the triangle edges and neighbors in the dual mesh
-        int num_tri_edges;
-        int *tri_edges, *tri_neighbors, *dual_edges;
-        int *node_to_tri_ptr, *node_to_tris;
-        computeTriEdges(num_points, ntris, mesh_tris,
-                        &num_tri_edges, &tri_edges,
-                        &tri_neighbors, &dual_edges,
-                        &node_to_tri_ptr, &node_to_tris);
-
-        // Smooth the resulting triangular mesh
-        if (options.tri_smoothing_type == TMRMeshOptions::TMR_LAPLACIAN){
-          laplacianSmoothing(options.num_smoothing_steps, num_fixed_pts,
-                             num_tri_edges, tri_edges,
-                             num_points, pts, X, face);
-        }
-        else {
-          double alpha = 0.1;
-          springSmoothing(options.num_smoothing_steps, alpha,
-                          num_fixed_pts, num_tri_edges, tri_edges,
-                          num_points, pts, X, face);
-        }
+  // Free the parameter/segment information
+  delete [] params;
+  delete [] segments;
 
-        if (options.write_post_smooth_triangle){
-          char filename[256];
-          sprintf(filename, "post_smooth_triangle%d.vtk",
-                  face->getEntityId());
-          writeTrisToVTK(filename, ntris, mesh_tris);
-        }
+  // Store the new mesh in the cache
+  if (cache){
+    int size = getPackedSize();
+    char *data = new char[ size ];
+    packMesh(data);
+    cache->store("face", key, data, size);
+    delete [] data;
+  }
+}
 
-        if (mesh_type == TMR_TRIANGLE){
-          num_tris = ntris;
-          tris = mesh_tris;
+/*
+  Compute the key that identifies the inputs to the face mesh
 
-          // Free the allocated data
-          delete [] tri_edges;
-          delete [] tri_neighbors;
-          delete [] dual_edges;
-          delete [] node_to_tri_ptr;
-          delete [] node_to_tris;
-        }
-        else { // mesh_type == TMR_UNSTRUCTURED
-          // Recombine the mesh into a quadrilateral mesh
-          if (ntris % 2 == 0){
-            recombine(ntris, mesh_tris, tri_neighbors,
-                      node_to_tri_ptr, node_to_tris,
-                      num_tri_edges, dual_edges, &num_quads, &quads, options);
-          }
-          else {
-            fprintf(stderr, "TMRFaceMesh error: Odd number of triangles, \
-cannot perform recombination\n");
-          }
+  The key depends on the meshing options, the points sampled over the
+  parametric range of the face, the feature size near the face, the
+  points along the bounding edge meshes and the mesh of the source
+  face (if any). The key is used by the mesh cache and to detect the
+  faces that must be remeshed.
+*/
+uint64_t TMRFaceMesh::computeMeshKey( TMRMeshOptions options,
+                                      TMRElementFeatureSize *fs ){
+  uint64_t key = TMR_HASH_OFFSET;
+
+  // Add the options that affect the mesh
+  int flags[4];
+  flags[0] = options.mesh_type_default;
+  flags[1] = options.num_smoothing_steps;
+  flags[2] = options.tri_smoothing_type;
+  flags[3] = face->getOrientation();
+  key = hash_bytes(key, flags, 4*sizeof(int));
+  key = hash_bytes(key, &options.frontal_quality_factor, sizeof(double));
+
+  // Sample the surface and the feature size
+  const int nsamples = TMR_CACHE_NUM_SAMPLES*TMR_CACHE_NUM_SAMPLES;
+  TMRPoint *Xs = new TMRPoint[ nsamples ];
+  double umin, vmin, umax, vmax;
+  face->getRange(&umin, &vmin, &umax, &vmax);
+  for ( int j = 0; j < TMR_CACHE_NUM_SAMPLES; j++ ){
+    double v = vmin + (vmax - vmin)*j/(TMR_CACHE_NUM_SAMPLES-1);
+    for ( int i = 0; i < TMR_CACHE_NUM_SAMPLES; i++ ){
+      double u = umin + (umax - umin)*i/(TMR_CACHE_NUM_SAMPLES-1);
+      face->evalPoint(u, v, &Xs[i + j*TMR_CACHE_NUM_SAMPLES]);
+    }
+  }
+  key = hash_bytes(key, Xs, nsamples*sizeof(TMRPoint));
+  key = hash_feature_size(key, fs, TMR_CACHE_NUM_SAMPLES,
+                          TMR_CACHE_NUM_SAMPLES, Xs);
+  delete [] Xs;
+
+  // Add the discretization of the edge loops
+  for ( int k = 0; k < face->getNumEdgeLoops(); k++ ){
+    TMREdgeLoop *loop;
+    face->getEdgeLoop(k, &loop);
+    int nedges;
+    TMREdge **edges;
+    const int *dir;
+    loop->getEdgeLoop(&nedges, &edges, &dir);
+    key = hash_bytes(key, &nedges, sizeof(int));
+    key = hash_bytes(key, dir, nedges*sizeof(int));
+    for ( int i = 0; i < nedges; i++ ){
+      TMREdgeMesh *mesh;
+      edges[i]->getMesh(&mesh);
+      int npts;
+      const double *tpts;
+      TMRPoint *Xpts;
+      mesh->getMeshPoints(&npts, &tpts, &Xpts);
+      key = hash_bytes(key, &npts, sizeof(int));
+      key = hash_bytes(key, tpts, npts*sizeof(double));
+      key = hash_bytes(key, Xpts, npts*sizeof(TMRPoint));
+    }
+  }
 
-          // Free the triangular mesh data
-          delete [] mesh_tris;
-          delete [] tri_edges;
-          delete [] tri_neighbors;
-          delete [] dual_edges;
-          delete [] node_to_tri_ptr;
-          delete [] node_to_tris;
+  // Add the mesh of the source face
+  int source_dir;
+  TMRFace *source;
+  face->getSource(&source_dir, NULL, &source);
+  if (source){
+    TMRFaceMesh *mesh;
+    source->getMesh(&mesh);
+    int size = mesh->getPackedSize();
+    char *data = new char[ size ];
+    mesh->packMesh(data);
+    key = hash_bytes(key, &source_dir, sizeof(int));
+    key = hash_bytes(key, data, size);
+    delete [] data;
+  }
 
-          // Simplify the new quadrilateral mesh by removing points/quads
-          // with poor quality/connectivity
-          simplifyQuads();
+  return key;
+}
 
-          // Simplify a second time (for good measure)
-          simplifyQuads();
-        }
+/*
+  Set the cache used to load and store the face mesh
+*/
+void TMRFaceMesh::setMeshCache( TMRMeshCache *_cache ){
+  if (_cache){ _cache->incref(); }
+  if (cache){ cache->decref(); }
+  cache = _cache;
+}
 
-        if (options.write_pre_smooth_quad){
-          char filename[256];
-          sprintf(filename, "pre_smooth_quad%d.vtk",
-                  face->getEntityId());
-          writeToVTK(filename);
-        }
+/*
+  Broadcast the face mesh from the root processor to all processors
+*/
+void TMRFaceMesh::broadcastMesh(){
+  int mpi_rank;
+  MPI_Comm_rank(comm, &mpi_rank);
 
-        int *pts_to_quad_ptr;
-        int *pts_to_quads;
-        computeNodeToElems(num_points, num_quads, 4, quads,
-                           &pts_to_quad_ptr, &pts_to_quads);
-
-        // Smooth the mesh using a local optimization of node locations
-        quadSmoothing(options.num_smoothing_steps, num_fixed_pts,
-                      num_points, pts_to_quad_ptr, pts_to_quads,
-                      num_quads, quads, pts, X, face);
-
-        // Free the connectivity information
-        delete [] pts_to_quad_ptr;
-        delete [] pts_to_quads;
-
-        if (options.write_post_smooth_quad){
-          char filename[256];
-          sprintf(filename, "post_smooth_quad%d.vtk",
-                  face->getEntityId());
-          writeToVTK(filename);
-        }
+  // Broadcast the number of points to all the processors
+  int temp[3];
+  temp[0] = num_points;
+  temp[1] = num_quads;
+  temp[2] = num_fixed_pts;
+  MPI_Bcast(temp, 3, MPI_INT, 0, comm);
+  num_points = temp[0];
+  num_quads = temp[1];
+  num_fixed_pts = temp[2];
+
+  if (mpi_rank != 0){
+    pts = new double[ 2*num_points ];
+    X = new TMRPoint[ num_points ];
+    quads = new int[ 4*num_quads ];
+  }
+
+  // Broadcast the parametric locations and points
+  MPI_Bcast(pts, 2*num_points, MPI_DOUBLE, 0, comm);
+  MPI_Bcast(X, num_points, TMRPoint_MPI_type, 0, comm);
+  MPI_Bcast(quads, 4*num_quads, MPI_INT, 0, comm);
+}
 
-        // Write out the dual of the final quadrilateral mesh
-        if (options.write_quad_dual){
-          int num_quad_edges;
-          int *quad_edges;
-          int *quad_neighbors, *quad_dual;
-          computeQuadEdges(num_points, num_quads, quads,
-                           &num_quad_edges, &quad_edges,
-                           &quad_neighbors, &quad_dual);
-
-          char filename[256];
-          sprintf(filename, "quad_dual%d.vtk",
-                  face->getEntityId());
-          writeDualToVTK(filename, 4, num_quads, quads,
-                         num_quad_edges, quad_dual, X);
-
-          delete [] quad_edges;
-          delete [] quad_neighbors;
-          delete [] quad_dual;
-        }
-      }
-    }
+/*
+  Get the number of bytes required to pack the face mesh
+*/
+int TMRFaceMesh::getPackedSize(){
+  return 5*sizeof(int) + 2*num_points*sizeof(double) +
+    num_points*sizeof(TMRPoint) + 4*num_quads*sizeof(int) +
+    3*num_tris*sizeof(int);
+}
 
-    // Free the parameter/segment information
-    delete [] params;
-    delete [] segments;
+/*
+  Pack the face mesh into the buffer so that it can be sent to other
+  processors. The buffer must be at least getPackedSize() bytes.
+*/
+void TMRFaceMesh::packMesh( char *buffer ){
+  int header[5];
+  header[0] = mesh_type;
+  header[1] = num_points;
+  header[2] = num_fixed_pts;
+  header[3] = num_quads;
+  header[4] = num_tris;
+  memcpy(buffer, header, 5*sizeof(int));
+  buffer += 5*sizeof(int);
+
+  memcpy(buffer, pts, 2*num_points*sizeof(double));
+  buffer += 2*num_points*sizeof(double);
+  buffer = pack_points(buffer, num_points, X);
+  if (num_quads > 0){
+    memcpy(buffer, quads, 4*num_quads*sizeof(int));
+    buffer += 4*num_quads*sizeof(int);
   }
+  if (num_tris > 0){
+    memcpy(buffer, tris, 3*num_tris*sizeof(int));
+  }
+}
 
-  if (mpi_size > 1){
-    // Broadcast the number of points to all the processors
-    int temp[3];
-    temp[0] = num_points;
-    temp[1] = num_quads;
-    temp[2] = num_fixed_pts;
-    MPI_Bcast(temp, 3, MPI_INT, 0, comm);
-    num_points = temp[0];
-    num_quads = temp[1];
-    num_fixed_pts = temp[2];
-
-    if (mpi_rank != 0){
-      pts = new double[ 2*num_points ];
-      X = new TMRPoint[ num_points ];
-      quads = new int[ 4*num_quads ];
-    }
-
-    // Broadcast the parametric locations and points
-    MPI_Bcast(pts, 2*num_points, MPI_DOUBLE, 0, comm);
-    MPI_Bcast(X, num_points, TMRPoint_MPI_type, 0, comm);
-    MPI_Bcast(quads, 4*num_quads, MPI_INT, 0, comm);
+/*
+  Unpack the face mesh from the buffer and return the number of bytes
+  that were read
+*/
+int TMRFaceMesh::unpackMesh( const char *buffer ){
+  int header[5];
+  memcpy(header, buffer, 5*sizeof(int));
+  mesh_type = (TMRFaceMeshType)header[0];
+  num_points = header[1];
+  num_fixed_pts = header[2];
+  num_quads = header[3];
+  num_tris = header[4];
+  const char *ptr = buffer + 5*sizeof(int);
+
+  pts = new double[ 2*num_points ];
+  memcpy(pts, ptr, 2*num_points*sizeof(double));
+  ptr += 2*num_points*sizeof(double);
+  X = new TMRPoint[ num_points ];
+  ptr = unpack_points(ptr, num_points, X);
+  if (num_quads > 0){
+    quads = new int[ 4*num_quads ];
+    memcpy(quads, ptr, 4*num_quads*sizeof(int));
+    ptr += 4*num_quads*sizeof(int);
   }
+  if (num_tris > 0){
+    tris = new int[ 3*num_tris ];
+    memcpy(tris, ptr, 3*num_tris*sizeof(int));
+    ptr += 3*num_tris*sizeof(int);
+  }
+
+  return ptr - buffer;
 }
 
 /*
@@ -2476,6 +3227,15 @@ int TMRFaceMesh::getNodeNums( const int **_vars ){
   return num_points;
 }
 
+/*
+  Reset the node numbers so that they are assigned again by the next
+  call to setNodeNums
+*/
+void TMRFaceMesh::resetNodeNums(){
+  if (vars){ delete [] vars; }
+  vars = NULL;
+}
+
 /*
   Get the number of fixed points that are not ordered by this surface
   mesh
@@ -4183,6 +4943,15 @@ int TMRVolumeMesh::getNodeNums( const int **_vars ){
   return num_points;
 }
 
+/*
+  Reset the node numbers so that they are assigned again by the next
+  call to setNodeNums
+*/
+void TMRVolumeMesh::resetNodeNums(){
+  if (vars){ delete [] vars; }
+  vars = NULL;
+}
+
 /*
   Mesh the given geometry and retrieve either a regular mesh
 */
@@ -4196,6 +4965,9 @@ TMRMesh::TMRMesh( MPI_Comm _comm, TMRModel *_geo ){
   comm = _comm;
   geo = _geo;
   geo->incref();
+  cache = NULL;
+  edge_keys = NULL;
+  face_keys = NULL;
 
   // Set the mesh properties
   num_nodes = 0;
@@ -4222,166 +4994,1009 @@ TMRMesh::~TMRMesh(){
     edges[i]->setMesh(NULL);
   }
 
-  int num_faces;
-  TMRFace **faces;
-  geo->getFaces(&num_faces, &faces);
+  int num_faces;
+  TMRFace **faces;
+  geo->getFaces(&num_faces, &faces);
+  for ( int i = 0; i < num_faces; i++ ){
+    TMRFaceMesh *mesh = NULL;
+    faces[i]->getMesh(&mesh);
+    if (mesh){ delete mesh; }
+    faces[i]->setMesh(NULL);
+  }
+
+  int num_volumes;
+  TMRVolume **volumes;
+  geo->getVolumes(&num_volumes, &volumes);
+  for ( int i = 0; i < num_volumes; i++ ){
+    TMRVolumeMesh *mesh = NULL;
+    volumes[i]->getMesh(&mesh);
+    if (mesh){ delete mesh; }
+    volumes[i]->setMesh(NULL);
+  }
+
+  geo->decref();
+  if (cache){ cache->decref(); }
+  if (edge_keys){ delete [] edge_keys; }
+  if (face_keys){ delete [] face_keys; }
+  if (quads){ delete [] quads; }
+  if (tris){ delete [] tris; }
+  if (hex){ delete [] hex; }
+  if (tet){ delete [] tet; }
+  if (X){ delete [] X; }
+}
+
+/*
+  Call the underlying mesher with the default options
+*/
+void TMRMesh::mesh( TMRMeshOptions options, double htarget ){
+  TMRElementFeatureSize *fs = new TMRElementFeatureSize(htarget);
+  fs->incref();
+  mesh(options, fs);
+  fs->decref();
+}
+
+/*
+  Set the directory used to cache the edge and face meshes
+
+  Meshes are loaded from the cache when the geometry, the boundary
+  discretization, the options and the sampled feature size are
+  unchanged. Otherwise they are computed and written to the cache.
+  The directory must already exist. Passing NULL disables the cache.
+*/
+void TMRMesh::setCacheDirectory( const char *dir ){
+  if (cache){ cache->decref(); }
+  cache = NULL;
+  if (dir){
+    cache = new TMRMeshCache(dir);
+    cache->incref();
+  }
+}
+
+/*
+  Clear the old mesh - if any exists
+*/
+void TMRMesh::resetMesh(){
+  // Reset the node numbers for the vertices
+  int num_vertices = 0;
+  TMRVertex **vertices;
+  geo->getVertices(&num_vertices, &vertices);
+  for ( int i = 0; i < num_vertices; i++ ){
+    vertices[i]->resetNodeNum();
+  }
+
+  // Reset the edge meshes
+  int num_edges;
+  TMREdge **edges;
+  geo->getEdges(&num_edges, &edges);
+  for ( int i = 0; i < num_edges; i++ ){
+    TMREdgeMesh *mesh = NULL;
+    edges[i]->getMesh(&mesh);
+    if (mesh){
+      mesh->decref();
+      edges[i]->setMesh(NULL);
+    }
+  }
+
+  // Reset the surface meshes
+  int num_faces;
+  TMRFace **faces;
+  geo->getFaces(&num_faces, &faces);
+  for ( int i = 0; i < num_faces; i++ ){
+    TMRFaceMesh *mesh = NULL;
+    faces[i]->getMesh(&mesh);
+    if (mesh){
+      mesh->decref();
+      faces[i]->setMesh(NULL);
+    }
+  }
+
+  // Reset the volume meshes (if any)
+  int num_volumes;
+  TMRVolume **volumes;
+  geo->getVolumes(&num_volumes, &volumes);
+  for ( int i = 0; i < num_volumes; i++ ){
+    TMRVolumeMesh *mesh = NULL;
+    volumes[i]->getMesh(&mesh);
+    if (mesh){
+      mesh->decref();
+      volumes[i]->setMesh(NULL);
+    }
+  }
+}
+
+/*
+  The data shared between the threads that mesh the edges or faces
+
+  Only one of edge_meshes or face_meshes is non-NULL. The dependents
+  of each entity (the entities that use it as their source) are
+  stored in the dep_ptr/deps arrays. The queue contains the entities
+  whose source mesh (if any) has been computed.
+*/
+class TMRMeshTaskArgs {
+ public:
+  TMRMeshOptions options;
+  TMRElementFeatureSize *fs;
+  TMREdgeMesh **edge_meshes;
+  TMRFaceMesh **face_meshes;
+
+  // The dependency graph
+  int num_tasks;
+  const int *dep_ptr, *deps;
+
+  // The ready queue and the number of completed tasks
+  int *queue;
+  int queue_start, queue_end;
+  int num_done;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+};
+
+/*
+  Build the graph of dependents from the source index of each entity
+
+  The source index is negative when the entity has no source. The
+  entities without a source are placed at the start of the queue.
+  The function returns the number of entities that can be reached
+  from the entities without a source. When this is less than the
+  number of entities, the source relationships contain a cycle.
+*/
+static int buildSourceGraph( int n, const int *source,
+                             int **_dep_ptr, int **_deps,
+                             int *queue, int *_num_roots ){
+  int *dep_ptr = new int[ n+1 ];
+  memset(dep_ptr, 0, (n+1)*sizeof(int));
+  for ( int i = 0; i < n; i++ ){
+    if (source[i] >= 0){
+      dep_ptr[source[i]+1]++;
+    }
+  }
+  for ( int i = 0; i < n; i++ ){
+    dep_ptr[i+1] += dep_ptr[i];
+  }
+
+  // Add the dependents in order and find the roots
+  int num_roots = 0;
+  int *deps = new int[ dep_ptr[n] ];
+  for ( int i = 0; i < n; i++ ){
+    if (source[i] >= 0){
+      deps[dep_ptr[source[i]]] = i;
+      dep_ptr[source[i]]++;
+    }
+    else {
+      queue[num_roots] = i;
+      num_roots++;
+    }
+  }
+  for ( int i = n; i > 0; i-- ){
+    dep_ptr[i] = dep_ptr[i-1];
+  }
+  dep_ptr[0] = 0;
+
+  // Count the entities that are reachable from the roots
+  int count = num_roots;
+  for ( int k = 0; k < count; k++ ){
+    int i = queue[k];
+    for ( int j = dep_ptr[i]; j < dep_ptr[i+1]; j++ ){
+      queue[count] = deps[j];
+      count++;
+    }
+  }
+
+  *_dep_ptr = dep_ptr;
+  *_deps = deps;
+  *_num_roots = num_roots;
+  return count;
+}
+
+/*
+  Mesh the entities from the ready queue
+
+  Each thread takes the next entity from the ready queue, computes its
+  mesh and then adds the entities that use it as a source to the
+  queue. The function returns once all the entities have been meshed.
+*/
+static void meshEntitiesFromQueue( TMRMeshTaskArgs *data ){
+  pthread_mutex_lock(&data->mutex);
+  while (data->num_done < data->num_tasks){
+    if (data->queue_start == data->queue_end){
+      pthread_cond_wait(&data->cond, &data->mutex);
+      continue;
+    }
+
+    // Take the next entity from the queue
+    int task = data->queue[data->queue_start];
+    data->queue_start++;
+    pthread_mutex_unlock(&data->mutex);
+
+    if (data->edge_meshes){
+      data->edge_meshes[task]->computeMesh(data->options, data->fs);
+    }
+    else {
+      data->face_meshes[task]->computeMesh(data->options, data->fs);
+    }
+
+    // Mark the entity as complete and queue its dependents
+    pthread_mutex_lock(&data->mutex);
+    data->num_done++;
+    for ( int j = data->dep_ptr[task]; j < data->dep_ptr[task+1]; j++ ){
+      data->queue[data->queue_end] = data->deps[j];
+      data->queue_end++;
+    }
+    pthread_cond_broadcast(&data->cond);
+  }
+  pthread_mutex_unlock(&data->mutex);
+}
+
+/*
+  The thread entry point for meshing the edges or faces
+*/
+static void *meshEntitiesThread( void *args ){
+  TMRSetPerfThreadTimers(0);
+  meshEntitiesFromQueue((TMRMeshTaskArgs*)args);
+  pthread_exit(NULL);
+  return NULL;
+}
+
+/*
+  Exchange the face meshes between all processors
+
+  Each processor packs the faces that it owns, in order, into a single
+  buffer. The buffers are gathered on all processors with one
+  collective and the faces owned by the other processors are unpacked.
+*/
+static void exchangeFaceMeshes( MPI_Comm comm, int num_faces,
+                                const int *owner,
+                                TMRFaceMesh **meshes ){
+  int mpi_rank, mpi_size;
+  MPI_Comm_rank(comm, &mpi_rank);
+  MPI_Comm_size(comm, &mpi_size);
+
+  // Pack the locally owned face meshes
+  int size = 0;
+  for ( int i = 0; i < num_faces; i++ ){
+    if (owner[i] == mpi_rank){
+      size += meshes[i]->getPackedSize();
+    }
+  }
+  char *send = new char[ size ];
+  for ( int i = 0, offset = 0; i < num_faces; i++ ){
+    if (owner[i] == mpi_rank){
+      meshes[i]->packMesh(&send[offset]);
+      offset += meshes[i]->getPackedSize();
+    }
+  }
+
+  // Gather the sizes and then the packed meshes from all processors
+  int *sizes = new int[ mpi_size ];
+  int *ptr = new int[ mpi_size+1 ];
+  MPI_Allgather(&size, 1, MPI_INT, sizes, 1, MPI_INT, comm);
+  ptr[0] = 0;
+  for ( int k = 0; k < mpi_size; k++ ){
+    ptr[k+1] = ptr[k] + sizes[k];
+  }
+  char *recv = new char[ ptr[mpi_size] ];
+  MPI_Allgatherv(send, size, MPI_BYTE,
+                 recv, sizes, ptr, MPI_BYTE, comm);
+  delete [] send;
+
+  // Unpack the meshes in the same order they were packed
+  int *offset = new int[ mpi_size ];
+  memcpy(offset, ptr, mpi_size*sizeof(int));
+  for ( int i = 0; i < num_faces; i++ ){
+    int k = owner[i];
+    if (k != mpi_rank){
+      offset[k] += meshes[i]->unpackMesh(&recv[offset[k]]);
+    }
+  }
+
+  delete [] sizes;
+  delete [] ptr;
+  delete [] offset;
+  delete [] recv;
+}
+
+/*
+  Mesh the edges or faces in parallel
+
+  The source index of each entity gives the only entity that must be
+  meshed first. The dependency graph is built up front and the
+  entities that do not depend on one another are meshed concurrently
+  on a pool of threads.
+
+  When owner is NULL, all the entities are meshed on the root
+  processor and broadcast. Otherwise, entity i is meshed on processor
+  owner[i] and the results are exchanged with a single collective.
+  This is only supported for faces, and each face must have the same
+  owner as its source. Each mesh is computed from the same data as in
+  the serial code, so the result is identical for any number of
+  threads or processors. The function returns a non-zero value,
+  without meshing anything, if the source relationships are cyclic.
+*/
+static int meshEntities( MPI_Comm comm, int num_threads,
+                         TMRMeshOptions options,
+                         TMRElementFeatureSize *fs,
+                         int num_tasks, const int *source,
+                         const int *owner,
+                         TMREdgeMesh **edge_meshes,
+                         TMRFaceMesh **face_meshes ){
+  int mpi_rank, mpi_size;
+  MPI_Comm_rank(comm, &mpi_rank);
+  MPI_Comm_size(comm, &mpi_size);
+
+  int *dep_ptr, *deps, num_roots;
+  int *queue = new int[ num_tasks ];
+  int count = buildSourceGraph(num_tasks, source, &dep_ptr, &deps,
+                               queue, &num_roots);
+  if (count < num_tasks){
+    delete [] dep_ptr;
+    delete [] deps;
+    delete [] queue;
+    return 1;
+  }
+
+  // Keep only the roots and count the entities meshed on this
+  // processor
+  int num_local = 0, num_local_roots = 0;
+  if (owner){
+    for ( int i = 0; i < num_tasks; i++ ){
+      if (owner[i] == mpi_rank){
+        num_local++;
+      }
+    }
+    for ( int k = 0; k < num_roots; k++ ){
+      if (owner[queue[k]] == mpi_rank){
+        queue[num_local_roots] = queue[k];
+        num_local_roots++;
+      }
+    }
+  }
+  else if (mpi_rank == 0){
+    num_local = num_tasks;
+    num_local_roots = num_roots;
+  }
+
+  if (num_local > 0){
+    TMRPerfBegin(TMR_PERF_MESH_ENTITIES);
+    TMRMeshTaskArgs args;
+    args.options = options;
+    args.fs = fs;
+    args.edge_meshes = edge_meshes;
+    args.face_meshes = face_meshes;
+    args.num_tasks = num_local;
+    args.dep_ptr = dep_ptr;
+    args.deps = deps;
+    args.queue = queue;
+    args.queue_start = 0;
+    args.queue_end = num_local_roots;
+    args.num_done = 0;
+    pthread_mutex_init(&args.mutex, NULL);
+    pthread_cond_init(&args.cond, NULL);
+
+    if (num_threads > num_local){
+      num_threads = num_local;
+    }
+    if (num_threads > 1){
+      pthread_t *threads = new pthread_t[ num_threads ];
+      for ( int k = 0; k < num_threads; k++ ){
+        pthread_create(&threads[k], NULL, meshEntitiesThread,
+                       (void*)&args);
+      }
+      for ( int k = 0; k < num_threads; k++ ){
+        pthread_join(threads[k], NULL);
+      }
+      delete [] threads;
+    }
+    else {
+      meshEntitiesFromQueue(&args);
+    }
+
+    pthread_mutex_destroy(&args.mutex);
+    pthread_cond_destroy(&args.cond);
+    TMRPerfEnd(TMR_PERF_MESH_ENTITIES);
+  }
+
+  delete [] dep_ptr;
+  delete [] deps;
+  delete [] queue;
+
+  if (owner){
+    exchangeFaceMeshes(comm, num_tasks, owner, face_meshes);
+  }
+  else if (mpi_size > 1){
+    // Broadcast the meshes in order from the root processor
+    for ( int i = 0; i < num_tasks; i++ ){
+      if (edge_meshes){
+        edge_meshes[i]->broadcastMesh();
+      }
+      else {
+        face_meshes[i]->broadcastMesh();
+      }
+    }
+  }
+
+  return 0;
+}
+
+/*
+  Compare the tree costs so that they are sorted in decreasing order
+*/
+static int compare_tree_costs( const void *avoid, const void *bvoid ){
+  const TMRIndexWeight *a = static_cast<const TMRIndexWeight*>(avoid);
+  const TMRIndexWeight *b = static_cast<const TMRIndexWeight*>(bvoid);
+
+  if (a->weight > b->weight){
+    return -1;
+  }
+  else if (a->weight < b->weight){
+    return 1;
+  }
+  return a->index - b->index;
+}
+
+/*
+  Assign the faces to processors based on the estimated meshing cost
+
+  A face and the faces that use it as a source (directly or not) form
+  a tree that is assigned to a single processor. The cost of a face is
+  estimated as the square of the number of segments along its
+  boundary, since the number of elements scales with (L/h)^2 where L
+  is the boundary length. The trees are assigned in order of
+  decreasing cost to the processor with the least work. Ties are
+  broken by the face index so that all processors compute the same
+  assignment.
+
+  Only the faces are distributed. The volumes are still meshed on
+  every processor, and distributing them in the same way is left as a
+  follow-up.
+*/
+static void assignFaceOwners( int mpi_size, int num_faces,
+                              TMRFace **faces, const int *source,
+                              int *owner ){
+  // Find the root of the source tree for each face
+  int *root = new int[ num_faces ];
+  for ( int i = 0; i < num_faces; i++ ){
+    owner[i] = 0;
+    root[i] = i;
+    for ( int k = 0; k < num_faces && source[root[i]] >= 0; k++ ){
+      root[i] = source[root[i]];
+    }
+  }
+
+  // Estimate the cost of each face and add it to its tree
+  double *cost = new double[ num_faces ];
+  memset(cost, 0, num_faces*sizeof(double));
+  for ( int i = 0; i < num_faces; i++ ){
+    int nsegs = 0;
+    for ( int k = 0; k < faces[i]->getNumEdgeLoops(); k++ ){
+      TMREdgeLoop *loop;
+      faces[i]->getEdgeLoop(k, &loop);
+      int nedges;
+      TMREdge **edges;
+      loop->getEdgeLoop(&nedges, &edges, NULL);
+      for ( int j = 0; j < nedges; j++ ){
+        TMREdgeMesh *mesh;
+        edges[j]->getMesh(&mesh);
+        int npts = 0;
+        if (mesh){
+          mesh->getMeshPoints(&npts, NULL, NULL);
+        }
+        if (npts > 1){
+          nsegs += npts-1;
+        }
+      }
+    }
+    cost[root[i]] += 1.0*nsegs*nsegs;
+  }
+
+  // Sort the trees by decreasing cost
+  int num_trees = 0;
+  TMRIndexWeight *trees = new TMRIndexWeight[ num_faces ];
   for ( int i = 0; i < num_faces; i++ ){
-    TMRFaceMesh *mesh = NULL;
-    faces[i]->getMesh(&mesh);
-    if (mesh){ delete mesh; }
-    faces[i]->setMesh(NULL);
+    if (root[i] == i){
+      trees[num_trees].index = i;
+      trees[num_trees].weight = cost[i];
+      num_trees++;
+    }
   }
-
-  int num_volumes;
-  TMRVolume **volumes;
-  geo->getVolumes(&num_volumes, &volumes);
-  for ( int i = 0; i < num_volumes; i++ ){
-    TMRVolumeMesh *mesh = NULL;
-    volumes[i]->getMesh(&mesh);
-    if (mesh){ delete mesh; }
-    volumes[i]->setMesh(NULL);
+  qsort(trees, num_trees, sizeof(TMRIndexWeight),
+        compare_tree_costs);
+
+  // Assign each tree to the processor with the least work
+  double *work = new double[ mpi_size ];
+  memset(work, 0, mpi_size*sizeof(double));
+  for ( int k = 0; k < num_trees; k++ ){
+    int rank = 0;
+    for ( int j = 1; j < mpi_size; j++ ){
+      if (work[j] < work[rank]){
+        rank = j;
+      }
+    }
+    work[rank] += trees[k].weight;
+    owner[trees[k].index] = rank;
+  }
+  for ( int i = 0; i < num_faces; i++ ){
+    owner[i] = owner[root[i]];
   }
 
-  geo->decref();
-  if (quads){ delete [] quads; }
-  if (tris){ delete [] tris; }
-  if (hex){ delete [] hex; }
-  if (tet){ delete [] tet; }
-  if (X){ delete [] X; }
+  delete [] root;
+  delete [] cost;
+  delete [] trees;
+  delete [] work;
 }
 
 /*
-  Call the underlying mesher with the default options
+  Create the mesh for the given volume and report any failure
 */
-void TMRMesh::mesh( TMRMeshOptions options, double htarget ){
-  TMRElementFeatureSize *fs = new TMRElementFeatureSize(htarget);
-  fs->incref();
-  mesh(options, fs);
-  fs->decref();
+static void meshVolume( MPI_Comm comm, TMRMeshOptions options,
+                        TMRVolume *volume, int index ){
+  TMRVolumeMesh *mesh = new TMRVolumeMesh(comm, volume);
+  int fail = mesh->mesh(options);
+  if (fail){
+    const char *attr = volume->getAttribute();
+    if (attr){
+      fprintf(stderr,
+              "TMRMesh: Volume meshing failed for object %s\n",
+              attr);
+    }
+    else {
+      fprintf(stderr,
+              "TMRMesh: Volume meshing failed for volume %d\n", index);
+    }
+  }
+  else {
+    volume->setMesh(mesh);
+  }
 }
 
 /*
-  Clear the old mesh - if any exists
+  Mesh the underlying geometry
 */
-void TMRMesh::resetMesh(){
-  // Reset the node numbers for the vertices
-  int num_vertices = 0;
-  TMRVertex **vertices;
-  geo->getVertices(&num_vertices, &vertices);
-  for ( int i = 0; i < num_vertices; i++ ){
-    vertices[i]->resetNodeNum();
+void TMRMesh::mesh( TMRMeshOptions options,
+                    TMRElementFeatureSize *fs ){
+  int mpi_rank, mpi_size;
+  MPI_Comm_rank(comm, &mpi_rank);
+  MPI_Comm_size(comm, &mpi_size);
+
+  // Reset the meshes within the mesh
+  resetMesh();
+  if (cache){
+    cache->resetStatistics();
   }
 
-  // Reset the edge meshes
+  // Mesh the curves
   int num_edges;
   TMREdge **edges;
   geo->getEdges(&num_edges, &edges);
-  for ( int i = 0; i < num_edges; i++ ){
-    TMREdgeMesh *mesh = NULL;
-    edges[i]->getMesh(&mesh);
-    if (mesh){
-      mesh->decref();
-      edges[i]->setMesh(NULL);
+  int edges_meshed = 0;
+  if (options.num_threads > 1 && num_edges > 1){
+    // Create all the edge meshes and find the source edge indices
+    TMREdgeMesh **meshes = new TMREdgeMesh*[ num_edges ];
+    int *source = new int[ num_edges ];
+    for ( int i = 0; i < num_edges; i++ ){
+      meshes[i] = new TMREdgeMesh(comm, edges[i]);
+      meshes[i]->setMeshCache(cache);
+      TMREdge *src;
+      edges[i]->getSource(&src);
+      source[i] = -1;
+      if (src && src != edges[i]){
+        source[i] = geo->getEdgeIndex(src);
+      }
+    }
+
+    // Set the meshes so that each edge can find its source
+    for ( int i = 0; i < num_edges; i++ ){
+      edges[i]->setMesh(meshes[i]);
+    }
+
+    if (meshEntities(comm, options.num_threads, options, fs,
+                     num_edges, source, NULL, meshes, NULL) == 0){
+      edges_meshed = 1;
+    }
+    else {
+      fprintf(stderr,
+              "TMRMesh: Cyclic source edges, meshing edges serially\n");
+      for ( int i = 0; i < num_edges; i++ ){
+        edges[i]->setMesh(NULL);
+        delete meshes[i];
+      }
     }
+    delete [] meshes;
+    delete [] source;
   }
 
-  // Reset the surface meshes
+  if (!edges_meshed){
+    for ( int i = 0; i < num_edges; i++ ){
+      TMREdgeMesh *mesh = NULL;
+      edges[i]->getMesh(&mesh);
+      if (!mesh){
+        mesh = new TMREdgeMesh(comm, edges[i]);
+        mesh->setMeshCache(cache);
+        mesh->mesh(options, fs);
+        edges[i]->setMesh(mesh);
+      }
+    }
+  }
+
+  // Mesh the surface
   int num_faces;
   TMRFace **faces;
   geo->getFaces(&num_faces, &faces);
-  for ( int i = 0; i < num_faces; i++ ){
-    TMRFaceMesh *mesh = NULL;
-    faces[i]->getMesh(&mesh);
-    if (mesh){
-      mesh->decref();
-      faces[i]->setMesh(NULL);
+  int faces_meshed = 0;
+  if ((options.num_threads > 1 || mpi_size > 1) && num_faces > 1){
+    // Create all the face meshes and find the source face indices.
+    // The mesh type depends only on the edge meshes.
+    TMRFaceMesh **meshes = new TMRFaceMesh*[ num_faces ];
+    int *source = new int[ num_faces ];
+    for ( int i = 0; i < num_faces; i++ ){
+      meshes[i] = new TMRFaceMesh(comm, faces[i]);
+      meshes[i]->setMeshCache(cache);
+      meshes[i]->selectMeshType(options);
+      TMRFace *src;
+      faces[i]->getSource(NULL, NULL, &src);
+      source[i] = -1;
+      if (src){
+        source[i] = geo->getFaceIndex(src);
+      }
+    }
+
+    // Set the meshes so that each target face can find its source
+    for ( int i = 0; i < num_faces; i++ ){
+      faces[i]->setMesh(meshes[i]);
+    }
+
+    // Distribute the faces between the processors by estimated cost
+    int *owner = NULL;
+    if (mpi_size > 1){
+      owner = new int[ num_faces ];
+      assignFaceOwners(mpi_size, num_faces, faces, source, owner);
+    }
+
+    if (meshEntities(comm, options.num_threads, options, fs,
+                     num_faces, source, owner, NULL, meshes) == 0){
+      faces_meshed = 1;
+    }
+    else {
+      fprintf(stderr,
+              "TMRMesh: Cyclic source faces, meshing faces serially\n");
+      for ( int i = 0; i < num_faces; i++ ){
+        faces[i]->setMesh(NULL);
+        delete meshes[i];
+      }
     }
+    delete [] meshes;
+    delete [] source;
+    if (owner){ delete [] owner; }
   }
 
-  // Reset the volume meshes (if any)
+  if (!faces_meshed){
+    for ( int i = 0; i < num_faces; i++ ){
+      TMRFaceMesh *mesh = NULL;
+      faces[i]->getMesh(&mesh);
+      if (!mesh){
+        mesh = new TMRFaceMesh(comm, faces[i]);
+        mesh->setMeshCache(cache);
+        mesh->mesh(options, fs);
+        faces[i]->setMesh(mesh);
+      }
+    }
+  }
+
+  // Report the number of edge and face meshes loaded from the cache
+  if (cache && options.write_mesh_cache_statistics){
+    int counts[2];
+    cache->getStatistics(&counts[0], &counts[1]);
+    MPI_Allreduce(MPI_IN_PLACE, counts, 2, MPI_INT, MPI_SUM, comm);
+    if (mpi_rank == 0){
+      printf("TMRMesh: Mesh cache hits: %d misses: %d\n",
+             counts[0], counts[1]);
+    }
+  }
+
+  // Update target/source relationships
   int num_volumes;
   TMRVolume **volumes;
   geo->getVolumes(&num_volumes, &volumes);
   for ( int i = 0; i < num_volumes; i++ ){
     TMRVolumeMesh *mesh = NULL;
     volumes[i]->getMesh(&mesh);
-    if (mesh){
-      mesh->decref();
-      volumes[i]->setMesh(NULL);
+    if (!mesh){
+      meshVolume(comm, options, volumes[i], i);
     }
   }
+
+  // Record the keys that identify the inputs to each edge and face
+  // mesh so that remesh() can detect the changes
+  if (edge_keys){ delete [] edge_keys; }
+  if (face_keys){ delete [] face_keys; }
+  edge_keys = new uint64_t[ num_edges ];
+  face_keys = new uint64_t[ num_faces ];
+  for ( int i = 0; i < num_edges; i++ ){
+    TMREdgeMesh *mesh = NULL;
+    edges[i]->getMesh(&mesh);
+    edge_keys[i] = mesh->computeMeshKey(fs);
+  }
+  for ( int i = 0; i < num_faces; i++ ){
+    TMRFaceMesh *mesh = NULL;
+    faces[i]->getMesh(&mesh);
+    face_keys[i] = mesh->computeMeshKey(options, fs);
+  }
+
+  // Order the nodes and count the elements
+  finalizeMesh(options);
 }
 
 /*
-  Mesh the underlying geometry
+  Remesh only the parts of the geometry affected by a change in the
+  feature size, the options or the sources
+
+  The key for each edge mesh is recomputed from the geometry sampled
+  along the edge and the feature size near the edge. Edges are visited
+  so that each source edge is checked before its targets. Edges with a
+  new key are remeshed. The faces are then checked in the same way.
+  The face key includes the bounding edge meshes and the source face
+  mesh, so a face is remeshed whenever one of these changes. Any
+  volume bounded by a remeshed face is remeshed as well.
+
+  The node numbers of the entities that are ordered before the first
+  changed entity are kept. The remaining entities are renumbered.
+  The face and volume meshes copy the node numbers on their boundary,
+  so a change to any edge renumbers all of the faces and volumes, and
+  a change to any face renumbers all of the volumes. Only the meshes
+  are reused in that case, not the global node numbering. When there
+  is no existing mesh, the whole geometry is meshed.
+
+  The result is the same as a full mesh as long as the keys capture
+  every change. This holds for the feature size classes in this file.
+  A derived feature size that does not override addParametersToKey()
+  is only sampled, so a change between the samples may be missed.
 */
-void TMRMesh::mesh( TMRMeshOptions options,
-                    TMRElementFeatureSize *fs ){
-  // Reset the meshes within the mesh
-  resetMesh();
+void TMRMesh::remesh( TMRMeshOptions options,
+                      TMRElementFeatureSize *fs ){
+  if (!edge_keys || !face_keys){
+    mesh(options, fs);
+    return;
+  }
 
-  // Mesh the curves
-  int num_edges;
+  int mpi_rank;
+  MPI_Comm_rank(comm, &mpi_rank);
+
+  int num_edges, num_faces, num_volumes;
   TMREdge **edges;
+  TMRFace **faces;
+  TMRVolume **volumes;
   geo->getEdges(&num_edges, &edges);
+  geo->getFaces(&num_faces, &faces);
+  geo->getVolumes(&num_volumes, &volumes);
+
+  // Find the order in which the edges and faces are visited such that
+  // each source is visited before its targets
+  int *edge_source = new int[ num_edges ];
   for ( int i = 0; i < num_edges; i++ ){
+    TMREdge *src;
+    edges[i]->getSource(&src);
+    edge_source[i] = -1;
+    if (src && src != edges[i]){
+      edge_source[i] = geo->getEdgeIndex(src);
+    }
+  }
+  int *face_source = new int[ num_faces ];
+  for ( int i = 0; i < num_faces; i++ ){
+    TMRFace *src;
+    faces[i]->getSource(NULL, NULL, &src);
+    face_source[i] = -1;
+    if (src){
+      face_source[i] = geo->getFaceIndex(src);
+    }
+  }
+
+  int *dep_ptr, *deps, num_roots;
+  int *edge_order = new int[ num_edges ];
+  int edge_count = buildSourceGraph(num_edges, edge_source,
+                                    &dep_ptr, &deps,
+                                    edge_order, &num_roots);
+  delete [] dep_ptr;
+  delete [] deps;
+  int *face_order = new int[ num_faces ];
+  int face_count = buildSourceGraph(num_faces, face_source,
+                                    &dep_ptr, &deps,
+                                    face_order, &num_roots);
+  delete [] dep_ptr;
+  delete [] deps;
+  delete [] edge_source;
+  delete [] face_source;
+
+  if (edge_count < num_edges || face_count < num_faces){
+    delete [] edge_order;
+    delete [] face_order;
+    mesh(options, fs);
+    return;
+  }
+
+  if (cache){
+    cache->resetStatistics();
+  }
+
+  // Remesh the edges whose inputs have changed
+  int num_changed_edges = 0, first_edge = num_edges;
+  for ( int k = 0; k < num_edges; k++ ){
+    int i = edge_order[k];
     TMREdgeMesh *mesh = NULL;
     edges[i]->getMesh(&mesh);
-    if (!mesh){
+    uint64_t key = mesh->computeMeshKey(fs);
+    if (key != edge_keys[i]){
+      delete mesh;
       mesh = new TMREdgeMesh(comm, edges[i]);
+      mesh->setMeshCache(cache);
       mesh->mesh(options, fs);
       edges[i]->setMesh(mesh);
+      edge_keys[i] = key;
+      num_changed_edges++;
+      if (i < first_edge){ first_edge = i; }
     }
   }
 
-  // Mesh the surface
-  int num_faces;
-  TMRFace **faces;
-  geo->getFaces(&num_faces, &faces);
-  for ( int i = 0; i < num_faces; i++ ){
+  // Remesh the faces whose inputs have changed
+  int num_changed_faces = 0, first_face = num_faces;
+  int *face_changed = new int[ num_faces ];
+  memset(face_changed, 0, num_faces*sizeof(int));
+  for ( int k = 0; k < num_faces; k++ ){
+    int i = face_order[k];
     TMRFaceMesh *mesh = NULL;
     faces[i]->getMesh(&mesh);
-    if (!mesh){
+    uint64_t key = mesh->computeMeshKey(options, fs);
+    if (key != face_keys[i]){
+      delete mesh;
       mesh = new TMRFaceMesh(comm, faces[i]);
+      mesh->setMeshCache(cache);
       mesh->mesh(options, fs);
       faces[i]->setMesh(mesh);
+      face_keys[i] = key;
+      face_changed[i] = 1;
+      num_changed_faces++;
+      if (i < first_face){ first_face = i; }
     }
   }
 
-  // Update target/source relationships
-  int num_volumes;
-  TMRVolume **volumes;
-  geo->getVolumes(&num_volumes, &volumes);
+  // Remesh the volumes bounded by a remeshed face
+  int num_changed_volumes = 0, first_volume = num_volumes;
   for ( int i = 0; i < num_volumes; i++ ){
+    int nfaces;
+    TMRFace **vfaces;
+    volumes[i]->getFaces(&nfaces, &vfaces, NULL);
+    int changed = 0;
+    for ( int j = 0; j < nfaces; j++ ){
+      if (face_changed[geo->getFaceIndex(vfaces[j])]){
+        changed = 1;
+        break;
+      }
+    }
+    if (changed){
+      TMRVolumeMesh *mesh = NULL;
+      volumes[i]->getMesh(&mesh);
+      if (mesh){ delete mesh; }
+      volumes[i]->setMesh(NULL);
+      meshVolume(comm, options, volumes[i], i);
+      num_changed_volumes++;
+      if (i < first_volume){ first_volume = i; }
+    }
+  }
+
+  delete [] edge_order;
+  delete [] face_order;
+  delete [] face_changed;
+
+  // Report the number of edge and face meshes loaded from the cache
+  if (cache && options.write_mesh_cache_statistics){
+    int counts[2];
+    cache->getStatistics(&counts[0], &counts[1]);
+    MPI_Allreduce(MPI_IN_PLACE, counts, 2, MPI_INT, MPI_SUM, comm);
+    if (mpi_rank == 0){
+      printf("TMRMesh: Mesh cache hits: %d misses: %d\n",
+             counts[0], counts[1]);
+    }
+  }
+
+  // Reset the node numbers from the first changed entity onwards.
+  // The face and volume meshes copy the numbers of the nodes on their
+  // boundary, so they are renumbered when any edge or face changes.
+  if (num_changed_edges > 0){
+    first_face = 0;
+    first_volume = 0;
+  }
+  else if (num_changed_faces > 0){
+    first_volume = 0;
+  }
+  for ( int i = first_edge; i < num_edges; i++ ){
+    TMREdgeMesh *mesh = NULL;
+    edges[i]->getMesh(&mesh);
+    mesh->resetNodeNums();
+  }
+  for ( int i = first_face; i < num_faces; i++ ){
+    TMRFaceMesh *mesh = NULL;
+    faces[i]->getMesh(&mesh);
+    mesh->resetNodeNums();
+  }
+  for ( int i = first_volume; i < num_volumes; i++ ){
     TMRVolumeMesh *mesh = NULL;
     volumes[i]->getMesh(&mesh);
-    if (!mesh){
-      mesh = new TMRVolumeMesh(comm, volumes[i]);
-      int fail = mesh->mesh(options);
-      if (fail){
-        const char *attr = volumes[i]->getAttribute();
-        if (attr){
-          fprintf(stderr,
-                  "TMRMesh: Volume meshing failed for object %s\n",
-                  attr);
-        }
-        else {
-          fprintf(stderr,
-                  "TMRMesh: Volume meshing failed for volume %d\n", i);
-        }
-      }
-      else {
-        volumes[i]->setMesh(mesh);
-      }
+    if (mesh){
+      mesh->resetNodeNums();
     }
   }
 
-  // Now that we're done meshing, go ahead and uniquely order
-  // the nodes in the mesh
+  // Order the new nodes and count the elements
+  finalizeMesh(options);
+}
+
+/*
+  Order the nodes in the mesh and count the elements
+
+  The nodes are numbered in the order: vertices, edges, faces and
+  volumes. Entities that already have node numbers keep them, and the
+  numbering continues after the largest existing node number. The
+  global arrays are freed so that they are created again when needed.
+*/
+void TMRMesh::finalizeMesh( TMRMeshOptions options ){
+  // Free the global arrays from any previous mesh
+  if (quads){ delete [] quads; }
+  if (tris){ delete [] tris; }
+  if (hex){ delete [] hex; }
+  if (tet){ delete [] tet; }
+  if (X){ delete [] X; }
+  quads = NULL;
+  tris = NULL;
+  hex = NULL;
+  tet = NULL;
+  X = NULL;
+
+  int num_edges, num_faces, num_volumes;
+  TMREdge **edges;
+  TMRFace **faces;
+  TMRVolume **volumes;
+  geo->getEdges(&num_edges, &edges);
+  geo->getFaces(&num_faces, &faces);
+  geo->getVolumes(&num_volumes, &volumes);
+
+  // Find the next node number after those that have been kept
   int num = 0;
   int num_vertices = 0;
   TMRVertex **vertices;
   geo->getVertices(&num_vertices, &vertices);
+  for ( int i = 0; i < num_vertices; i++ ){
+    int var = -1;
+    vertices[i]->getNodeNum(&var);
+    if (var+1 > num){ num = var+1; }
+  }
+  for ( int i = 0; i < num_edges; i++ ){
+    TMREdgeMesh *mesh = NULL;
+    edges[i]->getMesh(&mesh);
+    const int *vars;
+    int npts = mesh->getNodeNums(&vars);
+    for ( int j = 0; vars && j < npts; j++ ){
+      if (vars[j]+1 > num){ num = vars[j]+1; }
+    }
+  }
+  for ( int i = 0; i < num_faces; i++ ){
+    TMRFaceMesh *mesh = NULL;
+    faces[i]->getMesh(&mesh);
+    const int *vars;
+    int npts = mesh->getNodeNums(&vars);
+    for ( int j = 0; vars && j < npts; j++ ){
+      if (vars[j]+1 > num){ num = vars[j]+1; }
+    }
+  }
+  for ( int i = 0; i < num_volumes; i++ ){
+    TMRVolumeMesh *mesh = NULL;
+    volumes[i]->getMesh(&mesh);
+    const int *vars;
+    int npts = mesh->getNodeNums(&vars);
+    for ( int j = 0; vars && j < npts; j++ ){
+      if (vars[j]+1 > num){ num = vars[j]+1; }
+    }
+  }
+
+  // Go ahead and uniquely order the remaining nodes in the mesh
   for ( int i = 0; i < num_vertices; i++ ){
     vertices[i]->setNodeNum(&num);
   }
@@ -4651,6 +6266,34 @@ void TMRMesh::getHexConnectivity( int *_nhex, const int **_hex ){
   if (_hex){ *_hex = hex; }
 }
 
+/*
+  Add the memory used by the global mesh arrays to the memory usage
+  object. The meshes stored on the geometric entities are not
+  included.
+*/
+void TMRMesh::getMemoryUsage( TMRMemoryUsage *usage ){
+  size_t bytes = 0;
+  if (X){
+    bytes = num_nodes*sizeof(TMRPoint);
+  }
+  usage->add("mesh_points", bytes);
+
+  bytes = 0;
+  if (quads){
+    bytes += 4*num_quads*sizeof(int);
+  }
+  if (tris){
+    bytes += 3*num_tris*sizeof(int);
+  }
+  if (hex){
+    bytes += 8*num_hex*sizeof(int);
+  }
+  if (tet){
+    bytes += 4*num_tet*sizeof(int);
+  }
+  usage->add("mesh_conn", bytes);
+}
+
 /*
   Print out the mesh to a VTK file
 */
@@ -48,6 +48,7 @@ class TMRMeshOptions {
     triangularize_print_level = 0;
     triangularize_print_iter = 1000;
     write_mesh_quality_histogram = 0;
+    write_mesh_cache_statistics = 0;
     
     // Set the default meshing options
     mesh_type_default = TMR_STRUCTURED;
@@ -64,6 +65,9 @@ class TMRMeshOptions {
     write_pre_smooth_quad = 0;
     write_post_smooth_quad = 0;
     write_quad_dual = 0;
+
+    // Mesh the edges and faces serially by default
+    num_threads = 1;
   }
 
   // Set the print level for the triangularize code
@@ -73,6 +77,9 @@ class TMRMeshOptions {
   // Set the write level for the quality histogram
   int write_mesh_quality_histogram;
 
+  // Print the number of cache hits and misses after meshing
+  int write_mesh_cache_statistics;
+
   // Options to control the meshing algorithm
   TMRFaceMeshType mesh_type_default;
   int num_smoothing_steps;
@@ -88,6 +95,9 @@ class TMRMeshOptions {
   int write_pre_smooth_quad;
   int write_post_smooth_quad;
   int write_quad_dual;
+
+  // The number of threads used to mesh independent edges and faces
+  int num_threads;
 };
 
 /*
@@ -99,6 +109,11 @@ class TMRElementFeatureSize : public TMREntity {
   virtual ~TMRElementFeatureSize();
   virtual double getFeatureSize( TMRPoint pt );
 
+  // Add the parameters that set the feature size within a box to a
+  // hash key. Returns zero if the parameters are not available.
+  virtual int addParametersToKey( TMRPoint lower, TMRPoint upper,
+                                  uint64_t *key );
+
  protected:
   // The min local feature size
   double hmin;
@@ -113,6 +128,8 @@ class TMRLinearElementSize : public TMRElementFeatureSize {
                         double c, double _ax, double _ay, double _az );
   ~TMRLinearElementSize();
   double getFeatureSize( TMRPoint pt );
+  int addParametersToKey( TMRPoint lower, TMRPoint upper,
+                          uint64_t *key );
 
  private:
   double hmax;
@@ -129,6 +146,8 @@ class TMRBoxFeatureSize : public TMRElementFeatureSize {
   ~TMRBoxFeatureSize();
   void addBox( TMRPoint p1, TMRPoint p2, double h );
   double getFeatureSize( TMRPoint pt );
+  int addParametersToKey( TMRPoint lower, TMRPoint upper,
+                          uint64_t *key );
 
  private:
   // Maximum feature size
@@ -140,6 +159,9 @@ class TMRBoxFeatureSize : public TMRElementFeatureSize {
     // Check whether the box contains a point
     int contains( TMRPoint p );
 
+    // Check whether the box intersects the box [lower, upper]
+    int intersects( TMRPoint lower, TMRPoint upper );
+
     // Data for the box and its location
     TMRPoint m; // Center of the box
     TMRPoint d; // Half-edge length of each box
@@ -185,6 +207,40 @@ class TMRBoxFeatureSize : public TMRElementFeatureSize {
   } *root;
 };
 
+/*
+  An on-disk cache of edge and face meshes
+
+  Each mesh is stored in a separate binary file in the cache
+  directory. The file name contains a 64-bit hash of the data that
+  the mesh depends on: the sampled geometry, the boundary
+  discretization, the meshing options and the feature size near the
+  entity. A cached mesh is only used when its size matches the size
+  recorded in the file. The cache counts the meshes that were loaded
+  (hits) and the meshes that had to be computed (misses).
+*/
+class TMRMeshCache : public TMREntity {
+ public:
+  TMRMeshCache( const char *_dir );
+  ~TMRMeshCache();
+
+  // Load or store the packed mesh data with the given key
+  char* load( const char *prefix, uint64_t key, int *size,
+              int (*getUnpackedSize)( const char*, int ) );
+  void store( const char *prefix, uint64_t key,
+              const char *data, int size );
+
+  // Get/reset the number of cache hits and misses
+  void getStatistics( int *_num_hits, int *_num_misses );
+  void resetStatistics();
+
+ private:
+  // Get the file name for the given key
+  void getFileName( const char *prefix, uint64_t key, char *name );
+
+  char *dir;
+  int num_hits, num_misses;
+};
+
 /*
   The mesh for a geometric curve
 */
@@ -203,9 +259,27 @@ class TMREdgeMesh : public TMREntity {
   void mesh( TMRMeshOptions options, 
              TMRElementFeatureSize *fs );
 
+  // Compute the mesh on this processor and broadcast it from the
+  // root. These are the parts of mesh() used by threaded meshing.
+  void computeMesh( TMRMeshOptions options,
+                    TMRElementFeatureSize *fs );
+  void broadcastMesh();
+
+  // Pack/unpack the mesh to store it in the mesh cache
+  int getPackedSize();
+  void packMesh( char *buffer );
+  int unpackMesh( const char *buffer );
+
+  // Set the cache used to load/store the mesh
+  void setMeshCache( TMRMeshCache *_cache );
+
+  // Compute a key that identifies the inputs to the mesh
+  uint64_t computeMeshKey( TMRElementFeatureSize *fs );
+
   // Order the mesh points uniquely
   int setNodeNums( int *num );
   int getNodeNums( const int **_vars );
+  void resetNodeNums();
 
   // Retrieve the mesh points
   void getMeshPoints( int *_npts, const double **_pts, TMRPoint **X );
@@ -213,6 +287,7 @@ class TMREdgeMesh : public TMREntity {
  private:
   MPI_Comm comm;
   TMREdge *edge;
+  TMRMeshCache *cache;
 
   // The parametric locations of the points that are obtained from
   // meshing the curve
@@ -239,6 +314,27 @@ class TMRFaceMesh : public TMREntity {
   void mesh( TMRMeshOptions options, 
              TMRElementFeatureSize *fs );
 
+  // Select the mesh type, compute the mesh on this processor and
+  // broadcast it from the root. These are the parts of mesh() used
+  // by threaded meshing.
+  void selectMeshType( TMRMeshOptions options );
+  void computeMesh( TMRMeshOptions options,
+                    TMRElementFeatureSize *fs );
+  void broadcastMesh();
+
+  // Pack/unpack the mesh to exchange it between processors or to
+  // store it in the mesh cache
+  int getPackedSize();
+  void packMesh( char *buffer );
+  int unpackMesh( const char *buffer );
+
+  // Set the cache used to load/store the mesh
+  void setMeshCache( TMRMeshCache *_cache );
+
+  // Compute a key that identifies the inputs to the mesh
+  uint64_t computeMeshKey( TMRMeshOptions options,
+                           TMRElementFeatureSize *fs );
+
   // Return the type of the underlying mesh
   TMRFaceMeshType getMeshType(){
     return mesh_type;
@@ -250,6 +346,7 @@ class TMRFaceMesh : public TMREntity {
   // Order the mesh points uniquely
   int setNodeNums( int *num );
   int getNodeNums( const int **_vars );
+  void resetNodeNums();
   int getNumFixedPoints();
 
   // Retrieve the local connectivity from this surface mesh
@@ -306,6 +403,7 @@ class TMRFaceMesh : public TMREntity {
   // The underlying surface
   MPI_Comm comm;
   TMRFace *face;
+  TMRMeshCache *cache;
 
   // The actual type of mesh used to mesh the structure
   TMRFaceMeshType mesh_type;
@@ -350,6 +448,7 @@ class TMRVolumeMesh : public TMREntity {
   // Order the mesh points uniquely
   int setNodeNums( int *num );
   int getNodeNums( const int **_vars );
+  void resetNodeNums();
 
   // Write the volume mesh to a VTK file
   void writeToVTK( const char *filename );
@@ -409,6 +508,13 @@ class TMRMesh : public TMREntity {
   void mesh( TMRMeshOptions options, 
              TMRElementFeatureSize *fs );
 
+  // Remesh only the entities affected by a change in the inputs
+  void remesh( TMRMeshOptions options,
+               TMRElementFeatureSize *fs );
+
+  // Set the directory used to cache the edge and face meshes
+  void setCacheDirectory( const char *dir );
+
   // Write the mesh to a VTK file
   void writeToVTK( const char *filename, 
                    int flag=(TMRMesh::TMR_QUAD | TMRMesh::TMR_HEX) );
@@ -427,6 +533,9 @@ class TMRMesh : public TMREntity {
   // Create a topology object (with underlying mesh geometry)
   TMRModel* createModelFromMesh();
 
+  // Add the memory used by the mesh arrays
+  void getMemoryUsage( TMRMemoryUsage *usage );
+
  private:
   // Allocate and initialize the underlying mesh
   void initMesh( int count_nodes=0 );
@@ -434,10 +543,19 @@ class TMRMesh : public TMREntity {
   // Reset the mesh
   void resetMesh();
 
+  // Number the nodes, count the elements and reset the global arrays
+  void finalizeMesh( TMRMeshOptions options );
+
   // The underlying geometry object
   MPI_Comm comm;
   TMRModel *geo;
 
+  // The on-disk cache for the edge and face meshes (if any)
+  TMRMeshCache *cache;
+
+  // The keys identifying the inputs to each edge and face mesh
+  uint64_t *edge_keys, *face_keys;
+
   // The number of nodes/positions in the mesh
   int num_nodes;
   TMRPoint *X;  
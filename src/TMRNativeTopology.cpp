@@ -20,6 +20,7 @@
 
 #include "TMRNativeTopology.h"
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 /*
@@ -76,6 +77,13 @@ int TMRVertexFromEdge::evalPoint( TMRPoint *p ){
   return edge->evalPoint(t, p);
 }
 
+/*
+  The vertex is thread-safe when its edge is
+*/
+int TMRVertexFromEdge::isThreadSafe(){
+  return edge->isThreadSafe();
+}
+
 /*
   Retrieve the underlying curve object
 */
@@ -142,6 +150,13 @@ int TMRVertexFromFace::evalPoint( TMRPoint *p ){
   return face->evalPoint(u, v, p);
 }
 
+/*
+  The vertex is thread-safe when its face is
+*/
+int TMRVertexFromFace::isThreadSafe(){
+  return face->isThreadSafe();
+}
+
 /*
   Get the underlying parametric point (if any)
 */
@@ -201,6 +216,19 @@ int TMREdgeFromFace::evalPoint( double t, TMRPoint *X ){
   return fail;
 }
 
+/*
+  The edge is thread-safe when all of its faces and parametric curves
+  are
+*/
+int TMREdgeFromFace::isThreadSafe(){
+  for ( int i = 0; i < nfaces; i++ ){
+    if (!faces[i]->isThreadSafe() || !pcurves[i]->isThreadSafe()){
+      return 0;
+    }
+  }
+  return 1;
+}
+
 /*
   Parametrize the curve on the given surface
 */
@@ -360,6 +388,13 @@ int TMRSplitEdge::evalPoint( double t, TMRPoint *X ){
   return edge->evalPoint(t, X);
 }
 
+/*
+  The split edge is thread-safe when the underlying edge is
+*/
+int TMRSplitEdge::isThreadSafe(){
+  return edge->isThreadSafe();
+}
+
 /*
   Get the parameter on the split curve
 */
@@ -406,6 +441,15 @@ int TMRTFIEdge::evalPoint( double t, TMRPoint *X ){
   return f1 || f2;
 }
 
+/*
+  The edge is thread-safe when both of its vertices are
+*/
+int TMRTFIEdge::isThreadSafe(){
+  TMRVertex *_v1, *_v2;
+  getVertices(&_v1, &_v2);
+  return _v1->isThreadSafe() && _v2->isThreadSafe();
+}
+
 /*
   Create a transfinite-interpolation (TFI) face from the given set of
   edges and vertices
@@ -511,6 +555,16 @@ int TMRTFIFace::evalPoint( double u, double v,
   }
     
   // Evaluate the point on the surface
+  evalTFIPoint(u, v, e, X);
+
+  return fail;
+} 
+
+/*
+  Compute the transfinite interpolation from the edge points
+*/
+void TMRTFIFace::evalTFIPoint( double u, double v, const TMRPoint e[],
+                               TMRPoint *X ){
   X->x = (1.0-u)*e[3].x + u*e[1].x + (1.0-v)*e[0].x + v*e[2].x
     - ((1.0-u)*(1.0-v)*c[0].x + u*(1.0-v)*c[1].x + 
        u*v*c[2].x + v*(1.0-u)*c[3].x);
@@ -522,9 +576,77 @@ int TMRTFIFace::evalPoint( double u, double v,
   X->z = (1.0-u)*e[3].z + u*e[1].z + (1.0-v)*e[0].z + v*e[2].z
     - ((1.0-u)*(1.0-v)*c[0].z + u*(1.0-v)*c[1].z + 
        u*v*c[2].z + v*(1.0-u)*c[3].z);
+}
+
+/*
+  Evaluate a list of points given by indices into the parameter values
+
+  The edges e0 and e2 only depend on u while the edges e1 and e3
+  only depend on v. The edge points are evaluated once for each
+  parameter value that is used by a point and then combined for each
+  point.
+*/
+int TMRTFIFace::evalPoints( int nu, const double u[],
+                            int nv, const double v[],
+                            int npts, const int pts[], TMRPoint X[] ){
+  int fail = 0;
+
+  // Flag the parameter values that are used
+  int *flags = new int[ nu + nv ];
+  memset(flags, 0, (nu + nv)*sizeof(int));
+  for ( int k = 0; k < npts; k++ ){
+    flags[pts[2*k]] = 1;
+    flags[nu + pts[2*k+1]] = 1;
+  }
+
+  // Evaluate the points along the edges
+  TMRPoint *eu = new TMRPoint[ 2*nu ];
+  TMRPoint *ev = new TMRPoint[ 2*nv ];
+  for ( int i = 0; i < nu; i++ ){
+    if (flags[i]){
+      double p0 = (1.0 - u[i])*tmin[0] + u[i]*tmax[0];
+      double p2 = u[i]*tmin[2] + (1.0 - u[i])*tmax[2];
+      fail |= edges[0]->evalPoint(p0, &eu[2*i]);
+      fail |= edges[2]->evalPoint(p2, &eu[2*i+1]);
+    }
+  }
+  for ( int j = 0; j < nv; j++ ){
+    if (flags[nu + j]){
+      double p1 = (1.0 - v[j])*tmin[1] + v[j]*tmax[1];
+      double p3 = v[j]*tmin[3] + (1.0 - v[j])*tmax[3];
+      fail |= edges[1]->evalPoint(p1, &ev[2*j]);
+      fail |= edges[3]->evalPoint(p3, &ev[2*j+1]);
+    }
+  }
+
+  for ( int k = 0; k < npts; k++ ){
+    int i = pts[2*k], j = pts[2*k+1];
+    TMRPoint e[4];
+    e[0] = eu[2*i];
+    e[1] = ev[2*j];
+    e[2] = eu[2*i+1];
+    e[3] = ev[2*j+1];
+    evalTFIPoint(u[i], v[j], e, &X[k]);
+  }
+
+  delete [] flags;
+  delete [] eu;
+  delete [] ev;
 
   return fail;
-} 
+}
+
+/*
+  The face is thread-safe when all of its edges are
+*/
+int TMRTFIFace::isThreadSafe(){
+  for ( int k = 0; k < 4; k++ ){
+    if (!edges[k]->isThreadSafe()){
+      return 0;
+    }
+  }
+  return 1;
+}
 
 /*  
   Inverse evaluation: This is not yet implemented
@@ -827,6 +949,21 @@ int TMRParametricTFIFace::invEvalPoint( TMRPoint p,
   return fail;
 }
 
+/*
+  The face is thread-safe when the underlying face and the edges are
+*/
+int TMRParametricTFIFace::isThreadSafe(){
+  if (!face->isThreadSafe()){
+    return 0;
+  }
+  for ( int k = 0; k < 4; k++ ){
+    if (!edges[k]->isThreadSafe()){
+      return 0;
+    }
+  }
+  return 1;
+}
+
 /*
   Derivative evaluation: This is not yet implemented
 */
@@ -918,6 +1055,17 @@ int TMRTFIVolume::evalPoint( double u, double v, double w,
     }
   }
 
+  // Compute the point from the edge points
+  evalTFIPoint(u, v, w, e, X);
+
+  return 1;
+}
+
+/*
+  Compute the transfinite interpolation from the edge points
+*/
+void TMRTFIVolume::evalTFIPoint( double u, double v, double w,
+                                 const TMRPoint e[], TMRPoint *X ){
   X->x = ((1.0-v)*(1.0-w)*e[0].x + v*(1.0-w)*e[1].x + 
        (1.0-v)*w*e[2].x + v*w*e[3].x +
        (1.0-u)*(1.0-w)*e[4].x + u*(1.0-w)*e[5].x + 
@@ -950,7 +1098,80 @@ int TMRTFIVolume::evalPoint( double u, double v, double w,
            (1.0-u)*v*(1.0-w)*c[2].z + u*v*(1.0-w)*c[3].z + 
            (1.0-u)*(1.0-v)*w*c[4].z + u*(1.0-v)*w*c[5].z + 
            (1.0-u)*v*w*c[6].z + u*v*w*c[7].z);
+}
+
+/*
+  Evaluate a list of points given by indices into the parameter values
 
+  Edges 0-3 only depend on u, edges 4-7 only depend on v and edges
+  8-11 only depend on w. The edge points are evaluated once for each
+  parameter value that is used by a point and then combined for each
+  point. This reduces the number of edge evaluations from 12*npts to
+  at most 4*(nu + nv + nw).
+*/
+int TMRTFIVolume::evalPoints( int nu, const double u[],
+                              int nv, const double v[],
+                              int nw, const double w[],
+                              int npts, const int pts[], TMRPoint X[] ){
+  int fail = 0;
+
+  // Evaluate the points along the edges for the parameter values
+  // that are used
+  int n[3] = {nu, nv, nw};
+  const double *t[3] = {u, v, w};
+  TMRPoint *et[3];
+  for ( int d = 0; d < 3; d++ ){
+    int *flags = new int[ n[d] ];
+    memset(flags, 0, n[d]*sizeof(int));
+    for ( int p = 0; p < npts; p++ ){
+      flags[pts[3*p + d]] = 1;
+    }
+
+    et[d] = new TMRPoint[ 4*n[d] ];
+    for ( int i = 0; i < n[d]; i++ ){
+      if (!flags[i]){
+        continue;
+      }
+      for ( int k = 0; k < 4; k++ ){
+        int edge = 4*d + k;
+        if (edge_dir[edge] > 0){
+          fail |= edges[edge]->evalPoint(t[d][i], &et[d][4*i + k]);
+        }
+        else {
+          fail |= edges[edge]->evalPoint(1.0-t[d][i], &et[d][4*i + k]);
+        }
+      }
+    }
+    delete [] flags;
+  }
+
+  for ( int p = 0; p < npts; p++ ){
+    int ii = pts[3*p], jj = pts[3*p+1], kk = pts[3*p+2];
+    TMRPoint e[12];
+    for ( int k = 0; k < 4; k++ ){
+      e[k] = et[0][4*ii + k];
+      e[4 + k] = et[1][4*jj + k];
+      e[8 + k] = et[2][4*kk + k];
+    }
+    evalTFIPoint(u[ii], v[jj], w[kk], e, &X[p]);
+  }
+
+  for ( int d = 0; d < 3; d++ ){
+    delete [] et[d];
+  }
+
+  return fail;
+}
+
+/*
+  The volume is thread-safe when all of its edges are
+*/
+int TMRTFIVolume::isThreadSafe(){
+  for ( int k = 0; k < 12; k++ ){
+    if (!edges[k]->isThreadSafe()){
+      return 0;
+    }
+  }
   return 1;
 }
 
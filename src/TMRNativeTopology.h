@@ -47,6 +47,9 @@ class TMREdgeFromCurve : public TMREdge {
   int evalDeriv( double t, TMRPoint *Xt ){
     return curve->evalDeriv(t, Xt);
   }
+  int isThreadSafe(){
+    return curve->isThreadSafe();
+  }
  private:
   TMRCurve *curve;
 };
@@ -77,6 +80,9 @@ class TMRFaceFromSurface : public TMRFace {
                  TMRPoint *Xu, TMRPoint *Xv ){
     return surf->evalDeriv(u, v, Xu, Xv);
   }
+  int isThreadSafe(){
+    return surf->isThreadSafe();
+  }
  private:
   TMRSurface *surf;
 };
@@ -89,6 +95,7 @@ class TMRVertexFromPoint : public TMRVertex {
   TMRVertexFromPoint( TMRPoint p );
   ~TMRVertexFromPoint(){}
   int evalPoint( TMRPoint *p );
+  int isThreadSafe(){ return 1; }
  private:
   TMRPoint pt;
 };
@@ -108,6 +115,7 @@ class TMRVertexFromEdge : public TMRVertex {
   int evalPoint( TMRPoint *p );
   int getParamOnEdge( TMREdge *edge, double *t );
   int getParamsOnFace( TMRFace *face, double *u, double *v );
+  int isThreadSafe();
   TMREdge* getEdge();
 
  private:
@@ -127,6 +135,7 @@ class TMRVertexFromFace : public TMRVertex {
   int evalPoint( TMRPoint *p );
   int getParamsOnFace( TMRFace *surf,
                        double *u, double *v );
+  int isThreadSafe();
   TMRFace* getFace();
 
  private:
@@ -148,6 +157,7 @@ class TMREdgeFromFace : public TMREdge {
   int invEvalPoint( TMRPoint X, double *t );
   int evalDeriv( double t, TMRPoint *Xt );
   int isDegenerate(){ return is_degen; }
+  int isThreadSafe();
   void addEdgeFromFace( TMRFace *_face, TMRPcurve *_pcurve );
  private:
   int is_degen;
@@ -170,6 +180,7 @@ class TMRSplitEdge : public TMREdge {
   int evalPoint( double t, TMRPoint *X );
   int getParamsOnFace( TMRFace *face, double t, 
                        int dir, double *u, double *v );
+  int isThreadSafe();
 
  private:
   // Evaluate the bspline curve
@@ -188,6 +199,7 @@ class TMRTFIEdge : public TMREdge {
   ~TMRTFIEdge();
   void getRange( double *tmin, double *tmax );
   int evalPoint( double t, TMRPoint *X );
+  int isThreadSafe();
 };
 
 /*
@@ -212,11 +224,17 @@ class TMRTFIFace : public TMRFace {
   void getRange( double *umin, double *vmin,
                  double *umax, double *vmax ); 
   int evalPoint( double u, double v, TMRPoint *X ); 
+  int evalPoints( int nu, const double u[], int nv, const double v[],
+                  int npts, const int pts[], TMRPoint X[] );
   int invEvalPoint( TMRPoint p, double *u, double *v );
   int evalDeriv( double u, double v, 
                  TMRPoint *Xu, TMRPoint *Xv );
+  int isThreadSafe();
 
  private:
+  // Compute the point from the edge points and corners
+  void evalTFIPoint( double u, double v, const TMRPoint e[], TMRPoint *X );
+
   // Set the number of Newton iterations
   static int max_newton_iters; 
   
@@ -270,6 +288,7 @@ class TMRParametricTFIFace : public TMRFace {
   int invEvalPoint( TMRPoint p, double *u, double *v );
   int evalDeriv( double u, double v, 
                  TMRPoint *Xu, TMRPoint *Xv );
+  int isThreadSafe();
 
  private:
   TMRFace *face;
@@ -318,10 +337,18 @@ class TMRTFIVolume : public TMRVolume {
   void getRange( double *umin, double *vmin, double *wmin,
                  double *umax, double *vmax, double *wmax );
   int evalPoint( double u, double v, double w, TMRPoint *X ); 
+  int evalPoints( int nu, const double u[], int nv, const double v[],
+                  int nw, const double w[],
+                  int npts, const int pts[], TMRPoint X[] );
+  int isThreadSafe();
   void getEntities( TMRFace ***_faces, TMREdge ***_edges, 
                     TMRVertex ***_verts );
 
  private:
+  // Compute the point from the edge points and corners
+  void evalTFIPoint( double u, double v, double w,
+                     const TMRPoint e[], TMRPoint *X );
+
   // Faces surrounding the volume: coordinate ordered
   TMRFace *faces[6];
   int orient[6];
@@ -20,6 +20,8 @@
 
 #include "TMROctForest.h"
 #include "TMRInterpolation.h"
+#include "TMRMesh.h"
+#include <pthread.h>
 
 /*
   Map from a block edge number to the local node numbers
@@ -95,91 +97,6 @@ const int face_orientations[][4] =
    {3,1,2,0},
    {1,0,3,2}};
 
-/*
-  Given the x/y locations on the face with orientation face_id,
-  find/return the corresponding u/v coordinates on the transformed
-  face.
-*/
-inline void get_face_oct_coords( const int face_id, const int32_t h,
-                                 const int32_t x, const int32_t y,
-                                 int32_t *u, int32_t *v ){
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;  
-  if (face_id == 0){
-    *u = x;
-    *v = y;
-  }
-  else if (face_id == 1){
-    *u = hmax - h - y;
-    *v = x;
-  }
-  else if (face_id == 2){
-    *u = hmax - h - x;
-    *v = hmax - h - y;
-  }
-  else if (face_id == 3){
-    *u = y;
-    *v = hmax - h - x;
-  }
-  else if (face_id == 4){
-    *u = y;
-    *v = x;
-  }
-  else if (face_id == 5){
-    *u = x;
-    *v = hmax - h - y;
-  }
-  else if (face_id == 6){
-    *u = hmax - h - y;
-    *v = hmax - h - x;
-  }
-  else {
-    *u = hmax - h - x;
-    *v = y;
-  }
-}
-
-/*
-  Given the u/v locations on the owner face, set the coordinates on the
-  destination face.
-*/
-inline void set_face_oct_coords( const int face_id, const int32_t h,
-                                 const int32_t u, const int32_t v,
-                                 int32_t *x, int32_t *y ){
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;  
-  if (face_id == 0){
-    *x = u;
-    *y = v;
-  }
-  else if (face_id == 1){
-    *x = v;
-    *y = hmax - h - u;
-  }
-  else if (face_id == 2){
-    *x = hmax - h - u;
-    *y = hmax - h - v; 
-  }
-  else if (face_id == 3){
-    *x = hmax - h - v;
-    *y = u; 
-  }
-  else if (face_id == 4){
-    *x = v;
-    *y = u;
-  }
-  else if (face_id == 5){
-    *x = u;
-    *y = hmax - h - v;
-  }
-  else if (face_id == 6){
-    *x = hmax - h - v; 
-    *y = hmax - h - u;
-  }
-  else {
-    *x = hmax - h - u; 
-    *y = v;
-  }
-}
-
 /*
   Given the x/y locations on a face with orientation face_id,
   find/return the corresponding u/v coordinates on the transformed
@@ -265,6 +182,68 @@ inline void set_face_node_coords( const int face_id,
   }
 }
 
+/*
+  The integer transformations between the coordinate frames of
+  adjacent blocks.
+
+  Each transformation is packed into a single integer with 3 bits for
+  each of the x/y/z coordinates on the destination block. The code
+  for each coordinate selects the source coordinate (perm), its sign
+  and whether the offset hmax - h is added so that
+
+  dst[k] = sign*src[perm] + offset*(hmax - h)
+
+  where h is the side length of the octant (or zero for nodes).
+  Codes 0 and 1 place the coordinate on the lower or upper side of
+  the block, while codes 2 + 2*perm + flip copy (or flip) the source
+  coordinate.
+*/
+const int block_transform_codes[][3] = 
+  {{0, 0, 0},
+   {0, 0, 1},
+   {0, 1, 0},
+   {0, -1, 1},
+   {1, 1, 0},
+   {1, -1, 1},
+   {2, 1, 0},
+   {2, -1, 1}};
+
+/*
+  Compute the transformation code for a destination coordinate that
+  is set from a signed source coordinate reference (+/-(perm+1))
+*/
+inline int get_transform_code( const int ref ){
+  if (ref < 0){
+    return 2 + 2*(-ref - 1) + 1;
+  }
+  return 2 + 2*(ref - 1);
+}
+
+/*
+  Pack the three coordinate codes into a single transformation
+*/
+inline int pack_block_transform( const int cx, const int cy, 
+                                 const int cz ){
+  return cx | (cy << 3) | (cz << 6);
+}
+
+/*
+  Apply the transformation to the coordinates of the source octant
+  with side length h and set the coordinates of the destination
+*/
+inline void apply_block_transform( const int trans, const int32_t h,
+                                   const TMROctant *src, 
+                                   TMROctant *dest ){
+  const int32_t hmax = 1 << TMR_MAX_LEVEL;
+  const int32_t c[3] = {src->x, src->y, src->z};
+  const int *tx = block_transform_codes[trans & 7];
+  const int *ty = block_transform_codes[(trans >> 3) & 7];
+  const int *tz = block_transform_codes[(trans >> 6) & 7];
+  dest->x = tx[1]*c[tx[0]] + tx[2]*(hmax - h);
+  dest->y = ty[1]*c[ty[0]] + ty[2]*(hmax - h);
+  dest->z = tz[1]*c[tz[0]] + tz[2]*(hmax - h);
+}
+
 /*
   Convert from the face/edge infor arguments to a local info argument,
   indicating the dependent edges/faces on the given octant.
@@ -340,6 +319,21 @@ static int compare_integers( const void *a, const void *b ){
   return (*(int*)a - *(int*)b);
 }
 
+/*
+  Compare tuples of N integers for sorting
+*/
+template <int N>
+static int compare_int_tuples( const void *a, const void *b ){
+  const int *aa = (const int*)a;
+  const int *bb = (const int*)b;
+  for ( int k = 0; k < N; k++ ){
+    if (aa[k] != bb[k]){
+      return (aa[k] < bb[k] ? -1 : 1);
+    }
+  }
+  return 0;
+}
+
 /*
   Compare tags for sorting
 */
@@ -383,6 +377,21 @@ TMROctForest::TMROctForest( MPI_Comm _comm, int _mesh_order,
 
   mesh_order = 2;
   interp_knots = NULL;
+  interp_tables = NULL;
+
+  // Evaluate the node locations on a single thread by default
+  num_threads = 1;
+
+  // Zero the memory high-water marks
+  balance_peak_memory = 0;
+  nodes_peak_memory = 0;
+
+  // The attribute index is created on demand
+  num_attrs = 0;
+  attr_names = NULL;
+  attr_octs = NULL;
+  attr_node_ptr = NULL;
+  attr_nodes = NULL;
 
   // Set the topology object to NULL to begin with
   topo = NULL;
@@ -407,6 +416,11 @@ TMROctForest::TMROctForest( MPI_Comm _comm, int _mesh_order,
   face_block_owners = NULL;
   edge_block_owners = NULL;
   node_block_owners = NULL;
+  block_face_trans_ptr = NULL;
+  face_trans = NULL;
+  block_edge_trans_ptr = NULL;
+  edge_trans = NULL;
+  shared_conn = NULL;
 
   // Null the octant owners/octant list
   owners = NULL;
@@ -425,7 +439,9 @@ TMROctForest::TMROctForest( MPI_Comm _comm, int _mesh_order,
 
   dep_ptr = NULL;
   dep_conn = NULL;
+  dep_tmpl = NULL;
   dep_weights = NULL;
+  dep_interp = NULL;
 
   // Set the mesh order
   setMeshOrder(_mesh_order, _interp_type);
@@ -439,27 +455,46 @@ TMROctForest::~TMROctForest(){
   if (topo){ topo->decref(); }
 
   freeData();
+
+  // Free the interpolation data
+  if (interp_knots){ delete [] interp_knots; }
+  if (dep_interp){ delete [] dep_interp; }
+  if (interp_tables){ delete interp_tables; }
 }
 /*
   Free any data that has been allocated
 */
 void TMROctForest::freeData(){
-  // Free the connectivity data
-  if (block_conn){ delete [] block_conn; }
-  if (block_face_conn){ delete [] block_face_conn; }
-  if (block_face_ids){ delete [] block_face_ids; }
-  if (block_edge_conn){ delete [] block_edge_conn; }
-  if (node_block_ptr){ delete [] node_block_ptr; }
-  if (node_block_conn){ delete [] node_block_conn; }
-  if (edge_block_ptr){ delete [] edge_block_ptr; }
-  if (edge_block_conn){ delete [] edge_block_conn; }
-  if (face_block_ptr){ delete [] face_block_ptr; }
-  if (face_block_conn){ delete [] face_block_conn; }
-
-  // Free the ownership data
-  if (face_block_owners){ delete [] face_block_owners; }
-  if (edge_block_owners){ delete [] edge_block_owners; }
-  if (node_block_owners){ delete [] node_block_owners; }
+  freeAttributeIndex();
+
+  if (shared_conn){
+    // Release the connectivity which may be shared with other forests
+    shared_conn->decref();
+  }
+  else {
+    // Free the connectivity data
+    if (block_conn){ delete [] block_conn; }
+    if (block_face_conn){ delete [] block_face_conn; }
+    if (block_face_ids){ delete [] block_face_ids; }
+    if (block_edge_conn){ delete [] block_edge_conn; }
+    if (node_block_ptr){ delete [] node_block_ptr; }
+    if (node_block_conn){ delete [] node_block_conn; }
+    if (edge_block_ptr){ delete [] edge_block_ptr; }
+    if (edge_block_conn){ delete [] edge_block_conn; }
+    if (face_block_ptr){ delete [] face_block_ptr; }
+    if (face_block_conn){ delete [] face_block_conn; }
+
+    // Free the ownership data
+    if (face_block_owners){ delete [] face_block_owners; }
+    if (edge_block_owners){ delete [] edge_block_owners; }
+    if (node_block_owners){ delete [] node_block_owners; }
+
+    // Free the transformations between blocks
+    if (block_face_trans_ptr){ delete [] block_face_trans_ptr; }
+    if (face_trans){ delete [] face_trans; }
+    if (block_edge_trans_ptr){ delete [] block_edge_trans_ptr; }
+    if (edge_trans){ delete [] edge_trans; }
+  }
 
   // Free the octants/adjacency/dependency data
   if (owners){ delete [] owners; }
@@ -470,6 +505,7 @@ void TMROctForest::freeData(){
   if (node_range){ delete [] node_range; }
   if (dep_ptr){ delete [] dep_ptr; }
   if (dep_conn){ delete [] dep_conn; }
+  if (dep_tmpl){ delete [] dep_tmpl; }
   if (dep_weights){ delete [] dep_weights; }
 
   // Zero out the nodes/edges/faces and all data
@@ -492,6 +528,11 @@ void TMROctForest::freeData(){
   face_block_owners = NULL;
   edge_block_owners = NULL;
   node_block_owners = NULL;
+  block_face_trans_ptr = NULL;
+  face_trans = NULL;
+  block_edge_trans_ptr = NULL;
+  edge_trans = NULL;
+  shared_conn = NULL;
 
   // Null the octant owners/octant list
   owners = NULL;
@@ -510,6 +551,7 @@ void TMROctForest::freeData(){
 
   dep_ptr = NULL;
   dep_conn = NULL;
+  dep_tmpl = NULL;
   dep_weights = NULL;
 }
 
@@ -518,6 +560,8 @@ void TMROctForest::freeData(){
 */
 void TMROctForest::freeMeshData( int free_octs,
                                  int free_owners ){
+  freeAttributeIndex();
+
   if (free_owners){
     if (owners){ delete [] owners; }
     owners = NULL;
@@ -536,6 +580,7 @@ void TMROctForest::freeMeshData( int free_octs,
   if (node_range){ delete [] node_range; }
   if (dep_ptr){ delete [] dep_ptr; }
   if (dep_conn){ delete [] dep_conn; }
+  if (dep_tmpl){ delete [] dep_tmpl; }
   if (dep_weights){ delete [] dep_weights; }
 
   // Null the octant owners/octant list
@@ -553,6 +598,7 @@ void TMROctForest::freeMeshData( int free_octs,
 
   dep_ptr = NULL;
   dep_conn = NULL;
+  dep_tmpl = NULL;
   dep_weights = NULL;
 }
 
@@ -560,57 +606,42 @@ void TMROctForest::freeMeshData( int free_octs,
   Copy the connectivity data, but not the octants/nodes
 */
 void TMROctForest::copyData( TMROctForest *copy ){
+  // Copy the number of threads
+  copy->num_threads = num_threads;
+
   // Copy over the connectivity data
   copy->num_nodes = num_nodes;
   copy->num_edges = num_edges;
   copy->num_faces = num_faces;
   copy->num_blocks = num_blocks;
 
-  // Allocate/copy the block connectivities
-  copy->block_conn = new int[ 8*num_blocks ];
-  copy->block_face_conn = new int[ 6*num_faces ];
-  copy->block_face_ids = new int[ 6*num_faces ];
-  copy->block_edge_conn = new int[ 12*num_faces ];
-  memcpy(copy->block_conn, block_conn, 8*num_blocks*sizeof(int));
-  memcpy(copy->block_face_conn, block_face_conn, 
-         6*num_blocks*sizeof(int));
-  memcpy(copy->block_face_ids, block_face_ids, 
-         6*num_blocks*sizeof(int));
-  memcpy(copy->block_edge_conn, block_edge_conn, 
-         12*num_blocks*sizeof(int));
-    
-  // Allocate/copy the inverse relationships
-  copy->node_block_ptr = new int[ num_nodes+1 ];
-  copy->node_block_conn = new int[ node_block_ptr[num_nodes] ];
-  memcpy(copy->node_block_ptr, node_block_ptr, 
-         (num_nodes+1)*sizeof(int));
-  memcpy(copy->node_block_conn, node_block_conn, 
-         node_block_ptr[num_nodes]*sizeof(int));
-
-  copy->edge_block_ptr = new int[ num_edges+1 ];
-  copy->edge_block_conn = new int[ edge_block_ptr[num_edges] ];
-  memcpy(copy->edge_block_ptr, edge_block_ptr, 
-         (num_edges+1)*sizeof(int));
-  memcpy(copy->edge_block_conn, edge_block_conn, 
-         edge_block_ptr[num_edges]*sizeof(int));
-
-  copy->face_block_ptr = new int[ num_faces+1 ];
-  copy->face_block_conn = new int[ face_block_ptr[num_faces] ];
-  memcpy(copy->face_block_ptr, face_block_ptr, 
-         (num_faces+1)*sizeof(int));
-  memcpy(copy->face_block_conn, face_block_conn, 
-         face_block_ptr[num_faces]*sizeof(int));
-
-  // Copy the ownership information
-  copy->face_block_owners = new int[ num_faces ];
-  copy->edge_block_owners = new int[ num_edges ];
-  copy->node_block_owners = new int[ num_nodes ];
-  memcpy(copy->face_block_owners, face_block_owners,
-         num_faces*sizeof(int));
-  memcpy(copy->edge_block_owners, edge_block_owners,
-         num_edges*sizeof(int));
-  memcpy(copy->node_block_owners, node_block_owners,
-         num_nodes*sizeof(int));
+  // Share the block connectivities and the inverse relationships
+  copy->block_conn = block_conn;
+  copy->block_face_conn = block_face_conn;
+  copy->block_face_ids = block_face_ids;
+  copy->block_edge_conn = block_edge_conn;
+  copy->node_block_ptr = node_block_ptr;
+  copy->node_block_conn = node_block_conn;
+  copy->edge_block_ptr = edge_block_ptr;
+  copy->edge_block_conn = edge_block_conn;
+  copy->face_block_ptr = face_block_ptr;
+  copy->face_block_conn = face_block_conn;
+
+  // Share the ownership information
+  copy->face_block_owners = face_block_owners;
+  copy->edge_block_owners = edge_block_owners;
+  copy->node_block_owners = node_block_owners;
+
+  // Share the transformations between blocks
+  copy->block_face_trans_ptr = block_face_trans_ptr;
+  copy->face_trans = face_trans;
+  copy->block_edge_trans_ptr = block_edge_trans_ptr;
+  copy->edge_trans = edge_trans;
+
+  copy->shared_conn = shared_conn;
+  if (copy->shared_conn){
+    copy->shared_conn->incref();
+  }
 
   // Copy over the topology object
   copy->topo = topo;
@@ -707,7 +738,13 @@ void TMROctForest::setConnectivity( int _num_nodes,
   computeFacesToBlocks();
 
   // Compute the block owners based on the node, edge and face data
-  computeBlockOwners();  
+  computeBlockOwners();
+
+  // Compute the transformations between adjacent blocks
+  computeBlockTransforms();
+
+  // Store the connectivity so that it can be shared with copies
+  createSharedConnectivity();
 }
 
 /*
@@ -752,7 +789,13 @@ void TMROctForest::setFullConnectivity( int _num_nodes,
   computeFacesToBlocks();
 
   // Compute the block owners based on the node, edge and face data
-  computeBlockOwners();  
+  computeBlockOwners();
+
+  // Compute the transformations between adjacent blocks
+  computeBlockTransforms();
+
+  // Store the connectivity so that it can be shared with copies
+  createSharedConnectivity();
 }
 
 /*
@@ -891,73 +934,72 @@ void TMROctForest::computeEdgesToBlocks(){
 
 /*
   Establish a unique ordering of the edges along each block
+
+  The edges are bucketed by their smallest node number and then sorted
+  by the other node number so that the equivalent edges are adjacent.
+  The edges are numbered in the order in which they first appear.
 */
 void TMROctForest::computeEdgesFromNodes(){
   block_edge_conn = new int[ 12*num_blocks ];
+
+  // Bucket the block edges by their smallest node number. Each entry
+  // stores the other node number and the block edge index.
+  int *ptr = new int[ num_nodes+1 ];
+  memset(ptr, 0, (num_nodes+1)*sizeof(int));
   for ( int i = 0; i < 12*num_blocks; i++ ){
-    block_edge_conn[i] = -1;
+    int n1 = block_conn[8*(i/12) + block_to_edge_nodes[i % 12][0]];
+    int n2 = block_conn[8*(i/12) + block_to_edge_nodes[i % 12][1]];
+    ptr[(n1 < n2 ? n1 : n2)+1]++;
+  }
+  for ( int i = 0; i < num_nodes; i++ ){
+    ptr[i+1] += ptr[i];
   }
 
-  int edge = 0;
-  for ( int i = 0; i < num_blocks; i++ ){
-    // Loop over each edge on this block
-    for ( int j = 0; j < 12; j++ ){
-      if (block_edge_conn[12*i + j] < 0){
-        int n1 = block_conn[8*i + block_to_edge_nodes[j][0]];
-        int n2 = block_conn[8*i + block_to_edge_nodes[j][1]];
-
-        // Keep track of the number of edges found
-        const int max_nedges = 128;
-        int edge_index[max_nedges];
-        int nedges = 1;
-        edge_index[0] = 12*i + j;
-
-        // Set the edge number - if any is found
-        int edge_num = -1;
-
-        // Scan through the blocks that share the same node and check
-        // if any of the edges are also shared 
-        for ( int ip = node_block_ptr[n1];
-              ip < node_block_ptr[n1+1]; ip++ ){
-          int ii = node_block_conn[ip]/8;
-          
-          // Loop over each edge in the new block
-          for ( int jj = 0; jj < 12; jj++ ){
-            int nn1 = block_conn[8*ii + block_to_edge_nodes[jj][0]];
-            int nn2 = block_conn[8*ii + block_to_edge_nodes[jj][1]];
-
-            // Check if the block matches
-            if ((n1 == nn1 && n2 == nn2) ||
-                (n1 == nn2 && n2 == nn1)){
-              if (block_edge_conn[12*ii + jj] >= 0){
-                // If this edge has been ordered, copy over
-                // the edge number
-                edge_num = block_edge_conn[12*ii + jj];
-              }
-              else if (nedges < max_nedges){
-                // This edge has not yet been ordered, add it
-                // to the unordered list if there is still room
-                // if not, we will detect and order it during
-                // a future iteration
-                edge_index[nedges] = 12*ii + jj;
-                nedges++;
-              }
-            }
-          }
-        }
+  int *keys = new int[ 2*12*num_blocks ];
+  for ( int i = 0; i < 12*num_blocks; i++ ){
+    int n1 = block_conn[8*(i/12) + block_to_edge_nodes[i % 12][0]];
+    int n2 = block_conn[8*(i/12) + block_to_edge_nodes[i % 12][1]];
+    int n = (n1 < n2 ? n1 : n2);
+    keys[2*ptr[n]] = (n1 < n2 ? n2 : n1);
+    keys[2*ptr[n]+1] = i;
+    ptr[n]++;
+  }
 
-        // If this edge does not have an edge number, assign
-        // a new one to the list
-        if (edge_num < 0){
-          edge_num = edge;
-          edge++;
-        }
+  // Reset the pointer array
+  for ( int i = num_nodes; i >= 1; i-- ){
+    ptr[i] = ptr[i-1];
+  }
+  ptr[0] = 0;
 
-        // Set the edge numbers for all the edges that we found
-        for ( int ii = 0; ii < nedges; ii++ ){
-          block_edge_conn[edge_index[ii]] = edge_num;
-        }
+  // Sort each bucket so that equivalent edges are adjacent and ordered
+  // by their index. Store the index of the first equivalent edge.
+  for ( int n = 0; n < num_nodes; n++ ){
+    int size = ptr[n+1] - ptr[n];
+    if (size > 1){
+      qsort(&keys[2*ptr[n]], size, 2*sizeof(int), compare_int_tuples<2>);
+    }
+    int first = -1;
+    for ( int k = ptr[n]; k < ptr[n+1]; k++ ){
+      if (k == ptr[n] || keys[2*k] != keys[2*(k-1)]){
+        first = keys[2*k+1];
       }
+      block_edge_conn[keys[2*k+1]] = first;
+    }
+  }
+
+  delete [] ptr;
+  delete [] keys;
+
+  // Number the edges in the order in which they first appear
+  int edge = 0;
+  for ( int i = 0; i < 12*num_blocks; i++ ){
+    int first = block_edge_conn[i];
+    if (first == i){
+      block_edge_conn[i] = edge;
+      edge++;
+    }
+    else {
+      block_edge_conn[i] = block_edge_conn[first];
     }
   }
 
@@ -967,92 +1009,120 @@ void TMROctForest::computeEdgesFromNodes(){
 
 /*
   Establish a unique ordering of the faces for each block
+
+  The faces are bucketed by their smallest node number and then
+  sorted by the remaining node numbers so that the faces with the same
+  nodes are adjacent. The relative orientation is only checked once
+  for each match. The faces are numbered in the order in which they
+  first appear.
 */
 void TMROctForest::computeFacesFromNodes(){
   block_face_conn = new int[ 6*num_blocks ];
+
+  // Bucket the block faces by their smallest node number. Each entry
+  // stores the other three node numbers in ascending order and the
+  // block face index.
+  int *ptr = new int[ num_nodes+1 ];
+  memset(ptr, 0, (num_nodes+1)*sizeof(int));
   for ( int i = 0; i < 6*num_blocks; i++ ){
-    block_face_conn[i] = -1;
+    int n = block_conn[8*(i/6) + block_to_face_nodes[i % 6][0]];
+    for ( int k = 1; k < 4; k++ ){
+      int nk = block_conn[8*(i/6) + block_to_face_nodes[i % 6][k]];
+      if (nk < n){ n = nk; }
+    }
+    ptr[n+1]++;
+  }
+  for ( int i = 0; i < num_nodes; i++ ){
+    ptr[i+1] += ptr[i];
   }
 
-  // Count up and order the number of faces in the mesh
-  int face = 0;
-  for ( int i = 0; i < num_blocks; i++ ){
-    // Loop over all the face for this block
-    for ( int j = 0; j < 6; j++ ){
-      if (block_face_conn[6*i + j] < 0){
-        // Get the face nodes for the j-th face of the i-th block
-        int face_nodes[4];
-        for ( int k = 0; k < 4; k++ ){
-          face_nodes[k] = block_conn[8*i + block_to_face_nodes[j][k]];
-        }
-
-        // Keep track of the number of connecting faces
-        const int max_nfaces = 128;
-        int face_index[max_nfaces];
-        int nfaces = 1;
-        face_index[0] = 6*i + j;
-
-        // Set the face number
-        int face_num = -1;
-        
-        // Scan through and find the blocks that share a common
-        // node that is also on this face
-        int node = face_nodes[0];
-        for ( int ip = node_block_ptr[node];
-              ip < node_block_ptr[node+1]; ip++ ){
-          int ii = node_block_conn[ip]/8;
+  int *keys = new int[ 4*6*num_blocks ];
+  for ( int i = 0; i < 6*num_blocks; i++ ){
+    int t[4];
+    for ( int k = 0; k < 4; k++ ){
+      t[k] = block_conn[8*(i/6) + block_to_face_nodes[i % 6][k]];
+    }
 
-          // Skip this if the blocks are the same
-          if (ii == i){ continue; }
+    // Sort the four node numbers
+    for ( int k = 1; k < 4; k++ ){
+      int tk = t[k], m = k-1;
+      while (m >= 0 && t[m] > tk){
+        t[m+1] = t[m];
+        m--;
+      }
+      t[m+1] = tk;
+    }
 
-          // Loop over all the faces for the ii-th block
-          int face_equiv = 0;
-          for ( int jj = 0; jj < 6; jj++ ){
-            // Get the nodes corresponding to this face
-            int adj_face_nodes[4];
-            for ( int k = 0; k < 4; k++ ){
-              adj_face_nodes[k] = 
-                block_conn[8*ii + block_to_face_nodes[jj][k]];
-            }
+    int *key = &keys[4*ptr[t[0]]];
+    key[0] = t[1];
+    key[1] = t[2];
+    key[2] = t[3];
+    key[3] = i;
+    ptr[t[0]]++;
+  }
 
-            // Loop over the relative orientations between this block
-            // and the last block
-            for ( int ort = 0; ort < 8; ort++ ){
-              face_equiv = 
-                (face_nodes[0] == adj_face_nodes[face_orientations[ort][0]] &&
-                 face_nodes[1] == adj_face_nodes[face_orientations[ort][1]] &&
-                 face_nodes[2] == adj_face_nodes[face_orientations[ort][2]] &&
-                 face_nodes[3] == adj_face_nodes[face_orientations[ort][3]]);
-              // We've found a matching face
-              if (face_equiv){
-                break;
-              }
-            }
+  // Reset the pointer array
+  for ( int i = num_nodes; i >= 1; i-- ){
+    ptr[i] = ptr[i-1];
+  }
+  ptr[0] = 0;
 
-            if (face_equiv){
-              if (block_face_conn[6*ii + jj] >= 0){
-                face_num = block_face_conn[6*ii + jj];
-              }
-              else if (nfaces < max_nfaces){
-                face_index[nfaces] = 6*ii + jj;
-                nfaces++;
-              }
+  // Sort each bucket so that faces with the same nodes are adjacent
+  // and ordered by their index. Store the index of the first
+  // equivalent face.
+  for ( int n = 0; n < num_nodes; n++ ){
+    int size = ptr[n+1] - ptr[n];
+    if (size > 1){
+      qsort(&keys[4*ptr[n]], size, 4*sizeof(int), compare_int_tuples<4>);
+    }
+    int first = -1;
+    for ( int k = ptr[n]; k < ptr[n+1]; k++ ){
+      const int *key = &keys[4*k];
+      if (k == ptr[n] || key[0] != key[-4] || 
+          key[1] != key[-3] || key[2] != key[-2]){
+        first = key[3];
+        block_face_conn[key[3]] = first;
+        continue;
+      }
+
+      // Check that the face matches the first face on a different
+      // block for one of the relative orientations
+      int i = first/6, j = first % 6;
+      int ii = key[3]/6, jj = key[3] % 6;
+      int face_equiv = 0;
+      if (ii != i){
+        for ( int ort = 0; ort < 8; ort++ ){
+          face_equiv = 1;
+          for ( int m = 0; m < 4; m++ ){
+            if (block_conn[8*i + block_to_face_nodes[j][m]] !=
+                block_conn[8*ii + 
+                           block_to_face_nodes[jj][face_orientations[ort][m]]]){
+              face_equiv = 0;
+              break;
             }
           }
+          if (face_equiv){
+            break;
+          }
         }
+      }
+      block_face_conn[key[3]] = (face_equiv ? first : key[3]);
+    }
+  }
 
-        // If this face does not have an associated face number
-        // give it one
-        if (face_num < 0){
-          face_num = face;
-          face++;
-        }
+  delete [] ptr;
+  delete [] keys;
 
-        // Set the face numbers
-        for ( int ii = 0; ii < nfaces; ii++ ){
-          block_face_conn[face_index[ii]] = face_num;
-        }
-      }
+  // Number the faces in the order in which they first appear
+  int face = 0;
+  for ( int i = 0; i < 6*num_blocks; i++ ){
+    int first = block_face_conn[i];
+    if (first == i){
+      block_face_conn[i] = face;
+      face++;
+    }
+    else {
+      block_face_conn[i] = block_face_conn[first];
     }
   }
 
@@ -1182,6 +1252,179 @@ void TMROctForest::computeFacesToBlocks(){
   }
 }
 
+/*
+  Compute the integer transformations between the coordinate frames
+  of all pairs of blocks that share a face or an edge.
+
+  The transformations for the block face (or edge) are stored
+  contiguously starting at block_face_trans_ptr[6*block + face_index]
+  (or block_edge_trans_ptr[12*block + edge_index]) in the same order
+  as the entries in face_block_conn (or edge_block_conn). The
+  transformation that takes an octant on the face of the block to
+  the adjacent block face_block_conn[ip] is therefore
+
+  face_trans[block_face_trans_ptr[6*block + face_index] + 
+             ip - face_block_ptr[face]]
+
+  These tables replace the face orientation and edge direction
+  checks during balancing, the adjacency computations and the node
+  ordering.
+*/
+void TMROctForest::computeBlockTransforms(){
+  // Count up the number of face transformations
+  int num_face_trans = 0;
+  block_face_trans_ptr = new int[ 6*num_blocks ];
+  for ( int face = 0; face < num_faces; face++ ){
+    int nf = face_block_ptr[face+1] - face_block_ptr[face];
+    for ( int ip = face_block_ptr[face]; ip < face_block_ptr[face+1]; ip++ ){
+      block_face_trans_ptr[face_block_conn[ip]] = num_face_trans;
+      num_face_trans += nf;
+    }
+  }
+
+  // Compute the transformations between the adjacent faces
+  face_trans = new int[ num_face_trans ];
+  for ( int face = 0; face < num_faces; face++ ){
+    for ( int ip = face_block_ptr[face]; ip < face_block_ptr[face+1]; ip++ ){
+      int block = face_block_conn[ip]/6;
+      int face_index = face_block_conn[ip] % 6;
+      int face_id = block_face_ids[6*block + face_index];
+      int *t = &face_trans[block_face_trans_ptr[6*block + face_index]];
+
+      // Set the signed references to the coordinates in the plane of
+      // the source face (x = 1, y = 2, z = 3)
+      int32_t x = 2, y = 3;
+      if (face_index >= 2 && face_index < 4){
+        x = 1;  y = 3;
+      }
+      else if (face_index >= 4){
+        x = 1;  y = 2;
+      }
+
+      // Find the references on the owner face
+      int32_t u, v;
+      get_face_node_coords(face_id, 0, x, y, &u, &v);
+
+      for ( int jp = face_block_ptr[face]; 
+            jp < face_block_ptr[face+1]; jp++, t++ ){
+        int adjacent = face_block_conn[jp]/6;
+        int adj_index = face_block_conn[jp] % 6;
+        int adj_face_id = block_face_ids[6*adjacent + adj_index];
+
+        // Find the references on the adjacent face
+        set_face_node_coords(adj_face_id, 0, u, v, &x, &y);
+
+        // The normal coordinate lies on the side of the adjacent face
+        int side = adj_index % 2;
+        if (adj_index < 2){
+          t[0] = pack_block_transform(side, get_transform_code(x),
+                                      get_transform_code(y));
+        }
+        else if (adj_index < 4){
+          t[0] = pack_block_transform(get_transform_code(x), side,
+                                      get_transform_code(y));
+        }
+        else {
+          t[0] = pack_block_transform(get_transform_code(x),
+                                      get_transform_code(y), side);
+        }
+      }
+    }
+  }
+
+  // Count up the number of edge transformations
+  int num_edge_trans = 0;
+  block_edge_trans_ptr = new int[ 12*num_blocks ];
+  for ( int edge = 0; edge < num_edges; edge++ ){
+    int ne = edge_block_ptr[edge+1] - edge_block_ptr[edge];
+    for ( int ip = edge_block_ptr[edge]; ip < edge_block_ptr[edge+1]; ip++ ){
+      block_edge_trans_ptr[edge_block_conn[ip]] = num_edge_trans;
+      num_edge_trans += ne;
+    }
+  }
+
+  // Compute the transformations between the adjacent edges
+  edge_trans = new int[ num_edge_trans ];
+  for ( int edge = 0; edge < num_edges; edge++ ){
+    for ( int ip = edge_block_ptr[edge]; ip < edge_block_ptr[edge+1]; ip++ ){
+      int block = edge_block_conn[ip]/12;
+      int edge_index = edge_block_conn[ip] % 12;
+      int *t = &edge_trans[block_edge_trans_ptr[12*block + edge_index]];
+
+      // Retrieve the first and second node numbers
+      int n1 = block_conn[8*block + block_to_edge_nodes[edge_index][0]];
+      int n2 = block_conn[8*block + block_to_edge_nodes[edge_index][1]];
+
+      // The source coordinate along the edge
+      int perm = edge_index/4;
+
+      for ( int jp = edge_block_ptr[edge]; 
+            jp < edge_block_ptr[edge+1]; jp++, t++ ){
+        int adjacent = edge_block_conn[jp]/12;
+        int adj_index = edge_block_conn[jp] % 12;
+
+        // Get the nodes on the adjacent block
+        int nn1 = block_conn[8*adjacent + block_to_edge_nodes[adj_index][0]];
+        int nn2 = block_conn[8*adjacent + block_to_edge_nodes[adj_index][1]];
+
+        // Determine whether the edges are in the same direction
+        int reverse = (n1 == nn2 && n2 == nn1);
+        int code = 2 + 2*perm + reverse;
+
+        if (adj_index < 4){
+          t[0] = pack_block_transform(code, adj_index % 2, adj_index/2);
+        }
+        else if (adj_index < 8){
+          t[0] = pack_block_transform(adj_index % 2, code, 
+                                      (adj_index-4)/2);
+        }
+        else {
+          t[0] = pack_block_transform(adj_index % 2, 
+                                      (adj_index-8)/2, code);
+        }
+      }
+    }
+  }
+}
+
+/*
+  Transfer the ownership of the connectivity arrays to a
+  reference-counted object so that the arrays can be shared, rather
+  than copied, by the forests created with duplicate() or coarsen()
+*/
+void TMROctForest::createSharedConnectivity(){
+  shared_conn = new TMRSharedArrays();
+  shared_conn->incref();
+  shared_conn->add(block_conn, 8*num_blocks);
+  shared_conn->add(block_face_conn, 6*num_blocks);
+  shared_conn->add(block_face_ids, 6*num_blocks);
+  shared_conn->add(block_edge_conn, 12*num_blocks);
+  shared_conn->add(node_block_ptr, num_nodes+1);
+  shared_conn->add(node_block_conn, node_block_ptr[num_nodes]);
+  shared_conn->add(edge_block_ptr, num_edges+1);
+  shared_conn->add(edge_block_conn, edge_block_ptr[num_edges]);
+  shared_conn->add(face_block_ptr, num_faces+1);
+  shared_conn->add(face_block_conn, face_block_ptr[num_faces]);
+  shared_conn->add(face_block_owners, num_faces);
+  shared_conn->add(edge_block_owners, num_edges);
+  shared_conn->add(node_block_owners, num_nodes);
+
+  // Count the number of face/edge transformations
+  int num_face_trans = 0, num_edge_trans = 0;
+  for ( int face = 0; face < num_faces; face++ ){
+    int nf = face_block_ptr[face+1] - face_block_ptr[face];
+    num_face_trans += nf*nf;
+  }
+  for ( int edge = 0; edge < num_edges; edge++ ){
+    int ne = edge_block_ptr[edge+1] - edge_block_ptr[edge];
+    num_edge_trans += ne*ne;
+  }
+  shared_conn->add(block_face_trans_ptr, 6*num_blocks);
+  shared_conn->add(face_trans, num_face_trans);
+  shared_conn->add(block_edge_trans_ptr, 12*num_blocks);
+  shared_conn->add(edge_trans, num_edge_trans);
+}
+
 /*
   Once the connectivity for the blocks/faces/edges have been set,
   compute the owners of each object.  
@@ -1454,22 +1697,521 @@ void TMROctForest::writeForestToVTK( const char *filename ){
 }
 
 /*
-  Free the mesh element data if it exists
+  Write the forest to a binary file
+
+  The file contains a header, the block connectivity and the octants
+  in the order of the space-filling curve, followed by the optional
+  element and node data. Each processor writes its octants and data
+  with collective MPI-IO calls at an offset computed from the number
+  of octants on the preceding processors so the forest is never
+  gathered. The file uses the native binary representation.
+
+  The node data is stored at each node of each element so that the
+  file does not depend on the node numbering. This requires that the
+  nodes have been created. The element and node data sizes must be
+  the same on all processors.
+
+  input:
+  filename:   the name of the file
+  elem_size:  the number of values per element
+  elem_data:  the element values (elem_size values per local element)
+  node_size:  the number of values per node
+  node_data:  the node values (node_size values per local node in the
+              order returned by getNodeNumbers())
+
+  returns:    non-zero on failure
 */
-void TMROctForest::setMeshOrder( int _mesh_order,
-                                 TMRInterpolationType _interp_type ){
-  // Don't free the octants/owner information if it exists, 
-  // but free the connectivity and node data
-  freeMeshData(0, 0);
+int TMROctForest::writeToFile( const char *filename,
+                               int elem_size, const double *elem_data,
+                               int node_size, const double *node_data ){
+  if (!octants || !block_conn){
+    fprintf(stderr, "[%d] TMROctForest: Cannot write a forest without "
+            "octants to %s\n", mpi_rank, filename);
+    return 1;
+  }
+  if (!elem_data){ elem_size = 0; }
+  if (!node_data){ node_size = 0; }
+  if (node_size > 0 && !conn){
+    fprintf(stderr, "[%d] TMROctForest: Nodes must be created to write "
+            "node data to %s\n", mpi_rank, filename);
+    return 1;
+  }
+
+  // Get the local octants
+  int size;
+  TMROctant *array;
+  octants->getArray(&array, &size);
 
-  // Free the interpolation knots
-  if (interp_knots){
-    delete [] interp_knots;
+  // Compute the number of octants before this processor and the
+  // total number of octants
+  int64_t local_count = size, offset_count = 0, num_elements = 0;
+  MPI_Exscan(&local_count, &offset_count, 1, MPI_INT64_T, MPI_SUM, comm);
+  if (mpi_rank == 0){
+    offset_count = 0;
+  }
+  MPI_Allreduce(&local_count, &num_elements, 1, MPI_INT64_T, MPI_SUM, comm);
+
+  MPI_File fp;
+  if (MPI_File_open(comm, (char*)filename, 
+                    MPI_MODE_WRONLY | MPI_MODE_CREATE,
+                    MPI_INFO_NULL, &fp) != MPI_SUCCESS){
+    fprintf(stderr, "[%d] TMROctForest: Could not open file %s\n",
+            mpi_rank, filename);
+    return 1;
+  }
+  MPI_File_set_size(fp, 0);
+
+  // Write out the header and the block connectivity
+  if (mpi_rank == 0){
+    int64_t header[TMR_FILE_HEADER_SIZE];
+    memset(header, 0, TMR_FILE_HEADER_SIZE*sizeof(int64_t));
+    header[0] = TMR_OCT_FILE_ID;
+    header[1] = TMR_FILE_VERSION;
+    header[2] = mesh_order;
+    header[3] = interp_type;
+    header[4] = elem_size;
+    header[5] = node_size;
+    header[6] = num_nodes;
+    header[7] = num_edges;
+    header[8] = num_faces;
+    header[9] = num_blocks;
+    header[10] = num_elements;
+
+    MPI_Offset offset = 0;
+    MPI_File_write_at(fp, offset, header, TMR_FILE_HEADER_SIZE,
+                      MPI_INT64_T, MPI_STATUS_IGNORE);
+    offset += TMR_FILE_HEADER_SIZE*sizeof(int64_t);
+    MPI_File_write_at(fp, offset, block_conn, 8*num_blocks,
+                      MPI_INT, MPI_STATUS_IGNORE);
+    offset += 8*num_blocks*sizeof(int);
+    MPI_File_write_at(fp, offset, block_edge_conn, 12*num_blocks,
+                      MPI_INT, MPI_STATUS_IGNORE);
+    offset += 12*num_blocks*sizeof(int);
+    MPI_File_write_at(fp, offset, block_face_conn, 6*num_blocks,
+                      MPI_INT, MPI_STATUS_IGNORE);
+  }
+  MPI_Offset offset = (TMR_FILE_HEADER_SIZE*sizeof(int64_t) + 
+                       26*num_blocks*sizeof(int));
+
+  // Write out the octants
+  int oct_size;
+  MPI_Type_size(TMROctant_MPI_type, &oct_size);
+  MPI_File_write_at_all(fp, offset + offset_count*oct_size,
+                        array, size, TMROctant_MPI_type, 
+                        MPI_STATUS_IGNORE);
+  offset += num_elements*oct_size;
+
+  // Write out the element data
+  if (elem_size > 0){
+    MPI_Offset data_size = elem_size*sizeof(double);
+    MPI_File_write_at_all(fp, offset + offset_count*data_size,
+                          (void*)elem_data, elem_size*size, MPI_DOUBLE,
+                          MPI_STATUS_IGNORE);
+    offset += num_elements*data_size;
+  }
+
+  // Write out the node data at the nodes of each element
+  if (node_size > 0){
+    const int nodes_per_element = mesh_order*mesh_order*mesh_order;
+    const int elem_node_size = node_size*nodes_per_element;
+    double *values = new double[ elem_node_size*size ];
+    for ( int i = 0; i < size; i++ ){
+      for ( int j = 0; j < nodes_per_element; j++ ){
+        int index = getLocalNodeNumber(conn[nodes_per_element*i + j]);
+        memcpy(&values[elem_node_size*i + node_size*j],
+               &node_data[node_size*index], node_size*sizeof(double));
+      }
+    }
+
+    MPI_Offset data_size = elem_node_size*sizeof(double);
+    MPI_File_write_at_all(fp, offset + offset_count*data_size,
+                          values, elem_node_size*size, MPI_DOUBLE,
+                          MPI_STATUS_IGNORE);
+    delete [] values;
   }
 
-  // Check that the order falls within allowable bounds
-  mesh_order = _mesh_order;
-  if (mesh_order < 2){
+  MPI_File_close(&fp);
+
+  return 0;
+}
+
+/*
+  Read the forest from a binary file created by writeToFile()
+
+  The octants are split evenly between the processors in the order of
+  the space-filling curve, so the file can be read on any number of
+  processors. Each processor reads only the header, the block
+  connectivity and its own octants and data.
+
+  If the connectivity has already been set (for instance by
+  setTopology()) it must match the connectivity in the file. 
+  Otherwise the connectivity is set from the file. The mesh order and
+  interpolation type are set from the file. If node data is
+  requested, the nodes are created.
+
+  input:
+  filename:   the name of the file
+
+  output:
+  elem_size:  the number of values per element
+  elem_data:  the element values (elem_size values per local element)
+  node_size:  the number of values per node
+  node_data:  the node values (node_size values per local node in the
+              order returned by getNodeNumbers())
+
+  returns:    non-zero on failure
+*/
+int TMROctForest::readFromFile( const char *filename,
+                                int *_elem_size, double **_elem_data,
+                                int *_node_size, double **_node_data ){
+  if (_elem_size){ *_elem_size = 0; }
+  if (_elem_data){ *_elem_data = NULL; }
+  if (_node_size){ *_node_size = 0; }
+  if (_node_data){ *_node_data = NULL; }
+
+  MPI_File fp;
+  if (MPI_File_open(comm, (char*)filename, MPI_MODE_RDONLY,
+                    MPI_INFO_NULL, &fp) != MPI_SUCCESS){
+    fprintf(stderr, "[%d] TMROctForest: Could not open file %s\n",
+            mpi_rank, filename);
+    return 1;
+  }
+
+  // Read in the header
+  int64_t header[TMR_FILE_HEADER_SIZE];
+  MPI_Offset offset = 0;
+  MPI_File_read_at_all(fp, offset, header, TMR_FILE_HEADER_SIZE,
+                       MPI_INT64_T, MPI_STATUS_IGNORE);
+  offset += TMR_FILE_HEADER_SIZE*sizeof(int64_t);
+
+  if (header[0] != TMR_OCT_FILE_ID || header[1] != TMR_FILE_VERSION){
+    fprintf(stderr, "[%d] TMROctForest: %s is not a forest of octrees\n",
+            mpi_rank, filename);
+    MPI_File_close(&fp);
+    return 1;
+  }
+
+  const int elem_size = header[4];
+  const int node_size = header[5];
+  const int file_num_blocks = header[9];
+  const int64_t num_elements = header[10];
+
+  // Read in the block connectivity
+  int *file_block_conn = new int[ 8*file_num_blocks ];
+  int *file_block_edge_conn = new int[ 12*file_num_blocks ];
+  int *file_block_face_conn = new int[ 6*file_num_blocks ];
+  MPI_File_read_at_all(fp, offset, file_block_conn, 8*file_num_blocks,
+                       MPI_INT, MPI_STATUS_IGNORE);
+  offset += 8*file_num_blocks*sizeof(int);
+  MPI_File_read_at_all(fp, offset, file_block_edge_conn, 12*file_num_blocks,
+                       MPI_INT, MPI_STATUS_IGNORE);
+  offset += 12*file_num_blocks*sizeof(int);
+  MPI_File_read_at_all(fp, offset, file_block_face_conn, 6*file_num_blocks,
+                       MPI_INT, MPI_STATUS_IGNORE);
+  offset += 6*file_num_blocks*sizeof(int);
+
+  int fail = 0;
+  if (block_conn){
+    // Check that the existing connectivity matches the file
+    if (num_blocks != file_num_blocks ||
+        num_nodes != header[6] || num_edges != header[7] ||
+        num_faces != header[8] ||
+        memcmp(block_conn, file_block_conn, 
+               8*num_blocks*sizeof(int)) != 0 ||
+        memcmp(block_edge_conn, file_block_edge_conn,
+               12*num_blocks*sizeof(int)) != 0 ||
+        memcmp(block_face_conn, file_block_face_conn,
+               6*num_blocks*sizeof(int)) != 0){
+      fprintf(stderr, "[%d] TMROctForest: Connectivity in %s does not "
+              "match the forest\n", mpi_rank, filename);
+      fail = 1;
+    }
+    else {
+      freeMeshData();
+    }
+  }
+  else {
+    setFullConnectivity(header[6], header[7], header[8], file_num_blocks,
+                        file_block_conn, file_block_edge_conn,
+                        file_block_face_conn);
+  }
+  delete [] file_block_conn;
+  delete [] file_block_edge_conn;
+  delete [] file_block_face_conn;
+
+  if (fail){
+    MPI_File_close(&fp);
+    return fail;
+  }
+
+  // Set the mesh order from the file
+  setMeshOrder(header[2], (TMRInterpolationType)header[3]);
+
+  // Split the octants evenly between the processors
+  int64_t average_count = num_elements/mpi_size;
+  int64_t remain = num_elements - average_count*mpi_size;
+  int64_t start = mpi_rank*average_count;
+  start += (mpi_rank < remain ? mpi_rank : remain);
+  int size = average_count + (mpi_rank < remain ? 1 : 0);
+
+  // Read in the local octants
+  int oct_size;
+  MPI_Type_size(TMROctant_MPI_type, &oct_size);
+  TMROctant *array = new TMROctant[ size ];
+  MPI_File_read_at_all(fp, offset + start*oct_size, array, size,
+                       TMROctant_MPI_type, MPI_STATUS_IGNORE);
+  offset += num_elements*oct_size;
+
+  // Set the local octants and their owners
+  for ( int i = 0; i < size; i++ ){
+    array[i].tag = i;
+  }
+  octants = new TMROctantArray(array, size);
+
+  // Set the first octant on each processor. Processors without
+  // octants take the owner from the preceding processor.
+  TMROctant p;
+  p.block = num_blocks-1;
+  p.tag = -1;
+  p.level = 0;
+  p.info = 0;
+  p.x = p.y = p.z = 1 << TMR_MAX_LEVEL;
+  if (size > 0){
+    p = array[0];
+  }
+  owners = new TMROctant[ mpi_size ];
+  MPI_Allgather(&p, 1, TMROctant_MPI_type, 
+                owners, 1, TMROctant_MPI_type, comm);
+  for ( int k = 1; k < mpi_size; k++ ){
+    if (owners[k].tag == -1){
+      owners[k] = owners[k-1];
+    }
+  }
+
+  // Read in the element data
+  if (elem_size > 0){
+    MPI_Offset data_size = elem_size*sizeof(double);
+    double *elem_data = new double[ elem_size*size ];
+    MPI_File_read_at_all(fp, offset + start*data_size,
+                         elem_data, elem_size*size, MPI_DOUBLE,
+                         MPI_STATUS_IGNORE);
+    offset += num_elements*data_size;
+
+    if (_elem_size){ *_elem_size = elem_size; }
+    if (_elem_data){ *_elem_data = elem_data; }
+    else { delete [] elem_data; }
+  }
+
+  // Read in the node data and set it at the local nodes
+  if (node_size > 0 && _node_data){
+    const int nodes_per_element = mesh_order*mesh_order*mesh_order;
+    const int elem_node_size = node_size*nodes_per_element;
+    MPI_Offset data_size = elem_node_size*sizeof(double);
+    double *values = new double[ elem_node_size*size ];
+    MPI_File_read_at_all(fp, offset + start*data_size,
+                         values, elem_node_size*size, MPI_DOUBLE,
+                         MPI_STATUS_IGNORE);
+
+    createNodes();
+    double *node_data = new double[ node_size*num_local_nodes ];
+    for ( int i = 0; i < size; i++ ){
+      for ( int j = 0; j < nodes_per_element; j++ ){
+        int index = getLocalNodeNumber(conn[nodes_per_element*i + j]);
+        memcpy(&node_data[node_size*index],
+               &values[elem_node_size*i + node_size*j],
+               node_size*sizeof(double));
+      }
+    }
+    delete [] values;
+
+    if (_node_size){ *_node_size = node_size; }
+    *_node_data = node_data;
+  }
+
+  MPI_File_close(&fp);
+
+  return 0;
+}
+
+/*
+  Get the memory usage of the forest on this processor
+
+  The entries are the number of bytes currently allocated for each
+  group of arrays. The high-water marks record the largest memory
+  usage, including the transient hash tables, queues and arrays,
+  observed during balance() and createNodes().
+
+  output:
+  usage:   the memory usage object (entries are added to it)
+*/
+void TMROctForest::getMemoryUsage( TMRMemoryUsage *usage ){
+  size_t bytes = 0;
+  if (octants){
+    bytes = octants->getMemoryUsage();
+  }
+  usage->add("octants", bytes);
+
+  bytes = 0;
+  if (adjacent){
+    bytes = adjacent->getMemoryUsage();
+  }
+  usage->add("adjacent", bytes);
+
+  bytes = 0;
+  if (owners){
+    bytes = mpi_size*sizeof(TMROctant);
+  }
+  usage->add("owners", bytes);
+
+  // The element to node connectivity
+  bytes = 0;
+  if (conn && octants){
+    int num_elements;
+    octants->getArray(NULL, &num_elements);
+    bytes = mesh_order*mesh_order*mesh_order*num_elements*sizeof(int);
+  }
+  usage->add("conn", bytes);
+
+  // The local node numbers and the ownership ranges
+  bytes = 0;
+  if (node_numbers){
+    bytes += num_local_nodes*sizeof(int);
+  }
+  if (node_range){
+    bytes += (mpi_size+1)*sizeof(int);
+  }
+  usage->add("node_numbers", bytes);
+
+  // The dependent node connectivity and weights
+  bytes = 0;
+  if (dep_ptr){
+    bytes += (num_dep_nodes+1)*sizeof(int);
+    if (dep_conn){
+      bytes += dep_ptr[num_dep_nodes]*sizeof(int);
+    }
+    if (dep_tmpl){
+      bytes += num_dep_nodes*sizeof(int);
+    }
+    if (dep_weights){
+      bytes += dep_ptr[num_dep_nodes]*sizeof(double);
+    }
+  }
+  usage->add("dep_nodes", bytes);
+
+  bytes = 0;
+  if (X){
+    bytes = num_local_nodes*sizeof(TMRPoint);
+  }
+  usage->add("X", bytes);
+
+  // The block connectivity tables (the same on all processors)
+  bytes = 0;
+  if (block_conn){
+    bytes += 8*num_blocks*sizeof(int);
+  }
+  if (block_face_conn){
+    bytes += 6*num_blocks*sizeof(int);
+  }
+  if (block_face_ids){
+    bytes += 6*num_blocks*sizeof(int);
+  }
+  if (block_edge_conn){
+    bytes += 12*num_blocks*sizeof(int);
+  }
+  if (node_block_ptr){
+    bytes += (num_nodes+1 + node_block_ptr[num_nodes])*sizeof(int);
+  }
+  if (edge_block_ptr){
+    bytes += (num_edges+1 + edge_block_ptr[num_edges])*sizeof(int);
+  }
+  if (face_block_ptr){
+    bytes += (num_faces+1 + face_block_ptr[num_faces])*sizeof(int);
+  }
+  if (face_block_owners){
+    bytes += num_faces*sizeof(int);
+  }
+  if (edge_block_owners){
+    bytes += num_edges*sizeof(int);
+  }
+  if (node_block_owners){
+    bytes += num_nodes*sizeof(int);
+  }
+  usage->add("connectivity", bytes);
+
+  // The interpolation knots and tables
+  bytes = 0;
+  if (interp_knots){
+    bytes += mesh_order*sizeof(double);
+  }
+  if (dep_interp){
+    bytes += 2*mesh_order*mesh_order*sizeof(double);
+  }
+  if (interp_tables){
+    bytes += interp_tables->getMemoryUsage();
+  }
+  usage->add("interp", bytes);
+
+  // The attribute index
+  bytes = 0;
+  if (attr_octs){
+    bytes += num_attrs*(sizeof(char*) + sizeof(TMROctantArray*));
+    for ( int k = 0; k < num_attrs; k++ ){
+      if (attr_names[k]){
+        bytes += strlen(attr_names[k])+1;
+      }
+      bytes += attr_octs[k]->getMemoryUsage();
+    }
+  }
+  if (attr_node_ptr){
+    bytes += (num_attrs+1 + attr_node_ptr[num_attrs])*sizeof(int);
+  }
+  usage->add("attr_index", bytes);
+
+  usage->addPeak("balance_peak", balance_peak_memory);
+  usage->addPeak("create_nodes_peak", nodes_peak_memory);
+}
+
+/*
+  Get the total memory currently held by the forest. This traverses
+  all of the arrays, so it is only called once within balance()
+  and createNodes(). The resident memory is then adjusted
+  as the octants are replaced.
+*/
+size_t TMROctForest::getResidentMemory(){
+  TMRMemoryUsage usage;
+  getMemoryUsage(&usage);
+  return usage.getTotal();
+}
+
+/*
+  Update the high-water mark with the resident memory of the forest
+  plus the given transient memory
+*/
+void TMROctForest::updatePeakMemory( size_t *peak, size_t resident,
+                                     size_t transient ){
+  size_t bytes = resident + transient;
+  if (bytes > *peak){
+    *peak = bytes;
+  }
+}
+
+/*
+  Free the mesh element data if it exists
+*/
+void TMROctForest::setMeshOrder( int _mesh_order,
+                                 TMRInterpolationType _interp_type ){
+  // Don't free the octants/owner information if it exists, 
+  // but free the connectivity and node data
+  freeMeshData(0, 0);
+
+  // Free the interpolation knots
+  if (interp_knots){
+    delete [] interp_knots;
+  }
+
+  // Check that the order falls within allowable bounds
+  mesh_order = _mesh_order;
+  if (mesh_order < 2){
     mesh_order = 2;
   }
   else if (mesh_order > MAX_ORDER){
@@ -1494,6 +2236,63 @@ void TMROctForest::setMeshOrder( int _mesh_order,
       interp_knots[i] = -1.0 + 2.0*i/(mesh_order-1);
     }
   }
+
+  // Reset the cached interpolation tables
+  if (interp_tables){
+    interp_tables->clear();
+  }
+  else {
+    interp_tables = new TMRInterpTableCache();
+  }
+
+  // Compute the tables at the knots and child knots
+  double pts[3*MAX_ORDER];
+  lagrange_child_knots(mesh_order, interp_knots, pts);
+  interp_tables->getTable(mesh_order, interp_knots, 3*mesh_order, pts,
+                          NULL, NULL);
+
+  // Compute the weights for the dependent node templates
+  computeDepInterpTable();
+}
+
+/*
+  Compute the 1D interpolation table for the dependent nodes
+
+  The weights for any dependent node depend only on the mesh order,
+  the interpolation knots, the position of the child within the
+  parent and the local knot index of the dependent node. The
+  dependent nodes along an edge use a single row of this table, while
+  the dependent nodes on a face use the tensor product of two rows.
+*/
+void TMROctForest::computeDepInterpTable(){
+  if (dep_interp){
+    delete [] dep_interp;
+  }
+
+  dep_interp = new double[ 2*mesh_order*mesh_order ];
+  for ( int x = 0; x < 2; x++ ){
+    for ( int k = 0; k < mesh_order; k++ ){
+      // Compute the parametric location of the knot on the parent
+      double u = 1.0*(x-1) + 0.5*(1.0 + interp_knots[k]);
+      lagrange_shape_functions(mesh_order, u, interp_knots,
+                               &dep_interp[mesh_order*(mesh_order*x + k)]);
+    }
+  }
+}
+
+/*
+  Set the number of threads used to evaluate the node locations
+
+  The geometry evaluation is performed in parallel over contiguous
+  ranges of the nodes. The threads are only used when all of the
+  volumes report that concurrent calls to evalPoints are safe through
+  isThreadSafe(). Otherwise the nodes are evaluated serially.
+*/
+void TMROctForest::setNumThreads( int _num_threads ){
+  num_threads = _num_threads;
+  if (num_threads < 1){
+    num_threads = 1;
+  }
 }
 
 /*
@@ -1621,6 +2420,32 @@ void TMROctForest::evalInterp( const double pt[], double N[],
   }
 }
 
+/*
+  Retrieve the 1D shape functions and their derivatives evaluated at
+  the given parametric points.
+
+  The tables are cached by the forest so that repeated requests with
+  the same points do not recompute the shape functions. The returned
+  tables have npts rows of length mesh_order and remain valid until
+  the mesh order is changed. The cache is not thread-safe, so this
+  must not be called concurrently.
+
+  input:
+  npts:   the number of parametric points
+  pts:    the parametric points
+
+  output:
+  N:      the shape functions at each point
+  Nd:     the derivatives of the shape functions at each point
+
+  returns: the mesh order (the length of each row)
+*/
+int TMROctForest::getInterpTable( int npts, const double pts[],
+                                  const double **_N, const double **_Nd ){
+  interp_tables->getTable(mesh_order, interp_knots, npts, pts, _N, _Nd);
+  return mesh_order;
+}
+
 /*
   Retrieve information about the connectivity between 
   blocks, faces, edges and nodes
@@ -1658,10 +2483,45 @@ void TMROctForest::getInverseConnectivity( const int **_node_block_conn,
   if (_face_block_ptr){ *_face_block_ptr = face_block_ptr; }
 }
 
+/*
+  Set the octant at the given position along the space-filling curve
+  of a forest where every block is uniformly refined to the given
+  level. Within each block, the octants are ordered by their Morton
+  index where the x-coordinate is the most significant.
+*/
+static void get_uniform_octant( int64_t index, int32_t level, 
+                                TMROctant *oct ){
+  const int64_t nblock = 1LL << (3*level);
+  const int64_t m = index % nblock;
+
+  // Extract the x/y/z bits from the interleaved Morton index
+  int32_t x = 0, y = 0, z = 0;
+  for ( int32_t k = 0; k < level; k++ ){
+    z |= ((m >> (3*k)) & 1) << k;
+    y |= ((m >> (3*k+1)) & 1) << k;
+    x |= ((m >> (3*k+2)) & 1) << k;
+  }
+
+  oct->tag = 0;
+  oct->block = index/nblock;
+  oct->level = level;
+  oct->info = 0;
+  oct->x = x << (TMR_MAX_LEVEL - level);
+  oct->y = y << (TMR_MAX_LEVEL - level);
+  oct->z = z << (TMR_MAX_LEVEL - level);
+}
+
 /*
   Allocate the trees for each element within the mesh
+
+  Every block is refined uniformly, so the position of each octant
+  along the space-filling curve is known in advance. The octants are
+  split evenly across the processors and each processor generates
+  only its own range, directly in sorted order. The owners are
+  computed in the same manner without any communication.
 */
 void TMROctForest::createTrees( int refine_level ){
+  TMRPerfBegin(TMR_PERF_CREATE_TREES);
   // Free all of the mesh data
   freeMeshData();
 
@@ -1674,81 +2534,50 @@ void TMROctForest::createTrees( int refine_level ){
     level = TMR_MAX_LEVEL-1;
   }
 
-  // Set who owns what blocks
-  int nblocks = num_blocks/mpi_size;
-  int remain = num_blocks % mpi_size;
-  int start = mpi_rank*nblocks;
-  int end = (mpi_rank+1)*nblocks;
-  if (mpi_rank < remain){
-    nblocks += 1;
-    start += mpi_rank;
-    end += mpi_rank+1;
-  }
-  else {
-    start += remain;
-    end += remain;
-  }
-  
-  // Create an array of the octants that will be stored
-  int nelems = 1 << refine_level;
-  int size = nelems*nelems*nelems*nblocks;
-  TMROctant *array = new TMROctant[ size ];
-
-  // Generate all of the octants on the associated blocks
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;
-  const int32_t h = 1 << (TMR_MAX_LEVEL - level);
-  for ( int count = 0, block = start; block < end; block++ ){
-    for ( int32_t x = 0; x < hmax; x += h ){
-      for ( int32_t y = 0; y < hmax; y += h ){
-        for ( int32_t z = 0; z < hmax; z += h ){
-          array[count].tag = 0;
-          array[count].block = block;
-          array[count].level = level;
-          array[count].info = 0;
-          array[count].x = x;
-          array[count].y = y;
-          array[count].z = z;
-          count++;
-        }
-      }
-    }
-  }
+  // Compute the total number of octants in the forest and the
+  // number of octants on each processor
+  const int64_t num_elements = (1LL << (3*level))*num_blocks;
+  const int64_t nocts = num_elements/mpi_size;
+  const int64_t remain = num_elements % mpi_size;
 
-  // Create the array of octants
-  octants = new TMROctantArray(array, size);
-  octants->sort();
+  // Set the range of octants owned by this processor
+  int64_t start = mpi_rank*nocts + (mpi_rank < remain ? mpi_rank : remain);
+  int size = nocts + (mpi_rank < remain ? 1 : 0);
 
-  // Set the local reordering for the elements
-  int oct_size;
-  TMROctant *octs;
-  octants->getArray(&octs, &oct_size);
-  for ( int i = 0; i < oct_size; i++ ){
-    octs[i].tag = i;
+  // Generate the octants in order along the space-filling curve
+  TMROctant *array = new TMROctant[ size ];
+  for ( int i = 0; i < size; i++ ){
+    get_uniform_octant(start + i, level, &array[i]);
+    array[i].tag = i;
   }
 
-  // Set the last octant
-  TMROctant p;
-  p.block = num_blocks-1;
-  p.tag = -1;
-  p.level = 0;
-  p.info = 0;
-  p.x = p.y = p.z = hmax;
-  if (size > 0){
-    p = array[0];
-  }
+  // Create the array of octants - this is already sorted
+  octants = new TMROctantArray(array, size);
 
+  // Set the first octant on each processor. Processors that have
+  // no octants take the owner of the previous processor.
+  const int32_t hmax = 1 << TMR_MAX_LEVEL;
   if (owners){ delete [] owners; }
   owners = new TMROctant[ mpi_size ];
-  MPI_Allgather(&p, 1, TMROctant_MPI_type, 
-                owners, 1, TMROctant_MPI_type, comm);
-
-  // Set the offsets if some of the processors have zero
-  // octants
-  for ( int k = 1; k < mpi_size; k++ ){
-    if (owners[k].tag == -1){
+  for ( int k = 0; k < mpi_size; k++ ){
+    int64_t k_start = k*nocts + (k < remain ? k : remain);
+    if (k_start < num_elements){
+      get_uniform_octant(k_start, level, &owners[k]);
+    }
+    else if (k > 0){
       owners[k] = owners[k-1];
     }
+    else {
+      owners[k].tag = -1;
+      owners[k].block = num_blocks-1;
+      owners[k].level = 0;
+      owners[k].info = 0;
+      owners[k].x = owners[k].y = owners[k].z = hmax;
+    }
   }
+
+  TMRPerfAdd(TMR_PERF_ELEMENTS_CREATED, size);
+  TMRPerfEnd(TMR_PERF_CREATE_TREES);
 }
 
 /*
@@ -1756,6 +2585,7 @@ void TMROctForest::createTrees( int refine_level ){
 */
 void TMROctForest::createRandomTrees( int nrand,
                                       int min_level, int max_level ){
+  TMRPerfBegin(TMR_PERF_CREATE_TREES);
   // Free all the mesh-specific data
   freeMeshData();
 
@@ -1832,12 +2662,205 @@ void TMROctForest::createRandomTrees( int nrand,
       owners[k] = owners[k-1];
     }
   }
+  TMRPerfAdd(TMR_PERF_ELEMENTS_CREATED, oct_size);
+  TMRPerfEnd(TMR_PERF_CREATE_TREES);
 }
+/*
+  Create a forest of octrees that is refined to match the element
+  feature size
+
+  The forest is constructed top-down starting from a uniform forest
+  at min_level. At each level, the physical locations of the corners
+  and the center of all the pending octants are evaluated in a batch
+  along with the feature size at each of these points. An octant is
+  subdivided if the length of any of its edges in physical space
+  exceeds the smallest feature size sampled within it. The octants
+  are subdivided independently on each processor so no communication
+  is required until the forest is repartitioned and balanced. Only
+  the first child of each family is passed to balance(), which
+  creates the siblings.
+
+  input:
+  fs:              the element feature size
+  min_level:       the minimum refinement level
+  max_level:       the maximum refinement level
+  balance_corner:  balance the corners of the forest
+*/
+void TMROctForest::createRefinedTrees( TMRElementFeatureSize *fs,
+                                       int min_level, int max_level,
+                                       int balance_corner ){
+  if (min_level < 0){
+    min_level = 0;
+  }
+  if (max_level >= TMR_MAX_LEVEL){
+    max_level = TMR_MAX_LEVEL-1;
+  }
+  if (max_level < min_level){
+    max_level = min_level;
+  }
+
+  // Create the uniform forest at the minimum level
+  createTrees(min_level);
+  if (!topo || !fs){
+    fprintf(stderr, 
+            "TMROctForest: Cannot create refined trees without a "
+            "topology and feature size\n");
+    return;
+  }
+
+  TMRPerfBegin(TMR_PERF_CREATE_TREES);
+
+  // The octants that will not be refined further
+  TMROctantQueue *queue = new TMROctantQueue();
+
+  // The indices of the corners and center of each octant into the
+  // 3 x 3 x 3 grid of parameter values
+  int pts[27];
+  for ( int k = 0; k < 8; k++ ){
+    pts[3*k] = 2*(k % 2);
+    pts[3*k+1] = 2*((k % 4)/2);
+    pts[3*k+2] = 2*(k/4);
+  }
+  pts[24] = pts[25] = pts[26] = 1;
+
+  // The pairs of corners that define the edges of the octant
+  const int edge_corners[][2] = 
+    {{0, 1}, {2, 3}, {4, 5}, {6, 7},
+     {0, 2}, {1, 3}, {4, 6}, {5, 7},
+     {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+
+  // Get the pending octants on this processor
+  int size;
+  TMROctant *array;
+  octants->getArray(&array, &size);
+  TMROctant *pending = new TMROctant[ size ];
+  memcpy(pending, array, size*sizeof(TMROctant));
+
+  while (size > 0){
+    // Evaluate the points within all of the pending octants
+    TMRPoint *X = new TMRPoint[ 9*size ];
+    double *hvals = new double[ 9*size ];
+
+    // Keep track of the last volume to avoid repeated look ups
+    int block = -1;
+    TMRVolume *vol = NULL;
+
+    for ( int i = 0; i < size; i++ ){
+      if (pending[i].block != block){
+        block = pending[i].block;
+        topo->getVolume(block, &vol);
+      }
+
+      // Set the parametric locations of the points
+      const int32_t h = 1 << (TMR_MAX_LEVEL - pending[i].level);
+      double d = convert_to_coordinate(h);
+      double u = convert_to_coordinate(pending[i].x);
+      double v = convert_to_coordinate(pending[i].y);
+      double w = convert_to_coordinate(pending[i].z);
+      double pu[3], pv[3], pw[3];
+      for ( int k = 0; k < 3; k++ ){
+        pu[k] = u + 0.5*d*k;
+        pv[k] = v + 0.5*d*k;
+        pw[k] = w + 0.5*d*k;
+      }
+      vol->evalPoints(3, pu, 3, pv, 3, pw, 9, pts, &X[9*i]);
+    }
+
+    // Evaluate the feature size at all of the points
+    for ( int i = 0; i < 9*size; i++ ){
+      hvals[i] = fs->getFeatureSize(X[i]);
+    }
+
+    // Count up the number of octants that will be refined
+    int num_refine = 0;
+    for ( int i = 0; i < size; i++ ){
+      if (pending[i].level < max_level){
+        // Find the smallest feature size within the octant
+        double hmin = hvals[9*i];
+        for ( int k = 1; k < 9; k++ ){
+          if (hvals[9*i+k] < hmin){
+            hmin = hvals[9*i+k];
+          }
+        }
+
+        // Find the longest edge of the octant
+        const TMRPoint *Xc = &X[9*i];
+        double lmax = 0.0;
+        for ( int k = 0; k < 12; k++ ){
+          TMRPoint d;
+          d.x = Xc[edge_corners[k][1]].x - Xc[edge_corners[k][0]].x;
+          d.y = Xc[edge_corners[k][1]].y - Xc[edge_corners[k][0]].y;
+          d.z = Xc[edge_corners[k][1]].z - Xc[edge_corners[k][0]].z;
+          double l = sqrt(d.dot(d));
+          if (l > lmax){
+            lmax = l;
+          }
+        }
+
+        if (lmax > hmin){
+          // Mark the octant for refinement
+          pending[i].tag = -1;
+          num_refine++;
+          continue;
+        }
+      }
+
+      // Only the first child of each family is required since the
+      // siblings are added during the balancing
+      if (pending[i].childId() == 0){
+        queue->push(&pending[i]);
+      }
+    }
+
+    delete [] X;
+    delete [] hvals;
+
+    // Create the children of the refined octants
+    TMROctant *children = new TMROctant[ 8*num_refine ];
+    for ( int i = 0, count = 0; i < size; i++ ){
+      if (pending[i].tag == -1){
+        const int32_t h = 1 << (TMR_MAX_LEVEL - pending[i].level - 1);
+        for ( int k = 0; k < 8; k++, count++ ){
+          children[count] = pending[i];
+          children[count].tag = 0;
+          children[count].level = pending[i].level + 1;
+          children[count].x = pending[i].x + h*(k % 2);
+          children[count].y = pending[i].y + h*((k % 4)/2);
+          children[count].z = pending[i].z + h*(k/4);
+        }
+      }
+    }
+    delete [] pending;
+    pending = children;
+    size = 8*num_refine;
+  }
+  delete [] pending;
+
+  // Create the new array of octants
+  delete octants;
+  octants = queue->toArray();
+  delete queue;
+  octants->sort();
+
+  octants->getArray(&array, &size);
+  for ( int i = 0; i < size; i++ ){
+    array[i].tag = i;
+  }
+  TMRPerfAdd(TMR_PERF_ELEMENTS_CREATED, size);
+  TMRPerfEnd(TMR_PERF_CREATE_TREES);
+
+  // Distribute the octants evenly and balance the forest
+  repartition();
+  balance(balance_corner);
+  repartition();
+}
+
 
 /*
   Repartition the octants across all processors
 */
 void TMROctForest::repartition(){
+  TMRPerfBegin(TMR_PERF_REPARTITION);
   // Free everything but the octants
   freeMeshData(0);
 
@@ -1920,6 +2943,7 @@ void TMROctForest::repartition(){
         // Send the element array to the new owner
         MPI_Isend(&array[start], count, TMROctant_MPI_type,
                   i, 0, comm, &send_requests[send_count]);
+        TMRPerfAdd(TMR_PERF_BYTES_SENT, count*sizeof(TMROctant));
         send_count++;
       }
     }
@@ -1973,6 +2997,7 @@ void TMROctForest::repartition(){
   for ( int i = 0; i < size; i++ ){
     array[i].tag = i;
   }
+  TMRPerfEnd(TMR_PERF_REPARTITION);
 }
 
 /*
@@ -1983,7 +3008,24 @@ void TMROctForest::repartition(){
   and copies each individual tree.
 */
 TMROctForest *TMROctForest::duplicate(){
-  TMROctForest *dup = new TMROctForest(comm, mesh_order, interp_type);
+  return duplicate(mesh_order, interp_type);
+}
+
+/*
+  Duplicate the forest with a different mesh order
+
+  The octants and their parallel distribution are copied from this
+  forest. This can be used to create the p-levels of a multigrid
+  hierarchy, since createInterpolation() can be used between forests
+  with different mesh orders.
+
+  input:
+  order:        the mesh order of the new forest
+  interp_type:  the interpolation type of the new forest
+*/
+TMROctForest *TMROctForest::duplicate( int order,
+                                       TMRInterpolationType _interp_type ){
+  TMROctForest *dup = new TMROctForest(comm, order, _interp_type);
   if (block_conn){
     copyData(dup);
 
@@ -2051,6 +3093,7 @@ TMROctForest *TMROctForest::coarsen(){
 */
 void TMROctForest::refine( const int refinement[],
                            int min_level, int max_level ){
+  TMRPerfBegin(TMR_PERF_REFINE);
   // Free the mesh data
   freeMeshData(0, 0);
 
@@ -2213,6 +3256,8 @@ void TMROctForest::refine( const int refinement[],
   for ( int i = 0; i < size; i++ ){
     array[i].tag = i;
   }
+  TMRPerfAdd(TMR_PERF_ELEMENTS_CREATED, size);
+  TMRPerfEnd(TMR_PERF_REFINE);
 }
 
 /*
@@ -2376,6 +3421,7 @@ TMROctantArray *TMROctForest::sendOctants( TMROctantArray *list,
       int count = oct_ptr[i+1] - oct_ptr[i];
       MPI_Isend(&array[oct_ptr[i]], count, TMROctant_MPI_type, 
                 i, 0, comm, &send_request[j]);
+      TMRPerfAdd(TMR_PERF_BYTES_SENT, count*sizeof(TMROctant));
       j++;
     }
     else if (i == mpi_rank){
@@ -2428,57 +3474,25 @@ void TMROctForest::addFaceNeighbors( int face_index,
   // Determine the global face number
   int block = p.block;
   int face = block_face_conn[6*block + face_index];
-  int face_id = block_face_ids[6*block + face_index];
  
   // Set the size of the side-length of the octant
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;
   const int32_t h = 1 << (TMR_MAX_LEVEL - p.level);
 
-  // Get the u/v coordinates of this face on the owner
-  int32_t u, v;
-  if (face_index < 2){ // x-face
-    get_face_oct_coords(face_id, 2*h, p.y, p.z, &u, &v);
-  }
-  else if (face_index < 4){ // y-face
-    get_face_oct_coords(face_id, 2*h, p.x, p.z, &u, &v);
-  }
-  else { // z-face
-    get_face_oct_coords(face_id, 2*h, p.x, p.y, &u, &v);
-  }
+  // Get the transformations to the blocks adjacent to this face
+  const int *trans = &face_trans[block_face_trans_ptr[6*block + face_index]];
 
   // Loop over all the adjacent faces and add the block
-  for ( int ip = face_block_ptr[face]; ip < face_block_ptr[face+1]; ip++ ){
-    // Get the adjacent block and the face index on the adjacent block
+  for ( int ip = face_block_ptr[face]; 
+        ip < face_block_ptr[face+1]; ip++, trans++ ){
+    // Get the adjacent block
     int adjacent = face_block_conn[ip]/6;
     if (adjacent != block){
-      // Get the face index on the adjacent block
-      int adj_index = face_block_conn[ip] % 6;
-
-      // Get the face id for the matching face
-      face_id = block_face_ids[6*adjacent + adj_index];
-
-      // Get the neighboring octant on the face
+      // Transform the octant to the neighboring octant on the face
       TMROctant neighbor;
       neighbor.block = adjacent;
       neighbor.level = p.level;
       neighbor.info = 0;
-
-      // Set the coordinates from the owner to the destination face
-      if (adj_index < 2){
-        neighbor.x = (hmax - 2*h)*(adj_index % 2);
-        set_face_oct_coords(face_id, 2*h, u, v, 
-                            &neighbor.y, &neighbor.z);
-      }
-      else if (adj_index < 4){
-        neighbor.y = (hmax - 2*h)*(adj_index % 2);
-        set_face_oct_coords(face_id, 2*h, u, v, 
-                            &neighbor.x, &neighbor.z);
-      }
-      else {
-        neighbor.z = (hmax - 2*h)*(adj_index % 2);
-        set_face_oct_coords(face_id, 2*h, u, v, 
-                            &neighbor.x, &neighbor.y);
-      }
+      apply_block_transform(trans[0], 2*h, &p, &neighbor);
       
       // Find the octant owner and add the octant to the hash
       // tables and possibly queue
@@ -2521,63 +3535,23 @@ void TMROctForest::addEdgeNeighbors( int edge_index,
   int edge = block_edge_conn[12*block + edge_index];
   
   // Compute the edge length
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;
   const int32_t h = 1 << (TMR_MAX_LEVEL - p.level);
 
-  // Store the u coordinate along the edge
-  int32_t ucoord = 0;
-  if (edge_index < 4){
-    ucoord = p.x;
-  }
-  else if (edge_index < 8){
-    ucoord = p.y;
-  }
-  else {
-    ucoord = p.z;
-  }
-
-  // Retrieve the first and second node numbers
-  int n1 = block_conn[8*block + block_to_edge_nodes[edge_index][0]];
-  int n2 = block_conn[8*block + block_to_edge_nodes[edge_index][1]];
+  // Get the transformations to the blocks adjacent to this edge
+  const int *trans = &edge_trans[block_edge_trans_ptr[12*block + edge_index]];
 
   // Now, cycle through all the adjacent blocks
-  for ( int ip = edge_block_ptr[edge]; ip < edge_block_ptr[edge+1]; ip++ ){
+  for ( int ip = edge_block_ptr[edge]; 
+        ip < edge_block_ptr[edge+1]; ip++, trans++ ){
     // Get the block that is adjacent across this edge
     int adjacent = edge_block_conn[ip]/12;
     if (adjacent != block){
-      // Get the adjacent edge index
-      int adj_index = edge_block_conn[ip] % 12;
-
-      // Get the nodes on the adjacent block
-      int nn1 = block_conn[8*adjacent + block_to_edge_nodes[adj_index][0]];
-      int nn2 = block_conn[8*adjacent + block_to_edge_nodes[adj_index][1]];
-
-      // Add the octant to the list
-      int reverse = (n1 == nn2 && n2 == nn1);
-      int32_t u = ucoord;
-      if (reverse){
-        u = hmax - 2*h - ucoord;
-      }
-      
+      // Transform the octant to the neighboring octant on the edge
       TMROctant neighbor;
       neighbor.block = adjacent;
       neighbor.level = p.level;
       neighbor.info = 0;
-      if (adj_index < 4){
-        neighbor.x = u;
-        neighbor.y = (hmax - 2*h)*(adj_index % 2);
-        neighbor.z = (hmax - 2*h)*(adj_index/2);
-      }
-      else if (adj_index < 8){
-        neighbor.x = (hmax - 2*h)*(adj_index % 2);
-        neighbor.y = u;
-        neighbor.z = (hmax - 2*h)*((adj_index-4)/2);
-      }
-      else {
-        neighbor.x = (hmax - 2*h)*(adj_index % 2);
-        neighbor.y = (hmax - 2*h)*((adj_index-8)/2);
-        neighbor.z = u;
-      }
+      apply_block_transform(trans[0], 2*h, &p, &neighbor);
 
       // Find the octant owner and add the octant to the hash
       // tables and possibly queue
@@ -2847,6 +3821,13 @@ void TMROctForest::balanceOctant( TMROctant *oct,
   per edge) and balances across corners optionally.
 */
 void TMROctForest::balance( int balance_corner ){
+  TMRPerfBegin(TMR_PERF_BALANCE);
+  // The octants are replaced below, so the attribute index is invalid
+  freeAttributeIndex();
+
+  // The memory held by the forest, excluding the transient data
+  size_t resident = getResidentMemory();
+
   // Create a hash table for the balanced tree
   TMROctantHash *hash = new TMROctantHash();
   TMROctantHash *ext_hash = new TMROctantHash();
@@ -2879,8 +3860,15 @@ void TMROctForest::balance( int balance_corner ){
                   balance_corner, balance_tree);
   }
 
+  // Record the memory before the original octants are freed
+  updatePeakMemory(&balance_peak_memory, resident,
+                   hash->getMemoryUsage() + ext_hash->getMemoryUsage() +
+                   queue->getMemoryUsage());
+
   // Free the original octant array and set it to NULL
+  resident -= octants->getMemoryUsage();
   delete octants;
+  octants = NULL;
 
   while (queue->length() > 0){
     // Now continue until the queue of added octants is
@@ -2899,6 +3887,9 @@ void TMROctForest::balance( int balance_corner ){
   // Create a sorted list of local the 0-child octants. This can be
   // further reduced to limit the amount of memory passed between
   // processors
+  updatePeakMemory(&balance_peak_memory, resident,
+                   hash->getMemoryUsage() + ext_hash->getMemoryUsage() +
+                   queue->getMemoryUsage());
   TMROctantArray *elems0 = ext_hash->toArray();
   delete ext_hash;
   elems0->sort();
@@ -2983,6 +3974,9 @@ void TMROctForest::balance( int balance_corner ){
   }
 
   // Free the temporary elements
+  updatePeakMemory(&balance_peak_memory, resident,
+                   hash->getMemoryUsage() + queue->getMemoryUsage() +
+                   child0_elems->getMemoryUsage());
   delete child0_elems;
 
   // Turn the queue into an array
@@ -3007,6 +4001,7 @@ void TMROctForest::balance( int balance_corner ){
   // Set the elements into the octree
   octants = hash->toArray();
   octants->sort();
+  resident += octants->getMemoryUsage();
 
   // Get the octants and order their labels
   octants->getArray(&array, &size);
@@ -3015,7 +4010,11 @@ void TMROctForest::balance( int balance_corner ){
   }
 
   // Free the hash
+  updatePeakMemory(&balance_peak_memory, resident,
+                   hash->getMemoryUsage());
   delete hash;
+  TMRPerfAdd(TMR_PERF_ELEMENTS_CREATED, size);
+  TMRPerfEnd(TMR_PERF_BALANCE);
 }
 
 /*
@@ -3029,55 +4028,25 @@ void TMROctForest::addAdjacentFaceToQueue( int face_index,
   // Determine the global face number
   int block = p.block;
   int face = block_face_conn[6*block + face_index];
-  int face_id = block_face_ids[6*block + face_index];
  
   // Set the size of the side-length of the octant
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;
   const int32_t h = 1 << (TMR_MAX_LEVEL - p.level);
 
-  // Get the u/v coordinates of this face
-  int32_t u, v;
-  if (face_index < 2){ // x-face
-    get_face_oct_coords(face_id, h, p.y, p.z, &u, &v);
-  }
-  else if (face_index < 4){ // y-face
-    get_face_oct_coords(face_id, h, p.x, p.z, &u, &v);
-  }
-  else { // z-face
-    get_face_oct_coords(face_id, h, p.x, p.y, &u, &v);
-  }
+  // Get the transformations to the blocks adjacent to this face
+  const int *trans = &face_trans[block_face_trans_ptr[6*block + face_index]];
 
   // Loop over all the adjacent faces and add the block
-  for ( int ip = face_block_ptr[face]; ip < face_block_ptr[face+1]; ip++ ){
-    // Get the adjacent block and the face index on the adjacent block
+  for ( int ip = face_block_ptr[face]; 
+        ip < face_block_ptr[face+1]; ip++, trans++ ){
+    // Get the adjacent block
     int adjacent = face_block_conn[ip]/6;
     if (adjacent != block){
-      // Get the face index on the adjacent block
-      int adj_index = face_block_conn[ip] % 6;
-
-      // Get the face id for the matching face
-      face_id = block_face_ids[6*adjacent + adj_index];
-
       // Get the neighboring octant on the face
       TMROctant neighbor;
       neighbor.block = adjacent;
       neighbor.level = p.level;
       neighbor.info = 0;
-      if (adj_index < 2){
-        neighbor.x = (hmax - h)*(adj_index % 2);
-        set_face_oct_coords(face_id, h, u, v, 
-                            &neighbor.y, &neighbor.z);
-      }
-      else if (adj_index < 4){
-        neighbor.y = (hmax - h)*(adj_index % 2);
-        set_face_oct_coords(face_id, h, u, v, 
-                            &neighbor.x, &neighbor.z);
-      }
-      else {
-        neighbor.z = (hmax - h)*(adj_index % 2);
-        set_face_oct_coords(face_id, h, u, v, 
-                            &neighbor.x, &neighbor.y);
-      }
+      apply_block_transform(trans[0], h, &p, &neighbor);
       
       // Find the octant owner
       int owner = getOctantMPIOwner(&neighbor);
@@ -3102,63 +4071,23 @@ void TMROctForest::addAdjacentEdgeToQueue( int edge_index,
   int edge = block_edge_conn[12*block + edge_index];
   
   // Compute the edge length
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;
   const int32_t h = 1 << (TMR_MAX_LEVEL - p.level);
 
-  // Store the u coordinate along the edge
-  int32_t ucoord = 0;
-  if (edge_index < 4){
-    ucoord = p.x;
-  }
-  else if (edge_index < 8){
-    ucoord = p.y;
-  }
-  else {
-    ucoord = p.z;
-  }
-
-  // Retrieve the first and second node numbers
-  int n1 = block_conn[8*block + block_to_edge_nodes[edge_index][0]];
-  int n2 = block_conn[8*block + block_to_edge_nodes[edge_index][1]];
+  // Get the transformations to the blocks adjacent to this edge
+  const int *trans = &edge_trans[block_edge_trans_ptr[12*block + edge_index]];
 
-  // Now, cycle through all the adjacent faces
-  for ( int ip = edge_block_ptr[edge]; ip < edge_block_ptr[edge+1]; ip++ ){
+  // Now, cycle through all the adjacent blocks
+  for ( int ip = edge_block_ptr[edge]; 
+        ip < edge_block_ptr[edge+1]; ip++, trans++ ){
     // Get the block that is adjacent across this edge
     int adjacent = edge_block_conn[ip]/12;
     if (adjacent != block){
-      // Get the adjacent edge index
-      int adj_index = edge_block_conn[ip] % 12;
-
-      // Get the nodes on the adjacent block
-      int nn1 = block_conn[8*adjacent + block_to_edge_nodes[adj_index][0]];
-      int nn2 = block_conn[8*adjacent + block_to_edge_nodes[adj_index][1]];
-
-      // Add the octant to the list
-      int reverse = (n1 == nn2 && n2 == nn1);
-      int32_t u = ucoord;
-      if (reverse){
-        u = hmax - h - ucoord;
-      }
-      
+      // Get the neighboring octant on the edge
       TMROctant neighbor;
       neighbor.block = adjacent;
       neighbor.level = p.level;
       neighbor.info = 0;
-      if (adj_index < 4){
-        neighbor.x = u;
-        neighbor.y = (hmax - h)*(adj_index % 2);
-        neighbor.z = (hmax - h)*(adj_index/2);
-      }
-      else if (adj_index < 8){
-        neighbor.x = (hmax - h)*(adj_index % 2);
-        neighbor.y = u;
-        neighbor.z = (hmax - h)*((adj_index-4)/2);
-      }
-      else {
-        neighbor.x = (hmax - h)*(adj_index % 2);
-        neighbor.y = (hmax - h)*((adj_index-8)/2);
-        neighbor.z = u;
-      }
+      apply_block_transform(trans[0], h, &p, &neighbor);
       
       // Find the octant owner
       int owner = getOctantMPIOwner(&neighbor);
@@ -3226,6 +4155,7 @@ void TMROctForest::addAdjacentCornerToQueue( int corner,
   octrees should be freed after the nodal ordering has been computed.
 */
 void TMROctForest::computeAdjacentOctants(){
+  TMRPerfBegin(TMR_PERF_COMPUTE_ADJACENT);
   if (adjacent){
     delete adjacent;
   }
@@ -3408,6 +4338,7 @@ void TMROctForest::computeAdjacentOctants(){
   adjacent->sort();
 
   delete list;
+  TMRPerfEnd(TMR_PERF_COMPUTE_ADJACENT);
 }
 
 /*
@@ -3425,53 +4356,27 @@ void TMROctForest::computeAdjacentOctants(){
 int TMROctForest::checkAdjacentFaces( int face_index,
                                       TMROctant *neighbor ){
   // Get the side length of the octant
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;
   const int32_t h = 1 << (TMR_MAX_LEVEL - neighbor->level);
 
-  // Get the face id number
+  // Get the face number
   int block_owner = neighbor->block;
   int face = block_face_conn[6*block_owner + face_index];
-  int face_id = block_face_ids[6*block_owner + face_index];
 
-  // Get the u/v coordinates for this node on the owner face
-  int32_t u, v;
-  if (face_index < 2){ // x-face
-    get_face_oct_coords(face_id, h, neighbor->y, neighbor->z, &u, &v);
-  }
-  else if (face_index < 4){ // y-face
-    get_face_oct_coords(face_id, h, neighbor->x, neighbor->z, &u, &v);
-  }
-  else { // z-face
-    get_face_oct_coords(face_id, h, neighbor->x, neighbor->y, &u, &v);
-  }
+  // Get the transformations to the blocks adjacent to this face
+  const int *trans = 
+    &face_trans[block_face_trans_ptr[6*block_owner + face_index]];
 
   // Loop over all the adjacent faces/blocks
-  for ( int ip = face_block_ptr[face]; ip < face_block_ptr[face+1]; ip++ ){
+  for ( int ip = face_block_ptr[face]; 
+        ip < face_block_ptr[face+1]; ip++, trans++ ){
     int block = face_block_conn[ip]/6;
 
     if (block_owner != block){
-      int adj_index = face_block_conn[ip] % 6;
-
-      // Get the face_id corresponding to the orientation of this
-      // adjacent face
-      face_id = block_face_ids[6*block + adj_index];
-      
       // Transform the octant p to the local octant coordinates
       TMROctant oct;
       oct.block = block;
       oct.level = neighbor->level;
-      if (adj_index < 2){
-        oct.x = (hmax - h)*(adj_index % 2);
-        set_face_oct_coords(face_id, h, u, v, &oct.y, &oct.z);
-      }
-      else if (adj_index < 4){
-        oct.y = (hmax - h)*(adj_index % 2);
-        set_face_oct_coords(face_id, h, u, v, &oct.x, &oct.z);
-      }
-      else {
-        oct.z = (hmax - h)*(adj_index % 2);
-        set_face_oct_coords(face_id, h, u, v, &oct.x, &oct.y);
-      }
+      apply_block_transform(trans[0], h, neighbor, &oct);
       
       // If the more-refined element exists then label the
       // corresponding nodes as dependent
@@ -3498,65 +4403,27 @@ int TMROctForest::checkAdjacentFaces( int face_index,
 int TMROctForest::checkAdjacentEdges( int edge_index,
                                       TMROctant *neighbor ){
   // Get the side length of the octant
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;
   const int32_t h = 1 << (TMR_MAX_LEVEL - neighbor->level);
 
-  // Store the u coordinate along the edge
-  int32_t ucoord = 0;
-  if (edge_index < 4){
-    ucoord = neighbor->x;
-  }
-  else if (edge_index < 8){
-    ucoord = neighbor->y;
-  }
-  else {
-    ucoord = neighbor->z;
-  }
-
-  // Retrieve the first and second node numbers
+  // Get the edge number
   int block_owner = neighbor->block;
   int edge = block_edge_conn[12*block_owner + edge_index];
-  int n1 = block_conn[8*block_owner + block_to_edge_nodes[edge_index][0]];
-  int n2 = block_conn[8*block_owner + block_to_edge_nodes[edge_index][1]];
+
+  // Get the transformations to the blocks adjacent to this edge
+  const int *trans = 
+    &edge_trans[block_edge_trans_ptr[12*block_owner + edge_index]];
 
   // Now, cycle through all the adjacent edges
-  for ( int ip = edge_block_ptr[edge]; ip < edge_block_ptr[edge+1]; ip++ ){
+  for ( int ip = edge_block_ptr[edge]; 
+        ip < edge_block_ptr[edge+1]; ip++, trans++ ){
     int block = edge_block_conn[ip]/12;
 
     if (block_owner != block){
-      // Get the adjacent edge index
-      int adj_index = edge_block_conn[ip] % 12;
-
-      // Get the nodes on the adjacent block
-      int nn1 = block_conn[8*block + block_to_edge_nodes[adj_index][0]];
-      int nn2 = block_conn[8*block + block_to_edge_nodes[adj_index][1]];
-
-      // Add the octant to the list
-      int reverse = (n1 == nn2 && n2 == nn1);
-      int32_t u = ucoord;
-      if (reverse){
-        u = hmax - h - ucoord;
-      }
-
       // Search for the neighboring octant
       TMROctant oct;
       oct.block = block;
       oct.level = neighbor->level;
-      if (adj_index < 4){
-        oct.x = u;
-        oct.y = (hmax - h)*(adj_index % 2);
-        oct.z = (hmax - h)*(adj_index/2);
-      }
-      else if (adj_index < 8){
-        oct.x = (hmax - h)*(adj_index % 2);
-        oct.y = u;
-        oct.z = (hmax - h)*((adj_index-4)/2);
-      }
-      else {
-        oct.x = (hmax - h)*(adj_index % 2);
-        oct.y = (hmax - h)*((adj_index-8)/2);
-        oct.z = u;
-      }
+      apply_block_transform(trans[0], h, neighbor, &oct);
       
       // If the more-refined element exists then label the
       // corresponding nodes as dependent
@@ -3583,6 +4450,7 @@ int TMROctForest::checkAdjacentEdges( int edge_index,
   side effects:
 */
 void TMROctForest::computeDepFacesAndEdges(){
+  TMRPerfBegin(TMR_PERF_COMPUTE_DEP_FACES_EDGES);
   const int32_t hmax = 1 << TMR_MAX_LEVEL;
 
   // Get all of the octants owned by this processor
@@ -3669,6 +4537,7 @@ void TMROctForest::computeDepFacesAndEdges(){
       octs[i].info = 0;
     }
   }
+  TMRPerfEnd(TMR_PERF_COMPUTE_DEP_FACES_EDGES);
 }
 
 /*
@@ -3860,18 +4729,14 @@ void TMROctForest::transformNode( TMROctant *oct,
     else if ((fy && fz) || (fx && fz) || (fx && fy)){
       // This node lies on an edge
       int edge_index = 0;
-      int32_t u = 0;
       if (fy && fz){
         edge_index = (fy0 ? 0 : 1) + (fz0 ? 0 : 2);
-        u = oct->x;
       }
       else if (fx && fz){
         edge_index = (fx0 ? 4 : 5) + (fz0 ? 0 : 2);
-        u = oct->y;
       }
       else {
         edge_index = (fx0 ? 8 : 9) + (fy0 ? 0 : 2);
-        u = oct->z;
       }
 
       // Get the edge number
@@ -3883,44 +4748,19 @@ void TMROctForest::transformNode( TMROctant *oct,
         int adj = edge_block_conn[ptr]/12;
         int adj_index = edge_block_conn[ptr] % 12;
 
-        // Retrieve the first and second node numbers to determine the
-        // relative orientation between this edge and each adjacent edge
-        int n1 = block_conn[8*block + block_to_edge_nodes[edge_index][0]];
-        int n2 = block_conn[8*block + block_to_edge_nodes[edge_index][1]];
-        
-        int nn1 = block_conn[8*adj + block_to_edge_nodes[adj_index][0]];
-        int nn2 = block_conn[8*adj + block_to_edge_nodes[adj_index][1]];
-            
+        // Get the transformation to the edge owner
+        int trans = edge_trans[block_edge_trans_ptr[12*block + edge_index]];
+
         // Determine whether the edges are in the same direction
         // or are reversed
-        int reverse = (n1 == nn2 && n2 == nn1);
         if (edge_reversed){
-          *edge_reversed = reverse;
+          int code = (trans >> 3*(adj_index/4)) & 7;
+          *edge_reversed = (code & 1);
         }
 
-        // Set the u-coordinate along the edge
-        int32_t uoct = u;
-        if (reverse){
-          uoct = hmax - u;
-        }
-        
         // Transform the octant to the adjacent coordinate system
         oct->block = adj;
-        if (adj_index < 4){
-          oct->x = uoct;
-          oct->y = hmax*(adj_index % 2);
-          oct->z = hmax*(adj_index/2);
-        }
-        else if (adj_index < 8){
-          oct->x = hmax*(adj_index % 2);
-          oct->y = uoct;
-          oct->z = hmax*((adj_index-4)/2);
-        }
-        else {
-          oct->x = hmax*(adj_index % 2);
-          oct->y = hmax*((adj_index-8)/2);
-          oct->z = uoct;
-        }
+        apply_block_transform(trans, 0, oct, oct);
       }
     }
     else {
@@ -3940,61 +4780,28 @@ void TMROctForest::transformNode( TMROctant *oct,
           *src_face_id = face_id;
         }
 
-        // Get the u/v coordinates for this node on the owner face
-        int32_t u, v;
-        if (face_index < 2){ // x-face
-          get_face_node_coords(face_id, hmax, oct->y, oct->z, &u, &v);
-        }
-        else if (face_index < 4){ // y-face
-          get_face_node_coords(face_id, hmax, oct->x, oct->z, &u, &v);
-        }
-        else { // z-face
-          get_face_node_coords(face_id, hmax, oct->x, oct->y, &u, &v);
-        }
+        // Get the transformation to the face owner
+        int trans = face_trans[block_face_trans_ptr[6*block + face_index]];
 
-        // Compute the edge_reversed flag (if needed)
+        // Compute the edge_reversed flag (if needed) by finding the
+        // coordinate on the owner that is set from edge_dir
         if (edge_reversed){
           *edge_reversed = 0;
-          int32_t x = 0, y = 0, z = 0;
-          if (edge_dir == 0){ x = 1; }
-          else if (edge_dir == 1){ y = 1; }
-          else if (edge_dir == 2){ z = 1; }
-          if (face_index < 2){ // x-face
-            get_face_node_coords(face_id, 0, y, z, &y, &z);
-          }
-          else if (face_index < 4){ // y-face
-            get_face_node_coords(face_id, 0, x, z, &x, &z);
-          }
-          else { // z-face
-            get_face_node_coords(face_id, 0, x, y, &x, &y);
-          }
-          if (x < 0 || y < 0 || z < 0){
-            *edge_reversed = 1;
+          for ( int k = 0; k < 3; k++ ){
+            int code = (trans >> 3*k) & 7;
+            if (code >= 2 && (code - 2)/2 == edge_dir){
+              *edge_reversed = (code & 1);
+            }
           }
         }
 
         // Now find the owner block 
         int ptr = face_block_ptr[face];
         int adj = face_block_conn[ptr]/6;
-        int adj_index = face_block_conn[ptr] % 6;
           
         // Transform the octant p to the local octant coordinates
         oct->block = adj;
-        if (adj_index < 2){
-          oct->x = hmax*(adj_index % 2);
-          oct->y = u;
-          oct->z = v;
-        }
-        else if (adj_index < 4){
-          oct->x = u;
-          oct->y = hmax*(adj_index % 2);
-          oct->z = v;
-        }
-        else {
-          oct->x = u;
-          oct->y = v;
-          oct->z = hmax*(adj_index % 2);
-        }
+        apply_block_transform(trans, 0, oct, oct);
       }
     }
 
@@ -4035,6 +4842,11 @@ void TMROctForest::createNodes(){
     // there is no need to create it a second time.
     return;
   }
+
+  // The octants are labeled below, so the attribute index is invalid
+  freeAttributeIndex();
+
+  TMRPerfBegin(TMR_PERF_CREATE_NODES);
   
   // Send/recv the adjacent octants
   computeAdjacentOctants();
@@ -4147,6 +4959,11 @@ void TMROctForest::createNodes(){
   // other processors and referenced by the elements on this
   // processor.
   TMROctantArray *ext_array = ext_nodes->toArray();
+  size_t resident = getResidentMemory();
+  updatePeakMemory(&nodes_peak_memory, resident,
+                   nodes->getMemoryUsage() + node_size*sizeof(int) +
+                   ext_nodes->getMemoryUsage() +
+                   ext_array->getMemoryUsage());
   delete ext_nodes;
 
   // Sort based on the tags
@@ -4182,6 +4999,10 @@ void TMROctForest::createNodes(){
   TMROctantArray *return_nodes = sendOctants(dist_nodes, 
                                              recv_ptr, send_ptr,
                                              use_node_index);
+  updatePeakMemory(&nodes_peak_memory, resident,
+                   nodes->getMemoryUsage() + node_size*sizeof(int) +
+                   dist_nodes->getMemoryUsage() +
+                   return_nodes->getMemoryUsage());
   delete dist_nodes;
   delete [] recv_ptr;
   delete [] send_ptr;
@@ -4230,6 +5051,7 @@ void TMROctForest::createNodes(){
 
   // Evaluate the node locations
   evaluateNodeLocations();
+  TMRPerfEnd(TMR_PERF_CREATE_NODES);
 }
 
 /*
@@ -4253,6 +5075,7 @@ void TMROctForest::createNodes(){
   3. level represents the number of nodes represented by the quad
 */
 TMROctantArray *TMROctForest::createLocalNodes(){
+  TMRPerfBegin(TMR_PERF_CREATE_LOCAL_NODES);
   // Allocate the array of elements
   int num_elements;
   TMROctant *octs;
@@ -4624,6 +5447,8 @@ TMROctantArray *TMROctForest::createLocalNodes(){
   }
   delete owner_nodes;
 
+  TMRPerfEnd(TMR_PERF_CREATE_LOCAL_NODES);
+
   // Return the owners for each node
   return nodes;
 }
@@ -5161,14 +5986,21 @@ void TMROctForest::getFaceNodes( TMROctant *oct, int face_index,
   Create the dependent mesh information for all local dependent
   nodes.
 
+  The weights are not stored explicitly. Instead, each dependent node
+  is assigned a template index into the 1D table computed by
+  computeDepInterpTable(). Edge templates lie in [0, 2*order) and
+  select a single row of the table. Face templates are offset by
+  2*order and encode the rows in the u/v directions.
+
   output:
   ptr:      pointer for each dependent node number
   conn:     connectivity to each (global) independent node
-  weights:  the weight values for each dependent node
+  tmpl:     the weight template for each dependent node
 */
 void TMROctForest::createDependentConn( const int *node_nums,
                                         TMROctantArray *nodes,
                                         const int *node_offset ){
+  TMRPerfBegin(TMR_PERF_CREATE_DEPENDENT_CONN);
   // Allocate space for the connectivity
   dep_ptr = new int[ num_dep_nodes+1 ];
   memset(dep_ptr, 0, (num_dep_nodes+1)*sizeof(int));
@@ -5188,8 +6020,6 @@ void TMROctForest::createDependentConn( const int *node_nums,
   int *dep_edge_nodes = new int[ mesh_order ];
   int *face_nodes = new int[ mesh_order*mesh_order ];
   int *dep_face_nodes = new int[ mesh_order*mesh_order ];
-  double *Nu = new double[ mesh_order ];
-  double *Nv = new double[ mesh_order ];
 
   for ( int i = 0; i < num_elements; i++ ){
     if (octs[i].info){
@@ -5306,7 +6136,7 @@ void TMROctForest::createDependentConn( const int *node_nums,
 
   // Allocate the space for the node numbers
   dep_conn = new int[ dep_ptr[num_dep_nodes] ];
-  dep_weights = new double[ dep_ptr[num_dep_nodes] ];
+  dep_tmpl = new int[ num_dep_nodes ];
 
   // Loop over the elements again, this time setting the local
   // connectivity
@@ -5373,27 +6203,26 @@ void TMROctForest::createDependentConn( const int *node_nums,
                 int y = ((id % 4)/2);
                 int z = id/4;
 
-                // Compute parametric location along the edge
-                double u = 0.0;
+                // Compute the position of the child along the edge
+                int offset = 0;
                 if (edge_index < 4){
-                  u = 1.0*(x-1) + 0.5*(1.0 + interp_knots[k]);
+                  offset = x;
                 }
                 else if (edge_index < 8){
-                  u = 1.0*(y-1) + 0.5*(1.0 + interp_knots[k]);
+                  offset = y;
                 }
                 else {
-                  u = 1.0*(z-1) + 0.5*(1.0 + interp_knots[k]);
+                  offset = z;
                 }
                 
-                // Compute the shape functions
+                // Set the parent nodes
                 int ptr = dep_ptr[index];
                 for ( int j = 0; j < mesh_order; j++ ){
                   dep_conn[ptr + j] = edge_nodes[j];
                 }
                 
-                // Evaluate the shape functions
-                lagrange_shape_functions(mesh_order, u, interp_knots,
-                                         &dep_weights[ptr]);
+                // Set the edge template for this dependent node
+                dep_tmpl[index] = mesh_order*offset + k;
               }
             }
           }
@@ -5447,42 +6276,39 @@ void TMROctForest::createDependentConn( const int *node_nums,
       
                 int len = dep_ptr[index+1] - dep_ptr[index];
                 if (len == mesh_order*mesh_order){
-                  // Compute the distance along the edges
-                  double u = -1.0 + 0.5*(1.0 + interp_knots[ii]);
-                  double v = -1.0 + 0.5*(1.0 + interp_knots[jj]);
-
                   // Compute the offsets to add (if any)
                   int x = id % 2;
                   int y = ((id % 4)/2);
                   int z = id/4;
 
+                  // Compute the rows of the 1D table in the u/v
+                  // directions along the face
+                  int urow = ii, vrow = jj;
                   if (face_index < 2){
                     // add the y/z components
-                    u += 1.0*y;
-                    v += 1.0*z;
+                    urow += mesh_order*y;
+                    vrow += mesh_order*z;
                   }
                   else if (face_index < 4){
                     // add the x/z components
-                    u += 1.0*x;
-                    v += 1.0*z;
+                    urow += mesh_order*x;
+                    vrow += mesh_order*z;
                   }
                   else {
                     // add the x/y components
-                    u += 1.0*x;
-                    v += 1.0*y;
+                    urow += mesh_order*x;
+                    vrow += mesh_order*y;
                   }
 
-                  // Evaluate the shape functions
-                  lagrange_shape_functions(mesh_order, u, interp_knots, Nu);
-                  lagrange_shape_functions(mesh_order, v, interp_knots, Nv);
-                  
-                  // Add the appropriate offset along the u/v directions
+                  // Set the parent nodes
                   int ptr = dep_ptr[index];
                   for ( int j = 0; j < mesh_order*mesh_order; j++ ){
                     dep_conn[ptr + j] = face_nodes[j];
-                    dep_weights[ptr + j] = 
-                      Nu[j % mesh_order]*Nv[j / mesh_order];
                   }
+
+                  // Set the face template for this dependent node
+                  dep_tmpl[index] = 
+                    2*mesh_order*(1 + vrow) + urow;
                 }
               }
             }
@@ -5496,65 +6322,255 @@ void TMROctForest::createDependentConn( const int *node_nums,
   delete [] dep_edge_nodes;
   delete [] face_nodes;
   delete [] dep_face_nodes;
-  delete [] Nu;
-  delete [] Nv;
+  TMRPerfEnd(TMR_PERF_CREATE_DEPENDENT_CONN);
+}
+
+/*
+  Compare two parameter values for sorting
+*/
+static int compare_doubles( const void *a, const void *b ){
+  const double *aa = static_cast<const double*>(a);
+  const double *bb = static_cast<const double*>(b);
+
+  if (*aa < *bb){
+    return -1;
+  }
+  else if (*aa > *bb){
+    return 1;
+  }
+  return 0;
+}
+
+/*
+  Sort the values in place, remove the duplicates and return the
+  number of unique values
+*/
+static int sort_unique_doubles( int n, double *a ){
+  if (n == 0){
+    return 0;
+  }
+  qsort(a, n, sizeof(double), compare_doubles);
+  int k = 1;
+  for ( int i = 1; i < n; i++ ){
+    if (a[i] != a[k-1]){
+      a[k] = a[i];
+      k++;
+    }
+  }
+  return k;
+}
+
+/*
+  The arguments passed to each thread that evaluates node locations
+
+  The points are stored in runs that lie in the same volume. The
+  parameter values of run r are stored in params starting at
+  3*run_ptr[r] for each of the three coordinate directions.
+*/
+class TMROctNodeLocationArgs {
+ public:
+  int start, end;
+  int num_runs;
+  const int *run_ptr;
+  TMRVolume **vols;
+  const int *nparams;
+  const double *params;
+  const int *pts;
+  TMRPoint *Xpts;
+};
+
+/*
+  Evaluate the points in the range [start, end) of the point list
+*/
+static void evaluateOctNodeLocations( TMROctNodeLocationArgs *args ){
+  for ( int r = 0; r < args->num_runs; r++ ){
+    int s = args->run_ptr[r];
+    int e = args->run_ptr[r+1];
+    if (s < args->start){ s = args->start; }
+    if (e > args->end){ e = args->end; }
+    if (s >= e){
+      continue;
+    }
+
+    // Get the parameter values along each direction for this run
+    const int n = args->run_ptr[r+1] - args->run_ptr[r];
+    const double *u = &args->params[3*args->run_ptr[r]];
+    const double *v = &u[n];
+    const double *w = &u[2*n];
+    args->vols[r]->evalPoints(args->nparams[3*r], u,
+                              args->nparams[3*r+1], v,
+                              args->nparams[3*r+2], w,
+                              e - s, &args->pts[3*s], &args->Xpts[s]);
+  }
+}
+
+/*
+  The thread entry point for evaluating the node locations
+*/
+static void *evaluateOctNodeLocationsThread( void *args ){
+  TMRSetPerfThreadTimers(0);
+  evaluateOctNodeLocations((TMROctNodeLocationArgs*)args);
+  pthread_exit(NULL);
+  return NULL;
 }
 
 /*
   Evaluate the node locations based on the parametric locations
+
+  Each local node is assigned to the first element that references it
+  and the nodes are collected into runs of points that lie in the same
+  volume. The parameter values of each run are sorted and the
+  duplicates are removed, so that each point is given by indices into
+  the unique parameter values. TMRVolume::evalPoints is then called
+  once for each run, so the geometry can evaluate the edges and faces
+  once for each unique parameter value instead of once for each
+  node. The points are split into contiguous ranges that are
+  evaluated on separate threads when num_threads > 1, but only if all
+  of the volumes report that they are thread-safe.
 */
 void TMROctForest::evaluateNodeLocations(){
+  TMRPerfBegin(TMR_PERF_EVALUATE_NODE_LOCATIONS);
   // Allocate the array of locally owned nodes
   X = new TMRPoint[ num_local_nodes ];
   memset(X, 0, num_local_nodes*sizeof(TMRPoint));
 
-  int *flags = new int[ num_local_nodes ];
-  memset(flags, 0, num_local_nodes*sizeof(int));
-
   int num_elements;
   TMROctant *octs;
   octants->getArray(&octs, &num_elements);
 
   if (topo){
-    for ( int i = 0; i < num_elements; i++ ){
-      // Get the right surface
-      TMRVolume *vol;
-      topo->getVolume(octs[i].block, &vol);
-
-      // Compute the edge length
-      const int32_t h = 1 << (TMR_MAX_LEVEL - octs[i].level);
+    const int nodes_per_element = mesh_order*mesh_order*mesh_order;
+
+    // Assign each node to the first element that references it and
+    // record its parametric location
+    int npts = 0;
+    int *nodes = new int[ num_local_nodes ];
+    double *pt_params = new double[ 3*num_local_nodes ];
+    int *flags = new int[ num_local_nodes ];
+    memset(flags, 0, num_local_nodes*sizeof(int));
+
+    // The runs of points that lie in the same volume
+    int num_runs = 0, block = -1;
+    int *run_ptr = new int[ num_elements+1 ];
+    TMRVolume **vols = new TMRVolume*[ num_elements ];
+    run_ptr[0] = 0;
 
+    for ( int i = 0; i < num_elements; i++ ){
       // Compute the origin of the element in parametric space
       // and the edge length of the element
+      const int32_t h = 1 << (TMR_MAX_LEVEL - octs[i].level);
       double d = convert_to_coordinate(h);
       double u = convert_to_coordinate(octs[i].x);
       double v = convert_to_coordinate(octs[i].y);
       double w = convert_to_coordinate(octs[i].z);
 
-      // Set the offset into the connectivity array
-      const int *c = &conn[mesh_order*mesh_order*mesh_order*i];
-
-      // Look for nodes that are not assigned
+      const int *c = &conn[nodes_per_element*i];
       for ( int kk = 0; kk < mesh_order; kk++ ){
         for ( int jj = 0; jj < mesh_order; jj++ ){
           for ( int ii = 0; ii < mesh_order; ii++ ){
-            // Compute the mesh index
-            int node = c[ii + jj*mesh_order + kk*mesh_order*mesh_order];
-            int index = getLocalNodeNumber(node);
-            if (!flags[index]){
-              flags[index] = 1;
-              vol->evalPoint(u + 0.5*d*(1.0 + interp_knots[ii]),
-                             v + 0.5*d*(1.0 + interp_knots[jj]),
-                             w + 0.5*d*(1.0 + interp_knots[kk]),
-                             &X[index]);
+            int index = 
+              getLocalNodeNumber(c[ii + mesh_order*(jj + mesh_order*kk)]);
+            if (index < 0 || flags[index]){
+              continue;
+            }
+            flags[index] = 1;
+
+            // Start a new run when the volume changes
+            if (octs[i].block != block){
+              block = octs[i].block;
+              topo->getVolume(block, &vols[num_runs]);
+              run_ptr[num_runs] = npts;
+              num_runs++;
             }
+
+            nodes[npts] = index;
+            pt_params[3*npts] = u + 0.5*d*(1.0 + interp_knots[ii]);
+            pt_params[3*npts+1] = v + 0.5*d*(1.0 + interp_knots[jj]);
+            pt_params[3*npts+2] = w + 0.5*d*(1.0 + interp_knots[kk]);
+            npts++;
           }
         }
       }
     }
-  }
+    run_ptr[num_runs] = npts;
+    delete [] flags;
+
+    // Find the unique parameter values in each run and the indices
+    // of each point into these values
+    int thread_safe = 1;
+    int *nparams = new int[ 3*num_runs ];
+    double *params = new double[ 3*npts ];
+    int *pts = new int[ 3*npts ];
+    for ( int r = 0; r < num_runs; r++ ){
+      const int s = run_ptr[r];
+      const int n = run_ptr[r+1] - s;
+      for ( int k = 0; k < 3; k++ ){
+        double *p = &params[3*s + k*n];
+        for ( int j = 0; j < n; j++ ){
+          p[j] = pt_params[3*(s + j) + k];
+        }
+        nparams[3*r+k] = sort_unique_doubles(n, p);
+        for ( int j = 0; j < n; j++ ){
+          double *ptr = (double*)bsearch(&pt_params[3*(s + j) + k], p,
+                                         nparams[3*r+k], sizeof(double),
+                                         compare_doubles);
+          pts[3*(s + j) + k] = ptr - p;
+        }
+      }
+      if (!vols[r]->isThreadSafe()){
+        thread_safe = 0;
+      }
+    }
+    delete [] pt_params;
+
+    TMRPoint *Xpts = new TMRPoint[ npts ];
+    TMROctNodeLocationArgs args;
+    args.start = 0;
+    args.end = npts;
+    args.num_runs = num_runs;
+    args.run_ptr = run_ptr;
+    args.vols = vols;
+    args.nparams = nparams;
+    args.params = params;
+    args.pts = pts;
+    args.Xpts = Xpts;
+
+    if (num_threads > 1 && thread_safe && npts > num_threads){
+      // Split the points into contiguous ranges for each thread
+      pthread_t *threads = new pthread_t[ num_threads ];
+      TMROctNodeLocationArgs *targs = 
+        new TMROctNodeLocationArgs[ num_threads ];
+      for ( int k = 0; k < num_threads; k++ ){
+        targs[k] = args;
+        targs[k].start = (k*npts)/num_threads;
+        targs[k].end = ((k+1)*npts)/num_threads;
+        pthread_create(&threads[k], NULL, evaluateOctNodeLocationsThread,
+                       (void*)&targs[k]);
+      }
+      for ( int k = 0; k < num_threads; k++ ){
+        pthread_join(threads[k], NULL);
+      }
+      delete [] threads;
+      delete [] targs;
+    }
+    else {
+      evaluateOctNodeLocations(&args);
+    }
 
-  delete [] flags;
+    // Copy the points to the node locations
+    for ( int i = 0; i < npts; i++ ){
+      X[nodes[i]] = Xpts[i];
+    }
+
+    delete [] nodes;
+    delete [] run_ptr;
+    delete [] vols;
+    delete [] nparams;
+    delete [] params;
+    delete [] pts;
+    delete [] Xpts;
+  }
+  TMRPerfEnd(TMR_PERF_EVALUATE_NODE_LOCATIONS);
 }
 
 /*
@@ -5592,21 +6608,102 @@ void TMROctForest::getNodeConn( const int **_conn,
 */
 int TMROctForest::getDepNodeConn( const int **ptr, const int **conn,
                                   const double **weights ){
+  // Expand the weights from the templates if they are requested
+  if (weights && !dep_weights && dep_ptr){
+    dep_weights = new double[ dep_ptr[num_dep_nodes] ];
+    for ( int i = 0; i < num_dep_nodes; i++ ){
+      evalDepTemplate(dep_tmpl[i], &dep_weights[dep_ptr[i]]);
+    }
+  }
+
   if (ptr){ *ptr = dep_ptr; }
   if (conn){ *conn = dep_conn; }
   if (weights){ *weights = dep_weights; }
   return num_dep_nodes;
 }
 
+/*
+  Get the compressed form of the dependent node information. Note
+  that this call is not collective.
+
+  output:
+  ptr:      pointer for each dependent node number
+  conn:     connectivity to each (global) independent node
+  tmpl:     the weight template index for each dependent node
+*/
+int TMROctForest::getDepNodeTemplates( const int **ptr, const int **conn,
+                                       const int **tmpl ){
+  if (ptr){ *ptr = dep_ptr; }
+  if (conn){ *conn = dep_conn; }
+  if (tmpl){ *tmpl = dep_tmpl; }
+  return num_dep_nodes;
+}
+
+/*
+  Expand a single row of the dependent node constraints without
+  forming the full weight array.
+
+  input:
+  dep_node:  the dependent node index (0 <= dep_node < num_dep_nodes)
+
+  output:
+  conn:      pointer to the independent nodes for this row
+  weights:   the weights (must be of length order*order)
+
+  returns:   the length of the row
+*/
+int TMROctForest::getDepNodeRow( int dep_node, const int **conn, 
+                                 double *weights ){
+  if (dep_node < 0 || dep_node >= num_dep_nodes){
+    return 0;
+  }
+  if (conn){ *conn = &dep_conn[dep_ptr[dep_node]]; }
+  if (weights){
+    evalDepTemplate(dep_tmpl[dep_node], weights);
+  }
+  return dep_ptr[dep_node+1] - dep_ptr[dep_node];
+}
+
+/*
+  Evaluate the weights associated with the given template
+
+  input:
+  tmpl:     the template index
+
+  output:
+  weights:  the weights (must be of length order*order)
+
+  returns:  the number of weights in the template
+*/
+int TMROctForest::evalDepTemplate( int tmpl, double *weights ){
+  if (tmpl < 2*mesh_order){
+    // This is an edge template
+    const double *N = &dep_interp[mesh_order*tmpl];
+    for ( int j = 0; j < mesh_order; j++ ){
+      weights[j] = N[j];
+    }
+    return mesh_order;
+  }
+
+  // This is a face template - take the tensor product of the rows
+  tmpl -= 2*mesh_order;
+  const double *Nu = &dep_interp[mesh_order*(tmpl % (2*mesh_order))];
+  const double *Nv = &dep_interp[mesh_order*(tmpl / (2*mesh_order))];
+  for ( int j = 0; j < mesh_order; j++ ){
+    for ( int i = 0; i < mesh_order; i++ ){
+      weights[i + j*mesh_order] = Nu[i]*Nv[j];
+    }
+  }
+  return mesh_order*mesh_order;
+}
+
 /*
   Get the elements that either lie in a volume, on a face or on a
   curve with a given attribute.
 
-  This code loops over all octants that are locally owned on this
-  processor and checks the attribute of the underlying topological
-  entry. If the volume attribute matches, the octant is added
-  directly, otherwise the local face or volume index is set as the
-  tag. 
+  This code uses the attribute index to find the octants. If the
+  volume attribute matches, the octant is added directly, otherwise
+  the local face index is set in the info member of the octant.
 
   input:
   attr:   string attribute associated with the geometric feature
@@ -5626,102 +6723,18 @@ getOctsWithAttribute()\n");
     return NULL;
   }
 
-  // Set the flag if the attribute is NULL
-  int attr_is_null = 1;
-  if (attr){
-    attr_is_null = 0;
+  // Create the index if it does not yet exist
+  if (!attr_octs){
+    createAttributeIndex();
   }
 
-  // Create a queue to store the elements that we find
-  TMROctantQueue *queue = new TMROctantQueue();
-
-  // Get the octants
-  int size;
-  TMROctant *array;
-  octants->getArray(&array, &size);
-
-  // Loop over the octants and find out whether it touches
-  // a face or edge with the prescribed attribute
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;
-  for ( int i = 0; i < size; i++ ){
-    const int32_t h = 1 << (TMR_MAX_LEVEL - array[i].level);
-
-    // Get the surface octant
-    TMRVolume *vol;
-    topo->getVolume(array[i].block, &vol);  
-    const char *vol_attr = vol->getAttribute();
-    if ((attr_is_null && !vol_attr) ||
-        (vol_attr && strcmp(vol_attr, attr) == 0)){
-      queue->push(&array[i]);
-    }
-    else {
-      // If this is a root octant, then we should check all of the
-      // sides, otherwise we will only check a maximum of three of the
-      // sides to see if the face attribute matches
-      if (array[i].level == 0){
-        for ( int face_index = 0; face_index < 6; face_index++ ){
-          TMROctant oct = array[i];
-          int face_num = block_face_conn[6*array[i].block + face_index];
-          TMRFace *face;
-          topo->getFace(face_num, &face);
-          const char *face_attr = face->getAttribute();
-          if ((attr_is_null && !face_attr) ||
-              (face_attr && strcmp(face_attr, attr) == 0)){
-            oct.info = face_index;
-            queue->push(&oct);
-          }
-        }
-      }
-      else {
-        // Check if this octant lies on one or more face
-        int fx0 = (array[i].x == 0);
-        int fy0 = (array[i].y == 0);
-        int fz0 = (array[i].z == 0);
-        int fx = (fx0 || array[i].x + h == hmax);
-        int fy = (fy0 || array[i].y + h == hmax);
-        int fz = (fz0 || array[i].z + h == hmax);
-
-        if (fx || fy || fz){
-          TMRFace *face = NULL;
-          TMROctant oct = array[i];
-          if (fx){
-            int face_index = (fx0 ? 0 : 1);
-            int face_num = block_face_conn[6*array[i].block + face_index];
-            topo->getFace(face_num, &face);
-            const char *face_attr = face->getAttribute();
-            if ((attr_is_null && !face_attr) ||
-                (face_attr && strcmp(face_attr, attr) == 0)){
-              oct.info = face_index;
-              queue->push(&oct);
-            }
-          }
-          if (fy){
-            int face_index = (fy0 ? 2 : 3);
-            int face_num = block_face_conn[6*array[i].block + face_index];
-            topo->getFace(face_num, &face);
-            const char *face_attr = face->getAttribute();
-            if ((attr_is_null && !face_attr) ||
-                (face_attr && strcmp(face_attr, attr) == 0)){
-              oct.info = face_index;
-              queue->push(&oct);
-            }
-          }
-          if (fz){
-            int face_index = (fz0 ? 4 : 5);
-            int face_num = block_face_conn[6*array[i].block + face_index];
-            topo->getFace(face_num, &face);
-            const char *face_attr = face->getAttribute();
-            if ((attr_is_null && !face_attr) ||
-                (face_attr && strcmp(face_attr, attr) == 0)){
-              oct.info = face_index;
-              queue->push(&oct);
-            }
-          }
-        }
-      }
-    }
+  int index = findAttribute(attr);
+  if (index >= 0){
+    return attr_octs[index]->duplicate();
   }
 
+  // No entity has this attribute: return an empty array
+  TMROctantQueue *queue = new TMROctantQueue();
   TMROctantArray *list = queue->toArray();
   delete queue;
   return list;
@@ -5731,13 +6744,10 @@ getOctsWithAttribute()\n");
   Create an array of the nodes that are lie on a surface, edge or
   corner with a given attribute
 
-  This code loops over all nodes and check whether they lie on a
-  geometric entity that has the given attribute. If the intersect flag
-  is active (which is the default), then only the owner is checked,
-  e.g. if the node lies on a corner, only the attribute of the vertex
-  is checked. If intersect is false then the edge, face and volume
-  attributes are also check and the node is added if any of them
-  match.  
+  The nodes are retrieved from the attribute index. The nodes that
+  lie on a vertex, edge or face of a block with the given attribute
+  are included. Note that the returned list is sorted and unique, and
+  must be freed by the caller.
 
   input:
   attr:       the string of the attribute to search
@@ -5760,44 +6770,151 @@ getNodesWithAttribute()\n");
     return 0;
   }
 
-  // The max octant edge length
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;
+  // Create the index if it does not yet exist or if it was created
+  // before the nodes
+  if (!attr_node_ptr){
+    freeAttributeIndex();
+    createAttributeIndex();
+  }
+
+  int len = 0;
+  int index = findAttribute(attr);
+  if (index >= 0){
+    len = attr_node_ptr[index+1] - attr_node_ptr[index];
+  }
+  int *node_list = new int[ len ];
+  if (len > 0){
+    memcpy(node_list, &attr_nodes[attr_node_ptr[index]], len*sizeof(int));
+  }
+
+  *_nodes = node_list;
+  return len;
+}
+
+/*
+  Add a node to the list of nodes for the given attribute index
+*/
+static inline void add_attr_node( int index, int node, int *len,
+                                  int *max_len, int **lists ){
+  if (len[index] >= max_len[index]){
+    max_len[index] = 2*max_len[index] + 64;
+    int *tmp = new int[ max_len[index] ];
+    if (lists[index]){
+      memcpy(tmp, lists[index], len[index]*sizeof(int));
+      delete [] lists[index];
+    }
+    lists[index] = tmp;
+  }
+  lists[index][len[index]] = node;
+  len[index]++;
+}
+
+/*
+  Find the index of the attribute in the attribute index. The index 0
+  is reserved for entities without an attribute.
 
-  // Set the flag if the attribute is NULL
-  int attr_is_null = 1;
-  if (attr){
-    attr_is_null = 0;
+  input:
+  attr:   the attribute (may be NULL)
+
+  returns:
+  the index or -1 if no entity has the attribute
+*/
+int TMROctForest::findAttribute( const char *attr ){
+  if (!attr){
+    return 0;
+  }
+  for ( int i = 1; i < num_attrs; i++ ){
+    if (strcmp(attr_names[i], attr) == 0){
+      return i;
+    }
   }
+  return -1;
+}
+
+/*
+  Add the attribute to the index (if it is not already present) and
+  return its index
+*/
+int TMROctForest::addAttribute( const char *attr ){
+  int index = findAttribute(attr);
+  if (index < 0){
+    index = num_attrs;
+    attr_names[index] = new char[ strlen(attr)+1 ];
+    strcpy(attr_names[index], attr);
+    num_attrs++;
+  }
+  return index;
+}
 
-  int count = 0; // Current node count
-  int max_len = 1024; // max length of the node list
-  int *node_list = new int[ max_len ]; // Nodes touching this attribute
+/*
+  Create the index of the octants and nodes for each attribute
+
+  The attribute of each volume, face, edge and vertex in the topology
+  is found once. A single pass over the local octants then adds the
+  octant (or the octant on the boundary face) and, if the nodes have
+  been created, the nodes on the block boundaries to the lists for the
+  matching attributes. The index is freed whenever the octants, the
+  nodes or the topology change.
+*/
+void TMROctForest::createAttributeIndex(){
+  // Assign an index to the attribute of each topological entity
+  int max_attrs = 1 + num_blocks + num_faces + num_edges + num_nodes;
+  attr_names = new char*[ max_attrs ];
+  attr_names[0] = NULL;
+  num_attrs = 1;
+
+  int *vol_attr = new int[ num_blocks ];
+  for ( int i = 0; i < num_blocks; i++ ){
+    TMRVolume *volume;
+    topo->getVolume(i, &volume);
+    vol_attr[i] = addAttribute(volume->getAttribute());
+  }
+  int *face_attr = new int[ num_faces ];
+  for ( int i = 0; i < num_faces; i++ ){
+    TMRFace *face;
+    topo->getFace(i, &face);
+    face_attr[i] = addAttribute(face->getAttribute());
+  }
+  int *edge_attr = new int[ num_edges ];
+  for ( int i = 0; i < num_edges; i++ ){
+    TMREdge *edge;
+    topo->getEdge(i, &edge);
+    edge_attr[i] = addAttribute(edge->getAttribute());
+  }
+  int *vert_attr = new int[ num_nodes ];
+  for ( int i = 0; i < num_nodes; i++ ){
+    TMRVertex *vert;
+    topo->getVertex(i, &vert);
+    vert_attr[i] = addAttribute(vert->getAttribute());
+  }
+
+  // Allocate the queues for the octants and the node lists
+  TMROctantQueue **queues = new TMROctantQueue*[ num_attrs ];
+  for ( int k = 0; k < num_attrs; k++ ){
+    queues[k] = new TMROctantQueue();
+  }
+  int *node_len = new int[ num_attrs ];
+  int *node_max = new int[ num_attrs ];
+  int **node_lists = new int*[ num_attrs ];
+  memset(node_len, 0, num_attrs*sizeof(int));
+  memset(node_max, 0, num_attrs*sizeof(int));
+  memset(node_lists, 0, num_attrs*sizeof(int*));
 
   // Get the octants
   int size;
   TMROctant *octs;
   octants->getArray(&octs, &size);
 
-  // Max node increment
-  const int max_node_incr = 8 + 12*mesh_order + 6*mesh_order*mesh_order +
-    mesh_order*mesh_order*mesh_order;
-  
-  // Loop over the octants and find out whether it touches a face or
-  // edge with the prescribed attribute
+  const int32_t hmax = 1 << TMR_MAX_LEVEL;
   for ( int i = 0; i < size; i++ ){
-    if (count + max_node_incr > max_len){
-      // Extend the length of the array
-      max_len = 2*max_len + max_node_incr;
-      int *tmp = new int[ max_len ];
-      memcpy(tmp, node_list, count*sizeof(int));
-      delete [] node_list;
-      node_list = tmp;
-    }
-
-    // Compute the octant edge length
     const int32_t h = 1 << (TMR_MAX_LEVEL - octs[i].level);
+    const int block = octs[i].block;
 
-    // Check if this node lies on an octree boundary
+    // Add the octant to the list for its volume
+    const int va = vol_attr[block];
+    queues[va]->push(&octs[i]);
+
+    // Check if this octant lies on one or more faces
     int fx0 = (octs[i].x == 0);
     int fy0 = (octs[i].y == 0);
     int fz0 = (octs[i].z == 0);
@@ -5808,235 +6925,210 @@ getNodesWithAttribute()\n");
     int fy = fy0 || fy1;
     int fz = fz0 || fz1;
 
-    // Set a pointer into the connectivity array
-    const int *c = &conn[mesh_order*mesh_order*mesh_order*octs[i].tag];
-
-    if (fx && fy && fz){
-      // This node lies on a corner
-      int nverts = 0;
-      int vert_index[8];
-      if (fx0 && fy0 && fz0){
-        vert_index[nverts] = 0;  nverts++;
-      }
-      if (fx1 && fy0 && fz0){
-        vert_index[nverts] = 1;  nverts++;
-      }
-      if (fx0 && fy1 && fz0){
-        vert_index[nverts] = 2;  nverts++;
+    // Find the faces of the block touched by this octant. Only one
+    // face in each direction is used unless this is a root octant.
+    int nfaces = 0;
+    int face_index[6];
+    if (octs[i].level == 0){
+      for ( int k = 0; k < 6; k++ ){
+        face_index[nfaces] = k;  nfaces++;
       }
-      if (fx1 && fy1 && fz0){
-        vert_index[nverts] = 3;  nverts++;
-      }
-      if (fx0 && fy0 && fz1){
-        vert_index[nverts] = 4;  nverts++;
-      }
-      if (fx1 && fy0 && fz1){
-        vert_index[nverts] = 5;  nverts++;
-      }
-      if (fx0 && fy1 && fz1){
-        vert_index[nverts] = 6;  nverts++;
+    }
+    else {
+      if (fx){
+        face_index[nfaces] = (fx0 ? 0 : 1);  nfaces++;
       }
-      if (fx1 && fy1 && fz1){
-        vert_index[nverts] = 7;  nverts++;
+      if (fy){
+        face_index[nfaces] = (fy0 ? 2 : 3);  nfaces++;
       }
-      
-      for ( int k = 0; k < nverts; k++ ){
-        TMRVertex *vert;
-        int vert_num = block_conn[8*octs[i].block + vert_index[k]];
-        topo->getVertex(vert_num, &vert);
-        const char *vert_attr = vert->getAttribute();
-        if ((attr_is_null && !vert_attr) ||
-            (vert_attr && strcmp(vert_attr, attr) == 0)){
-          int offset = ((mesh_order-1)*(vert_index[k] % 2) +
-                        (mesh_order-1)*mesh_order*((vert_index[k] % 4)/2) +
-                        (mesh_order-1)*mesh_order*mesh_order*(vert_index[k]/4));
-          node_list[count] = c[offset];
-          count++;
-        }
+      if (fz){
+        face_index[nfaces] = (fz0 ? 4 : 5);  nfaces++;
       }
     }
-    if ((fy && fz) || (fx && fz) || (fx && fy)){
-      int nedges = 0;
-      int edge_index[12];
 
-      // x-parallel edges
-      if (fy0 && fz0){
-        edge_index[nedges] = 0;  nedges++;
-      }
-      if (fy1 && fz0){
-        edge_index[nedges] = 1;  nedges++;
-      }
-      if (fy0 && fz1){
-        edge_index[nedges] = 2;  nedges++;
-      }
-      if (fy1 && fz1){
-        edge_index[nedges] = 3;  nedges++;
+    // Add the octant to the lists for the face attributes that do
+    // not match the volume attribute
+    for ( int k = 0; k < nfaces; k++ ){
+      const int fa = face_attr[block_face_conn[6*block + face_index[k]]];
+      if (fa != va){
+        TMROctant oct = octs[i];
+        oct.info = face_index[k];
+        queues[fa]->push(&oct);
       }
+    }
 
-      // y-parallel edges
-      if (fx0 && fz0){
-        edge_index[nedges] = 4;  nedges++;
-      }
-      if (fx1 && fz0){
-        edge_index[nedges] = 5;  nedges++;
-      }
-      if (fx0 && fz1){
-        edge_index[nedges] = 6;  nedges++;
-      }
-      if (fx1 && fz1){
-        edge_index[nedges] = 7;  nedges++;
-      }
+    if (!conn){
+      continue;
+    }
 
-      // z-parallel edges
-      if (fx0 && fy0){
-        edge_index[nedges] = 8;  nedges++;
-      }
-      if (fx1 && fy0){
-        edge_index[nedges] = 9;  nedges++;
-      }
-      if (fx0 && fy1){
-        edge_index[nedges] = 10; nedges++;
-      }
-      if (fx1 && fy1){
-        edge_index[nedges] = 11; nedges++;
-      }
-     
-      // This node lies on an edge
-      for ( int k = 0; k < nedges; k++ ){
-        TMREdge *edge;
-        int edge_num = block_edge_conn[12*octs[i].block + edge_index[k]];
-        topo->getEdge(edge_num, &edge);
-        const char *edge_attr = edge->getAttribute();
-        if ((attr_is_null && !edge_attr) ||
-            (edge_attr && strcmp(edge_attr, attr) == 0)){
-          if (edge_index[k] < 4){
-            const int jj = (mesh_order-1)*(edge_index[k] % 2);
-            const int kk = (mesh_order-1)*(edge_index[k] / 2);
-            for ( int ii = 0; ii < mesh_order; ii++ ){
-              int offset = ii + jj*mesh_order + kk*mesh_order*mesh_order;
-              node_list[count] = c[offset];
-              count++;
-            }
-          }
-          else if (edge_index[k] < 8){
-            const int ii = (mesh_order-1)*(edge_index[k] % 2);
-            const int kk = (mesh_order-1)*((edge_index[k] - 4)/2);
-            for ( int jj = 0; jj < mesh_order; jj++ ){
-              int offset = ii + jj*mesh_order + kk*mesh_order*mesh_order;
-              node_list[count] = c[offset];
-              count++;
-            }
-          }
-          else {
-            const int ii = (mesh_order-1)*(edge_index[k] % 2);
-            const int jj = (mesh_order-1)*((edge_index[k] - 8)/2);
-            for ( int kk = 0; kk < mesh_order; kk++ ){
-              int offset = ii + jj*mesh_order + kk*mesh_order*mesh_order;
-              node_list[count] = c[offset];
-              count++;
-            }
-          }
+    // Set a pointer into the connectivity array
+    const int *c = &conn[mesh_order*mesh_order*mesh_order*octs[i].tag];
+
+    if (fx && fy && fz){
+      // This octant touches one or more corners
+      for ( int vert_index = 0; vert_index < 8; vert_index++ ){
+        if (((vert_index % 2) ? fx1 : fx0) &&
+            (((vert_index % 4)/2) ? fy1 : fy0) &&
+            ((vert_index/4) ? fz1 : fz0)){
+          int vert_num = block_conn[8*block + vert_index];
+          int offset = ((mesh_order-1)*(vert_index % 2) +
+                        (mesh_order-1)*mesh_order*((vert_index % 4)/2) +
+                        (mesh_order-1)*mesh_order*mesh_order*(vert_index/4));
+          add_attr_node(vert_attr[vert_num], c[offset],
+                        node_len, node_max, node_lists);
         }
       }
     }
-    if (fx || fy || fz){
-      int nfaces = 0;
-      int face_index[6];
-      if (fx0){
-        face_index[nfaces] = 0;  nfaces++;
-      }
-      if (fx1){
-        face_index[nfaces] = 1;  nfaces++;
-      }
-      if (fy0){
-        face_index[nfaces] = 2;  nfaces++;
-      }
-      if (fy1){
-        face_index[nfaces] = 3;  nfaces++;
-      }
-      if (fz0){
-        face_index[nfaces] = 4;  nfaces++;
-      }
-      if (fz1){
-        face_index[nfaces] = 5;  nfaces++;
-      }
-      
-      // Which face index are we dealing with?
-      for ( int k = 0; k < nfaces; k++ ){
-        TMRFace *face;
-        int face_num = block_face_conn[6*octs[i].block + face_index[k]];
-        topo->getFace(face_num, &face);  
-        const char *face_attr = face->getAttribute();
-        if ((attr_is_null && !face_attr) ||
-            (face_attr && strcmp(face_attr, attr) == 0)){
-          if (face_index[k] < 2){
-            const int ii = (mesh_order-1)*(face_index[k] % 2);
-            for ( int kk = 0; kk < mesh_order; kk++ ){
-              for ( int jj = 0; jj < mesh_order; jj++ ){
-                int offset = ii + jj*mesh_order + kk*mesh_order*mesh_order;
-              node_list[count] = c[offset];
-              count++;
-            }
+    if ((fy && fz) || (fx && fz) || (fx && fy)){
+      // This octant touches one or more edges
+      for ( int edge_index = 0; edge_index < 12; edge_index++ ){
+        int on_edge = 0;
+        if (edge_index < 4){
+          on_edge = ((edge_index % 2) ? fy1 : fy0) &&
+            ((edge_index/2) ? fz1 : fz0);
+        }
+        else if (edge_index < 8){
+          on_edge = ((edge_index % 2) ? fx1 : fx0) &&
+            (((edge_index - 4)/2) ? fz1 : fz0);
+        }
+        else {
+          on_edge = ((edge_index % 2) ? fx1 : fx0) &&
+            (((edge_index - 8)/2) ? fy1 : fy0);
+        }
+        if (!on_edge){
+          continue;
+        }
+
+        int edge_num = block_edge_conn[12*block + edge_index];
+        int ea = edge_attr[edge_num];
+        for ( int k = 0; k < mesh_order; k++ ){
+          int offset = 0;
+          if (edge_index < 4){
+            const int jj = (mesh_order-1)*(edge_index % 2);
+            const int kk = (mesh_order-1)*(edge_index / 2);
+            offset = k + jj*mesh_order + kk*mesh_order*mesh_order;
           }
-        }
-          else if (face_index[k] < 4){
-            const int jj = (mesh_order-1)*(face_index[k] % 2);
-            for ( int kk = 0; kk < mesh_order; kk++ ){
-              for ( int ii = 0; ii < mesh_order; ii++ ){
-                int offset = ii + jj*mesh_order + kk*mesh_order*mesh_order;
-                node_list[count] = c[offset];
-                count++;
-              }
-            }
+          else if (edge_index < 8){
+            const int ii = (mesh_order-1)*(edge_index % 2);
+            const int kk = (mesh_order-1)*((edge_index - 4)/2);
+            offset = ii + k*mesh_order + kk*mesh_order*mesh_order;
           }
           else {
-            const int kk = (mesh_order-1)*(face_index[k] % 2);
-            for ( int jj = 0; jj < mesh_order; jj++ ){
-              for ( int ii = 0; ii < mesh_order; ii++ ){
-                int offset = ii + jj*mesh_order + kk*mesh_order*mesh_order;
-                node_list[count] = c[offset];
-                count++;
-              }
-            }
+            const int ii = (mesh_order-1)*(edge_index % 2);
+            const int jj = (mesh_order-1)*((edge_index - 8)/2);
+            offset = ii + jj*mesh_order + k*mesh_order*mesh_order;
           }
+          add_attr_node(ea, c[offset], node_len, node_max, node_lists);
         }
       }
     }
-    else {
-      TMRVolume *volume;
-      topo->getVolume(octs[i].block, &volume);
-      const char *volume_attr = volume->getAttribute();
-      if ((attr_is_null && !volume_attr) ||
-          (volume_attr && strcmp(volume_attr, attr) == 0)){
-        for ( int kk = 0; kk < mesh_order; kk++ ){
-          for ( int jj = 0; jj < mesh_order; jj++ ){
-            for ( int ii = 0; ii < mesh_order; ii++ ){
-              int offset = ii + jj*mesh_order + kk*mesh_order*mesh_order;
-              node_list[count] = c[offset];
+    if (fx || fy || fz){
+      // This octant touches one or more faces
+      const int touches[6] = {fx0, fx1, fy0, fy1, fz0, fz1};
+      for ( int face_index = 0; face_index < 6; face_index++ ){
+        if (!touches[face_index]){
+          continue;
+        }
+
+        int face_num = block_face_conn[6*block + face_index];
+        int fa = face_attr[face_num];
+        for ( int q = 0; q < mesh_order; q++ ){
+          for ( int p = 0; p < mesh_order; p++ ){
+            int offset = 0;
+            if (face_index < 2){
+              const int ii = (mesh_order-1)*(face_index % 2);
+              offset = ii + p*mesh_order + q*mesh_order*mesh_order;
+            }
+            else if (face_index < 4){
+              const int jj = (mesh_order-1)*(face_index % 2);
+              offset = p + jj*mesh_order + q*mesh_order*mesh_order;
+            }
+            else {
+              const int kk = (mesh_order-1)*(face_index % 2);
+              offset = p + q*mesh_order + kk*mesh_order*mesh_order;
             }
+            add_attr_node(fa, c[offset], node_len, node_max, node_lists);
           }
         }
       }
     }
   }
 
-  // Now, sort the node numbers and remove duplicates
-  qsort(node_list, count, sizeof(int), compare_integers);
+  // Convert the queues to arrays
+  attr_octs = new TMROctantArray*[ num_attrs ];
+  for ( int k = 0; k < num_attrs; k++ ){
+    attr_octs[k] = queues[k]->toArray();
+    delete queues[k];
+  }
+  delete [] queues;
+
+  if (conn){
+    // Sort and uniquify the node lists and store them in a single array
+    attr_node_ptr = new int[ num_attrs+1 ];
+    attr_node_ptr[0] = 0;
+    for ( int k = 0; k < num_attrs; k++ ){
+      int len = 0;
+      if (node_len[k] > 0){
+        qsort(node_lists[k], node_len[k], sizeof(int), compare_integers);
+        for ( int ptr = 0; ptr < node_len[k]; ptr++, len++ ){
+          while ((ptr < node_len[k]-1) &&
+                 (node_lists[k][ptr] == node_lists[k][ptr+1])){
+            ptr++;
+          }
+          if (ptr != len){
+            node_lists[k][len] = node_lists[k][ptr];
+          }
+        }
+      }
+      node_len[k] = len;
+      attr_node_ptr[k+1] = attr_node_ptr[k] + len;
+    }
 
-  // Remove duplicates from the array
-  int len = 0;  
-  for ( int ptr = 0; ptr < count; ptr++, len++ ){
-    while ((ptr < count-1) && (node_list[ptr] == node_list[ptr+1])){
-      ptr++;
+    attr_nodes = new int[ attr_node_ptr[num_attrs] ];
+    for ( int k = 0; k < num_attrs; k++ ){
+      if (node_len[k] > 0){
+        memcpy(&attr_nodes[attr_node_ptr[k]], node_lists[k],
+               node_len[k]*sizeof(int));
+      }
     }
+  }
+
+  for ( int k = 0; k < num_attrs; k++ ){
+    if (node_lists[k]){ delete [] node_lists[k]; }
+  }
+  delete [] node_lists;
+  delete [] node_len;
+  delete [] node_max;
+  delete [] vol_attr;
+  delete [] face_attr;
+  delete [] edge_attr;
+  delete [] vert_attr;
+}
 
-    if (ptr != len){
-      node_list[len] = node_list[ptr];
+/*
+  Free the attribute index
+*/
+void TMROctForest::freeAttributeIndex(){
+  if (attr_names){
+    for ( int k = 0; k < num_attrs; k++ ){
+      if (attr_names[k]){ delete [] attr_names[k]; }
+    }
+    delete [] attr_names;
+  }
+  if (attr_octs){
+    for ( int k = 0; k < num_attrs; k++ ){
+      delete attr_octs[k];
     }
+    delete [] attr_octs;
   }
+  if (attr_node_ptr){ delete [] attr_node_ptr; }
+  if (attr_nodes){ delete [] attr_nodes; }
 
-  *_nodes = node_list;
-  return len;
+  num_attrs = 0;
+  attr_names = NULL;
+  attr_octs = NULL;
+  attr_node_ptr = NULL;
+  attr_nodes = NULL;
 }
 
 /*
@@ -6066,6 +7158,145 @@ TMROctant* TMROctForest::findEnclosing( const int order,
                                         const double *knots,
                                         TMROctant *node, 
                                         int *mpi_owner ){
+  // Find the starting point for the search
+  int start = searchEnclosing(node);
+
+  return scanEnclosing(order, knots, node, start, mpi_owner);
+}
+
+/*
+  Find the enclosing octants for an array of nodes
+
+  This is a bulk version of findEnclosing() that is designed for
+  nodes ordered by their element octants. Since both the nodes and
+  the octants of this forest are sorted along the same space-filling
+  curve, a single merge-walk through the two arrays finds the
+  starting position for each node in O(1) amortized time, instead of
+  a binary search for each node. If a node is out of order, the
+  starting position is found by a binary search instead.
+
+  Nodes that are not enclosed by a local octant have a NULL
+  enclosing octant. In this case, the owner of the node is returned
+  in mpi_owners so that all of these nodes can be exchanged with a
+  single call to distributeOctants().
+
+  input:
+  order:       the order of the node's element
+  knots:       the knot locations within the node's element
+  num_nodes:   the number of nodes
+  nodes:       the node octants (info = local node index)
+
+  output:
+  enclosing:   the enclosing octant for each node (or NULL)
+  mpi_owners:  the MPI owner of each node (may be NULL)
+*/
+void TMROctForest::findEnclosing( const int order, 
+                                  const double *knots,
+                                  const int num_nodes,
+                                  TMROctant *nodes,
+                                  TMROctant **enclosing,
+                                  int *mpi_owners ){
+  // Retrieve the array of elements
+  int size = 0;
+  TMROctant *array = NULL;
+  octants->getArray(&array, &size);
+
+  // The last octant with a position that is less than or equal to
+  // the position of the current node
+  int cursor = 0;
+
+  for ( int i = 0; i < num_nodes; i++ ){
+    if (i > 0 && nodes[i].comparePosition(&nodes[i-1]) < 0){
+      // The nodes are out of order: restart the walk
+      cursor = searchEnclosing(&nodes[i]);
+    }
+    else {
+      while (cursor+1 < size && 
+             array[cursor+1].comparePosition(&nodes[i]) <= 0){
+        cursor++;
+      }
+    }
+
+    int *owner = NULL;
+    if (mpi_owners){
+      owner = &mpi_owners[i];
+    }
+    enclosing[i] = scanEnclosing(order, knots, &nodes[i], cursor, owner);
+  }
+}
+
+/*
+  Find the starting position in the octant array for the search for
+  the octant that encloses the given node
+
+  input:
+  node:     the node octant
+
+  returns:  the index of the octant where the search begins
+*/
+int TMROctForest::searchEnclosing( TMROctant *node ){
+  // Retrieve the array of elements
+  int size = 0;
+  TMROctant *array = NULL;
+  octants->getArray(&array, &size);
+
+  // Set the low and high indices to the first and last element of the
+  // element array
+  int low = 0;
+  int high = size-1;
+  int mid = low + (int)((high - low)/2);
+
+  // Maintain values of low/high and mid such that the octant is
+  // between (elems[low], elems[high]).  Note that if high-low=1, then
+  // mid = low
+  while (mid != low){
+    // Check if the node is contained by the mid octant
+    if (array[mid].contains(node)){
+      break;
+    }
+
+    // Compare the ordering of the two octants - if the octant is less
+    // than the other, then adjust the mid point
+    int stat = array[mid].comparePosition(node);
+
+    // array[mid] ? node
+    if (stat == 0){
+      break;
+    }
+    else if (stat < 0){
+      low = mid+1;
+    }
+    else {
+      high = mid-1;
+    }
+    
+    // Re compute the mid-point and repeat
+    mid = low + (int)((high - low)/2);
+  }
+
+  return mid;
+}
+
+/*
+  Scan the octant array, starting from the given position, for the
+  octant that encloses the node
+
+  input:
+  order:      the order of the node's element
+  knots:      the knot locations within the node's element
+  node:       the node octant (info = local node index)
+  start:      the starting index in the octant array
+
+  output:
+  mpi_owner:  the MPI owner of the node if it is not found locally
+
+  returns:    the enclosing octant or NULL if it does not exist locally
+*/
+TMROctant* TMROctForest::scanEnclosing( const int order, 
+                                        const double *knots,
+                                        TMROctant *node,
+                                        int start,
+                                        int *mpi_owner ){
   // Assume that we'll find the node on this processor for now.
   if (mpi_owner){
     *mpi_owner = mpi_rank;
@@ -6115,39 +7346,8 @@ TMROctant* TMROctForest::findEnclosing( const int order,
   const double yd = node->y + 0.5*h*(1.0 + knots[jj]);
   const double zd = node->z + 0.5*h*(1.0 + knots[kk]);
 
-  // Set the low and high indices to the first and last element of the
-  // element array
-  int low = 0;
-  int high = size-1;
-  int mid = low + (int)((high - low)/2);
-
-  // Maintain values of low/high and mid such that the octant is
-  // between (elems[low], elems[high]).  Note that if high-low=1, then
-  // mid = low
-  while (mid != low){
-    // Check if the node is contained by the mid octant
-    if (array[mid].contains(node)){
-      break;
-    }
-
-    // Compare the ordering of the two octants - if the octant is less
-    // than the other, then adjust the mid point
-    int stat = array[mid].comparePosition(node);
-
-    // array[mid] ? node
-    if (stat == 0){
-      break;
-    }
-    else if (stat < 0){
-      low = mid+1;
-    }
-    else {
-      high = mid-1;
-    }
-    
-    // Re compute the mid-point and repeat
-    mid = low + (int)((high - low)/2);
-  }
+  // Start the search from the given position
+  int mid = start;
   
   // Compute the bounding octant. Octants greater than this octant
   // cannot own the node so a further search is futile.
@@ -6215,31 +7415,34 @@ TMROctant* TMROctForest::findEnclosing( const int order,
 }
 
 /*
-  Compute the interpolant from the given fine node to the
-  coarse mesh octant. 
+  Compute the interpolation stencil from the given fine node to the
+  nodes of the enclosing coarse mesh octant.
 
   Note that the node is defined as a TMROctant class with the
   octant information for the node where the info member is
-  the local index of the node on the element.
+  the local index of the node on the element. The stencil only
+  contains the non-zero weights, and the indices are the local node
+  numbers on the coarse element.
 
   input:
   node:     the node (element octant with info = element node index)
   coarse:   the coarse TMROctForest object
   oct:      an enclosing octant on the coarse mesh
+  Ntable:   the coarse shape functions at the points from
+            lagrange_child_knots() for this mesh (may be NULL)
   tmp:      temporary array (must be of size 3*coarse->mesh_order)
 
   output:
-  weights:  the index/weight pairs for the mesh
-*/
-int TMROctForest::computeElemInterp( TMROctant *node,
-                                     TMROctForest *coarse,
-                                     TMROctant *oct,
-                                     TMRIndexWeight *weights,
-                                     double *tmp ){
-  // Loop over the array of nodes
-  const int coarse_nodes_per_element = 
-    coarse->mesh_order*coarse->mesh_order*coarse->mesh_order;
+  stencil:  the local index/weight pairs for the coarse element
 
+  returns:  the number of entries in the stencil
+*/
+int TMROctForest::computeElemStencil( TMROctant *node,
+                                      TMROctForest *coarse,
+                                      TMROctant *oct,
+                                      const double *Ntable,
+                                      TMRIndexWeight *stencil,
+                                      double *tmp ){
   // Compute the i, j, k location of the fine mesh node on the element
   const int i = node->info % mesh_order;
   const int j = (node->info % (mesh_order*mesh_order))/mesh_order;
@@ -6271,6 +7474,15 @@ int TMROctForest::computeElemInterp( TMROctant *node,
     iend = coarse->mesh_order;
     Nu[istart] = 1.0;
   }
+  else if (Ntable && (hc == h || hc == 2*h)){
+    // Use the cached table for the same-size or parent octant
+    int row = i;
+    if (hc == 2*h){
+      row += mesh_order*(1 + (node->x - oct->x)/h);
+    }
+    memcpy(Nu, &Ntable[coarse->mesh_order*row],
+           coarse->mesh_order*sizeof(double));
+  }
   else {
     double u = -1.0 + 2.0*(node->x + 0.5*h*(1.0 + interp_knots[i]) -
                            oct->x)/hc;
@@ -6289,6 +7501,15 @@ int TMROctForest::computeElemInterp( TMROctant *node,
     jend = coarse->mesh_order;
     Nv[jstart] = 1.0;
   }
+  else if (Ntable && (hc == h || hc == 2*h)){
+    // Use the cached table for the same-size or parent octant
+    int row = j;
+    if (hc == 2*h){
+      row += mesh_order*(1 + (node->y - oct->y)/h);
+    }
+    memcpy(Nv, &Ntable[coarse->mesh_order*row],
+           coarse->mesh_order*sizeof(double));
+  }
   else {
     double v = -1.0 + 2.0*(node->y + 0.5*h*(1.0 + interp_knots[j]) -
                            oct->y)/hc;
@@ -6307,6 +7528,15 @@ int TMROctForest::computeElemInterp( TMROctant *node,
     kend = coarse->mesh_order;
     Nw[kstart] = 1.0;
   }
+  else if (Ntable && (hc == h || hc == 2*h)){
+    // Use the cached table for the same-size or parent octant
+    int row = k;
+    if (hc == 2*h){
+      row += mesh_order*(1 + (node->z - oct->z)/h);
+    }
+    memcpy(Nw, &Ntable[coarse->mesh_order*row],
+           coarse->mesh_order*sizeof(double));
+  }
   else {
     double w = -1.0 + 2.0*(node->z + 0.5*h*(1.0 + interp_knots[k]) -
                            oct->z)/hc;
@@ -6314,49 +7544,133 @@ int TMROctForest::computeElemInterp( TMROctant *node,
                              coarse->interp_knots, Nw);
   }
  
-  // Get the coarse grid information
-  const int *cdep_ptr;
-  const int *cdep_conn;
-  const double *cdep_weights;
-  coarse->getDepNodeConn(&cdep_ptr, &cdep_conn, &cdep_weights);
-
-  // Get the coarse connectivity array
-  const int num = oct->tag;
-  const int *c = &(coarse->conn[coarse_nodes_per_element*num]);
-
-  // Loop over the nodes that are within this octant
-  int nweights = 0;
+  // Store the non-zero weights using the local node numbers on
+  // the coarse element
+  int size = 0;
   for ( int kk = kstart; kk < kend; kk++ ){
     for ( int jj = jstart; jj < jend; jj++ ){
       for ( int ii = istart; ii < iend; ii++ ){
-        // Compute the offset into the coarse mesh
-        int offset = (ii +
-                      jj*coarse->mesh_order +
-                      kk*coarse->mesh_order*coarse->mesh_order);
-
-        // Compute the interpolation weight
         double weight = Nu[ii]*Nv[jj]*Nw[kk];
-
-        // Get the tag number
-        if (c[offset] >= 0){
-          weights[nweights].index = c[offset];
-          weights[nweights].weight = weight;
-          nweights++;
-        }
-        else {
-          int node = -c[offset]-1;
-          for ( int jp = cdep_ptr[node]; jp < cdep_ptr[node+1]; jp++ ){
-            weights[nweights].index = cdep_conn[jp];
-            weights[nweights].weight = weight*cdep_weights[jp];
-            nweights++;
-          }
+        if (weight != 0.0){
+          stencil[size].index = (ii +
+                                 jj*coarse->mesh_order +
+                                 kk*coarse->mesh_order*coarse->mesh_order);
+          stencil[size].weight = weight;
+          size++;
         }
       }
     }
   }
 
-  // Sort and add up the weight values
-  nweights = TMRIndexWeight::uniqueSort(weights, nweights);
+  return size;
+}
+
+/*
+  Compute the interpolant from the given fine node to the
+  coarse mesh octant.
+
+  The interpolation stencil in terms of the local nodes of the coarse
+  element is retrieved from the stencil table when the fine element
+  is the same size as, or a child of, the coarse element. Otherwise
+  the stencil is computed directly. The stencil is then gathered
+  through the coarse connectivity and the dependent node weights.
+
+  input:
+  node:      the node (element octant with info = element node index)
+  coarse:    the coarse TMROctForest object
+  oct:       an enclosing octant on the coarse mesh
+  Ntable:    the coarse shape functions at the points from
+             lagrange_child_knots() for this mesh (may be NULL)
+  stencils:  the table of stencils with (1 + 8)*nodes_per_element
+             entries for this mesh and the coarse mesh
+  tmp:       temporary array (must be of size 3*coarse->mesh_order)
+
+  output:
+  weights:   the index/weight pairs for the mesh
+*/
+int TMROctForest::computeElemInterp( TMROctant *node,
+                                     TMROctForest *coarse,
+                                     TMROctant *oct,
+                                     const double *Ntable,
+                                     TMRInterpStencilTable *stencils,
+                                     TMRIndexWeight *weights,
+                                     double *tmp ){
+  const int nodes_per_element = mesh_order*mesh_order*mesh_order;
+  const int coarse_nodes_per_element = 
+    coarse->mesh_order*coarse->mesh_order*coarse->mesh_order;
+
+  // Get the element size for coarse element
+  const int32_t h = 1 << (TMR_MAX_LEVEL - node->level);
+  const int32_t hc = 1 << (TMR_MAX_LEVEL - oct->level);
+
+  // The stencil depends only on the local node index, the level
+  // difference and the child identifier of the fine element within
+  // the coarse element. Compute the key for the stencil table.
+  int key = -1;
+  if (hc == h &&
+      node->x == oct->x && node->y == oct->y && node->z == oct->z){
+    key = node->info;
+  }
+  else if (hc == 2*h &&
+           node->x >= oct->x && node->x < oct->x + hc &&
+           node->y >= oct->y && node->y < oct->y + hc &&
+           node->z >= oct->z && node->z < oct->z + hc){
+    int child = (((node->x - oct->x)/h) +
+                 2*((node->y - oct->y)/h) +
+                 4*((node->z - oct->z)/h));
+    key = (1 + child)*nodes_per_element + node->info;
+  }
+
+  // Retrieve the stencil or compute it if it does not exist
+  int size = -1;
+  const TMRIndexWeight *stencil = NULL;
+  if (key >= 0){
+    size = stencils->getStencil(key, &stencil);
+  }
+  if (size < 0){
+    TMRIndexWeight *work = stencils->getWorkArray();
+    size = computeElemStencil(node, coarse, oct, Ntable, work, tmp);
+    if (key >= 0){
+      stencils->setStencil(key, size, work);
+    }
+    stencil = work;
+  }
+
+  // Temporary storage for the expanded dependent node weights
+  double cdep_weights[MAX_ORDER*MAX_ORDER];
+
+  // Get the coarse connectivity array
+  const int num = oct->tag;
+  const int *c = &(coarse->conn[coarse_nodes_per_element*num]);
+
+  // Gather the stencil through the coarse connectivity
+  int nweights = 0, has_dep_nodes = 0;
+  for ( int n = 0; n < size; n++ ){
+    const int offset = stencil[n].index;
+    const double weight = stencil[n].weight;
+    if (c[offset] >= 0){
+      weights[nweights].index = c[offset];
+      weights[nweights].weight = weight;
+      nweights++;
+    }
+    else {
+      int node = -c[offset]-1;
+      const int *cdep_conn;
+      int len = coarse->getDepNodeRow(node, &cdep_conn, cdep_weights);
+      for ( int jp = 0; jp < len; jp++ ){
+        weights[nweights].index = cdep_conn[jp];
+        weights[nweights].weight = weight*cdep_weights[jp];
+        nweights++;
+      }
+      has_dep_nodes = 1;
+    }
+  }
+
+  // The independent nodes of the coarse element are unique, so only
+  // sort and add up the weights when dependent nodes contribute
+  if (has_dep_nodes){
+    nweights = TMRIndexWeight::uniqueSort(weights, nweights);
+  }
 
   return nweights;
 }
@@ -6378,14 +7692,17 @@ int TMROctForest::computeElemInterp( TMROctant *node,
 */
 void TMROctForest::createInterpolation( TMROctForest *coarse,
                                         TACSBVecInterp *interp ){
+  TMRPerfBegin(TMR_PERF_CREATE_INTERPOLATION);
   // Ensure that the nodes are allocated on both octree forests
   createNodes();
   coarse->createNodes();
 
-  // Get the dependent node information
-  const int *cdep_ptr, *cdep_conn;
-  const double *cdep_weights;
-  coarse->getDepNodeConn(&cdep_ptr, &cdep_conn, &cdep_weights);
+  // Get the coarse shape functions at the knots of the fine mesh
+  // for elements of the same size and for the child elements
+  const double *Ntable;
+  double pts[3*MAX_ORDER];
+  lagrange_child_knots(mesh_order, interp_knots, pts);
+  coarse->getInterpTable(3*mesh_order, pts, &Ntable);
 
   // First, loop over the local list
   int local_size = node_range[mpi_rank+1] - node_range[mpi_rank];
@@ -6408,14 +7725,25 @@ void TMROctForest::createInterpolation( TMROctForest *coarse,
   // Loop over the array of nodes
   const int nodes_per_element = mesh_order*mesh_order*mesh_order;
 
+  // Allocate the table of interpolation stencils for the elements
+  // with the same size as the coarse element or for its children
+  const int num_children = 8;
+  TMRInterpStencilTable *stencils = 
+    new TMRInterpStencilTable((1 + num_children)*nodes_per_element,
+                              max_nodes);
+
   // Get the octants
   int num_elements;
   TMROctant *octs;
   octants->getArray(&octs, &num_elements);
 
-  // Allocate a queue to store the nodes that are on other procs
-  TMROctantQueue *ext_queue = new TMROctantQueue();
-
+  // Collect the locally owned nodes from the first element that
+  // references them. The nodes are ordered by their element octants
+  // so the enclosing coarse octants can be found with a single
+  // merge-walk through the coarse octants.
+  int num_nodes = 0;
+  TMROctant *nodes = new TMROctant[ local_size ];
+  int *node_nums = new int[ local_size ];
   for ( int i = 0; i < num_elements; i++ ){
     const int *c = &conn[nodes_per_element*i];
     for ( int j = 0; j < nodes_per_element; j++ ){
@@ -6426,42 +7754,53 @@ void TMROctForest::createInterpolation( TMROctForest *coarse,
         if (!flags[index]){
           // We're going to handle this node now, mark it as done
           flags[index] = 1;
+          nodes[num_nodes] = octs[i];
+          nodes[num_nodes].info = j;
+          node_nums[num_nodes] = c[j];
+          num_nodes++;
+        }
+      }
+    }
+  }
+
+  // Free the data
+  delete [] flags;
 
-          // Find the enclosing coarse octant on this 
-          // processor if it exits
-          TMROctant node = octs[i];
-          node.info = j;
+  // Find the enclosing coarse octants on this processor if they exist
+  TMROctant **enclosing = new TMROctant*[ num_nodes ];
+  int *mpi_owners = new int[ num_nodes ];
+  coarse->findEnclosing(mesh_order, interp_knots, num_nodes, nodes,
+                        enclosing, mpi_owners);
 
-          // Find the MPI owner or the
-          int mpi_owner = mpi_rank;
-          TMROctant *t = coarse->findEnclosing(mesh_order, interp_knots,
-                                               &node, &mpi_owner);
+  // Allocate a queue to store the nodes that are on other procs
+  TMROctantQueue *ext_queue = new TMROctantQueue();
 
-          // The node is owned a coarse element on this processor
-          if (t){
-            // Compute the element interpolation
-            int nweights = computeElemInterp(&node, coarse, t, weights, tmp);
+  for ( int i = 0; i < num_nodes; i++ ){
+    // The node is owned a coarse element on this processor
+    if (enclosing[i]){
+      // Compute the element interpolation
+      int nweights = computeElemInterp(&nodes[i], coarse, enclosing[i],
+                                       Ntable, stencils, weights, tmp);
 
-            for ( int k = 0; k < nweights; k++ ){
-              vars[k] = weights[k].index;
-              wvals[k] = weights[k].weight;
-            }
-            interp->addInterp(c[j], wvals, vars, nweights);
-          }
-          else {
-            // We've got to transfer the node to the processor that
-            // owns an enclosing element. Do to that, add the
-            // octant to the list of externals and store its mpi owner
-            node.tag = mpi_owner;
-            ext_queue->push(&node);
-          }
-        }
+      for ( int k = 0; k < nweights; k++ ){
+        vars[k] = weights[k].index;
+        wvals[k] = weights[k].weight;
       }
+      interp->addInterp(node_nums[i], wvals, vars, nweights);
+    }
+    else {
+      // We've got to transfer the node to the processor that
+      // owns an enclosing element. Do to that, add the
+      // octant to the list of externals and store its mpi owner
+      nodes[i].tag = mpi_owners[i];
+      ext_queue->push(&nodes[i]);
     }
   }
 
-  // Free the data
-  delete [] flags;
+  delete [] nodes;
+  delete [] node_nums;
+  delete [] enclosing;
+  delete [] mpi_owners;
 
   // Sort the sending octants by MPI rank
   TMROctantArray *ext_array = ext_queue->toArray();
@@ -6528,16 +7867,19 @@ void TMROctForest::createInterpolation( TMROctForest *coarse,
   TMROctant *recv_nodes;
   recv_array->getArray(&recv_nodes, &recv_size);
 
+  // Find the enclosing octants for the recv'd nodes
+  enclosing = new TMROctant*[ recv_size ];
+  coarse->findEnclosing(mesh_order, interp_knots, recv_size, recv_nodes,
+                        enclosing);
+
   // Recv the nodes and loop over the connectivity
   for ( int i = 0; i < recv_size; i++ ){
-    int mpi_owner;
-    TMROctant *t = coarse->findEnclosing(mesh_order, interp_knots,
-                                         &recv_nodes[i], &mpi_owner);
+    TMROctant *t = enclosing[i];
 
     if (t){
       // Compute the element interpolation
       int nweights = computeElemInterp(&recv_nodes[i], coarse, t, 
-                                       weights, tmp);
+                                       Ntable, stencils, weights, tmp);
 
       for ( int k = 0; k < nweights; k++ ){
         vars[k] = weights[k].index;
@@ -6555,10 +7897,13 @@ void TMROctForest::createInterpolation( TMROctForest *coarse,
 
   // Free the recv array
   delete recv_array;
+  delete [] enclosing;
 
   // Free the temporary arrays
+  delete stencils;
   delete [] tmp;
   delete [] vars;
   delete [] wvals;
   delete [] weights;
+  TMRPerfEnd(TMR_PERF_CREATE_INTERPOLATION);
 }
@@ -25,6 +25,13 @@
 #include "TMROctant.h"
 #include "BVecInterp.h"
 
+// Forward declaration of the interpolation table cache
+class TMRInterpTableCache;
+class TMRInterpStencilTable;
+
+// Forward declaration of the element feature size
+class TMRElementFeatureSize;
+
 /*
   TMR Forest class
 
@@ -40,7 +47,8 @@
   The duplicate() and coarsen() functions create a forest that is
   aligned with the parallel distribution of octrees. This facilitates
   the construction of the interpolation operators that can be used for
-  multigrid solution algorithms.
+  multigrid solution algorithms. A duplicate with a lower mesh order
+  can be used for the p-levels of the multigrid hierarchy.
 */
 class TMROctForest : public TMREntity {
  public:
@@ -78,6 +86,10 @@ class TMROctForest : public TMREntity {
                        TMR_GAUSS_LOBATTO_POINTS );
   int getMeshOrder();
   TMRInterpolationType getInterpType();
+
+  // Set the number of threads used to evaluate the node locations
+  // -------------------------------------------------------------
+  void setNumThreads( int _num_threads );
   
   // Re-partition the octrees based on element count
   // -----------------------------------------------
@@ -88,10 +100,15 @@ class TMROctForest : public TMREntity {
   void createTrees( int refine_level );
   void createRandomTrees( int nrand=10, 
                           int min_level=0, int max_level=8 );
+  void createRefinedTrees( TMRElementFeatureSize *fs,
+                           int min_level=0, int max_level=TMR_MAX_LEVEL,
+                           int balance_corner=0 );
 
   // Duplicate or coarsen the forest
   // -------------------------------
   TMROctForest *duplicate();
+  TMROctForest *duplicate( int order,
+                           TMRInterpolationType interp_type );
   TMROctForest *coarsen();
 
   // Refine the mesh
@@ -115,6 +132,10 @@ class TMROctForest : public TMREntity {
                     int *_num_local_nodes=NULL );
   int getDepNodeConn( const int **_ptr, const int **_conn,
                       const double **_weights );
+  int getDepNodeTemplates( const int **_ptr, const int **_conn,
+                           const int **_tmpl );
+  int getDepNodeRow( int dep_node, const int **_conn, double *_weights );
+  int evalDepTemplate( int tmpl, double *_weights );
  
   // Create interpolation/restriction operators
   // ------------------------------------------
@@ -140,6 +161,8 @@ class TMROctForest : public TMREntity {
   void evalInterp( const double pt[], double N[] );
   void evalInterp( const double pt[], double N[],
                    double Nxi[], double Neta[], double Nzeta[] );
+  int getInterpTable( int npts, const double pts[],
+                      const double **_N, const double **_Nd=NULL );
 
   // Retrieve the connectivity information
   // -------------------------------------
@@ -160,6 +183,9 @@ class TMROctForest : public TMREntity {
   // ----------------------------------------
   TMROctant* findEnclosing( const int order, const double *knots,
                             TMROctant *node, int *mpi_owner=NULL );
+  void findEnclosing( const int order, const double *knots,
+                      const int num_nodes, TMROctant *nodes,
+                      TMROctant **enclosing, int *mpi_owners=NULL );
 
   // Transform the octant to the global order
   // ----------------------------------------
@@ -189,13 +215,42 @@ class TMROctForest : public TMREntity {
   void writeToTecplot( const char *filename );
   void writeForestToVTK( const char *filename );
 
+  // Write/read the forest and element/node data to/from a binary file
+  // -----------------------------------------------------------------
+  int writeToFile( const char *filename,
+                   int elem_size=0, const double *elem_data=NULL,
+                   int node_size=0, const double *node_data=NULL );
+  int readFromFile( const char *filename,
+                    int *elem_size=NULL, double **elem_data=NULL,
+                    int *node_size=NULL, double **node_data=NULL );
+
+  // Get the memory usage and the high-water marks of the forest
+  // -----------------------------------------------------------
+  void getMemoryUsage( TMRMemoryUsage *usage );
+
  private:
+  // Identifiers for the binary forest files
+  static const int TMR_OCT_FILE_ID = 0x54434f52;
+  static const int TMR_FILE_VERSION = 1;
+  static const int TMR_FILE_HEADER_SIZE = 16;
+
   // Labels for the nodes
   static const int TMR_OCT_NODE_LABEL = 0;
   static const int TMR_OCT_EDGE_LABEL = 1;
   static const int TMR_OCT_FACE_LABEL = 2;
   static const int TMR_OCT_BLOCK_LABEL = 3;
 
+  // Get the memory held by the forest and update a high-water mark
+  // with the resident and transient memory
+  size_t getResidentMemory();
+  void updatePeakMemory( size_t *peak, size_t resident, size_t transient );
+
+  // Create/free the index of octants and nodes for each attribute
+  void createAttributeIndex();
+  void freeAttributeIndex();
+  int findAttribute( const char *attr );
+  int addAttribute( const char *attr );
+
   // Free the internally stored data and zero things
   void freeData();
   void freeMeshData( int free_quads=1, int free_owners=1 );
@@ -215,6 +270,12 @@ class TMROctForest : public TMREntity {
   // Set the owners - this determines how the mesh will be ordered
   void computeBlockOwners();
 
+  // Compute the transformations between adjacent blocks
+  void computeBlockTransforms();
+
+  // Store the connectivity so that it can be shared with copies
+  void createSharedConnectivity();
+
   // Get the octant owner
   int getOctantMPIOwner( TMROctant *oct );
 
@@ -293,13 +354,28 @@ class TMROctForest : public TMREntity {
   void createDependentConn( const int *node_nums,
                             TMROctantArray *nodes, 
                             const int *node_offset );
+
+  // Compute the 1D weight table used by the dependent node templates
+  void computeDepInterpTable();
   
   // Compute the node locations
   void evaluateNodeLocations();
 
-  // Compute the element interpolation
+  // Find the start of the search for an enclosing octant and scan
+  // the octants from that position
+  int searchEnclosing( TMROctant *node );
+  TMROctant* scanEnclosing( const int order, const double *knots,
+                            TMROctant *node, int start, int *mpi_owner );
+
+  // Compute the element interpolation stencil and the interpolation
+  int computeElemStencil( TMROctant *node,
+                          TMROctForest *coarse, TMROctant *oct,
+                          const double *Ntable,
+                          TMRIndexWeight *stencil, double *tmp );
   int computeElemInterp( TMROctant *node,
                          TMROctForest *coarse, TMROctant *oct,
+                         const double *Ntable,
+                         TMRInterpStencilTable *stencils,
                          TMRIndexWeight *weights, double *tmp );
 
   // The communicator
@@ -310,6 +386,9 @@ class TMROctForest : public TMREntity {
   TMRInterpolationType interp_type;
   double *interp_knots;
 
+  // Cached 1D shape function tables evaluated at fixed points
+  TMRInterpTableCache *interp_tables;
+
   // The owner octants which dictates the partitioning of the octants
   // across processors
   TMROctant *owners;
@@ -333,10 +412,33 @@ class TMROctForest : public TMREntity {
   // Information to enable transformations between faces
   int *block_face_ids;
 
+  // The packed integer transformations between the coordinate
+  // frames of blocks that share a face or an edge
+  int *block_face_trans_ptr, *face_trans;
+  int *block_edge_trans_ptr, *edge_trans;
+
+  // The owner of the connectivity arrays above. This is shared
+  // between the forests created by duplicate() and coarsen().
+  TMRSharedArrays *shared_conn;
+
   // Information about the mesh
   int mesh_order;
   int *conn;
 
+  // The number of threads used to evaluate the node locations
+  int num_threads;
+
+  // The high-water marks of the memory usage during balance() and
+  // createNodes() including the transient data
+  size_t balance_peak_memory, nodes_peak_memory;
+
+  // The index of the octants and nodes for each attribute. The first
+  // entry is reserved for entities without an attribute.
+  int num_attrs;
+  char **attr_names;
+  TMROctantArray **attr_octs;
+  int *attr_node_ptr, *attr_nodes;
+
   // Set the range of nodes owned by each processor
   int *node_range;
 
@@ -350,10 +452,17 @@ class TMROctForest : public TMREntity {
   int num_owned_nodes; // Number of nodes that are owned by me
   int ext_pre_offset; // Number of nodes before pre
 
-  // The dependent node information
-  int *dep_ptr, *dep_conn;
+  // The dependent node information. Each dependent node stores the
+  // parent node list and a template index. The weights are only
+  // expanded into dep_weights when they are requested.
+  int *dep_ptr, *dep_conn, *dep_tmpl;
   double *dep_weights;
 
+  // The 1D interpolation table for the dependent node templates.
+  // Row (order*x + k) stores the shape functions at the k-th knot of
+  // a child with offset x = 0, 1 within the parent edge.
+  double *dep_interp;
+
   // The array of all octants
   TMROctantArray *octants;
   
@@ -524,6 +524,13 @@ void TMROctantArray::merge( TMROctantArray *list ){
   size = len;
 }
 
+/*
+  Get the number of bytes allocated for the array
+*/
+size_t TMROctantArray::getMemoryUsage(){
+  return sizeof(TMROctantArray) + max_size*sizeof(TMROctant);
+}
+
 /*
   Get the underlying array
 */
@@ -594,6 +601,13 @@ TMROctant TMROctantQueue::pop(){
   }
 }
 
+/*
+  Get the number of bytes allocated for the queue
+*/
+size_t TMROctantQueue::getMemoryUsage(){
+  return sizeof(TMROctantQueue) + num_elems*sizeof(OctQueueNode);
+}
+
 /*
   Convert the queue to an array 
 */
@@ -674,6 +688,14 @@ TMROctantArray *TMROctantHash::toArray(){
   return list;
 }
 
+/*
+  Get the number of bytes allocated for the hash table
+*/
+size_t TMROctantHash::getMemoryUsage(){
+  return (sizeof(TMROctantHash) + num_buckets*sizeof(OctHashNode*) +
+          num_elems*sizeof(OctHashNode));
+}
+
 /*
   Add an octant to the hash table. 
 
@@ -749,6 +771,9 @@ int TMROctantHash::addOctant( TMROctant *oct ){
     OctHashNode *node = hash_buckets[bucket];
     if (use_node_index){
       while (node){
+        // Count each entry compared in the bucket
+        TMRPerfAdd(TMR_PERF_HASH_PROBES, 1);
+
         // The octant is in the list, quit now and return false
         if (node->oct.compareNode(oct) == 0){
           return 0;
@@ -765,6 +790,9 @@ int TMROctantHash::addOctant( TMROctant *oct ){
     }
     else {
       while (node){
+        // Count each entry compared in the bucket
+        TMRPerfAdd(TMR_PERF_HASH_PROBES, 1);
+
         // The octant is in the list, quit now and return false
         if (node->oct.compare(oct) == 0){
           return 0;
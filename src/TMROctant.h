@@ -72,6 +72,7 @@ class TMROctantArray {
   void sort();
   TMROctant* contains( TMROctant *q, int use_nodes=0 );
   void merge( TMROctantArray * list );
+  size_t getMemoryUsage();
 
  private:
   int use_node_index;
@@ -95,7 +96,8 @@ class TMROctantQueue {
   void push( TMROctant *oct );
   TMROctant pop();
   TMROctantArray* toArray();
-  
+  size_t getMemoryUsage();
+
  private:
   // Class that defines an element within the queue
   class OctQueueNode {
@@ -124,6 +126,7 @@ class TMROctantHash {
 
   TMROctantArray * toArray();
   int addOctant( TMROctant *oct );
+  size_t getMemoryUsage();
 
  private:
   // The minimum bucket size
@@ -20,7 +20,9 @@
 
 #include "TMRQuadForest.h"
 #include "TMRInterpolation.h"
+#include "TMRMesh.h"
 #include <stdlib.h>
+#include <pthread.h>
 
 /*
   Face to edge node connectivity
@@ -37,6 +39,21 @@ static int compare_integers( const void *a, const void *b ){
   return (*(int*)a - *(int*)b);
 }
 
+/*
+  Compare tuples of N integers for sorting
+*/
+template <int N>
+static int compare_int_tuples( const void *a, const void *b ){
+  const int *aa = (const int*)a;
+  const int *bb = (const int*)b;
+  for ( int k = 0; k < N; k++ ){
+    if (aa[k] != bb[k]){
+      return (aa[k] < bb[k] ? -1 : 1);
+    }
+  }
+  return 0;
+}
+
 /*
   Compare tags for sorting
 */
@@ -95,6 +112,25 @@ TMRQuadForest::TMRQuadForest( MPI_Comm _comm, int _mesh_order,
   edge_face_ptr = NULL;
   edge_face_owners = NULL;
   node_face_owners = NULL;
+  shared_conn = NULL;
+
+  // Set the interpolation knots to NULL
+  interp_knots = NULL;
+  interp_tables = NULL;
+
+  // Evaluate the node locations on a single thread by default
+  num_threads = 1;
+
+  // Zero the memory high-water marks
+  balance_peak_memory = 0;
+  nodes_peak_memory = 0;
+
+  // The attribute index is created on demand
+  num_attrs = 0;
+  attr_names = NULL;
+  attr_quads = NULL;
+  attr_node_ptr = NULL;
+  attr_nodes = NULL;
 
   // Null the quadrant owners/quadrant list
   owners = NULL;
@@ -113,7 +149,9 @@ TMRQuadForest::TMRQuadForest( MPI_Comm _comm, int _mesh_order,
 
   dep_ptr = NULL;
   dep_conn = NULL;
+  dep_tmpl = NULL;
   dep_weights = NULL;
+  dep_interp = NULL;
 
   // Set the mesh order
   setMeshOrder(_mesh_order, _interp_type);
@@ -127,23 +165,36 @@ TMRQuadForest::~TMRQuadForest(){
   if (topo){ topo->decref(); }
 
   freeData();
+
+  // Free the interpolation data
+  if (interp_knots){ delete [] interp_knots; }
+  if (dep_interp){ delete [] dep_interp; }
+  if (interp_tables){ delete interp_tables; }
 }
 
 /*
   Free data and prepare for it to be reallocated
 */
 void TMRQuadForest::freeData(){
-  // Free the connectivity
-  if (face_conn){ delete [] face_conn; }
-  if (face_edge_conn){ delete [] face_edge_conn; }
-  if (node_face_ptr){ delete [] node_face_ptr; }
-  if (node_face_conn){ delete [] node_face_conn; }
-  if (edge_face_ptr){ delete [] edge_face_ptr; }
-  if (edge_face_conn){ delete [] edge_face_conn; }
-
-  // Free the ownership data
-  if (node_face_owners){ delete [] node_face_owners; }
-  if (edge_face_owners){ delete [] edge_face_owners; }
+  freeAttributeIndex();
+
+  if (shared_conn){
+    // Release the connectivity which may be shared with other forests
+    shared_conn->decref();
+  }
+  else {
+    // Free the connectivity
+    if (face_conn){ delete [] face_conn; }
+    if (face_edge_conn){ delete [] face_edge_conn; }
+    if (node_face_ptr){ delete [] node_face_ptr; }
+    if (node_face_conn){ delete [] node_face_conn; }
+    if (edge_face_ptr){ delete [] edge_face_ptr; }
+    if (edge_face_conn){ delete [] edge_face_conn; }
+
+    // Free the ownership data
+    if (node_face_owners){ delete [] node_face_owners; }
+    if (edge_face_owners){ delete [] edge_face_owners; }
+  }
 
   // Free the quadrants/adjacency
   if (owners){ delete [] owners; }
@@ -156,6 +207,7 @@ void TMRQuadForest::freeData(){
   if (node_range){ delete [] node_range; }
   if (dep_ptr){ delete [] dep_ptr; }
   if (dep_conn){ delete [] dep_conn; }
+  if (dep_tmpl){ delete [] dep_tmpl; }
   if (dep_weights){ delete [] dep_weights; }
 
   // Zero out the nodes/edges/faces and all data
@@ -172,6 +224,7 @@ void TMRQuadForest::freeData(){
   edge_face_conn = NULL;
   edge_face_owners = NULL;
   node_face_owners = NULL;
+  shared_conn = NULL;
 
   // Null the quadrant owners/quadrant list
   owners = NULL;
@@ -190,6 +243,7 @@ void TMRQuadForest::freeData(){
 
   dep_ptr = NULL;
   dep_conn = NULL;
+  dep_tmpl = NULL;
   dep_weights = NULL;
 }
 
@@ -198,6 +252,8 @@ void TMRQuadForest::freeData(){
 */
 void TMRQuadForest::freeMeshData( int free_quads,
                                   int free_owners ){
+  freeAttributeIndex();
+
   if (free_quads){
     if (quadrants){ delete quadrants; }
     quadrants = NULL;
@@ -216,6 +272,7 @@ void TMRQuadForest::freeMeshData( int free_quads,
   if (node_range){ delete [] node_range; }
   if (dep_ptr){ delete [] dep_ptr; }
   if (dep_conn){ delete [] dep_conn; }
+  if (dep_tmpl){ delete [] dep_tmpl; }
   if (dep_weights){ delete [] dep_weights; }
 
   // Reset the data
@@ -228,6 +285,7 @@ void TMRQuadForest::freeMeshData( int free_quads,
   node_range = NULL;
   dep_ptr = NULL;
   dep_conn = NULL;
+  dep_tmpl = NULL;
   dep_weights = NULL;
 
   // Set the data to NULL
@@ -241,40 +299,30 @@ void TMRQuadForest::freeMeshData( int free_quads,
   Copy the connectivity data, but not the quadrants/nodes
 */
 void TMRQuadForest::copyData( TMRQuadForest *copy ){
+  // Copy the number of threads
+  copy->num_threads = num_threads;
+
   // Copy over the connectivity data
   copy->num_nodes = num_nodes;
   copy->num_edges = num_edges;
   copy->num_faces = num_faces;
 
-  // Allocate/copy the face connectivities
-  copy->face_conn = new int[ 4*num_faces ];
-  copy->face_edge_conn = new int[ 4*num_faces ];
-  memcpy(copy->face_conn, face_conn, 4*num_faces*sizeof(int));
-  memcpy(copy->face_edge_conn, face_edge_conn,
-         4*num_faces*sizeof(int));
-
-  // Allocate/copy the inverse relationships
-  copy->node_face_ptr = new int[ num_nodes+1 ];
-  copy->node_face_conn = new int[ node_face_ptr[num_nodes] ];
-  memcpy(copy->node_face_ptr, node_face_ptr,
-         (num_nodes+1)*sizeof(int));
-  memcpy(copy->node_face_conn, node_face_conn,
-         node_face_ptr[num_nodes]*sizeof(int));
-
-  copy->edge_face_ptr = new int[ num_edges+1 ];
-  copy->edge_face_conn = new int[ edge_face_ptr[num_edges] ];
-  memcpy(copy->edge_face_ptr, edge_face_ptr,
-         (num_edges+1)*sizeof(int));
-  memcpy(copy->edge_face_conn, edge_face_conn,
-         edge_face_ptr[num_edges]*sizeof(int));
-
-  // Copy the ownership information
-  copy->edge_face_owners = new int[ num_edges ];
-  copy->node_face_owners = new int[ num_nodes ];
-  memcpy(copy->edge_face_owners, edge_face_owners,
-         num_edges*sizeof(int));
-  memcpy(copy->node_face_owners, node_face_owners,
-         num_nodes*sizeof(int));
+  // Share the face connectivities and the inverse relationships
+  copy->face_conn = face_conn;
+  copy->face_edge_conn = face_edge_conn;
+  copy->node_face_ptr = node_face_ptr;
+  copy->node_face_conn = node_face_conn;
+  copy->edge_face_ptr = edge_face_ptr;
+  copy->edge_face_conn = edge_face_conn;
+
+  // Share the ownership information
+  copy->edge_face_owners = edge_face_owners;
+  copy->node_face_owners = node_face_owners;
+
+  copy->shared_conn = shared_conn;
+  if (copy->shared_conn){
+    copy->shared_conn->incref();
+  }
 
   // Copy over the topology object
   copy->topo = topo;
@@ -358,6 +406,9 @@ void TMRQuadForest::setConnectivity( int _num_nodes,
 
   // Compute the face owners based on the node, edge and face data
   computeFaceOwners();
+
+  // Store the connectivity so that it can be shared with copies
+  createSharedConnectivity();
 }
 
 /*
@@ -393,6 +444,27 @@ void TMRQuadForest::setFullConnectivity( int _num_nodes,
 
   // Compute the face owners based on the node, edge and face data
   computeFaceOwners();
+
+  // Store the connectivity so that it can be shared with copies
+  createSharedConnectivity();
+}
+
+/*
+  Transfer the ownership of the connectivity arrays to a
+  reference-counted object so that the arrays can be shared, rather
+  than copied, by the forests created with duplicate() or coarsen()
+*/
+void TMRQuadForest::createSharedConnectivity(){
+  shared_conn = new TMRSharedArrays();
+  shared_conn->incref();
+  shared_conn->add(face_conn, 4*num_faces);
+  shared_conn->add(face_edge_conn, 4*num_faces);
+  shared_conn->add(node_face_ptr, num_nodes+1);
+  shared_conn->add(node_face_conn, node_face_ptr[num_nodes]);
+  shared_conn->add(edge_face_ptr, num_edges+1);
+  shared_conn->add(edge_face_conn, edge_face_ptr[num_edges]);
+  shared_conn->add(edge_face_owners, num_edges);
+  shared_conn->add(node_face_owners, num_nodes);
 }
 
 /*
@@ -533,76 +605,73 @@ void TMRQuadForest::computeEdgesToFaces(){
 
 /*
   Compute the edges from the nodes
+
+  The edges are bucketed by their smallest node number and then sorted
+  by the other node number so that the equivalent edges are adjacent.
+  The edges are numbered in the order in which they first appear.
 */
 void TMRQuadForest::computeEdgesFromNodes(){
   // Now establish a unique ordering of the edges along each face
   face_edge_conn = new int[ 4*num_faces ];
+
+  // Bucket the face edges by their smallest node number. Each entry
+  // stores the other node number and the face edge index.
+  int *ptr = new int[ num_nodes+1 ];
+  memset(ptr, 0, (num_nodes+1)*sizeof(int));
   for ( int i = 0; i < 4*num_faces; i++ ){
-    face_edge_conn[i] = -1;
+    int n1 = face_conn[4*(i/4) + face_to_edge_nodes[i % 4][0]];
+    int n2 = face_conn[4*(i/4) + face_to_edge_nodes[i % 4][1]];
+    ptr[(n1 < n2 ? n1 : n2)+1]++;
+  }
+  for ( int i = 0; i < num_nodes; i++ ){
+    ptr[i+1] += ptr[i];
   }
 
-  // Keep track of the edge numbers
-  int edge = 0;
-  for ( int i = 0; i < num_faces; i++ ){
-    // Loop over each edge on this face
-    for ( int j = 0; j < 4; j++ ){
-      if (face_edge_conn[4*i + j] < 0){
-        int n1 = face_conn[4*i + face_to_edge_nodes[j][0]];
-        int n2 = face_conn[4*i + face_to_edge_nodes[j][1]];
-
-        // Keep track of the number of edges found
-        const int max_nedges = 20;
-        int edge_index[max_nedges];
-        int nedges = 1;
-        edge_index[0] = 4*i + j;
-
-        // Set the edge number - if any is found
-        int edge_num = -1;
-
-        // Scan through the faces that share the same
-        // node and check if any of the edges are also
-        // shared
-        for ( int ip = node_face_ptr[n1];
-              ip < node_face_ptr[n1+1]; ip++ ){
-          int ii = node_face_conn[ip]/4;
-
-          // Loop over each edge in the new face
-          for ( int jj = 0; jj < 4; jj++ ){
-            int nn1 = face_conn[4*ii + face_to_edge_nodes[jj][0]];
-            int nn2 = face_conn[4*ii + face_to_edge_nodes[jj][1]];
-
-            // Check if the face matches
-            if ((n1 == nn1 && n2 == nn2) ||
-                (n1 == nn2 && n2 == nn1)){
-              if (face_edge_conn[4*ii + jj] >= 0){
-                // If this edge has been ordered, copy over
-                // the edge number
-                edge_num = face_edge_conn[4*ii + jj];
-              }
-              else if (nedges < max_nedges){
-                // This edge has not yet been ordered, add it
-                // to the unordered list if there is still room
-                // if not, we will detect and order it during
-                // a future iteration
-                edge_index[nedges] = 4*ii + jj;
-                nedges++;
-              }
-            }
-          }
-        }
+  int *keys = new int[ 2*4*num_faces ];
+  for ( int i = 0; i < 4*num_faces; i++ ){
+    int n1 = face_conn[4*(i/4) + face_to_edge_nodes[i % 4][0]];
+    int n2 = face_conn[4*(i/4) + face_to_edge_nodes[i % 4][1]];
+    int n = (n1 < n2 ? n1 : n2);
+    keys[2*ptr[n]] = (n1 < n2 ? n2 : n1);
+    keys[2*ptr[n]+1] = i;
+    ptr[n]++;
+  }
 
-        // If this edge does not have an edge number, assign
-        // a new one to the list
-        if (edge_num < 0){
-          edge_num = edge;
-          edge++;
-        }
+  // Reset the pointer array
+  for ( int i = num_nodes; i >= 1; i-- ){
+    ptr[i] = ptr[i-1];
+  }
+  ptr[0] = 0;
 
-        // Set the edge numbers for all the edges that we found
-        for ( int ii = 0; ii < nedges; ii++ ){
-          face_edge_conn[edge_index[ii]] = edge_num;
-        }
+  // Sort each bucket so that equivalent edges are adjacent and ordered
+  // by their index. Store the index of the first equivalent edge.
+  for ( int n = 0; n < num_nodes; n++ ){
+    int size = ptr[n+1] - ptr[n];
+    if (size > 1){
+      qsort(&keys[2*ptr[n]], size, 2*sizeof(int), compare_int_tuples<2>);
+    }
+    int first = -1;
+    for ( int k = ptr[n]; k < ptr[n+1]; k++ ){
+      if (k == ptr[n] || keys[2*k] != keys[2*(k-1)]){
+        first = keys[2*k+1];
       }
+      face_edge_conn[keys[2*k+1]] = first;
+    }
+  }
+
+  delete [] ptr;
+  delete [] keys;
+
+  // Number the edges in the order in which they first appear
+  int edge = 0;
+  for ( int i = 0; i < 4*num_faces; i++ ){
+    int first = face_edge_conn[i];
+    if (first == i){
+      face_edge_conn[i] = edge;
+      edge++;
+    }
+    else {
+      face_edge_conn[i] = face_edge_conn[first];
     }
   }
 
@@ -927,11 +996,494 @@ void TMRQuadForest::writeAdjacentToVTK( const char *filename ){
   }
 }
 
+/*
+  Write the forest to a binary file
+
+  The file contains a header, the face connectivity and the quadrants
+  in the order of the space-filling curve, followed by the optional
+  element and node data. Each processor writes its quadrants and data
+  with collective MPI-IO calls at an offset computed from the number
+  of quadrants on the preceding processors so the forest is never
+  gathered. The file uses the native binary representation.
+
+  The node data is stored at each node of each element so that the
+  file does not depend on the node numbering. This requires that the
+  nodes have been created. The element and node data sizes must be
+  the same on all processors.
+
+  input:
+  filename:   the name of the file
+  elem_size:  the number of values per element
+  elem_data:  the element values (elem_size values per local element)
+  node_size:  the number of values per node
+  node_data:  the node values (node_size values per local node in the
+              order returned by getNodeNumbers())
+
+  returns:    non-zero on failure
+*/
+int TMRQuadForest::writeToFile( const char *filename,
+                               int elem_size, const double *elem_data,
+                               int node_size, const double *node_data ){
+  if (!quadrants || !face_conn){
+    fprintf(stderr, "[%d] TMRQuadForest: Cannot write a forest without "
+            "quadrants to %s\n", mpi_rank, filename);
+    return 1;
+  }
+  if (!elem_data){ elem_size = 0; }
+  if (!node_data){ node_size = 0; }
+  if (node_size > 0 && !conn){
+    fprintf(stderr, "[%d] TMRQuadForest: Nodes must be created to write "
+            "node data to %s\n", mpi_rank, filename);
+    return 1;
+  }
+
+  // Get the local quadrants
+  int size;
+  TMRQuadrant *array;
+  quadrants->getArray(&array, &size);
+
+  // Compute the number of quadrants before this processor and the
+  // total number of quadrants
+  int64_t local_count = size, offset_count = 0, num_elements = 0;
+  MPI_Exscan(&local_count, &offset_count, 1, MPI_INT64_T, MPI_SUM, comm);
+  if (mpi_rank == 0){
+    offset_count = 0;
+  }
+  MPI_Allreduce(&local_count, &num_elements, 1, MPI_INT64_T, MPI_SUM, comm);
+
+  MPI_File fp;
+  if (MPI_File_open(comm, (char*)filename, 
+                    MPI_MODE_WRONLY | MPI_MODE_CREATE,
+                    MPI_INFO_NULL, &fp) != MPI_SUCCESS){
+    fprintf(stderr, "[%d] TMRQuadForest: Could not open file %s\n",
+            mpi_rank, filename);
+    return 1;
+  }
+  MPI_File_set_size(fp, 0);
+
+  // Write out the header and the face connectivity
+  if (mpi_rank == 0){
+    int64_t header[TMR_FILE_HEADER_SIZE];
+    memset(header, 0, TMR_FILE_HEADER_SIZE*sizeof(int64_t));
+    header[0] = TMR_QUAD_FILE_ID;
+    header[1] = TMR_FILE_VERSION;
+    header[2] = mesh_order;
+    header[3] = interp_type;
+    header[4] = elem_size;
+    header[5] = node_size;
+    header[6] = num_nodes;
+    header[7] = num_edges;
+    header[8] = num_faces;
+    header[10] = num_elements;
+
+    MPI_Offset offset = 0;
+    MPI_File_write_at(fp, offset, header, TMR_FILE_HEADER_SIZE,
+                      MPI_INT64_T, MPI_STATUS_IGNORE);
+    offset += TMR_FILE_HEADER_SIZE*sizeof(int64_t);
+    MPI_File_write_at(fp, offset, face_conn, 4*num_faces,
+                      MPI_INT, MPI_STATUS_IGNORE);
+    offset += 4*num_faces*sizeof(int);
+    MPI_File_write_at(fp, offset, face_edge_conn, 4*num_faces,
+                      MPI_INT, MPI_STATUS_IGNORE);
+  }
+  MPI_Offset offset = (TMR_FILE_HEADER_SIZE*sizeof(int64_t) + 
+                       8*num_faces*sizeof(int));
+
+  // Write out the quadrants
+  int quad_size;
+  MPI_Type_size(TMRQuadrant_MPI_type, &quad_size);
+  MPI_File_write_at_all(fp, offset + offset_count*quad_size,
+                        array, size, TMRQuadrant_MPI_type, 
+                        MPI_STATUS_IGNORE);
+  offset += num_elements*quad_size;
+
+  // Write out the element data
+  if (elem_size > 0){
+    MPI_Offset data_size = elem_size*sizeof(double);
+    MPI_File_write_at_all(fp, offset + offset_count*data_size,
+                          (void*)elem_data, elem_size*size, MPI_DOUBLE,
+                          MPI_STATUS_IGNORE);
+    offset += num_elements*data_size;
+  }
+
+  // Write out the node data at the nodes of each element
+  if (node_size > 0){
+    const int nodes_per_element = mesh_order*mesh_order;
+    const int elem_node_size = node_size*nodes_per_element;
+    double *values = new double[ elem_node_size*size ];
+    for ( int i = 0; i < size; i++ ){
+      for ( int j = 0; j < nodes_per_element; j++ ){
+        int index = getLocalNodeNumber(conn[nodes_per_element*i + j]);
+        memcpy(&values[elem_node_size*i + node_size*j],
+               &node_data[node_size*index], node_size*sizeof(double));
+      }
+    }
+
+    MPI_Offset data_size = elem_node_size*sizeof(double);
+    MPI_File_write_at_all(fp, offset + offset_count*data_size,
+                          values, elem_node_size*size, MPI_DOUBLE,
+                          MPI_STATUS_IGNORE);
+    delete [] values;
+  }
+
+  MPI_File_close(&fp);
+
+  return 0;
+}
+
+/*
+  Read the forest from a binary file created by writeToFile()
+
+  The quadrants are split evenly between the processors in the order of
+  the space-filling curve, so the file can be read on any number of
+  processors. Each processor reads only the header, the block
+  connectivity and its own quadrants and data.
+
+  If the connectivity has already been set (for instance by
+  setTopology()) it must match the connectivity in the file. 
+  Otherwise the connectivity is set from the file. The mesh order and
+  interpolation type are set from the file. If node data is
+  requested, the nodes are created.
+
+  input:
+  filename:   the name of the file
+
+  output:
+  elem_size:  the number of values per element
+  elem_data:  the element values (elem_size values per local element)
+  node_size:  the number of values per node
+  node_data:  the node values (node_size values per local node in the
+              order returned by getNodeNumbers())
+
+  returns:    non-zero on failure
+*/
+int TMRQuadForest::readFromFile( const char *filename,
+                                int *_elem_size, double **_elem_data,
+                                int *_node_size, double **_node_data ){
+  if (_elem_size){ *_elem_size = 0; }
+  if (_elem_data){ *_elem_data = NULL; }
+  if (_node_size){ *_node_size = 0; }
+  if (_node_data){ *_node_data = NULL; }
+
+  MPI_File fp;
+  if (MPI_File_open(comm, (char*)filename, MPI_MODE_RDONLY,
+                    MPI_INFO_NULL, &fp) != MPI_SUCCESS){
+    fprintf(stderr, "[%d] TMRQuadForest: Could not open file %s\n",
+            mpi_rank, filename);
+    return 1;
+  }
+
+  // Read in the header
+  int64_t header[TMR_FILE_HEADER_SIZE];
+  MPI_Offset offset = 0;
+  MPI_File_read_at_all(fp, offset, header, TMR_FILE_HEADER_SIZE,
+                       MPI_INT64_T, MPI_STATUS_IGNORE);
+  offset += TMR_FILE_HEADER_SIZE*sizeof(int64_t);
+
+  if (header[0] != TMR_QUAD_FILE_ID || header[1] != TMR_FILE_VERSION){
+    fprintf(stderr, "[%d] TMRQuadForest: %s is not a forest of octrees\n",
+            mpi_rank, filename);
+    MPI_File_close(&fp);
+    return 1;
+  }
+
+  const int elem_size = header[4];
+  const int node_size = header[5];
+  const int file_num_faces = header[8];
+  const int64_t num_elements = header[10];
+
+  // Read in the face connectivity
+  int *file_face_conn = new int[ 4*file_num_faces ];
+  int *file_face_edge_conn = new int[ 4*file_num_faces ];
+  MPI_File_read_at_all(fp, offset, file_face_conn, 4*file_num_faces,
+                       MPI_INT, MPI_STATUS_IGNORE);
+  offset += 4*file_num_faces*sizeof(int);
+  MPI_File_read_at_all(fp, offset, file_face_edge_conn, 4*file_num_faces,
+                       MPI_INT, MPI_STATUS_IGNORE);
+  offset += 4*file_num_faces*sizeof(int);
+
+  int fail = 0;
+  if (face_conn){
+    // Check that the existing connectivity matches the file
+    if (num_faces != file_num_faces ||
+        num_nodes != header[6] || num_edges != header[7] ||
+        memcmp(face_conn, file_face_conn, 
+               4*num_faces*sizeof(int)) != 0 ||
+        memcmp(face_edge_conn, file_face_edge_conn,
+               4*num_faces*sizeof(int)) != 0){
+      fprintf(stderr, "[%d] TMRQuadForest: Connectivity in %s does not "
+              "match the forest\n", mpi_rank, filename);
+      fail = 1;
+    }
+    else {
+      freeMeshData();
+    }
+  }
+  else {
+    setFullConnectivity(header[6], header[7], file_num_faces,
+                        file_face_conn, file_face_edge_conn);
+  }
+  delete [] file_face_conn;
+  delete [] file_face_edge_conn;
+
+  if (fail){
+    MPI_File_close(&fp);
+    return fail;
+  }
+
+  // Set the mesh order from the file
+  setMeshOrder(header[2], (TMRInterpolationType)header[3]);
+
+  // Split the quadrants evenly between the processors
+  int64_t average_count = num_elements/mpi_size;
+  int64_t remain = num_elements - average_count*mpi_size;
+  int64_t start = mpi_rank*average_count;
+  start += (mpi_rank < remain ? mpi_rank : remain);
+  int size = average_count + (mpi_rank < remain ? 1 : 0);
+
+  // Read in the local quadrants
+  int quad_size;
+  MPI_Type_size(TMRQuadrant_MPI_type, &quad_size);
+  TMRQuadrant *array = new TMRQuadrant[ size ];
+  MPI_File_read_at_all(fp, offset + start*quad_size, array, size,
+                       TMRQuadrant_MPI_type, MPI_STATUS_IGNORE);
+  offset += num_elements*quad_size;
+
+  // Set the local quadrants and their owners
+  for ( int i = 0; i < size; i++ ){
+    array[i].tag = i;
+  }
+  quadrants = new TMRQuadrantArray(array, size);
+
+  // Set the first quadrant on each processor. Processors without
+  // quadrants take the owner from the preceding processor.
+  TMRQuadrant p;
+  p.tag = -1;
+  p.face = num_faces-1;
+  p.x = p.y = 1 << TMR_MAX_LEVEL;
+  p.level = 0;
+  p.info = 0;
+  if (size > 0){
+    p = array[0];
+  }
+  owners = new TMRQuadrant[ mpi_size ];
+  MPI_Allgather(&p, 1, TMRQuadrant_MPI_type, 
+                owners, 1, TMRQuadrant_MPI_type, comm);
+  for ( int k = 1; k < mpi_size; k++ ){
+    if (owners[k].tag == -1){
+      owners[k] = owners[k-1];
+    }
+  }
+
+  // Read in the element data
+  if (elem_size > 0){
+    MPI_Offset data_size = elem_size*sizeof(double);
+    double *elem_data = new double[ elem_size*size ];
+    MPI_File_read_at_all(fp, offset + start*data_size,
+                         elem_data, elem_size*size, MPI_DOUBLE,
+                         MPI_STATUS_IGNORE);
+    offset += num_elements*data_size;
+
+    if (_elem_size){ *_elem_size = elem_size; }
+    if (_elem_data){ *_elem_data = elem_data; }
+    else { delete [] elem_data; }
+  }
+
+  // Read in the node data and set it at the local nodes
+  if (node_size > 0 && _node_data){
+    const int nodes_per_element = mesh_order*mesh_order;
+    const int elem_node_size = node_size*nodes_per_element;
+    MPI_Offset data_size = elem_node_size*sizeof(double);
+    double *values = new double[ elem_node_size*size ];
+    MPI_File_read_at_all(fp, offset + start*data_size,
+                         values, elem_node_size*size, MPI_DOUBLE,
+                         MPI_STATUS_IGNORE);
+
+    createNodes();
+    double *node_data = new double[ node_size*num_local_nodes ];
+    for ( int i = 0; i < size; i++ ){
+      for ( int j = 0; j < nodes_per_element; j++ ){
+        int index = getLocalNodeNumber(conn[nodes_per_element*i + j]);
+        memcpy(&node_data[node_size*index],
+               &values[elem_node_size*i + node_size*j],
+               node_size*sizeof(double));
+      }
+    }
+    delete [] values;
+
+    if (_node_size){ *_node_size = node_size; }
+    *_node_data = node_data;
+  }
+
+  MPI_File_close(&fp);
+
+  return 0;
+}
+
+/*
+  Get the memory usage of the forest on this processor
+
+  The entries are the number of bytes currently allocated for each
+  group of arrays. The high-water marks record the largest memory
+  usage, including the transient hash tables, queues and arrays,
+  observed during balance() and createNodes().
+
+  output:
+  usage:   the memory usage object (entries are added to it)
+*/
+void TMRQuadForest::getMemoryUsage( TMRMemoryUsage *usage ){
+  size_t bytes = 0;
+  if (quadrants){
+    bytes = quadrants->getMemoryUsage();
+  }
+  usage->add("quadrants", bytes);
+
+  bytes = 0;
+  if (adjacent){
+    bytes = adjacent->getMemoryUsage();
+  }
+  usage->add("adjacent", bytes);
+
+  bytes = 0;
+  if (owners){
+    bytes = mpi_size*sizeof(TMRQuadrant);
+  }
+  usage->add("owners", bytes);
+
+  // The element to node connectivity
+  bytes = 0;
+  if (conn && quadrants){
+    int num_elements;
+    quadrants->getArray(NULL, &num_elements);
+    bytes = mesh_order*mesh_order*num_elements*sizeof(int);
+  }
+  usage->add("conn", bytes);
+
+  // The local node numbers and the ownership ranges
+  bytes = 0;
+  if (node_numbers){
+    bytes += num_local_nodes*sizeof(int);
+  }
+  if (node_range){
+    bytes += (mpi_size+1)*sizeof(int);
+  }
+  usage->add("node_numbers", bytes);
+
+  // The dependent node connectivity and weights
+  bytes = 0;
+  if (dep_ptr){
+    bytes += (num_dep_nodes+1)*sizeof(int);
+    if (dep_conn){
+      bytes += dep_ptr[num_dep_nodes]*sizeof(int);
+    }
+    if (dep_tmpl){
+      bytes += num_dep_nodes*sizeof(int);
+    }
+    if (dep_weights){
+      bytes += dep_ptr[num_dep_nodes]*sizeof(double);
+    }
+  }
+  usage->add("dep_nodes", bytes);
+
+  bytes = 0;
+  if (X){
+    bytes = num_local_nodes*sizeof(TMRPoint);
+  }
+  usage->add("X", bytes);
+
+  // The face connectivity tables (the same on all processors)
+  bytes = 0;
+  if (face_conn){
+    bytes += 4*num_faces*sizeof(int);
+  }
+  if (face_edge_conn){
+    bytes += 4*num_faces*sizeof(int);
+  }
+  if (node_face_ptr){
+    bytes += (num_nodes+1 + node_face_ptr[num_nodes])*sizeof(int);
+  }
+  if (edge_face_ptr){
+    bytes += (num_edges+1 + edge_face_ptr[num_edges])*sizeof(int);
+  }
+  if (edge_face_owners){
+    bytes += num_edges*sizeof(int);
+  }
+  if (node_face_owners){
+    bytes += num_nodes*sizeof(int);
+  }
+  usage->add("connectivity", bytes);
+
+  // The interpolation knots and tables
+  bytes = 0;
+  if (interp_knots){
+    bytes += mesh_order*sizeof(double);
+  }
+  if (dep_interp){
+    bytes += 2*mesh_order*mesh_order*sizeof(double);
+  }
+  if (interp_tables){
+    bytes += interp_tables->getMemoryUsage();
+  }
+  usage->add("interp", bytes);
+
+  // The attribute index
+  bytes = 0;
+  if (attr_quads){
+    bytes += num_attrs*(sizeof(char*) + sizeof(TMRQuadrantArray*));
+    for ( int k = 0; k < num_attrs; k++ ){
+      if (attr_names[k]){
+        bytes += strlen(attr_names[k])+1;
+      }
+      bytes += attr_quads[k]->getMemoryUsage();
+    }
+  }
+  if (attr_node_ptr){
+    bytes += (num_attrs+1 + attr_node_ptr[num_attrs])*sizeof(int);
+  }
+  usage->add("attr_index", bytes);
+
+  usage->addPeak("balance_peak", balance_peak_memory);
+  usage->addPeak("create_nodes_peak", nodes_peak_memory);
+}
+
+/*
+  Get the total memory currently held by the forest. This traverses
+  all of the arrays, so it is only called once within balance()
+  and createNodes(). The resident memory is then adjusted
+  as the quadrants are replaced.
+*/
+size_t TMRQuadForest::getResidentMemory(){
+  TMRMemoryUsage usage;
+  getMemoryUsage(&usage);
+  return usage.getTotal();
+}
+
+/*
+  Update the high-water mark with the resident memory of the forest
+  plus the given transient memory
+*/
+void TMRQuadForest::updatePeakMemory( size_t *peak, size_t resident,
+                                      size_t transient ){
+  size_t bytes = resident + transient;
+  if (bytes > *peak){
+    *peak = bytes;
+  }
+}
+
 /*
   Set the mesh order
 */
 void TMRQuadForest::setMeshOrder( int _mesh_order,
                                   TMRInterpolationType _interp_type ){
+  // Don't free the quadrants/owner information if it exists,
+  // but free the connectivity and node data
+  freeMeshData(0, 0);
+
+  // Free the interpolation knots
+  if (interp_knots){
+    delete [] interp_knots;
+  }
+
   // Check that the order falls within allowable bounds
   mesh_order = _mesh_order;
   if (mesh_order < 2){
@@ -959,6 +1511,61 @@ void TMRQuadForest::setMeshOrder( int _mesh_order,
       interp_knots[i] = -1.0 + 2.0*i/(mesh_order-1);
     }
   }
+
+  // Reset the cached interpolation tables
+  if (interp_tables){
+    interp_tables->clear();
+  }
+  else {
+    interp_tables = new TMRInterpTableCache();
+  }
+
+  // Compute the tables at the knots and child knots
+  double pts[3*MAX_ORDER];
+  lagrange_child_knots(mesh_order, interp_knots, pts);
+  interp_tables->getTable(mesh_order, interp_knots, 3*mesh_order, pts,
+                          NULL, NULL);
+
+  // Compute the weights for the dependent node templates
+  computeDepInterpTable();
+}
+
+/*
+  Compute the 1D interpolation table for the dependent nodes
+
+  The weights for any dependent node depend only on the mesh order,
+  the interpolation knots, the position of the child along the
+  parent edge and the local knot index of the dependent node.
+*/
+void TMRQuadForest::computeDepInterpTable(){
+  if (dep_interp){
+    delete [] dep_interp;
+  }
+
+  dep_interp = new double[ 2*mesh_order*mesh_order ];
+  for ( int x = 0; x < 2; x++ ){
+    for ( int k = 0; k < mesh_order; k++ ){
+      // Compute the parametric location of the knot on the parent
+      double u = 1.0*(x-1) + 0.5*(1.0 + interp_knots[k]);
+      lagrange_shape_functions(mesh_order, u, interp_knots,
+                               &dep_interp[mesh_order*(mesh_order*x + k)]);
+    }
+  }
+}
+
+/*
+  Set the number of threads used to evaluate the node locations
+
+  The geometry evaluation is performed in parallel over contiguous
+  ranges of the nodes. The threads are only used when all of the
+  faces report that concurrent calls to evalPoints are safe through
+  isThreadSafe(). Otherwise the nodes are evaluated serially.
+*/
+void TMRQuadForest::setNumThreads( int _num_threads ){
+  num_threads = _num_threads;
+  if (num_threads < 1){
+    num_threads = 1;
+  }
 }
 
 /*
@@ -1077,6 +1684,32 @@ void TMRQuadForest::evalInterp( const double pt[], double N[],
     }
   }
 }
+/*
+  Retrieve the 1D shape functions and their derivatives evaluated at
+  the given parametric points.
+
+  The tables are cached by the forest so that repeated requests with
+  the same points do not recompute the shape functions. The returned
+  tables have npts rows of length mesh_order and remain valid until
+  the mesh order is changed. The cache is not thread-safe, so this
+  must not be called concurrently.
+
+  input:
+  npts:   the number of parametric points
+  pts:    the parametric points
+
+  output:
+  N:      the shape functions at each point
+  Nd:     the derivatives of the shape functions at each point
+
+  returns: the mesh order (the length of each row)
+*/
+int TMRQuadForest::getInterpTable( int npts, const double pts[],
+                                   const double **_N, const double **_Nd ){
+  interp_tables->getTable(mesh_order, interp_knots, npts, pts, _N, _Nd);
+  return mesh_order;
+}
+
 
 /*
   Retrieve information about the connectivity between faces, edges and
@@ -1106,10 +1739,43 @@ void TMRQuadForest::getInverseConnectivity( const int **_node_face_conn,
   if (_edge_face_ptr){ *_edge_face_ptr = edge_face_ptr; }
 }
 
+/*
+  Set the quadrant at the given position along the space-filling
+  curve of a forest where every face is uniformly refined to the
+  given level. Within each face, the quadrants are ordered by their
+  Morton index where the x-coordinate is the most significant.
+*/
+static void get_uniform_quadrant( int64_t index, int32_t level, 
+                                  TMRQuadrant *quad ){
+  const int64_t nface = 1LL << (2*level);
+  const int64_t m = index % nface;
+
+  // Extract the x/y bits from the interleaved Morton index
+  int32_t x = 0, y = 0;
+  for ( int32_t k = 0; k < level; k++ ){
+    y |= ((m >> (2*k)) & 1) << k;
+    x |= ((m >> (2*k+1)) & 1) << k;
+  }
+
+  quad->tag = 0;
+  quad->face = index/nface;
+  quad->level = level;
+  quad->info = 0;
+  quad->x = x << (TMR_MAX_LEVEL - level);
+  quad->y = y << (TMR_MAX_LEVEL - level);
+}
+
 /*
   Create a forest with the specified refinement level
+
+  Every face is refined uniformly, so the position of each quadrant
+  along the space-filling curve is known in advance. The quadrants
+  are split evenly across the processors and each processor generates
+  only its own range, directly in sorted order. The owners are
+  computed in the same manner without any communication.
 */
 void TMRQuadForest::createTrees( int refine_level ){
+  TMRPerfBegin(TMR_PERF_CREATE_TREES);
   // Free all the mesh-specific data
   freeMeshData();
 
@@ -1122,6 +1788,60 @@ void TMRQuadForest::createTrees( int refine_level ){
     level = TMR_MAX_LEVEL-1;
   }
 
+  // Compute the total number of quadrants in the forest and the
+  // number of quadrants on each processor
+  const int64_t num_elements = (1LL << (2*level))*num_faces;
+  const int64_t nquads = num_elements/mpi_size;
+  const int64_t remain = num_elements % mpi_size;
+
+  // Set the range of quadrants owned by this processor
+  int64_t start = mpi_rank*nquads + (mpi_rank < remain ? mpi_rank : remain);
+  int size = nquads + (mpi_rank < remain ? 1 : 0);
+
+  // Generate the quadrants in order along the space-filling curve
+  TMRQuadrant *array = new TMRQuadrant[ size ];
+  for ( int i = 0; i < size; i++ ){
+    get_uniform_quadrant(start + i, level, &array[i]);
+    array[i].tag = i;
+  }
+
+  // Create the array of quadrants - this is already sorted
+  quadrants = new TMRQuadrantArray(array, size);
+
+  // Set the first quadrant on each processor. Processors that have
+  // no quadrants take the owner of the previous processor.
+  const int32_t hmax = 1 << TMR_MAX_LEVEL;
+  owners = new TMRQuadrant[ mpi_size ];
+  for ( int k = 0; k < mpi_size; k++ ){
+    int64_t k_start = k*nquads + (k < remain ? k : remain);
+    if (k_start < num_elements){
+      get_uniform_quadrant(k_start, level, &owners[k]);
+    }
+    else if (k > 0){
+      owners[k] = owners[k-1];
+    }
+    else {
+      owners[k].tag = -1;
+      owners[k].face = num_faces-1;
+      owners[k].level = 0;
+      owners[k].info = 0;
+      owners[k].x = owners[k].y = hmax;
+    }
+  }
+
+  TMRPerfAdd(TMR_PERF_ELEMENTS_CREATED, size);
+  TMRPerfEnd(TMR_PERF_CREATE_TREES);
+}
+
+/*
+  Create a forest with the specified refinement level
+*/
+void TMRQuadForest::createRandomTrees( int nrand,
+                                       int min_level, int max_level ){
+  TMRPerfBegin(TMR_PERF_CREATE_TREES);
+  // Free all the mesh-specific data
+  freeMeshData();
+
   // Set who owns what faces
   int nfaces = num_faces/mpi_size;
   int remain = num_faces % mpi_size;
@@ -1138,24 +1858,23 @@ void TMRQuadForest::createTrees( int refine_level ){
   }
 
   // Create an array of the quadrants that will be stored
-  int nelems = 1 << level;
-  int size = nelems*nelems*nfaces;
+  int size = nrand*nfaces;
   TMRQuadrant *array = new TMRQuadrant[ size ];
 
-  // Generate all of the quadrants on the associated faces
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;
-  const int32_t h = 1 << (TMR_MAX_LEVEL - level);
+  // Generate a random number of quadrants along random directions
   for ( int count = 0, face = start; face < end; face++ ){
-    for ( int32_t x = 0; x < hmax; x += h ){
-      for ( int32_t y = 0; y < hmax; y += h ){
-        array[count].tag = 0;
-        array[count].face = face;
-        array[count].level = level;
-        array[count].info = 0;
-        array[count].x = x;
-        array[count].y = y;
-        count++;
-      }
+    for ( int i = 0; i < nrand; i++, count++ ){
+      int32_t level = min_level + (rand() % (max_level - min_level + 1));
+
+      const int32_t h = 1 << (TMR_MAX_LEVEL - level);
+      int32_t x = h*(rand() % (1 << level));
+      int32_t y = h*(rand() % (1 << level));
+      array[count].tag = 0;
+      array[count].face = face;
+      array[count].level = level;
+      array[count].info = 0;
+      array[count].x = x;
+      array[count].y = y;
     }
   }
 
@@ -1175,7 +1894,7 @@ void TMRQuadForest::createTrees( int refine_level ){
   TMRQuadrant p;
   p.tag = -1;
   p.face = num_faces-1;
-  p.x = p.y = hmax;
+  p.x = p.y = 1 << TMR_MAX_LEVEL;
   p.info = 0;
   if (size > 0){
     p = array[0];
@@ -1192,87 +1911,186 @@ void TMRQuadForest::createTrees( int refine_level ){
       owners[k] = owners[k-1];
     }
   }
+  TMRPerfAdd(TMR_PERF_ELEMENTS_CREATED, quad_size);
+  TMRPerfEnd(TMR_PERF_CREATE_TREES);
 }
-
 /*
-  Create a forest with the specified refinement level
-*/
-void TMRQuadForest::createRandomTrees( int nrand,
-                                       int min_level, int max_level ){
-  // Free all the mesh-specific data
-  freeMeshData();
+  Create a forest of quadtrees that is refined to match the element
+  feature size
+
+  The forest is constructed top-down starting from a uniform forest
+  at min_level. At each level, the physical locations of the corners
+  and the center of all the pending quadrants are evaluated in a
+  batch along with the feature size at each of these points. A
+  quadrant is subdivided if the length of any of its edges in
+  physical space exceeds the smallest feature size sampled within it.
+  Only the first child of each family is passed to balance(), which
+  creates the siblings.
 
-  // Set who owns what faces
-  int nfaces = num_faces/mpi_size;
-  int remain = num_faces % mpi_size;
-  int start = mpi_rank*nfaces;
-  int end = (mpi_rank+1)*nfaces;
-  if (mpi_rank < remain){
-    nfaces += 1;
-    start += mpi_rank;
-    end += mpi_rank+1;
+  input:
+  fs:              the element feature size
+  min_level:       the minimum refinement level
+  max_level:       the maximum refinement level
+  balance_corner:  balance the corners of the forest
+*/
+void TMRQuadForest::createRefinedTrees( TMRElementFeatureSize *fs,
+                                        int min_level, int max_level,
+                                        int balance_corner ){
+  if (min_level < 0){
+    min_level = 0;
   }
-  else {
-    start += remain;
-    end += remain;
+  if (max_level >= TMR_MAX_LEVEL){
+    max_level = TMR_MAX_LEVEL-1;
+  }
+  if (max_level < min_level){
+    max_level = min_level;
   }
 
-  // Create an array of the quadrants that will be stored
-  int size = nrand*nfaces;
-  TMRQuadrant *array = new TMRQuadrant[ size ];
+  // Create the uniform forest at the minimum level
+  createTrees(min_level);
+  if (!topo || !fs){
+    fprintf(stderr, 
+            "TMRQuadForest: Cannot create refined trees without a "
+            "topology and feature size\n");
+    return;
+  }
 
-  // Generate a random number of quadrants along random directions
-  for ( int count = 0, face = start; face < end; face++ ){
-    for ( int i = 0; i < nrand; i++, count++ ){
-      int32_t level = min_level + (rand() % (max_level - min_level + 1));
+  TMRPerfBegin(TMR_PERF_CREATE_TREES);
 
-      const int32_t h = 1 << (TMR_MAX_LEVEL - level);
-      int32_t x = h*(rand() % (1 << level));
-      int32_t y = h*(rand() % (1 << level));
-      array[count].tag = 0;
-      array[count].face = face;
-      array[count].level = level;
-      array[count].info = 0;
-      array[count].x = x;
-      array[count].y = y;
+  // The quadrants that will not be refined further
+  TMRQuadrantQueue *queue = new TMRQuadrantQueue();
+
+  // The indices of the corners and center of each quadrant into the
+  // 3 x 3 grid of parameter values
+  const int pts[10] = {0, 0, 2, 0, 0, 2, 2, 2, 1, 1};
+
+  // The pairs of corners that define the edges of the quadrant
+  const int edge_corners[][2] = {{0, 1}, {2, 3}, {0, 2}, {1, 3}};
+
+  // Get the pending quadrants on this processor
+  int size;
+  TMRQuadrant *array;
+  quadrants->getArray(&array, &size);
+  TMRQuadrant *pending = new TMRQuadrant[ size ];
+  memcpy(pending, array, size*sizeof(TMRQuadrant));
+
+  while (size > 0){
+    // Evaluate the points within all of the pending quadrants
+    TMRPoint *X = new TMRPoint[ 5*size ];
+    double *hvals = new double[ 5*size ];
+
+    // Keep track of the last surface to avoid repeated look ups
+    int face = -1;
+    TMRFace *surf = NULL;
+
+    for ( int i = 0; i < size; i++ ){
+      if (pending[i].face != face){
+        face = pending[i].face;
+        topo->getFace(face, &surf);
+      }
+
+      // Set the parametric locations of the points
+      const int32_t h = 1 << (TMR_MAX_LEVEL - pending[i].level);
+      double d = convert_to_coordinate(h);
+      double u = convert_to_coordinate(pending[i].x);
+      double v = convert_to_coordinate(pending[i].y);
+      double pu[3], pv[3];
+      for ( int k = 0; k < 3; k++ ){
+        pu[k] = u + 0.5*d*k;
+        pv[k] = v + 0.5*d*k;
+      }
+      surf->evalPoints(3, pu, 3, pv, 5, pts, &X[5*i]);
     }
-  }
 
-  // Create the array of quadrants
-  quadrants = new TMRQuadrantArray(array, size);
-  quadrants->sort();
+    // Evaluate the feature size at all of the points
+    for ( int i = 0; i < 5*size; i++ ){
+      hvals[i] = fs->getFeatureSize(X[i]);
+    }
 
-  // Set the local ordering for the elements
-  int quad_size;
-  TMRQuadrant *quads;
-  quadrants->getArray(&quads, &quad_size);
-  for ( int i = 0; i < quad_size; i++ ){
-    quads[i].tag = i;
-  }
+    // Count up the number of quadrants that will be refined
+    int num_refine = 0;
+    for ( int i = 0; i < size; i++ ){
+      if (pending[i].level < max_level){
+        // Find the smallest feature size within the quadrant
+        double hmin = hvals[5*i];
+        for ( int k = 1; k < 5; k++ ){
+          if (hvals[5*i+k] < hmin){
+            hmin = hvals[5*i+k];
+          }
+        }
 
-  // Set the last quadrant
-  TMRQuadrant p;
-  p.tag = -1;
-  p.face = num_faces-1;
-  p.x = p.y = 1 << TMR_MAX_LEVEL;
-  p.info = 0;
-  if (size > 0){
-    p = array[0];
-  }
+        // Find the longest edge of the quadrant
+        const TMRPoint *Xc = &X[5*i];
+        double lmax = 0.0;
+        for ( int k = 0; k < 4; k++ ){
+          TMRPoint d;
+          d.x = Xc[edge_corners[k][1]].x - Xc[edge_corners[k][0]].x;
+          d.y = Xc[edge_corners[k][1]].y - Xc[edge_corners[k][0]].y;
+          d.z = Xc[edge_corners[k][1]].z - Xc[edge_corners[k][0]].z;
+          double l = sqrt(d.dot(d));
+          if (l > lmax){
+            lmax = l;
+          }
+        }
 
-  owners = new TMRQuadrant[ mpi_size ];
-  MPI_Allgather(&p, 1, TMRQuadrant_MPI_type,
-                owners, 1, TMRQuadrant_MPI_type, comm);
+        if (lmax > hmin){
+          // Mark the quadrant for refinement
+          pending[i].tag = -1;
+          num_refine++;
+          continue;
+        }
+      }
 
-  // Set the offsets if some of the processors have zero
-  // quadrants
-  for ( int k = 1; k < mpi_size; k++ ){
-    if (owners[k].tag == -1){
-      owners[k] = owners[k-1];
+      // Only the first child of each family is required since the
+      // siblings are added during the balancing
+      if (pending[i].childId() == 0){
+        queue->push(&pending[i]);
+      }
+    }
+
+    delete [] X;
+    delete [] hvals;
+
+    // Create the children of the refined quadrants
+    TMRQuadrant *children = new TMRQuadrant[ 4*num_refine ];
+    for ( int i = 0, count = 0; i < size; i++ ){
+      if (pending[i].tag == -1){
+        const int32_t h = 1 << (TMR_MAX_LEVEL - pending[i].level - 1);
+        for ( int k = 0; k < 4; k++, count++ ){
+          children[count] = pending[i];
+          children[count].tag = 0;
+          children[count].level = pending[i].level + 1;
+          children[count].x = pending[i].x + h*(k % 2);
+          children[count].y = pending[i].y + h*(k/2);
+        }
+      }
     }
+    delete [] pending;
+    pending = children;
+    size = 4*num_refine;
+  }
+  delete [] pending;
+
+  // Create the new array of quadrants
+  delete quadrants;
+  quadrants = queue->toArray();
+  delete queue;
+  quadrants->sort();
+
+  quadrants->getArray(&array, &size);
+  for ( int i = 0; i < size; i++ ){
+    array[i].tag = i;
   }
+  TMRPerfAdd(TMR_PERF_ELEMENTS_CREATED, size);
+  TMRPerfEnd(TMR_PERF_CREATE_TREES);
+
+  // Distribute the quadrants evenly and balance the forest
+  repartition();
+  balance(balance_corner);
+  repartition();
 }
 
+
 /*
   Repartition the quadrants across all processors.
 
@@ -1280,6 +2098,7 @@ void TMRQuadForest::createRandomTrees( int nrand,
   after this call so be careful.
 */
 void TMRQuadForest::repartition(){
+  TMRPerfBegin(TMR_PERF_REPARTITION);
   // Free everything but the quadrants
   freeMeshData(0);
 
@@ -1362,6 +2181,7 @@ void TMRQuadForest::repartition(){
         // Send the element array to the new owner
         MPI_Isend(&array[start], count, TMRQuadrant_MPI_type,
                   i, 0, comm, &send_requests[send_count]);
+        TMRPerfAdd(TMR_PERF_BYTES_SENT, count*sizeof(TMRQuadrant));
         send_count++;
       }
     }
@@ -1414,6 +2234,7 @@ void TMRQuadForest::repartition(){
   for ( int i = 0; i < new_size; i++ ){
     new_array[i].tag = i;
   }
+  TMRPerfEnd(TMR_PERF_REPARTITION);
 }
 
 /*
@@ -1424,7 +2245,24 @@ void TMRQuadForest::repartition(){
   and copies each individual tree.
 */
 TMRQuadForest *TMRQuadForest::duplicate(){
-  TMRQuadForest *dup = new TMRQuadForest(comm);
+  return duplicate(mesh_order, interp_type);
+}
+
+/*
+  Duplicate the forest with a different mesh order
+
+  The quadrants and their parallel distribution are copied from this
+  forest. This can be used to create the p-levels of a multigrid
+  hierarchy, since createInterpolation() can be used between forests
+  with different mesh orders.
+
+  input:
+  order:        the mesh order of the new forest
+  interp_type:  the interpolation type of the new forest
+*/
+TMRQuadForest *TMRQuadForest::duplicate( int order,
+                                         TMRInterpolationType _interp_type ){
+  TMRQuadForest *dup = new TMRQuadForest(comm, order, _interp_type);
   if (face_conn){
     copyData(dup);
 
@@ -1443,10 +2281,11 @@ TMRQuadForest *TMRQuadForest::duplicate(){
   This function creates a coarsened representation of the current
   forest. This is done by copying the global connectivity of the
   forest and coarsening each individual tree. Note that the resulting
-  forest is not necessarily balanced.
+  forest is not necessarily balanced. The coarse forest keeps the mesh
+  order and interpolation type of this forest, as in TMROctForest.
 */
 TMRQuadForest *TMRQuadForest::coarsen(){
-  TMRQuadForest *coarse = new TMRQuadForest(comm);
+  TMRQuadForest *coarse = new TMRQuadForest(comm, mesh_order, interp_type);
   if (face_conn){
     copyData(coarse);
 
@@ -1492,6 +2331,7 @@ TMRQuadForest *TMRQuadForest::coarsen(){
 */
 void TMRQuadForest::refine( const int refinement[],
                             int min_level, int max_level ){
+  TMRPerfBegin(TMR_PERF_REFINE);
   // Free the data associated with the mesh but not the quadrants/owners
   freeMeshData(0, 0);
 
@@ -1648,6 +2488,8 @@ void TMRQuadForest::refine( const int refinement[],
   for ( int i = 0; i < size; i++ ){
     array[i].tag = i;
   }
+  TMRPerfAdd(TMR_PERF_ELEMENTS_CREATED, size);
+  TMRPerfEnd(TMR_PERF_REFINE);
 }
 
 /*
@@ -1810,6 +2652,7 @@ TMRQuadrantArray *TMRQuadForest::sendQuadrants( TMRQuadrantArray *list,
       int count = quad_ptr[i+1] - quad_ptr[i];
       MPI_Isend(&array[quad_ptr[i]], count, TMRQuadrant_MPI_type,
                 i, 0, comm, &send_request[j]);
+      TMRPerfAdd(TMR_PERF_BYTES_SENT, count*sizeof(TMRQuadrant));
       j++;
     }
     else if (i == mpi_rank){
@@ -2114,6 +2957,13 @@ void TMRQuadForest::balanceQuadrant( TMRQuadrant *quad,
   per edge) and balances across corners optionally.
 */
 void TMRQuadForest::balance( int balance_corner ){
+  TMRPerfBegin(TMR_PERF_BALANCE);
+  // The quadrants are replaced below, so the attribute index is invalid
+  freeAttributeIndex();
+
+  // The memory held by the forest, excluding the transient data
+  size_t resident = getResidentMemory();
+
   // Create a hash table for the balanced tree
   TMRQuadrantHash *hash = new TMRQuadrantHash();
   TMRQuadrantHash *ext_hash = new TMRQuadrantHash();
@@ -2146,8 +2996,15 @@ void TMRQuadForest::balance( int balance_corner ){
                     balance_corner, balance_tree);
   }
 
+  // Record the memory before the original quadrants are freed
+  updatePeakMemory(&balance_peak_memory, resident,
+                   hash->getMemoryUsage() + ext_hash->getMemoryUsage() +
+                   queue->getMemoryUsage());
+
   // Free the original quadrant array and set it to NULL
+  resident -= quadrants->getMemoryUsage();
   delete quadrants;
+  quadrants = NULL;
 
   while (queue->length() > 0){
     // Now continue until the queue of added quadrants is
@@ -2166,6 +3023,9 @@ void TMRQuadForest::balance( int balance_corner ){
   // Create a sorted list of local the 0-child quadrants. This can be
   // further reduced to limit the amount of memory passed between
   // processors
+  updatePeakMemory(&balance_peak_memory, resident,
+                   hash->getMemoryUsage() + ext_hash->getMemoryUsage() +
+                   queue->getMemoryUsage());
   TMRQuadrantArray *elems0 = ext_hash->toArray();
   delete ext_hash;
   elems0->sort();
@@ -2250,6 +3110,9 @@ void TMRQuadForest::balance( int balance_corner ){
   }
 
   // Free the temporary elements
+  updatePeakMemory(&balance_peak_memory, resident,
+                   hash->getMemoryUsage() + queue->getMemoryUsage() +
+                   child0_elems->getMemoryUsage());
   delete child0_elems;
 
   // Turn the queue into an array
@@ -2274,6 +3137,7 @@ void TMRQuadForest::balance( int balance_corner ){
   // Set the elements into the quadtree
   quadrants = hash->toArray();
   quadrants->sort();
+  resident += quadrants->getMemoryUsage();
 
   // Get the quadrants and order their labels
   quadrants->getArray(&array, &size);
@@ -2282,7 +3146,11 @@ void TMRQuadForest::balance( int balance_corner ){
   }
 
   // Free the hash
+  updatePeakMemory(&balance_peak_memory, resident,
+                   hash->getMemoryUsage());
   delete hash;
+  TMRPerfAdd(TMR_PERF_ELEMENTS_CREATED, size);
+  TMRPerfEnd(TMR_PERF_BALANCE);
 }
 
 /*
@@ -2413,6 +3281,7 @@ void TMRQuadForest::addAdjacentCornerToQueue( int corner,
   computed.
 */
 void TMRQuadForest::computeAdjacentQuadrants(){
+  TMRPerfBegin(TMR_PERF_COMPUTE_ADJACENT);
   if (adjacent){
     delete adjacent;
   }
@@ -2528,6 +3397,7 @@ void TMRQuadForest::computeAdjacentQuadrants(){
   for ( int i = 0; i < size; i++ ){
     array[i].tag = i;
   }
+  TMRPerfEnd(TMR_PERF_COMPUTE_ADJACENT);
 }
 
 /*
@@ -2543,6 +3413,7 @@ void TMRQuadForest::computeAdjacentQuadrants(){
   info flags set in all quads in the quadrants list and adjacent list
 */
 void TMRQuadForest::computeDepEdges(){
+  TMRPerfBegin(TMR_PERF_COMPUTE_DEP_FACES_EDGES);
   for ( int iter = 0; iter < 2; iter++ ){
     // Get the elements either in the regular quadrant array or
     // in the adjacent element array
@@ -2611,6 +3482,7 @@ void TMRQuadForest::computeDepEdges(){
       }
     }
   }
+  TMRPerfEnd(TMR_PERF_COMPUTE_DEP_FACES_EDGES);
 }
 
 /*
@@ -2893,6 +3765,11 @@ void TMRQuadForest::createNodes(){
     return;
   }
 
+  // The quadrants are labeled below, so the attribute index is invalid
+  freeAttributeIndex();
+
+  TMRPerfBegin(TMR_PERF_CREATE_NODES);
+
   // Send/recv the adjacent quadrants
   computeAdjacentQuadrants();
 
@@ -3003,6 +3880,11 @@ void TMRQuadForest::createNodes(){
   // owned by other processors and referenced by the
   // elements on this processor.
   TMRQuadrantArray *ext_array = ext_nodes->toArray();
+  size_t resident = getResidentMemory();
+  updatePeakMemory(&nodes_peak_memory, resident,
+                   nodes->getMemoryUsage() + node_size*sizeof(int) +
+                   ext_nodes->getMemoryUsage() +
+                   ext_array->getMemoryUsage());
   delete ext_nodes;
 
     // Sort based on the tags
@@ -3036,6 +3918,10 @@ void TMRQuadForest::createNodes(){
   // Send the nodes back to the original processors
   TMRQuadrantArray *return_nodes = sendQuadrants(dist_nodes,
                                                  recv_ptr, send_ptr);
+  updatePeakMemory(&nodes_peak_memory, resident,
+                   nodes->getMemoryUsage() + node_size*sizeof(int) +
+                   dist_nodes->getMemoryUsage() +
+                   return_nodes->getMemoryUsage());
   delete dist_nodes;
   delete [] recv_ptr;
   delete [] send_ptr;
@@ -3081,6 +3967,7 @@ void TMRQuadForest::createNodes(){
 
   // Evaluate the node locations
   evaluateNodeLocations();
+  TMRPerfEnd(TMR_PERF_CREATE_NODES);
 }
 
 /*
@@ -3104,6 +3991,7 @@ void TMRQuadForest::createNodes(){
   3. level represents the number of nodes represented by the quad
 */
 TMRQuadrantArray *TMRQuadForest::createLocalNodes(){
+  TMRPerfBegin(TMR_PERF_CREATE_LOCAL_NODES);
   // Allocate the array of elements
   int num_elements;
   TMRQuadrant *quads;
@@ -3360,6 +4248,8 @@ TMRQuadrantArray *TMRQuadForest::createLocalNodes(){
   }
   delete owner_nodes;
 
+  TMRPerfEnd(TMR_PERF_CREATE_LOCAL_NODES);
+
   // Return the owners for each node
   return nodes;
 }
@@ -3570,14 +4460,19 @@ void TMRQuadForest::createLocalConn( TMRQuadrantArray *nodes,
   Create the dependent mesh information for all local dependent
   nodes.
 
+  The weights are not stored explicitly. Instead, each dependent node
+  is assigned a template index that selects a row of the 1D table
+  computed by computeDepInterpTable().
+
   output:
   ptr:      pointer for each dependent node number
   conn:     connectivity to each (global) independent node
-  weights:  the weight values for each dependent node
+  tmpl:     the weight template for each dependent node
 */
 void TMRQuadForest::createDependentConn( const int *node_nums,
                                          TMRQuadrantArray *nodes,
                                          const int *node_offset ){
+  TMRPerfBegin(TMR_PERF_CREATE_DEPENDENT_CONN);
   // Allocate space for the connectivity
   dep_ptr = new int[ num_dep_nodes+1 ];
   for ( int k = 0; k < num_dep_nodes+1; k++ ){
@@ -3586,7 +4481,7 @@ void TMRQuadForest::createDependentConn( const int *node_nums,
 
   // Allocate the space for the node numbers
   dep_conn = new int[ mesh_order*num_dep_nodes ];
-  dep_weights = new double[ mesh_order*num_dep_nodes ];
+  dep_tmpl = new int[ num_dep_nodes ];
 
   // Get the quadrants
   int num_elements;
@@ -3702,26 +4597,23 @@ void TMRQuadForest::createDependentConn( const int *node_nums,
             if (index < 0){
               index = -index-1;
 
-              // Compute parametric location along the edge
-              double u = 0.0;
+              // Compute the position of the child along the edge
+              int x = 0;
               if (edge_index < 2){
-                u = 1.0*(-1 + (quads[i].childId()/2)) +
-                  0.5*(1.0 + interp_knots[k]);
+                x = quads[i].childId()/2;
               }
               else {
-                u = 1.0*(-1 + (quads[i].childId() % 2)) +
-                  0.5*(1.0 + interp_knots[k]);
+                x = quads[i].childId() % 2;
               }
 
-              // Compute the shape functions
+              // Set the independent nodes
               int ptr = dep_ptr[index];
               for ( int j = 0; j < mesh_order; j++ ){
                 dep_conn[ptr + j] = edge_nodes[j];
               }
 
-              // Evaluate the shape functions
-              lagrange_shape_functions(mesh_order, u, interp_knots,
-                                       &dep_weights[ptr]);
+              // Set the weight template
+              dep_tmpl[index] = mesh_order*x + k;
             }
           }
         }
@@ -3730,73 +4622,267 @@ void TMRQuadForest::createDependentConn( const int *node_nums,
   }
 
   delete [] edge_nodes;
+  TMRPerfEnd(TMR_PERF_CREATE_DEPENDENT_CONN);
+}
+
+/*
+  Compare two parameter values for sorting
+*/
+static int compare_doubles( const void *a, const void *b ){
+  const double *aa = static_cast<const double*>(a);
+  const double *bb = static_cast<const double*>(b);
+
+  if (*aa < *bb){
+    return -1;
+  }
+  else if (*aa > *bb){
+    return 1;
+  }
+  return 0;
+}
+
+/*
+  Sort the values in place, remove the duplicates and return the
+  number of unique values
+*/
+static int sort_unique_doubles( int n, double *a ){
+  if (n == 0){
+    return 0;
+  }
+  qsort(a, n, sizeof(double), compare_doubles);
+  int k = 1;
+  for ( int i = 1; i < n; i++ ){
+    if (a[i] != a[k-1]){
+      a[k] = a[i];
+      k++;
+    }
+  }
+  return k;
+}
+
+/*
+  The arguments passed to each thread that evaluates node locations
+
+  The points are stored in runs that lie on the same face. The
+  parameter values of run r are stored in params starting at
+  2*run_ptr[r] for each of the two coordinate directions.
+*/
+class TMRQuadNodeLocationArgs {
+ public:
+  int start, end;
+  int num_runs;
+  const int *run_ptr;
+  TMRFace **faces;
+  const int *nparams;
+  const double *params;
+  const int *pts;
+  TMRPoint *Xpts;
+};
+
+/*
+  Evaluate the points in the range [start, end) of the point list
+*/
+static void evaluateQuadNodeLocations( TMRQuadNodeLocationArgs *args ){
+  for ( int r = 0; r < args->num_runs; r++ ){
+    int s = args->run_ptr[r];
+    int e = args->run_ptr[r+1];
+    if (s < args->start){ s = args->start; }
+    if (e > args->end){ e = args->end; }
+    if (s >= e){
+      continue;
+    }
+
+    // Get the parameter values along each direction for this run
+    const int n = args->run_ptr[r+1] - args->run_ptr[r];
+    const double *u = &args->params[2*args->run_ptr[r]];
+    const double *v = &u[n];
+    args->faces[r]->evalPoints(args->nparams[2*r], u,
+                               args->nparams[2*r+1], v,
+                               e - s, &args->pts[2*s], &args->Xpts[s]);
+  }
+}
+
+/*
+  The thread entry point for evaluating the node locations
+*/
+static void *evaluateQuadNodeLocationsThread( void *args ){
+  TMRSetPerfThreadTimers(0);
+  evaluateQuadNodeLocations((TMRQuadNodeLocationArgs*)args);
+  pthread_exit(NULL);
+  return NULL;
 }
 
 /*
   Evaluate the node locations based on the parametric locations
+
+  Each independent local node is assigned to the first element that
+  references it and the nodes are collected into runs of points that
+  lie on the same face. The parameter values of each run are sorted
+  and the duplicates are removed, so that each point is given by
+  indices into the unique parameter values. TMRFace::evalPoints is
+  then called once for each run, so the geometry can evaluate the
+  edges once for each unique parameter value instead of once for each
+  node. The points are split into contiguous ranges that are
+  evaluated on separate threads when num_threads > 1, but only if all
+  of the faces report that they are thread-safe. The dependent nodes
+  are computed from the independent nodes afterwards.
 */
 void TMRQuadForest::evaluateNodeLocations(){
+  TMRPerfBegin(TMR_PERF_EVALUATE_NODE_LOCATIONS);
   // Allocate the array of locally owned nodes
   X = new TMRPoint[ num_local_nodes ];
   memset(X, 0, num_local_nodes*sizeof(TMRPoint));
 
-  int *flags = new int[ num_local_nodes ];
-  memset(flags, 0, num_local_nodes*sizeof(int));
-
   int num_elements;
   TMRQuadrant *quads;
   quadrants->getArray(&quads, &num_elements);
 
   if (topo){
-    for ( int i = 0; i < num_elements; i++ ){
-      // Get the right surface
-      TMRFace *surf;
-      topo->getFace(quads[i].face, &surf);
-
-      // Compute the edge length
-      const int32_t h = 1 << (TMR_MAX_LEVEL - quads[i].level);
+    const int nodes_per_element = mesh_order*mesh_order;
+
+    // Assign each independent node to the first element that
+    // references it and record its parametric location
+    int npts = 0;
+    int *nodes = new int[ num_local_nodes ];
+    double *pt_params = new double[ 2*num_local_nodes ];
+    int *flags = new int[ num_local_nodes ];
+    memset(flags, 0, num_local_nodes*sizeof(int));
+
+    // The runs of points that lie on the same face
+    int num_runs = 0, face = -1;
+    int *run_ptr = new int[ num_elements+1 ];
+    TMRFace **faces = new TMRFace*[ num_elements ];
+    run_ptr[0] = 0;
 
+    for ( int i = 0; i < num_elements; i++ ){
       // Compute the origin of the element in parametric space
       // and the edge length of the element
+      const int32_t h = 1 << (TMR_MAX_LEVEL - quads[i].level);
       double d = convert_to_coordinate(h);
       double u = convert_to_coordinate(quads[i].x);
       double v = convert_to_coordinate(quads[i].y);
 
-      // Look for nodes that are not assigned
+      const int *c = &conn[nodes_per_element*i];
       for ( int jj = 0; jj < mesh_order; jj++ ){
         for ( int ii = 0; ii < mesh_order; ii++ ){
-          // Compute the mesh index
-          int node = conn[mesh_order*mesh_order*i +
-                          ii + jj*mesh_order];
-          if (node >= 0){
-            int index = getLocalNodeNumber(node);
-            if (!flags[index]){
-              flags[index] = 1;
-              surf->evalPoint(u + 0.5*d*(1.0 + interp_knots[ii]),
-                              v + 0.5*d*(1.0 + interp_knots[jj]),
-                              &X[index]);
-            }
+          if (c[ii + mesh_order*jj] < 0){
+            continue;
           }
+          int index = getLocalNodeNumber(c[ii + mesh_order*jj]);
+          if (index < 0 || flags[index]){
+            continue;
+          }
+          flags[index] = 1;
+
+          // Start a new run when the face changes
+          if (quads[i].face != face){
+            face = quads[i].face;
+            topo->getFace(face, &faces[num_runs]);
+            run_ptr[num_runs] = npts;
+            num_runs++;
+          }
+
+          nodes[npts] = index;
+          pt_params[2*npts] = u + 0.5*d*(1.0 + interp_knots[ii]);
+          pt_params[2*npts+1] = v + 0.5*d*(1.0 + interp_knots[jj]);
+          npts++;
+        }
+      }
+    }
+    run_ptr[num_runs] = npts;
+    delete [] flags;
+
+    // Find the unique parameter values in each run and the indices
+    // of each point into these values
+    int thread_safe = 1;
+    int *nparams = new int[ 2*num_runs ];
+    double *params = new double[ 2*npts ];
+    int *pts = new int[ 2*npts ];
+    for ( int r = 0; r < num_runs; r++ ){
+      const int s = run_ptr[r];
+      const int n = run_ptr[r+1] - s;
+      for ( int k = 0; k < 2; k++ ){
+        double *p = &params[2*s + k*n];
+        for ( int j = 0; j < n; j++ ){
+          p[j] = pt_params[2*(s + j) + k];
+        }
+        nparams[2*r+k] = sort_unique_doubles(n, p);
+        for ( int j = 0; j < n; j++ ){
+          double *ptr = (double*)bsearch(&pt_params[2*(s + j) + k], p,
+                                         nparams[2*r+k], sizeof(double),
+                                         compare_doubles);
+          pts[2*(s + j) + k] = ptr - p;
         }
       }
+      if (!faces[r]->isThreadSafe()){
+        thread_safe = 0;
+      }
+    }
+    delete [] pt_params;
+
+    TMRPoint *Xpts = new TMRPoint[ npts ];
+    TMRQuadNodeLocationArgs args;
+    args.start = 0;
+    args.end = npts;
+    args.num_runs = num_runs;
+    args.run_ptr = run_ptr;
+    args.faces = faces;
+    args.nparams = nparams;
+    args.params = params;
+    args.pts = pts;
+    args.Xpts = Xpts;
+
+    if (num_threads > 1 && thread_safe && npts > num_threads){
+      // Split the points into contiguous ranges for each thread
+      pthread_t *threads = new pthread_t[ num_threads ];
+      TMRQuadNodeLocationArgs *targs = 
+        new TMRQuadNodeLocationArgs[ num_threads ];
+      for ( int k = 0; k < num_threads; k++ ){
+        targs[k] = args;
+        targs[k].start = (k*npts)/num_threads;
+        targs[k].end = ((k+1)*npts)/num_threads;
+        pthread_create(&threads[k], NULL, evaluateQuadNodeLocationsThread,
+                       (void*)&targs[k]);
+      }
+      for ( int k = 0; k < num_threads; k++ ){
+        pthread_join(threads[k], NULL);
+      }
+      delete [] threads;
+      delete [] targs;
+    }
+    else {
+      evaluateQuadNodeLocations(&args);
     }
 
+    // Copy the points to the node locations
+    for ( int i = 0; i < npts; i++ ){
+      X[nodes[i]] = Xpts[i];
+    }
+
+    delete [] nodes;
+    delete [] run_ptr;
+    delete [] faces;
+    delete [] nparams;
+    delete [] params;
+    delete [] pts;
+    delete [] Xpts;
+
     // Set the dependent node values
     for ( int i = 0; i < num_dep_nodes; i++ ){
       int pt = num_dep_nodes-1-i;
       X[pt].x = X[pt].y = X[pt].z = 0.0;
 
-      for ( int j = dep_ptr[i]; j < dep_ptr[i+1]; j++ ){
-        int node = dep_conn[j];
+      const double *N = &dep_interp[mesh_order*dep_tmpl[i]];
+      for ( int j = 0; j < mesh_order; j++ ){
+        int node = dep_conn[dep_ptr[i] + j];
         int index = getLocalNodeNumber(node);
-        X[pt].x += dep_weights[j]*X[index].x;
-        X[pt].y += dep_weights[j]*X[index].y;
-        X[pt].z += dep_weights[j]*X[index].z;
+        X[pt].x += N[j]*X[index].x;
+        X[pt].y += N[j]*X[index].y;
+        X[pt].z += N[j]*X[index].z;
       }
     }
   }
-
-  delete [] flags;
+  TMRPerfEnd(TMR_PERF_EVALUATE_NODE_LOCATIONS);
 }
 
 /*
@@ -3833,22 +4919,90 @@ void TMRQuadForest::getNodeConn( const int **_conn,
 */
 int TMRQuadForest::getDepNodeConn( const int **ptr, const int **conn,
                                    const double **weights ){
+  // Expand the weights from the templates if they are requested
+  if (weights && !dep_weights && dep_ptr){
+    dep_weights = new double[ dep_ptr[num_dep_nodes] ];
+    for ( int i = 0; i < num_dep_nodes; i++ ){
+      evalDepTemplate(dep_tmpl[i], &dep_weights[dep_ptr[i]]);
+    }
+  }
+
   if (ptr){ *ptr = dep_ptr; }
   if (conn){ *conn = dep_conn; }
   if (weights){ *weights = dep_weights; }
   return num_dep_nodes;
 }
 
+/*
+  Get the compressed form of the dependent node information. Note
+  that this call is not collective.
+
+  output:
+  ptr:      pointer for each dependent node number
+  conn:     connectivity to each (global) independent node
+  tmpl:     the weight template index for each dependent node
+*/
+int TMRQuadForest::getDepNodeTemplates( const int **ptr, const int **conn,
+                                        const int **tmpl ){
+  if (ptr){ *ptr = dep_ptr; }
+  if (conn){ *conn = dep_conn; }
+  if (tmpl){ *tmpl = dep_tmpl; }
+  return num_dep_nodes;
+}
+
+/*
+  Expand a single row of the dependent node constraints without
+  forming the full weight array.
+
+  input:
+  dep_node:  the dependent node index (0 <= dep_node < num_dep_nodes)
+
+  output:
+  conn:      pointer to the independent nodes for this row
+  weights:   the weights (must be of length order)
+
+  returns:   the length of the row
+*/
+int TMRQuadForest::getDepNodeRow( int dep_node, const int **conn, 
+                                  double *weights ){
+  if (dep_node < 0 || dep_node >= num_dep_nodes){
+    return 0;
+  }
+  if (conn){ *conn = &dep_conn[dep_ptr[dep_node]]; }
+  if (weights){
+    evalDepTemplate(dep_tmpl[dep_node], weights);
+  }
+  return dep_ptr[dep_node+1] - dep_ptr[dep_node];
+}
+
+/*
+  Evaluate the weights associated with the given template
+
+  input:
+  tmpl:     the template index
+
+  output:
+  weights:  the weights (must be of length order)
+
+  returns:  the number of weights in the template
+*/
+int TMRQuadForest::evalDepTemplate( int tmpl, double *weights ){
+  const double *N = &dep_interp[mesh_order*tmpl];
+  for ( int j = 0; j < mesh_order; j++ ){
+    weights[j] = N[j];
+  }
+  return mesh_order;
+}
+
 /*
   Get the elements that either lie on a face or curve with a given
   attribute.
 
-  This code loops over all quadrants owned locally on this processor
-  and checks if each quadrant lies on a face or boundary. If the face
-  attribute matches, the quadrant is added without modification. If
-  the quadrant lies on an edge, the quadrant is modified so that the
-  tag indicates which edge the quadrant lies on using the regular edge
-  ordering scheme.
+  This code uses the attribute index to find the quadrants. If the
+  face attribute matches, the quadrant is added without
+  modification. If the quadrant lies on an edge, the quadrant is
+  modified so that the info member indicates which edge the quadrant
+  lies on using the regular edge ordering scheme.
 
   input:
   attr:   string attribute associated with the geometric feature
@@ -3868,88 +5022,29 @@ getQuadsWithAttribute()\n");
     return NULL;
   }
 
-  // Create a queue to store the elements that we find
+  // Create the index if it does not yet exist
+  if (!attr_quads){
+    createAttributeIndex();
+  }
+
+  int index = findAttribute(attr);
+  if (index >= 0){
+    return attr_quads[index]->duplicate();
+  }
+
+  // No entity has this attribute: return an empty array
   TMRQuadrantQueue *queue = new TMRQuadrantQueue();
+  TMRQuadrantArray *list = queue->toArray();
+  delete queue;
+  return list;
+}
 
-  // Get the quadrants
-  int size;
-  TMRQuadrant *array;
-  quadrants->getArray(&array, &size);
+/*
+  Create an array of the nodes that are lie on a surface, edge or
+  corner with a given attribute
 
-  // Loop over the quadrants and find out whether it touches
-  // a face or edge with the prescribed attribute
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;
-  for ( int i = 0; i < size; i++ ){
-    const int32_t h = 1 << (TMR_MAX_LEVEL - array[i].level);
-
-    // Get the surface quadrant
-    TMRFace *surf;
-    topo->getFace(array[i].face, &surf);
-    const char *face_attr = surf->getAttribute();
-    if ((!attr && !face_attr) ||
-        (face_attr && strcmp(face_attr, attr) == 0)){
-      queue->push(&array[i]);
-    }
-    else {
-      // If this quadrant was not added from a face
-      // attribute, check to see if it should be added
-      // as an edge/curve attribute
-      TMREdge *edge;
-      if (array[i].x == 0){
-        int edge_num = face_edge_conn[4*array[i].face];
-        topo->getEdge(edge_num,&edge);
-        const char *edge_attr = edge->getAttribute();
-        if (edge_attr && strcmp(edge_attr, attr) == 0){
-          TMRQuadrant p = array[i];
-          p.info = 0;
-          queue->push(&p);
-        }
-      }
-      if (array[i].x+h == hmax){
-        int edge_num = face_edge_conn[4*array[i].face+1];
-        topo->getEdge(edge_num, &edge);
-        const char *edge_attr = edge->getAttribute();
-        if (edge_attr && strcmp(edge_attr, attr) == 0){
-          TMRQuadrant p = array[i];
-          p.info = 1;
-          queue->push(&p);
-        }
-      }
-      if (array[i].y == 0){
-        int edge_num = face_edge_conn[4*array[i].face+2];
-        topo->getEdge(edge_num, &edge);
-        const char *edge_attr = edge->getAttribute();
-        if (edge_attr && strcmp(edge_attr, attr) == 0){
-          TMRQuadrant p = array[i];
-          p.info = 2;
-          queue->push(&p);
-        }
-      }
-      if (array[i].y+h == hmax){
-        int edge_num = face_edge_conn[4*array[i].face+3];
-        topo->getEdge(edge_num, &edge);
-        const char *edge_attr = edge->getAttribute();
-        if (edge_attr && strcmp(edge_attr, attr) == 0){
-          TMRQuadrant p = array[i];
-          p.info = 3;
-          queue->push(&p);
-        }
-      }
-    }
-  }
-
-  TMRQuadrantArray *list = queue->toArray();
-  delete queue;
-  return list;
-}
-
-/*
-  Create an array of the nodes that are lie on a surface, edge or
-  corner with a given attribute
-
-  This code loops over all nodes and check whether they lie on a
-  geometric entity that has the given attribute. The nodes are not
-  unique if they are lie on a shared boundary between processors.
+  The nodes are retrieved from the attribute index. The returned list
+  is sorted and unique, and must be freed by the caller.
 
   input:
   attr:   the string of the attribute to search
@@ -3972,146 +5067,282 @@ getNodesWithAttribute()\n");
     return 0;
   }
 
-  // The maximum quadrant edge length
-  const int32_t hmax = 1 << TMR_MAX_LEVEL;
+  // Create the index if it does not yet exist or if it was created
+  // before the nodes
+  if (!attr_node_ptr){
+    freeAttributeIndex();
+    createAttributeIndex();
+  }
 
-  // Get the local nodal quadrants
-  int size;
-  TMRQuadrant *quads;
-  quadrants->getArray(&quads, &size);
+  int len = 0;
+  int index = findAttribute(attr);
+  if (index >= 0){
+    len = attr_node_ptr[index+1] - attr_node_ptr[index];
+  }
+  int *node_list = new int[ len ];
+  if (len > 0){
+    memcpy(node_list, &attr_nodes[attr_node_ptr[index]], len*sizeof(int));
+  }
+
+  *_nodes = node_list;
+  return len;
+}
+
+/*
+  Add a node to the list of nodes for the given attribute index
+*/
+static inline void add_attr_node( int index, int node, int *len,
+                                  int *max_len, int **lists ){
+  if (len[index] >= max_len[index]){
+    max_len[index] = 2*max_len[index] + 64;
+    int *tmp = new int[ max_len[index] ];
+    if (lists[index]){
+      memcpy(tmp, lists[index], len[index]*sizeof(int));
+      delete [] lists[index];
+    }
+    lists[index] = tmp;
+  }
+  lists[index][len[index]] = node;
+  len[index]++;
+}
 
-  int count = 0; // Current node count
-  int max_len = 1024; // max length of the node list
-  int *node_list = new int[ max_len ]; // Nodes touching this attribute
+/*
+  Find the index of the attribute in the attribute index. The index 0
+  is reserved for entities without an attribute.
 
-  // Max number of nodes added by one quadrant
-  const int max_node_incr = 4 + 4*mesh_order + mesh_order*mesh_order;
+  input:
+  attr:   the attribute (may be NULL)
 
-  // Loop over the quadrants and find out whether it touches a face or
-  // edge with the prescribed attribute
-  for ( int i = 0; i < size; i++ ){
-    if (count + mesh_order*mesh_order > max_len){
-      // Extend the length of the array
-      max_len = 2*max_len + max_node_incr;
-      int *tmp = new int[ max_len ];
-      memcpy(tmp, node_list, count*sizeof(int));
-      delete [] node_list;
-      node_list = tmp;
+  returns:
+  the index or -1 if no entity has the attribute
+*/
+int TMRQuadForest::findAttribute( const char *attr ){
+  if (!attr){
+    return 0;
+  }
+  for ( int i = 1; i < num_attrs; i++ ){
+    if (strcmp(attr_names[i], attr) == 0){
+      return i;
     }
+  }
+  return -1;
+}
 
-    // Compute the quadrant edge length
+/*
+  Add the attribute to the index (if it is not already present) and
+  return its index
+*/
+int TMRQuadForest::addAttribute( const char *attr ){
+  int index = findAttribute(attr);
+  if (index < 0){
+    index = num_attrs;
+    attr_names[index] = new char[ strlen(attr)+1 ];
+    strcpy(attr_names[index], attr);
+    num_attrs++;
+  }
+  return index;
+}
+
+/*
+  Create the index of the quadrants and nodes for each attribute
+
+  The attribute of each face, edge and vertex in the topology is
+  found once. A single pass over the local quadrants then adds the
+  quadrant (or the quadrant on the boundary edge) and, if the nodes
+  have been created, the nodes on the face, edges and corners to the
+  lists for the matching attributes. Nodes and edge quadrants are
+  only added for entities with an attribute. The index is freed
+  whenever the quadrants, the nodes or the topology change.
+*/
+void TMRQuadForest::createAttributeIndex(){
+  // Assign an index to the attribute of each topological entity
+  int max_attrs = 1 + num_faces + num_edges + num_nodes;
+  attr_names = new char*[ max_attrs ];
+  attr_names[0] = NULL;
+  num_attrs = 1;
+
+  int *face_attr = new int[ num_faces ];
+  for ( int i = 0; i < num_faces; i++ ){
+    TMRFace *face;
+    topo->getFace(i, &face);
+    face_attr[i] = addAttribute(face->getAttribute());
+  }
+  int *edge_attr = new int[ num_edges ];
+  for ( int i = 0; i < num_edges; i++ ){
+    TMREdge *edge;
+    topo->getEdge(i, &edge);
+    edge_attr[i] = addAttribute(edge->getAttribute());
+  }
+  int *vert_attr = new int[ num_nodes ];
+  for ( int i = 0; i < num_nodes; i++ ){
+    TMRVertex *vert;
+    topo->getVertex(i, &vert);
+    vert_attr[i] = addAttribute(vert->getAttribute());
+  }
+
+  // Allocate the queues for the quadrants and the node lists
+  TMRQuadrantQueue **queues = new TMRQuadrantQueue*[ num_attrs ];
+  for ( int k = 0; k < num_attrs; k++ ){
+    queues[k] = new TMRQuadrantQueue();
+  }
+  int *node_len = new int[ num_attrs ];
+  int *node_max = new int[ num_attrs ];
+  int **node_lists = new int*[ num_attrs ];
+  memset(node_len, 0, num_attrs*sizeof(int));
+  memset(node_max, 0, num_attrs*sizeof(int));
+  memset(node_lists, 0, num_attrs*sizeof(int*));
+
+  // Get the quadrants
+  int size;
+  TMRQuadrant *quads;
+  quadrants->getArray(&quads, &size);
+
+  const int32_t hmax = 1 << TMR_MAX_LEVEL;
+  for ( int i = 0; i < size; i++ ){
     const int32_t h = 1 << (TMR_MAX_LEVEL - quads[i].level);
+    const int face = quads[i].face;
 
-    // Check if this node is on a corner, edge or face, and whether it
-    // shares the appropriate attribute
-    int fx0 = (quads[i].x == 0);
-    int fy0 = (quads[i].y == 0);
-    int fx = (fx0 || quads[i].x + h == hmax);
-    int fy = (fy0 || quads[i].y + h == hmax);
+    // Add the quadrant to the list for its face
+    const int fa = face_attr[face];
+    queues[fa]->push(&quads[i]);
 
-    if (fx && fy){
-      // Keep track of which corners this element touches
-      int ncorners = 0;
-      int corner_index[4];
-      if (quads[i].x == 0 && quads[i].y == 0){
-        corner_index[ncorners] = 0; ncorners++;
-      }
-      if (quads[i].x + h == hmax && quads[i].y == 0){
-        corner_index[ncorners] = 1; ncorners++;
-      }
-      if (quads[i].x == 0 && quads[i].y + h == hmax){
-        corner_index[ncorners] = 2; ncorners++;
-      }
-      if (quads[i].x + h == hmax && quads[i].y + h == hmax){
-        corner_index[ncorners] = 3; ncorners++;
-      }
+    // Check which edges of the face this quadrant touches
+    const int touches[4] = {(quads[i].x == 0), (quads[i].x + h == hmax),
+                            (quads[i].y == 0), (quads[i].y + h == hmax)};
 
-      for ( int ii = 0; ii < ncorners; ii++ ){
-        TMRVertex *vert;
-        int vert_num = face_conn[4*quads[i].face + corner_index[ii]];
-        topo->getVertex(vert_num, &vert);
-        const char *vert_attr = vert->getAttribute();
-        if (vert_attr && strcmp(vert_attr, attr) == 0){
-          int offset = ((mesh_order-1)*(corner_index[ii] % 2) +
-                        (mesh_order-1)*mesh_order*(corner_index[ii]/2));
-          node_list[count] =
-            conn[mesh_order*mesh_order*quads[i].tag + offset];
-          count++;
+    // Add the quadrant to the lists for the edge attributes that do
+    // not match the face attribute
+    for ( int edge_index = 0; edge_index < 4; edge_index++ ){
+      if (touches[edge_index]){
+        const int ea = edge_attr[face_edge_conn[4*face + edge_index]];
+        if (ea != 0 && ea != fa){
+          TMRQuadrant p = quads[i];
+          p.info = edge_index;
+          queues[ea]->push(&p);
         }
       }
     }
-    if (fx || fy){
-      // Keep track of which edges this element touches
-      int nedges = 0;
-      int edge_index[4];
-      if (quads[i].x == 0){
-        edge_index[nedges] = 0; nedges++;
-      }
-      if (quads[i].x + h == hmax){
-        edge_index[nedges] = 1; nedges++;
-      }
-      if (quads[i].y == 0){
-        edge_index[nedges] = 2; nedges++;
-      }
-      if (quads[i].y + h == hmax){
-        edge_index[nedges] = 3; nedges++;
+
+    if (!conn){
+      continue;
+    }
+
+    // Set a pointer into the connectivity array
+    const int *c = &conn[mesh_order*mesh_order*quads[i].tag];
+
+    // Add the nodes on the corners
+    for ( int corner = 0; corner < 4; corner++ ){
+      if (touches[corner % 2] && touches[2 + corner/2]){
+        const int va = vert_attr[face_conn[4*face + corner]];
+        if (va != 0){
+          int offset = ((mesh_order-1)*(corner % 2) +
+                        (mesh_order-1)*mesh_order*(corner/2));
+          add_attr_node(va, c[offset], node_len, node_max, node_lists);
+        }
       }
+    }
 
-      for ( int ii = 0; ii < nedges; ii++ ){
-        TMREdge *edge;
-        int edge_num = face_edge_conn[4*quads[i].face + edge_index[ii]];
-        topo->getEdge(edge_num, &edge);
-        const char *edge_attr = edge->getAttribute();
-        if (edge_attr && strcmp(edge_attr, attr) == 0){
+    // Add the nodes on the edges
+    for ( int edge_index = 0; edge_index < 4; edge_index++ ){
+      if (touches[edge_index]){
+        const int ea = edge_attr[face_edge_conn[4*face + edge_index]];
+        if (ea != 0){
           for ( int k = 0; k < mesh_order; k++ ){
             int offset = 0;
-            if (edge_index[ii] < 2){
-              offset = k*mesh_order + (mesh_order-1)*edge_index[ii];
+            if (edge_index < 2){
+              offset = k*mesh_order + (mesh_order-1)*edge_index;
             }
             else {
-              offset = k + (mesh_order-1)*mesh_order*(edge_index[ii] % 2);
+              offset = k + (mesh_order-1)*mesh_order*(edge_index % 2);
             }
-            node_list[count] =
-              conn[mesh_order*mesh_order*quads[i].tag + offset];
-            count++;
+            add_attr_node(ea, c[offset], node_len, node_max, node_lists);
           }
         }
       }
     }
 
-    // This node lies on the face
-    TMRFace *face;
-    topo->getFace(quads[i].face, &face);
-    const char *face_attr = face->getAttribute();
-    if (face_attr && strcmp(face_attr, attr) == 0){
-      for ( int jj = 0; jj < mesh_order; jj++ ){
-        for ( int ii = 0; ii < mesh_order; ii++ ){
-          int offset = ii + jj*mesh_order;
-          node_list[count] =
-            conn[mesh_order*mesh_order*quads[i].tag + offset];
-          count++;
-        }
+    // Add the nodes on the face
+    if (fa != 0){
+      for ( int k = 0; k < mesh_order*mesh_order; k++ ){
+        add_attr_node(fa, c[k], node_len, node_max, node_lists);
       }
     }
   }
 
-  // Now, sort the node numbers and remove duplicates
-  qsort(node_list, count, sizeof(int), compare_integers);
+  // Convert the queues to arrays
+  attr_quads = new TMRQuadrantArray*[ num_attrs ];
+  for ( int k = 0; k < num_attrs; k++ ){
+    attr_quads[k] = queues[k]->toArray();
+    delete queues[k];
+  }
+  delete [] queues;
 
-  // Remove duplicates from the array
-  int len = 0;
-  for ( int ptr = 0; ptr < count; ptr++, len++ ){
-    while ((ptr < count-1) && (node_list[ptr] == node_list[ptr+1])){
-      ptr++;
+  if (conn){
+    // Sort and uniquify the node lists and store them in a single array
+    attr_node_ptr = new int[ num_attrs+1 ];
+    attr_node_ptr[0] = 0;
+    for ( int k = 0; k < num_attrs; k++ ){
+      int len = 0;
+      if (node_len[k] > 0){
+        qsort(node_lists[k], node_len[k], sizeof(int), compare_integers);
+        for ( int ptr = 0; ptr < node_len[k]; ptr++, len++ ){
+          while ((ptr < node_len[k]-1) &&
+                 (node_lists[k][ptr] == node_lists[k][ptr+1])){
+            ptr++;
+          }
+          if (ptr != len){
+            node_lists[k][len] = node_lists[k][ptr];
+          }
+        }
+      }
+      node_len[k] = len;
+      attr_node_ptr[k+1] = attr_node_ptr[k] + len;
     }
 
-    if (ptr != len){
-      node_list[len] = node_list[ptr];
+    attr_nodes = new int[ attr_node_ptr[num_attrs] ];
+    for ( int k = 0; k < num_attrs; k++ ){
+      if (node_len[k] > 0){
+        memcpy(&attr_nodes[attr_node_ptr[k]], node_lists[k],
+               node_len[k]*sizeof(int));
+      }
     }
   }
 
-  *_nodes = node_list;
-  return len;
+  for ( int k = 0; k < num_attrs; k++ ){
+    if (node_lists[k]){ delete [] node_lists[k]; }
+  }
+  delete [] node_lists;
+  delete [] node_len;
+  delete [] node_max;
+  delete [] face_attr;
+  delete [] edge_attr;
+  delete [] vert_attr;
+}
+
+/*
+  Free the attribute index
+*/
+void TMRQuadForest::freeAttributeIndex(){
+  if (attr_names){
+    for ( int k = 0; k < num_attrs; k++ ){
+      if (attr_names[k]){ delete [] attr_names[k]; }
+    }
+    delete [] attr_names;
+  }
+  if (attr_quads){
+    for ( int k = 0; k < num_attrs; k++ ){
+      delete attr_quads[k];
+    }
+    delete [] attr_quads;
+  }
+  if (attr_node_ptr){ delete [] attr_node_ptr; }
+  if (attr_nodes){ delete [] attr_nodes; }
+
+  num_attrs = 0;
+  attr_names = NULL;
+  attr_quads = NULL;
+  attr_node_ptr = NULL;
+  attr_nodes = NULL;
 }
 
 /*
@@ -4124,45 +5355,87 @@ TMRQuadrant* TMRQuadForest::findEnclosing( const int order,
                                            const double *knots,
                                            TMRQuadrant *node,
                                            int *mpi_owner ){
-  // Assume that we'll find octant on this processor for now..
-  if (mpi_owner){
-    *mpi_owner = mpi_rank;
-  }
+  // Find the starting point for the search
+  int start = searchEnclosing(node);
+
+  return scanEnclosing(order, knots, node, start, mpi_owner);
+}
+
+/*
+  Find the enclosing quadrants for an array of nodes
+
+  This is a bulk version of findEnclosing() that is designed for
+  nodes ordered by their element quadrants. Since both the nodes and
+  the quadrants of this forest are sorted along the same
+  space-filling curve, a single merge-walk through the two arrays
+  finds the starting position for each node in O(1) amortized time,
+  instead of a binary search for each node. If a node is out of
+  order, the starting position is found by a binary search instead.
+
+  Nodes that are not enclosed by a local quadrant have a NULL
+  enclosing quadrant. In this case, the owner of the node is returned
+  in mpi_owners so that all of these nodes can be exchanged with a
+  single call to distributeQuadrants().
 
+  input:
+  order:       the order of the node's element
+  knots:       the knot locations within the node's element
+  num_nodes:   the number of nodes
+  nodes:       the node quadrants (info = local node index)
+
+  output:
+  enclosing:   the enclosing quadrant for each node (or NULL)
+  mpi_owners:  the MPI owner of each node (may be NULL)
+*/
+void TMRQuadForest::findEnclosing( const int order,
+                                   const double *knots,
+                                   const int num_nodes,
+                                   TMRQuadrant *nodes,
+                                   TMRQuadrant **enclosing,
+                                   int *mpi_owners ){
   // Retrieve the array of elements
   int size = 0;
   TMRQuadrant *array = NULL;
   quadrants->getArray(&array, &size);
 
-  // Set the lower and upper bounds for the quadrant
-  const int32_t face = node->face;
-  const int32_t h = 1 << (TMR_MAX_LEVEL - node->level);
+  // The last quadrant with a position that is less than or equal to
+  // the position of the current node
+  int cursor = 0;
 
-  // Compute the ii/jj locations
-  const int ii = node->info % order;
-  const int jj = node->info/order;
+  for ( int i = 0; i < num_nodes; i++ ){
+    if (i > 0 && nodes[i].comparePosition(&nodes[i-1]) < 0){
+      // The nodes are out of order: restart the walk
+      cursor = searchEnclosing(&nodes[i]);
+    }
+    else {
+      while (cursor+1 < size && 
+             array[cursor+1].comparePosition(&nodes[i]) <= 0){
+        cursor++;
+      }
+    }
 
-  // Compute the integer locations for the x/y nodes if they lie
-  // exactly along a coordinate line. These will take precidence over
-  // the real value parametric locations since comparisons will be
-  // exact.
-  int32_t xi = -1, yi = -1;
-  if (ii == 0 || ii == order-1){
-    xi = node->x + (ii/(order-1))*h;
-  }
-  else if (order % 2 == 1 && ii == order/2){
-    xi = node->x + h/2;
-  }
-  if (jj == 0 || jj == order-1){
-    yi = node->y + (jj/(order-1))*h;
-  }
-  else if (order % 2 == 1 && jj == order/2){
-    yi = node->y + h/2;
+    int *owner = NULL;
+    if (mpi_owners){
+      owner = &mpi_owners[i];
+    }
+    enclosing[i] = scanEnclosing(order, knots, &nodes[i], cursor, owner);
   }
+}
 
-  // Compute the parametric node location on this block
-  const double xd = node->x + 0.5*h*(1.0 + knots[ii]);
-  const double yd = node->y + 0.5*h*(1.0 + knots[jj]);
+/*
+  Find the starting position in the quadrant array for the search for
+  the quadrant that encloses the given node
+
+  input:
+  node:     the node quadrant
+
+  returns:  the index of the quadrant where the search begins
+*/
+int TMRQuadForest::searchEnclosing( TMRQuadrant *node ){
+  // Retrieve the array of elements
+  int size = 0;
+  TMRQuadrant *array = NULL;
+  quadrants->getArray(&array, &size);
 
   // Set the low and high indices to the first and last
   // element of the element array
@@ -4198,6 +5471,72 @@ TMRQuadrant* TMRQuadForest::findEnclosing( const int order,
     mid = low + (int)((high - low)/2);
   }
 
+  return mid;
+}
+
+/*
+  Scan the quadrant array, starting from the given position, for the
+  quadrant that encloses the node
+
+  input:
+  order:      the order of the node's element
+  knots:      the knot locations within the node's element
+  node:       the node quadrant (info = local node index)
+  start:      the starting index in the quadrant array
+
+  output:
+  mpi_owner:  the MPI owner of the node if it is not found locally
+
+  returns:    the enclosing quadrant or NULL if it does not exist locally
+*/
+TMRQuadrant* TMRQuadForest::scanEnclosing( const int order,
+                                           const double *knots,
+                                           TMRQuadrant *node,
+                                           int start,
+                                           int *mpi_owner ){
+  // Assume that we'll find octant on this processor for now..
+  if (mpi_owner){
+    *mpi_owner = mpi_rank;
+  }
+
+  // Retrieve the array of elements
+  int size = 0;
+  TMRQuadrant *array = NULL;
+  quadrants->getArray(&array, &size);
+
+  // Set the lower and upper bounds for the quadrant
+  const int32_t face = node->face;
+  const int32_t h = 1 << (TMR_MAX_LEVEL - node->level);
+
+  // Compute the ii/jj locations
+  const int ii = node->info % order;
+  const int jj = node->info/order;
+
+  // Compute the integer locations for the x/y nodes if they lie
+  // exactly along a coordinate line. These will take precidence over
+  // the real value parametric locations since comparisons will be
+  // exact.
+  int32_t xi = -1, yi = -1;
+  if (ii == 0 || ii == order-1){
+    xi = node->x + (ii/(order-1))*h;
+  }
+  else if (order % 2 == 1 && ii == order/2){
+    xi = node->x + h/2;
+  }
+  if (jj == 0 || jj == order-1){
+    yi = node->y + (jj/(order-1))*h;
+  }
+  else if (order % 2 == 1 && jj == order/2){
+    yi = node->y + h/2;
+  }
+
+  // Compute the parametric node location on this block
+  const double xd = node->x + 0.5*h*(1.0 + knots[ii]);
+  const double yd = node->y + 0.5*h*(1.0 + knots[jj]);
+
+  // Start the search from the given position
+  int mid = start;
+
   // Compute the bounding quadrant. Quadrants greater than this quad
   // cannot own the node so a further search is futile.
   TMRQuadrant quad;
@@ -4240,31 +5579,34 @@ TMRQuadrant* TMRQuadForest::findEnclosing( const int order,
 }
 
 /*
-  Compute the interpolant from the given fine node to the
-  coarse mesh quadrants.
+  Compute the interpolation stencil from the given fine node to the
+  nodes of the enclosing coarse mesh quadrant.
 
   Note that the node is defined as a TMRQuadrant class with the
   quadrant information for the node where the info member is
-  the local index of the node on the element.
+  the local index of the node on the element. The stencil only
+  contains the non-zero weights, and the indices are the local node
+  numbers on the coarse element.
 
   input:
-  node:     the node (element quad with info = element node index)
+  node:     the node (element quadrant with info = element node index)
   coarse:   the coarse TMRQuadForest object
   quad:     an enclosing quadrant on the coarse mesh
-  tmp:      temporary array (must be of size 3*coarse->mesh_order)
+  Ntable:   the coarse shape functions at the points from
+            lagrange_child_knots() for this mesh (may be NULL)
+  tmp:      temporary array (must be of size 2*coarse->mesh_order)
 
   output:
-  weights:  the index/weight pairs for the mesh
-*/
-int TMRQuadForest::computeElemInterp( TMRQuadrant *node,
-                                      TMRQuadForest *coarse,
-                                      TMRQuadrant *quad,
-                                      TMRIndexWeight *weights,
-                                      double *tmp ){
-  // Loop over the array of nodes
-  const int coarse_nodes_per_element =
-    coarse->mesh_order*coarse->mesh_order;
+  stencil:  the local index/weight pairs for the coarse element
 
+  returns:  the number of entries in the stencil
+*/
+int TMRQuadForest::computeElemStencil( TMRQuadrant *node,
+                                       TMRQuadForest *coarse,
+                                       TMRQuadrant *quad,
+                                       const double *Ntable,
+                                       TMRIndexWeight *stencil,
+                                       double *tmp ){
   // Compute the i, j location of the fine mesh node on the element
   const int i = node->info % mesh_order;
   const int j = node->info/mesh_order;
@@ -4293,6 +5635,15 @@ int TMRQuadForest::computeElemInterp( TMRQuadrant *node,
     iend = coarse->mesh_order;
     Nu[istart] = 1.0;
   }
+  else if (Ntable && (hc == h || hc == 2*h)){
+    // Use the cached table for the same-size or parent quadrant
+    int row = i;
+    if (hc == 2*h){
+      row += mesh_order*(1 + (node->x - quad->x)/h);
+    }
+    memcpy(Nu, &Ntable[coarse->mesh_order*row],
+           coarse->mesh_order*sizeof(double));
+  }
   else {
     double u = -1.0 + 2.0*(node->x + 0.5*h*(1.0 + interp_knots[i]) -
                            quad->x)/hc;
@@ -4311,6 +5662,15 @@ int TMRQuadForest::computeElemInterp( TMRQuadrant *node,
     jend = coarse->mesh_order;
     Nv[jstart] = 1.0;
   }
+  else if (Ntable && (hc == h || hc == 2*h)){
+    // Use the cached table for the same-size or parent quadrant
+    int row = j;
+    if (hc == 2*h){
+      row += mesh_order*(1 + (node->y - quad->y)/h);
+    }
+    memcpy(Nv, &Ntable[coarse->mesh_order*row],
+           coarse->mesh_order*sizeof(double));
+  }
   else {
     double v = -1.0 + 2.0*(node->y + 0.5*h*(1.0 + interp_knots[j]) -
                            quad->y)/hc;
@@ -4318,45 +5678,125 @@ int TMRQuadForest::computeElemInterp( TMRQuadrant *node,
                              coarse->interp_knots, Nv);
   }
 
-  // Get the coarse grid information
-  const int *cdep_ptr;
-  const int *cdep_conn;
-  const double *cdep_weights;
-  coarse->getDepNodeConn(&cdep_ptr, &cdep_conn, &cdep_weights);
+  // Store the non-zero weights using the local node numbers on
+  // the coarse element
+  int size = 0;
+  for ( int jj = jstart; jj < jend; jj++ ){
+    for ( int ii = istart; ii < iend; ii++ ){
+      double weight = Nu[ii]*Nv[jj];
+      if (weight != 0.0){
+        stencil[size].index = ii + jj*coarse->mesh_order;
+        stencil[size].weight = weight;
+        size++;
+      }
+    }
+  }
+
+  return size;
+}
+
+/*
+  Compute the interpolant from the given fine node to the
+  coarse mesh quadrant.
+
+  The interpolation stencil in terms of the local nodes of the coarse
+  element is retrieved from the stencil table when the fine element
+  is the same size as, or a child of, the coarse element. Otherwise
+  the stencil is computed directly. The stencil is then gathered
+  through the coarse connectivity and the dependent node weights.
+
+  input:
+  node:      the node (element quadrant with info = element node index)
+  coarse:    the coarse TMRQuadForest object
+  quad:      an enclosing quadrant on the coarse mesh
+  Ntable:    the coarse shape functions at the points from
+             lagrange_child_knots() for this mesh (may be NULL)
+  stencils:  the table of stencils with (1 + 4)*nodes_per_element
+             entries for this mesh and the coarse mesh
+  tmp:       temporary array (must be of size 2*coarse->mesh_order)
+
+  output:
+  weights:   the index/weight pairs for the mesh
+*/
+int TMRQuadForest::computeElemInterp( TMRQuadrant *node,
+                                      TMRQuadForest *coarse,
+                                      TMRQuadrant *quad,
+                                      const double *Ntable,
+                                      TMRInterpStencilTable *stencils,
+                                      TMRIndexWeight *weights,
+                                      double *tmp ){
+  const int nodes_per_element = mesh_order*mesh_order;
+  const int coarse_nodes_per_element = 
+    coarse->mesh_order*coarse->mesh_order;
+
+  // Get the element size for coarse element
+  const int32_t h = 1 << (TMR_MAX_LEVEL - node->level);
+  const int32_t hc = 1 << (TMR_MAX_LEVEL - quad->level);
+
+  // The stencil depends only on the local node index, the level
+  // difference and the child identifier of the fine element within
+  // the coarse element. Compute the key for the stencil table.
+  int key = -1;
+  if (hc == h && node->x == quad->x && node->y == quad->y){
+    key = node->info;
+  }
+  else if (hc == 2*h &&
+           node->x >= quad->x && node->x < quad->x + hc &&
+           node->y >= quad->y && node->y < quad->y + hc){
+    int child = ((node->x - quad->x)/h) + 2*((node->y - quad->y)/h);
+    key = (1 + child)*nodes_per_element + node->info;
+  }
+
+  // Retrieve the stencil or compute it if it does not exist
+  int size = -1;
+  const TMRIndexWeight *stencil = NULL;
+  if (key >= 0){
+    size = stencils->getStencil(key, &stencil);
+  }
+  if (size < 0){
+    TMRIndexWeight *work = stencils->getWorkArray();
+    size = computeElemStencil(node, coarse, quad, Ntable, work, tmp);
+    if (key >= 0){
+      stencils->setStencil(key, size, work);
+    }
+    stencil = work;
+  }
+
+  // Temporary storage for the expanded dependent node weights
+  double cdep_weights[MAX_ORDER];
 
   // Get the coarse connectivity array
   const int num = quad->tag;
   const int *c = &(coarse->conn[coarse_nodes_per_element*num]);
 
-  // Loop over the nodes that are within this octant
-  int nweights = 0;
-  for ( int jj = jstart; jj < jend; jj++ ){
-    for ( int ii = istart; ii < iend; ii++ ){
-      // Compute the offset into the coarse mesh
-      int offset = ii + jj*coarse->mesh_order;
-
-      // Compute the interpolation weight
-      double weight = Nu[ii]*Nv[jj];
-
-      // Get the tag number
-      if (c[offset] >= 0){
-        weights[nweights].index = c[offset];
-        weights[nweights].weight = weight;
+  // Gather the stencil through the coarse connectivity
+  int nweights = 0, has_dep_nodes = 0;
+  for ( int n = 0; n < size; n++ ){
+    const int offset = stencil[n].index;
+    const double weight = stencil[n].weight;
+    if (c[offset] >= 0){
+      weights[nweights].index = c[offset];
+      weights[nweights].weight = weight;
+      nweights++;
+    }
+    else {
+      int node = -c[offset]-1;
+      const int *cdep_conn;
+      int len = coarse->getDepNodeRow(node, &cdep_conn, cdep_weights);
+      for ( int jp = 0; jp < len; jp++ ){
+        weights[nweights].index = cdep_conn[jp];
+        weights[nweights].weight = weight*cdep_weights[jp];
         nweights++;
       }
-      else {
-        int node = -c[offset]-1;
-        for ( int jp = cdep_ptr[node]; jp < cdep_ptr[node+1]; jp++ ){
-          weights[nweights].index = cdep_conn[jp];
-          weights[nweights].weight = weight*cdep_weights[jp];
-          nweights++;
-        }
-      }
+      has_dep_nodes = 1;
     }
   }
 
-  // Sort and add up the weight values
-  nweights = TMRIndexWeight::uniqueSort(weights, nweights);
+  // The independent nodes of the coarse element are unique, so only
+  // sort and add up the weights when dependent nodes contribute
+  if (has_dep_nodes){
+    nweights = TMRIndexWeight::uniqueSort(weights, nweights);
+  }
 
   return nweights;
 }
@@ -4378,14 +5818,18 @@ int TMRQuadForest::computeElemInterp( TMRQuadrant *node,
 */
 void TMRQuadForest::createInterpolation( TMRQuadForest *coarse,
                                          TACSBVecInterp *interp ){
+  TMRPerfBegin(TMR_PERF_CREATE_INTERPOLATION);
   // Ensure that the nodes are allocated on both octree forests
   createNodes();
   coarse->createNodes();
 
-  // Get the dependent node information
-  const int *cdep_ptr, *cdep_conn;
-  const double *cdep_weights;
-  coarse->getDepNodeConn(&cdep_ptr, &cdep_conn, &cdep_weights);
+
+  // Get the coarse shape functions at the knots of the fine mesh
+  // for elements of the same size and for the child elements
+  const double *Ntable;
+  double pts[3*MAX_ORDER];
+  lagrange_child_knots(mesh_order, interp_knots, pts);
+  coarse->getInterpTable(3*mesh_order, pts, &Ntable);
 
   // First, loop over the local list
   int local_size = node_range[mpi_rank+1] - node_range[mpi_rank];
@@ -4408,14 +5852,25 @@ void TMRQuadForest::createInterpolation( TMRQuadForest *coarse,
   // Loop over the array of nodes
   const int nodes_per_element = mesh_order*mesh_order;
 
+  // Allocate the table of interpolation stencils for the elements
+  // with the same size as the coarse element or for its children
+  const int num_children = 4;
+  TMRInterpStencilTable *stencils = 
+    new TMRInterpStencilTable((1 + num_children)*nodes_per_element,
+                              max_nodes);
+
   // Get the quadrants
   int num_elements;
   TMRQuadrant *quads;
   quadrants->getArray(&quads, &num_elements);
 
-  // Allocate a queue to store the nodes that are on other procs
-  TMRQuadrantQueue *ext_queue = new TMRQuadrantQueue();
-
+  // Collect the locally owned nodes from the first element that
+  // references them. The nodes are ordered by their element quadrants
+  // so the enclosing coarse quadrants can be found with a single
+  // merge-walk through the coarse quadrants.
+  int num_nodes = 0;
+  TMRQuadrant *nodes = new TMRQuadrant[ local_size ];
+  int *node_nums = new int[ local_size ];
   for ( int i = 0; i < num_elements; i++ ){
     const int *c = &conn[nodes_per_element*i];
     for ( int j = 0; j < nodes_per_element; j++ ){
@@ -4426,42 +5881,53 @@ void TMRQuadForest::createInterpolation( TMRQuadForest *coarse,
         if (!flags[index]){
           // We're going to handle this node now, mark it as done
           flags[index] = 1;
+          nodes[num_nodes] = quads[i];
+          nodes[num_nodes].info = j;
+          node_nums[num_nodes] = c[j];
+          num_nodes++;
+        }
+      }
+    }
+  }
 
-          // Find the enclosing coarse quad on this
-          // processor if it exits
-          TMRQuadrant node = quads[i];
-          node.info = j;
+  // Free the data
+  delete [] flags;
 
-          // Find the MPI owner or the
-          int mpi_owner = mpi_rank;
-          TMRQuadrant *t = coarse->findEnclosing(mesh_order, interp_knots,
-                                                 &node, &mpi_owner);
+  // Find the enclosing coarse quadrants on this processor if they exist
+  TMRQuadrant **enclosing = new TMRQuadrant*[ num_nodes ];
+  int *mpi_owners = new int[ num_nodes ];
+  coarse->findEnclosing(mesh_order, interp_knots, num_nodes, nodes,
+                        enclosing, mpi_owners);
 
-          // The node is owned a coarse element on this processor
-          if (t){
-            // Compute the element interpolation
-            int nweights = computeElemInterp(&node, coarse, t, weights, tmp);
+  // Allocate a queue to store the nodes that are on other procs
+  TMRQuadrantQueue *ext_queue = new TMRQuadrantQueue();
 
-            for ( int k = 0; k < nweights; k++ ){
-              vars[k] = weights[k].index;
-              wvals[k] = weights[k].weight;
-            }
-            interp->addInterp(c[j], wvals, vars, nweights);
-          }
-          else {
-            // We've got to transfer the node to the processor that
-            // owns an enclosing element. Do to that, add the quad to
-            // the list of externals and store its mpi owner
-            node.tag = mpi_owner;
-            ext_queue->push(&node);
-          }
-        }
+  for ( int i = 0; i < num_nodes; i++ ){
+    // The node is owned a coarse element on this processor
+    if (enclosing[i]){
+      // Compute the element interpolation
+      int nweights = computeElemInterp(&nodes[i], coarse, enclosing[i],
+                                       Ntable, stencils, weights, tmp);
+
+      for ( int k = 0; k < nweights; k++ ){
+        vars[k] = weights[k].index;
+        wvals[k] = weights[k].weight;
       }
+      interp->addInterp(node_nums[i], wvals, vars, nweights);
+    }
+    else {
+      // We've got to transfer the node to the processor that
+      // owns an enclosing element. Do to that, add the quad to
+      // the list of externals and store its mpi owner
+      nodes[i].tag = mpi_owners[i];
+      ext_queue->push(&nodes[i]);
     }
   }
 
-  // Free the data
-  delete [] flags;
+  delete [] nodes;
+  delete [] node_nums;
+  delete [] enclosing;
+  delete [] mpi_owners;
 
   // Sort the sending quadrants by MPI rank
   TMRQuadrantArray *ext_array = ext_queue->toArray();
@@ -4529,15 +5995,19 @@ void TMRQuadForest::createInterpolation( TMRQuadForest *coarse,
   TMRQuadrant *recv_nodes;
   recv_array->getArray(&recv_nodes, &recv_size);
 
+  // Find the enclosing quadrants for the recv'd nodes
+  enclosing = new TMRQuadrant*[ recv_size ];
+  coarse->findEnclosing(mesh_order, interp_knots, recv_size, recv_nodes,
+                        enclosing);
+
   // Recv the nodes and loop over the connectivity
   for ( int i = 0; i < recv_size; i++ ){
-    TMRQuadrant *t = coarse->findEnclosing(mesh_order, interp_knots,
-                                           &recv_nodes[i]);
+    TMRQuadrant *t = enclosing[i];
 
     if (t){
       // Compute the element interpolation
       int nweights = computeElemInterp(&recv_nodes[i], coarse, t,
-                                       weights, tmp);
+                                       Ntable, stencils, weights, tmp);
 
       for ( int k = 0; k < nweights; k++ ){
         vars[k] = weights[k].index;
@@ -4554,10 +6024,13 @@ void TMRQuadForest::createInterpolation( TMRQuadForest *coarse,
 
   // Free the recv array
   delete recv_array;
+  delete [] enclosing;
 
   // Free the temporary arrays
+  delete stencils;
   delete [] tmp;
   delete [] vars;
   delete [] wvals;
   delete [] weights;
+  TMRPerfEnd(TMR_PERF_CREATE_INTERPOLATION);
 }
@@ -25,6 +25,13 @@
 #include "TMRQuadrant.h"
 #include "BVecInterp.h"
 
+// Forward declaration of the interpolation table cache
+class TMRInterpTableCache;
+class TMRInterpStencilTable;
+
+// Forward declaration of the element feature size
+class TMRElementFeatureSize;
+
 /*
   A parallel forest of quadtrees
 
@@ -35,7 +42,8 @@
 
   The duplicate() and coarsen() calls can be used to create a nested
   sequence of meshes that can be used in conjunction with multigrid
-  methods.
+  methods. A duplicate with a lower mesh order can be used for the
+  p-levels of the multigrid hierarchy.
 */
 class TMRQuadForest : public TMREntity {
  public:
@@ -74,6 +82,10 @@ class TMRQuadForest : public TMREntity {
   int getMeshOrder();
   TMRInterpolationType getInterpType();
 
+  // Set the number of threads used to evaluate the node locations
+  // -------------------------------------------------------------
+  void setNumThreads( int _num_threads );
+
   // Re-partition the quadtrees based on element count
   // -------------------------------------------------
   void repartition();
@@ -83,10 +95,15 @@ class TMRQuadForest : public TMREntity {
   void createTrees( int refine_level );
   void createRandomTrees( int nrand=10, 
                           int min_level=0, int max_level=8 );
+  void createRefinedTrees( TMRElementFeatureSize *fs,
+                           int min_level=0, int max_level=TMR_MAX_LEVEL,
+                           int balance_corner=0 );
 
   // Duplicate or coarsen the forest
   // -------------------------------
   TMRQuadForest *duplicate();
+  TMRQuadForest *duplicate( int order,
+                            TMRInterpolationType interp_type );
   TMRQuadForest *coarsen();
 
   // Refine the mesh
@@ -110,6 +127,10 @@ class TMRQuadForest : public TMREntity {
                     int *_num_local_nodes=NULL );
   int getDepNodeConn( const int **_ptr, const int **_conn,
                       const double **_weights );
+  int getDepNodeTemplates( const int **_ptr, const int **_conn,
+                           const int **_tmpl );
+  int getDepNodeRow( int dep_node, const int **_conn, double *_weights );
+  int evalDepTemplate( int tmpl, double *_weights );
 
   // Create interpolation/restriction operators
   // ------------------------------------------
@@ -135,6 +156,8 @@ class TMRQuadForest : public TMREntity {
   void evalInterp( const double pt[], double N[] );
   void evalInterp( const double pt[], double N[],
                    double Nxi[], double Neta[] );
+  int getInterpTable( int npts, const double pts[],
+                      const double **_N, const double **_Nd=NULL );
 
   // Retrieve the connectivity information
   // -------------------------------------
@@ -150,6 +173,13 @@ class TMRQuadForest : public TMREntity {
   // ------------------------------------------
   TMRQuadrant* findEnclosing( const int order, const double *knots,
                               TMRQuadrant *node, int *mpi_owner=NULL );
+  void findEnclosing( const int order, const double *knots,
+                      const int num_nodes, TMRQuadrant *nodes,
+                      TMRQuadrant **enclosing, int *mpi_owners=NULL );
+
+  // Transform the quadrant to the global order
+  // -------------------------------------------
+  void transformNode( TMRQuadrant *quad, int *edge_reversed=NULL );
 
   // Distribute the quadrant array
   // -----------------------------
@@ -171,12 +201,41 @@ class TMRQuadForest : public TMREntity {
   void writeForestToVTK( const char *filename );
   void writeAdjacentToVTK( const char *filename );
 
+  // Write/read the forest and element/node data to/from a binary file
+  // -----------------------------------------------------------------
+  int writeToFile( const char *filename,
+                   int elem_size=0, const double *elem_data=NULL,
+                   int node_size=0, const double *node_data=NULL );
+  int readFromFile( const char *filename,
+                    int *elem_size=NULL, double **elem_data=NULL,
+                    int *node_size=NULL, double **node_data=NULL );
+
+  // Get the memory usage and the high-water marks of the forest
+  // -----------------------------------------------------------
+  void getMemoryUsage( TMRMemoryUsage *usage );
+
  private:
+  // Identifiers for the binary forest files
+  static const int TMR_QUAD_FILE_ID = 0x44415551;
+  static const int TMR_FILE_VERSION = 1;
+  static const int TMR_FILE_HEADER_SIZE = 16;
+
   // Labels for the nodes
   static const int TMR_QUAD_NODE_LABEL = 0;
   static const int TMR_QUAD_EDGE_LABEL = 1;
   static const int TMR_QUAD_FACE_LABEL = 2;
 
+  // Get the memory held by the forest and update a high-water mark
+  // with the resident and transient memory
+  size_t getResidentMemory();
+  void updatePeakMemory( size_t *peak, size_t resident, size_t transient );
+
+  // Create/free the index of quadrants and nodes for each attribute
+  void createAttributeIndex();
+  void freeAttributeIndex();
+  int findAttribute( const char *attr );
+  int addAttribute( const char *attr );
+
   // Free the internally stored data and zero things
   void freeData();
   void freeMeshData( int free_quads=1, int free_owners=1 );
@@ -192,6 +251,9 @@ class TMRQuadForest : public TMREntity {
   // Compute the faces that own the edges and nodes
   void computeFaceOwners();
 
+  // Store the connectivity so that it can be shared with copies
+  void createSharedConnectivity();
+
   // Get the quadrant owner
   int getQuadrantMPIOwner( TMRQuadrant *quad );
 
@@ -241,10 +303,6 @@ class TMRQuadForest : public TMREntity {
   void computeAdjacentDepEdges( int edge_index, TMRQuadrant *b,
                                 TMRQuadrantArray *adjquads );
 
-  // Transform the node to the global numbering. Note that the node
-  // may be labeled a node, edge or face
-  void transformNode( TMRQuadrant *quad, int *edge_reversed=NULL );
-
   // Label the dependent nodes in the dependent node list
   void labelDependentNodes( int *nodes );
 
@@ -259,12 +317,28 @@ class TMRQuadForest : public TMREntity {
                             TMRQuadrantArray *nodes, 
                             const int *node_offset );
 
+  // Compute the 1D weight table used by the dependent node templates
+  void computeDepInterpTable();
+
   // Compute the node locations
   void evaluateNodeLocations();
 
-  // Compute the element interpolation
+  // Find the start of the search for an enclosing quadrant and scan
+  // the quadrants from that position
+  int searchEnclosing( TMRQuadrant *node );
+  TMRQuadrant* scanEnclosing( const int order, const double *knots,
+                              TMRQuadrant *node, int start, 
+                              int *mpi_owner );
+
+  // Compute the element interpolation stencil and the interpolation
+  int computeElemStencil( TMRQuadrant *node,
+                          TMRQuadForest *coarse, TMRQuadrant *quad,
+                          const double *Ntable,
+                          TMRIndexWeight *stencil, double *tmp );
   int computeElemInterp( TMRQuadrant *node,
                          TMRQuadForest *coarse, TMRQuadrant *quad,
+                         const double *Ntable,
+                         TMRInterpStencilTable *stencils,
                          TMRIndexWeight *weights, double *tmp );
 
   // The communicator 
@@ -275,6 +349,9 @@ class TMRQuadForest : public TMREntity {
   TMRInterpolationType interp_type;
   double *interp_knots;
 
+  // Cached 1D shape function tables evaluated at fixed points
+  TMRInterpTableCache *interp_tables;
+
   // The owner quadrant ranges for each processor. Note that this is
   // in the quadrant space not the node space
   TMRQuadrant *owners;
@@ -292,10 +369,28 @@ class TMRQuadForest : public TMREntity {
   // Set the node/edge owners
   int *node_face_owners, *edge_face_owners;
 
+  // The owner of the connectivity arrays above. This is shared
+  // between the forests created by duplicate() and coarsen().
+  TMRSharedArrays *shared_conn;
+
   // The mesh order/connectivity information
   int mesh_order;
   int *conn;
 
+  // The number of threads used to evaluate the node locations
+  int num_threads;
+
+  // The high-water marks of the memory usage during balance() and
+  // createNodes() including the transient data
+  size_t balance_peak_memory, nodes_peak_memory;
+
+  // The index of the quadrants and nodes for each attribute. The
+  // first entry is reserved for entities without an attribute.
+  int num_attrs;
+  char **attr_names;
+  TMRQuadrantArray **attr_quads;
+  int *attr_node_ptr, *attr_nodes;
+
   // Set the range of node numbers owned by each processor
   int *node_range;
 
@@ -309,10 +404,17 @@ class TMRQuadForest : public TMREntity {
   int num_owned_nodes; // Number of nodes that are owned by me
   int ext_pre_offset; // Number of nodes before pre
 
-  // The dependent node information
-  int *dep_ptr, *dep_conn;
+  // The dependent node information. Each dependent node stores the
+  // parent node list and a template index. The weights are only
+  // expanded into dep_weights when they are requested.
+  int *dep_ptr, *dep_conn, *dep_tmpl;
   double *dep_weights;
 
+  // The 1D interpolation table for the dependent node templates.
+  // Row (order*x + k) stores the shape functions at the k-th knot of
+  // a child with offset x = 0, 1 within the parent edge.
+  double *dep_interp;
+
   // The array of all quadrants
   TMRQuadrantArray *quadrants;
   
@@ -435,6 +435,13 @@ void TMRQuadrantArray::merge( TMRQuadrantArray * list ){
   size = len;
 }
 
+/*
+  Get the number of bytes allocated for the array
+*/
+size_t TMRQuadrantArray::getMemoryUsage(){
+  return sizeof(TMRQuadrantArray) + max_size*sizeof(TMRQuadrant);
+}
+
 /*
   Get the array
 */
@@ -505,6 +512,13 @@ TMRQuadrant TMRQuadrantQueue::pop(){
   }
 }
 
+/*
+  Get the number of bytes allocated for the queue
+*/
+size_t TMRQuadrantQueue::getMemoryUsage(){
+  return sizeof(TMRQuadrantQueue) + num_elems*sizeof(QuadQueueNode);
+}
+
 /*
   Convert the queue to an array 
 */
@@ -585,6 +599,14 @@ TMRQuadrantArray* TMRQuadrantHash::toArray(){
   return list;
 }
 
+/*
+  Get the number of bytes allocated for the hash table
+*/
+size_t TMRQuadrantHash::getMemoryUsage(){
+  return (sizeof(TMRQuadrantHash) + num_buckets*sizeof(QuadHashNode*) +
+          num_elems*sizeof(QuadHashNode));
+}
+
 /*
   Add an quadrant to the hash table. 
 
@@ -661,6 +683,8 @@ int TMRQuadrantHash::addQuadrant( TMRQuadrant *quad ){
     if (use_node_index){
       // Search the bucket to see if there's another node in the list
       while (node){
+        // Count each entry compared in the bucket
+        TMRPerfAdd(TMR_PERF_HASH_PROBES, 1);
         if (node->quad.compareNode(quad) == 0){
           return 0;
         }
@@ -676,6 +700,8 @@ int TMRQuadrantHash::addQuadrant( TMRQuadrant *quad ){
     else {
       // Perform the same search, except using quads
       while (node){
+        // Count each entry compared in the bucket
+        TMRPerfAdd(TMR_PERF_HASH_PROBES, 1);
         if (node->quad.compare(quad) == 0){
           return 0;
         }
@@ -70,6 +70,7 @@ class TMRQuadrantArray {
   void sort();
   TMRQuadrant* contains( TMRQuadrant *q, const int use_position=0 );
   void merge( TMRQuadrantArray * list );
+  size_t getMemoryUsage();
 
  private:
   int use_node_index;
@@ -93,7 +94,8 @@ class TMRQuadrantQueue {
   void push( TMRQuadrant *quad );
   TMRQuadrant pop();
   TMRQuadrantArray* toArray();
-  
+  size_t getMemoryUsage();
+
  private:
   // Class that defines an element within the queue
   class QuadQueueNode {
@@ -122,6 +124,7 @@ class TMRQuadrantHash {
 
   TMRQuadrantArray* toArray();
   int addQuadrant( TMRQuadrant *quad );
+  size_t getMemoryUsage();
 
  private:
   // The minimum bucket size
@@ -419,6 +419,36 @@ int TMRFace::getOrientation(){
   return normal_orient;
 }
 
+/*
+  Evaluate a list of points given by indices into the parameter values
+
+  The point k is (u[pts[2*k]], v[pts[2*k+1]]) and is stored in X[k].
+  The parameter values are shared between the points, so derived
+  classes can override this to evaluate the geometry once for each
+  parameter value instead of once for each point. The default
+  implementation calls evalPoint for each point.
+
+  input:
+  nu, u:   the number of parameters and parameter values along u
+  nv, v:   the number of parameters and parameter values along v
+  npts:    the number of points
+  pts:     the indices of the u and v parameters of each point
+
+  output:
+  X:       the physical points
+
+  returns: a non-zero value if any of the evaluations failed
+*/
+int TMRFace::evalPoints( int nu, const double u[],
+                         int nv, const double v[],
+                         int npts, const int pts[], TMRPoint X[] ){
+  int fail = 0;
+  for ( int k = 0; k < npts; k++ ){
+    fail |= evalPoint(u[pts[2*k]], v[pts[2*k+1]], &X[k]);
+  }
+  return fail;
+}
+
 /*
   Evaluate the derivative using a finite-difference step size
 */
@@ -802,6 +832,36 @@ int TMRVolume::evalPoint( double u, double v, double w, TMRPoint *X ){
   return 1;
 }
 
+/*
+  Evaluate a list of points given by indices into the parameter values
+
+  The point k is (u[pts[3*k]], v[pts[3*k+1]], w[pts[3*k+2]]) and is
+  stored in X[k]. The default implementation calls evalPoint for each
+  point.
+
+  input:
+  nu, u:   the number of parameters and parameter values along u
+  nv, v:   the number of parameters and parameter values along v
+  nw, w:   the number of parameters and parameter values along w
+  npts:    the number of points
+  pts:     the indices of the u, v and w parameters of each point
+
+  output:
+  X:       the physical points
+
+  returns: a non-zero value if any of the evaluations failed
+*/
+int TMRVolume::evalPoints( int nu, const double u[],
+                           int nv, const double v[],
+                           int nw, const double w[],
+                           int npts, const int pts[], TMRPoint X[] ){
+  int fail = 0;
+  for ( int k = 0; k < npts; k++ ){
+    fail |= evalPoint(u[pts[3*k]], v[pts[3*k+1]], w[pts[3*k+2]], &X[k]);
+  }
+  return fail;
+}
+
 /*
   Get the faces that enclose this volume
 */
@@ -1241,11 +1301,54 @@ int TMRModel::getVolumeIndex( TMRVolume *volume ){
   return -1;
 }
 
+/*
+  Add the points of the vertices on the outer edge loop of the face
+  to the sum. This is used to compute an approximate centroid.
+*/
+static void add_face_vertex_points( TMRFace *face, TMRPoint *sum,
+                                    int *count ){
+  if (face->getNumEdgeLoops() < 1){
+    return;
+  }
+
+  TMREdgeLoop *loop;
+  face->getEdgeLoop(0, &loop);
+
+  int nedges;
+  TMREdge **e;
+  loop->getEdgeLoop(&nedges, &e, NULL);
+  for ( int k = 0; k < nedges; k++ ){
+    TMRVertex *v1, *v2;
+    e[k]->getVertices(&v1, &v2);
+    TMRPoint p;
+    if (v1 && v1->evalPoint(&p) == 0){
+      sum->x += p.x;
+      sum->y += p.y;
+      sum->z += p.z;
+      (*count)++;
+    }
+  }
+}
+
 /*
   The main topology class that contains the objects used to build the
   underlying mesh.  
-*/
-TMRTopology::TMRTopology( MPI_Comm _comm, TMRModel *_geo ){
+
+  The volumes (or faces for a 2D model) are reordered so that the
+  trees owned by each processor are grouped together. The optional
+  weights (one per volume/face in the model ordering) give the
+  expected cost of each entity, e.g. the anticipated number of
+  elements, and are used by the METIS partition.
+
+  input:
+  comm:          the MPI communicator
+  geo:           the geometric model
+  reorder_type:  the type of reordering to use for the volumes/faces
+  weights:       optional entity weights (only used on the root)
+*/
+TMRTopology::TMRTopology( MPI_Comm _comm, TMRModel *_geo,
+                          TMRReorderType reorder_type,
+                          const int *weights ){
   // Set the communicator
   comm = _comm;
 
@@ -1319,10 +1422,39 @@ TMRTopology::TMRTopology( MPI_Comm _comm, TMRModel *_geo ){
     volume_to_new_num = new int[ num_volumes ];
     new_num_to_volume = new int[ num_volumes ];
 
-    // Do not use the RCM reordering for the volumes
-    int use_rcm = 0;
+    // Do not use the RCM reordering for the volumes in parallel
+    if (reorder_type == TMR_REORDER_DEFAULT){
+      int mpi_size;
+      MPI_Comm_size(comm, &mpi_size);
+      reorder_type = (mpi_size > 1 ? TMR_REORDER_METIS : TMR_REORDER_RCM);
+    }
+
+    // Compute the volume centroids for the space-filling curve
+    TMRPoint *centroids = NULL;
+    if (reorder_type == TMR_REORDER_SFC){
+      centroids = new TMRPoint[ num_volumes ];
+      for ( int i = 0; i < num_volumes; i++ ){
+        int nfaces;
+        TMRFace **f;
+        volumes[i]->getFaces(&nfaces, &f, NULL);
+
+        int count = 0;
+        centroids[i].zero();
+        for ( int j = 0; j < nfaces; j++ ){
+          add_face_vertex_points(f[j], &centroids[i], &count);
+        }
+        if (count > 0){
+          centroids[i].x /= count;
+          centroids[i].y /= count;
+          centroids[i].z /= count;
+        }
+      }
+    }
+
     reorderEntities(6, num_faces, num_volumes, volume_faces,
-                    volume_to_new_num, new_num_to_volume, use_rcm);
+                    reorder_type, weights, centroids,
+                    volume_to_new_num, new_num_to_volume);
+    if (centroids){ delete [] centroids; }
 
     // Free the temporary volume to faces pointer
     delete [] volume_faces;
@@ -1383,8 +1515,31 @@ TMRTopology::TMRTopology( MPI_Comm _comm, TMRModel *_geo ){
     face_to_new_num = new int[ num_faces ];
     new_num_to_face = new int[ num_faces ];
 
+    // Use the RCM reordering for the faces by default
+    if (reorder_type == TMR_REORDER_DEFAULT){
+      reorder_type = TMR_REORDER_RCM;
+    }
+
+    // Compute the face centroids for the space-filling curve
+    TMRPoint *centroids = NULL;
+    if (reorder_type == TMR_REORDER_SFC){
+      centroids = new TMRPoint[ num_faces ];
+      for ( int i = 0; i < num_faces; i++ ){
+        int count = 0;
+        centroids[i].zero();
+        add_face_vertex_points(faces[i], &centroids[i], &count);
+        if (count > 0){
+          centroids[i].x /= count;
+          centroids[i].y /= count;
+          centroids[i].z /= count;
+        }
+      }
+    }
+
     reorderEntities(4, num_edges, num_faces, face_edges,
+                    reorder_type, weights, centroids,
                     face_to_new_num, new_num_to_face);
+    if (centroids){ delete [] centroids; }
 
     // Delete face edges
     delete [] face_edges;
@@ -1686,28 +1841,158 @@ void TMRTopology::computeConnectivty( int num_entities,
   *_face_to_face = face_to_face;
 }
 
+/*
+  Interleave the bits of the integer coordinates to form the Morton
+  key used for the space-filling curve ordering
+*/
+static uint64_t morton_key( uint32_t x, uint32_t y, uint32_t z ){
+  uint64_t key = 0;
+  for ( int k = 20; k >= 0; k-- ){
+    key = (key << 3) | 
+      (((uint64_t)((z >> k) & 1)) << 2) |
+      (((uint64_t)((y >> k) & 1)) << 1) |
+      ((uint64_t)((x >> k) & 1));
+  }
+  return key;
+}
+
+/*
+  Compare the Morton keys for sorting. The key is stored first,
+  followed by the entity index which is used to break ties.
+*/
+static int compare_morton_keys( const void *a, const void *b ){
+  const uint64_t *aa = static_cast<const uint64_t*>(a);
+  const uint64_t *bb = static_cast<const uint64_t*>(b);
+  if (aa[0] != bb[0]){
+    return (aa[0] < bb[0] ? -1 : 1);
+  }
+  if (aa[1] != bb[1]){
+    return (aa[1] < bb[1] ? -1 : 1);
+  }
+  return 0;
+}
+
+/*
+  Compute the level structure rooted at the given entity using a
+  breadth-first search over the entities that have not been ordered
+  (vars[i] < 0). The entities are stored in levset and the entities
+  in the last level are levset[*last_start:size).
+
+  returns: the number of entities in the level structure
+*/
+static int compute_level_structure( int root, const int *ptr,
+                                    const int *adj, const int *vars,
+                                    int *mark, int stamp, int *levset,
+                                    int *nlevels, int *last_start ){
+  int start = 0, end = 1;
+  levset[0] = root;
+  mark[root] = stamp;
+  *nlevels = 0;
+  *last_start = 0;
+
+  while (start < end){
+    int next = end;
+    for ( int current = start; current < end; current++ ){
+      int node = levset[current];
+      for ( int j = ptr[node]; j < ptr[node+1]; j++ ){
+        int next_node = adj[j];
+        if (vars[next_node] < 0 && mark[next_node] != stamp){
+          mark[next_node] = stamp;
+          levset[next] = next_node;
+          next++;
+        }
+      }
+    }
+    (*nlevels)++;
+    *last_start = start;
+    start = end;
+    end = next;
+  }
+
+  return end;
+}
+
 /*
   Reorder volumes or faces to group things according to MPI rank
+
+  The new ordering is computed on the root processor and only the
+  resulting permutation is broadcast to the other processors.
+
+  The RCM ordering starts each connected component from a
+  pseudo-peripheral entity found with the George-Liu algorithm and
+  orders the neighbors in each level set by increasing degree. The
+  METIS ordering groups the entities by a partition with one part per
+  processor, weighted by the optional entity weights. The SFC
+  ordering sorts the entity centroids along a Morton curve. It does
+  not require the connectivity and scales to very large models.
 */
 void TMRTopology::reorderEntities( int num_entities, 
                                    int num_edges, int num_faces,
                                    const int *ftoedges,
+                                   TMRReorderType reorder_type,
+                                   const int *weights,
+                                   const TMRPoint *centroids,
                                    int *entity_to_new_num,
-                                   int *new_num_to_entity,
-                                   int use_rcm ){
+                                   int *new_num_to_entity ){
   // Get the mpi size
   int mpi_rank, mpi_size;
   MPI_Comm_rank(comm, &mpi_rank);
   MPI_Comm_size(comm, &mpi_size);
 
-  if (mpi_rank == 0){
+  // There is nothing to order. The number of entities is the same on
+  // all processors so no processor enters the broadcast below.
+  if (num_faces == 0){
+    return;
+  }
+
+  // Partitioning is only required in parallel
+  if (reorder_type == TMR_REORDER_METIS && mpi_size == 1){
+    reorder_type = TMR_REORDER_RCM;
+  }
+
+  if (mpi_rank == 0 && reorder_type == TMR_REORDER_SFC && centroids){
+    // Find the bounding box of the centroids
+    TMRPoint xmin = centroids[0], xmax = centroids[0];
+    for ( int i = 1; i < num_faces; i++ ){
+      if (centroids[i].x < xmin.x){ xmin.x = centroids[i].x; }
+      if (centroids[i].y < xmin.y){ xmin.y = centroids[i].y; }
+      if (centroids[i].z < xmin.z){ xmin.z = centroids[i].z; }
+      if (centroids[i].x > xmax.x){ xmax.x = centroids[i].x; }
+      if (centroids[i].y > xmax.y){ xmax.y = centroids[i].y; }
+      if (centroids[i].z > xmax.z){ xmax.z = centroids[i].z; }
+    }
+
+    // Use the same scaling in each direction
+    double d = xmax.x - xmin.x;
+    if (xmax.y - xmin.y > d){ d = xmax.y - xmin.y; }
+    if (xmax.z - xmin.z > d){ d = xmax.z - xmin.z; }
+    const uint32_t hmax = (1 << 21) - 1;
+    double scale = (d > 0.0 ? hmax/d : 0.0);
+
+    // Compute the keys and sort them
+    uint64_t *keys = new uint64_t[ 2*num_faces ];
+    for ( int i = 0; i < num_faces; i++ ){
+      uint32_t x = (uint32_t)(scale*(centroids[i].x - xmin.x));
+      uint32_t y = (uint32_t)(scale*(centroids[i].y - xmin.y));
+      uint32_t z = (uint32_t)(scale*(centroids[i].z - xmin.z));
+      keys[2*i] = morton_key(x, y, z);
+      keys[2*i+1] = i;
+    }
+    qsort(keys, num_faces, 2*sizeof(uint64_t), compare_morton_keys);
+
+    for ( int i = 0; i < num_faces; i++ ){
+      entity_to_new_num[keys[2*i+1]] = i;
+    }
+    delete [] keys;
+  }
+  else if (mpi_rank == 0){
     // Compute the new ordering
     int *face_to_face_ptr, *face_to_face;
     computeConnectivty(num_entities, num_edges, 
                        num_faces, ftoedges,
                        &face_to_face_ptr, &face_to_face);
     
-    if (mpi_size == 1 || use_rcm){
+    if (reorder_type != TMR_REORDER_METIS){
       // Set a pointer to the new numbers
       int *vars = entity_to_new_num;
       int *levset = new_num_to_entity;
@@ -1718,6 +2003,37 @@ void TMRTopology::reorderEntities( int num_entities,
         vars[i] = -1; 
       }
 
+      // Sort the entities by degree so that the next starting entity
+      // can be found without searching all the entities
+      int max_degree = 0;
+      for ( int i = 0; i < num_faces; i++ ){
+        int deg = face_to_face_ptr[i+1] - face_to_face_ptr[i];
+        if (deg > max_degree){ max_degree = deg; }
+      }
+      int *degree_ptr = new int[ max_degree+2 ];
+      int *by_degree = new int[ num_faces ];
+      memset(degree_ptr, 0, (max_degree+2)*sizeof(int));
+      for ( int i = 0; i < num_faces; i++ ){
+        degree_ptr[face_to_face_ptr[i+1] - face_to_face_ptr[i] + 1]++;
+      }
+      for ( int i = 0; i <= max_degree; i++ ){
+        degree_ptr[i+1] += degree_ptr[i];
+      }
+      for ( int i = 0; i < num_faces; i++ ){
+        int deg = face_to_face_ptr[i+1] - face_to_face_ptr[i];
+        by_degree[degree_ptr[deg]] = i;
+        degree_ptr[deg]++;
+      }
+      delete [] degree_ptr;
+
+      // Work arrays for the level structures
+      int *mark = new int[ num_faces ];
+      int *work = new int[ num_faces ];
+      for ( int i = 0; i < num_faces; i++ ){
+        mark[i] = -1;
+      }
+      int stamp = 0;
+
       // Set the start and end location for each level set
       int start = 0, end = 0;
       
@@ -1725,22 +2041,57 @@ void TMRTopology::reorderEntities( int num_entities,
       int n = 0;
       
       // Keep going until everything has been ordered
+      int next_root = 0;
       while (n < num_faces){
-        // Find the next root
-        int root = -1, max_degree = num_faces+1;
-        for ( int i = 0; i < num_faces; i++ ){
-          if (vars[i] < 0 && 
-              face_to_face_ptr[i+1] - face_to_face_ptr[i] < max_degree){
-            root = i;
-            max_degree = face_to_face_ptr[i+1] - face_to_face_ptr[i];
-          }
+        // Find the next unordered entity of minimum degree
+        while (next_root < num_faces && vars[by_degree[next_root]] >= 0){
+          next_root++;
         }
 
         // Nothing is left to order
-        if (root < 0){
+        if (next_root >= num_faces){
           break;
         }
-        
+        int root = by_degree[next_root];
+
+        // Find a pseudo-peripheral root: Move to the entity of minimum
+        // degree in the last level set until the number of levels
+        // stops increasing
+        int nlevels, last_start;
+        int size = compute_level_structure(root, face_to_face_ptr, 
+                                           face_to_face, vars, mark, 
+                                           stamp, work, 
+                                           &nlevels, &last_start);
+        stamp++;
+        while (1){
+          int candidate = -1, min_degree = num_faces+1;
+          for ( int k = last_start; k < size; k++ ){
+            int deg = 
+              face_to_face_ptr[work[k]+1] - face_to_face_ptr[work[k]];
+            if (deg < min_degree){
+              candidate = work[k];
+              min_degree = deg;
+            }
+          }
+
+          int cand_levels, cand_last;
+          int cand_size = compute_level_structure(candidate, 
+                                                  face_to_face_ptr, 
+                                                  face_to_face, vars,
+                                                  mark, stamp, work, 
+                                                  &cand_levels, &cand_last);
+          stamp++;
+          if (cand_levels > nlevels){
+            root = candidate;
+            nlevels = cand_levels;
+            last_start = cand_last;
+            size = cand_size;
+          }
+          else {
+            break;
+          }
+        }
+
         // Set the next root within the level set and continue
         levset[end] = root;
         vars[root] = n;
@@ -1753,7 +2104,9 @@ void TMRTopology::reorderEntities( int num_entities,
           for ( int current = start; current < end; current++ ){
             int node = levset[current];
 
-            // Add all the nodes in the next level set
+            // Add all the nodes in the next level set in order of
+            // increasing degree
+            int first = next;
             for ( int j = face_to_face_ptr[node]; 
                   j < face_to_face_ptr[node+1]; j++ ){
               int next_node = face_to_face[j];
@@ -1765,12 +2118,35 @@ void TMRTopology::reorderEntities( int num_entities,
                 next++;
               }
             }
+
+            // Insertion sort the new entries by degree
+            for ( int k = first+1; k < next; k++ ){
+              int t = levset[k];
+              int deg = face_to_face_ptr[t+1] - face_to_face_ptr[t];
+              int m = k-1;
+              while (m >= first && 
+                     face_to_face_ptr[levset[m]+1] - 
+                     face_to_face_ptr[levset[m]] > deg){
+                levset[m+1] = levset[m];
+                m--;
+              }
+              levset[m+1] = t;
+            }
           }
 
           start = end;
           end = next;
         }
       }
+
+      // Reverse the Cuthill-McKee ordering
+      for ( int i = 0; i < n; i++ ){
+        vars[levset[i]] = n-1-i;
+      }
+
+      delete [] by_degree;
+      delete [] mark;
+      delete [] work;
     }
     else {
       // Set the pointer to the new entities array
@@ -1785,13 +2161,23 @@ void TMRTopology::reorderEntities( int num_entities,
         
       // The objective value in METIS
       int objval = 0;
+
+      // Copy the weights (if any)
+      int *vwgt = NULL;
+      if (weights){
+        vwgt = new int[ num_faces ];
+        for ( int i = 0; i < num_faces; i++ ){
+          vwgt[i] = (weights[i] > 0 ? weights[i] : 1);
+        }
+      }
         
       // Partition based on the size of the mesh
       int ncon = 1;
       METIS_PartGraphRecursive(&num_faces, &ncon, 
                                face_to_face_ptr, face_to_face,
-                               NULL, NULL, NULL, &mpi_size, 
+                               vwgt, NULL, NULL, &mpi_size, 
                                NULL, NULL, options, &objval, partition);
+      if (vwgt){ delete [] vwgt; }
         
       int *offset = new int[ mpi_size+1 ];
       memset(offset, 0, (mpi_size+1)*sizeof(int));
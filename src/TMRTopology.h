@@ -40,6 +40,24 @@ class TMREdgeMesh;
 class TMRFaceMesh;
 class TMRVolumeMesh;
 
+/*
+  The type of reordering applied to the faces (2D) or volumes (3D)
+  when the topology is created. The entity ordering determines the
+  initial distribution of the trees in the forest.
+
+  TMR_REORDER_DEFAULT: RCM for faces, RCM for volumes in serial and
+                       METIS partitioning for volumes in parallel
+  TMR_REORDER_RCM:     reverse Cuthill-McKee ordering
+  TMR_REORDER_METIS:   group the entities by a (weighted) METIS
+                       partition with one part per processor
+  TMR_REORDER_SFC:     order along a Morton space-filling curve through
+                       the entity centroids
+*/
+enum TMRReorderType { TMR_REORDER_DEFAULT,
+                      TMR_REORDER_RCM,
+                      TMR_REORDER_METIS,
+                      TMR_REORDER_SFC };
+
 /*
   The vertex class: Note that this is used to store both the
   point and to represent the underlying geometry
@@ -57,6 +75,9 @@ class TMRVertex : public TMREntity {
   virtual int getParamsOnFace( TMRFace *face,
                                double *u, double *v );
 
+  // Check whether the evaluation may be called from several threads
+  virtual int isThreadSafe(){ return 0; }
+
   // Set/retrieve the node numbers
   void resetNodeNum();
   int setNodeNum( int *num );
@@ -96,6 +117,9 @@ class TMREdge : public TMREntity {
   // Is this edge degenerate
   virtual int isDegenerate(){ return 0; }
 
+  // Check whether the evaluation may be called from several threads
+  virtual int isThreadSafe(){ return 0; }
+
   // Set/retrieve the vertices at the beginning and end of the curve
   void setVertices( TMRVertex *_v1, TMRVertex *_v2 );
   void getVertices( TMRVertex **_v1, TMRVertex **_v2 );
@@ -163,6 +187,11 @@ class TMRFace : public TMREntity {
  
   // Given the parametric point, compute the x,y,z location
   virtual int evalPoint( double u, double v, TMRPoint *X ) = 0;
+
+  // Evaluate points given by indices into the parameter values
+  virtual int evalPoints( int nu, const double u[],
+                          int nv, const double v[],
+                          int npts, const int pts[], TMRPoint X[] );
   
   // Perform the inverse evaluation
   virtual int invEvalPoint( TMRPoint p, double *u, double *v );
@@ -175,6 +204,9 @@ class TMRFace : public TMREntity {
   virtual int eval2ndDeriv( double u, double v,
                             TMRPoint *Xuu, TMRPoint *Xuv, TMRPoint *Xvv );
 
+  // Check whether the evaluation may be called from several threads
+  virtual int isThreadSafe(){ return 0; }
+
   // Add an edge loop to the face
   int getNumEdgeLoops();
   void addEdgeLoop( TMREdgeLoop *loop );
@@ -231,6 +263,15 @@ class TMRVolume : public TMREntity {
   // Given the parametric point u,v,w compute the physical location x,y,z
   virtual int evalPoint( double u, double v, double w, TMRPoint *X );
 
+  // Evaluate points given by indices into the parameter values
+  virtual int evalPoints( int nu, const double u[],
+                          int nv, const double v[],
+                          int nw, const double w[],
+                          int npts, const int pts[], TMRPoint X[] );
+
+  // Check whether the evaluation may be called from several threads
+  virtual int isThreadSafe(){ return 0; }
+
   // Get the faces that enclose this volume
   void getFaces( int *_num_faces, TMRFace ***_faces, const int **_dir );
 
@@ -349,7 +390,9 @@ class TMRModel : public TMREntity {
 */
 class TMRTopology : public TMREntity {
  public:
-  TMRTopology( MPI_Comm _comm, TMRModel *geo );
+  TMRTopology( MPI_Comm _comm, TMRModel *geo,
+               TMRReorderType reorder_type=TMR_REORDER_DEFAULT,
+               const int *weights=NULL );
   ~TMRTopology();
   
   // Retrieve the face/edge/node information
@@ -378,8 +421,9 @@ class TMRTopology : public TMREntity {
                            int **_face_to_face_ptr,
                            int **_face_to_face );
   void reorderEntities( int num_entities, int num_edges, int num_faces,
-                        const int *ftoedges, int *entity_to_new_num, 
-                        int *new_num_to_entity, int use_rcm=1 );
+                        const int *ftoedges, TMRReorderType reorder_type,
+                        const int *weights, const TMRPoint *centroids,
+                        int *entity_to_new_num, int *new_num_to_entity );
 
   // Connectivity for face -> edge, face -> vertex and edge -> vertex
   void computeFaceConn();
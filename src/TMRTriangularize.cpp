@@ -440,6 +440,23 @@ void TMRQuadNode::findClosest( const double pt[],
   }
 }
 
+/*
+  Get the memory used by this node and all of its children
+*/
+size_t TMRQuadNode::getMemoryUsage(){
+  size_t bytes = sizeof(TMRQuadNode);
+  if (low_left){
+    bytes += low_left->getMemoryUsage();
+    bytes += low_right->getMemoryUsage();
+    bytes += up_left->getMemoryUsage();
+    bytes += up_right->getMemoryUsage();
+  }
+  else {
+    bytes += NODES_PER_LEVEL*(2*sizeof(double) + sizeof(uint32_t));
+  }
+  return bytes;
+}
+
 /*
   Create the triangularization object. 
 
@@ -498,8 +515,10 @@ TMRTriangularize::TMRTriangularize( int npts, const double inpts[], int nholes,
 void TMRTriangularize::initialize( int npts, const double inpts[], int nholes,
                                    int nsegs, const int segs[],
                                    TMRFace *surf ){
-  // Initialize the predicates code
-  exactinit();
+  // Initialize the predicates code if TMR has not been initialized
+  if (!TMRIsInitialized()){
+    TMRInitialize();
+  }
 
   // Set the frontal quality acceptance factor
   frontal_quality_factor = 1.5;
@@ -728,6 +747,35 @@ TMRTriangularize::~TMRTriangularize(){
   }
 }
 
+/*
+  Get the memory allocated for the points, the quadtree, the
+  triangle list and the edge hash table
+
+  output:
+  usage:   the memory usage object (entries are added to it)
+*/
+void TMRTriangularize::getMemoryUsage( TMRMemoryUsage *usage ){
+  usage->add("tri_points", max_num_points*(2*sizeof(double) +
+                                           sizeof(TMRPoint) +
+                                           sizeof(TMRTriangle*)));
+
+  size_t bytes = 0;
+  if (pslg_edges){
+    bytes = 2*num_pslg_edges*sizeof(uint32_t);
+  }
+  usage->add("tri_pslg_edges", bytes);
+
+  bytes = 0;
+  if (root){
+    bytes = root->getMemoryUsage();
+  }
+  usage->add("tri_quadtree", bytes);
+
+  usage->add("tri_triangles", num_triangles*sizeof(TriListNode));
+  usage->add("tri_edge_hash", (num_buckets*sizeof(EdgeHashNode*) +
+                               num_hash_nodes*sizeof(EdgeHashNode)));
+}
+
 /*
   Construct a delaunay triangulation using the edge flip algorithm.
 
@@ -1998,6 +2046,8 @@ class TMRTriangleCompare {
 */
 void TMRTriangularize::frontal( TMRMeshOptions options, 
                                 TMRElementFeatureSize *fs ){
+  TMRPerfBegin(TMR_PERF_FRONTAL);
+
   // The queue of active (and sometimes deleted) triangles
   std::priority_queue<TMRTriangle*, std::vector<TMRTriangle*>,
     TMRTriangleCompare> active;
@@ -2065,10 +2115,6 @@ void TMRTriangularize::frontal( TMRMeshOptions options,
     printf("%10s %10s %10s\n", "Iteration", "Triangles", "Active");
   }
 
-  double t0 = MPI_Wtime();
-  double t0_enclose = 0.0, t1_enclose = 0.0;
-  double t0_update = 0.0, t1_update = 0.0;
-
   int iter = 0;
   while (1){
     if (options.triangularize_print_level > 0 && 
@@ -2283,9 +2329,9 @@ void TMRTriangularize::frontal( TMRMeshOptions options,
       // Find the enclosing triangle for the new point
       pt_tri = tri;
       if (!enclosed(pt, pt_tri->u, pt_tri->v, pt_tri->w)){
-        t0_enclose += MPI_Wtime();
+        TMRPerfBegin(TMR_PERF_FRONTAL_FIND_ENCLOSING);
         findEnclosing(pt, &pt_tri);
-        t1_enclose += MPI_Wtime();
+        TMRPerfEnd(TMR_PERF_FRONTAL_FIND_ENCLOSING);
       }
 
       // If no triangle is found, then we quit an mark the source
@@ -2340,8 +2386,8 @@ void TMRTriangularize::frontal( TMRMeshOptions options,
       }
     }
     else { // (pt_tri){
-      // Add up the update time
-      t0_update += MPI_Wtime();
+      // Time the update of the triangulation
+      TMRPerfBegin(TMR_PERF_FRONTAL_UPDATE);
     
       // Set the pointer to the last member in the list
       TriListNode *list_marker = list_end; 
@@ -2419,12 +2465,10 @@ void TMRTriangularize::frontal( TMRMeshOptions options,
         // Increment the pointer to the next member of the list
         ptr = ptr->next;
       }
-      t1_update += MPI_Wtime();
+      TMRPerfEnd(TMR_PERF_FRONTAL_UPDATE);
     }
   }
 
-  t0 = MPI_Wtime() - t0;
-
   if (options.mesh_type_default != TMR_TRIANGLE){
     // Ensure that we do not have isolated triangles on the boundary
     // which will cause problems if we do a conversion to a
@@ -2476,10 +2520,7 @@ void TMRTriangularize::frontal( TMRMeshOptions options,
   if (options.triangularize_print_level > 0){
     printf("%10d %10d\n", iter, num_triangles);
   }
-  if (options.triangularize_print_level > 1){
-    printf("Time breakdown\n");
-    printf("findEnclosing: %15.4e s\n", t1_enclose - t0_enclose);
-    printf("update:        %15.4e s\n", t1_update - t0_update);
-    printf("total:         %15.4e s\n", t0);
-  }
+
+  TMRPerfAdd(TMR_PERF_ELEMENTS_CREATED, num_triangles);
+  TMRPerfEnd(TMR_PERF_FRONTAL);
 }
@@ -64,6 +64,9 @@ class TMRQuadNode {
   // -------------------------------------------------------------
   uint32_t findClosest( const double pt[], double *_dist=NULL );
 
+  // Get the memory used by this node and its children
+  size_t getMemoryUsage();
+
  private:
   // This is only for creating children
   TMRQuadNode( TMRQuadDomain *_domain,
@@ -161,6 +164,9 @@ class TMRTriangularize : public TMREntity {
   // Write the triangulation to an outputfile
   void writeToVTK( const char *filename, const int param_space=0 );
 
+  // Get the memory allocated by the triangularization
+  void getMemoryUsage( TMRMemoryUsage *usage );
+
  private:
   // The Bowyer-Watson algorithm is started with 4 points (2 triangles)
   // that cover the entire domain. These are deleted at the end 
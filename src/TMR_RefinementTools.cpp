@@ -19,6 +19,7 @@
 */
 
 #include "TMR_RefinementTools.h"
+#include "TMRInterpolation.h"
 #include "TensorToolbox.h"
 #include "TACSElementAlgebra.h"
 #include "tacslapack.h"
@@ -1310,6 +1311,13 @@ void addRefinedSolution2D( TMRQuadForest *forest,
   // Refined element solution
   TacsScalar *uref = new TacsScalar[ vars_per_node*num_refined_nodes ];
 
+  // Temporary space for the sum-factorized interpolation
+  TacsScalar *work = new TacsScalar[ vars_per_node*refined_order*order ];
+
+  // Get the shape functions at the refined knots
+  const double *Ntable;
+  forest->getInterpTable(refined_order, refined_knots, &Ntable);
+
   // The maximum number of nodes for any element
   TacsScalar Xpts[3*MAX_ORDER*MAX_ORDER];
 
@@ -1400,6 +1408,10 @@ void addRefinedSolution2D( TMRQuadForest *forest,
       // Zero the refined element contribution
       memset(uref, 0, vars_per_node*num_refined_nodes*sizeof(TacsScalar));
 
+      // Interpolate the element solution to the refined knots
+      lagrange_tensor_interp_2d(order, refined_order, Ntable, Ntable,
+                                vars_per_node, uelem, uref, work);
+
       // Compute the element order
       for ( int m = 0; m < refined_order; m++ ){
         for ( int n = 0; n < refined_order; n++ ){
@@ -1408,21 +1420,6 @@ void addRefinedSolution2D( TMRQuadForest *forest,
           pt[0] = refined_knots[n];
           pt[1] = refined_knots[m];
 
-          // Evaluate the shape functions
-          double N[MAX_ORDER*MAX_ORDER];
-          forest->evalInterp(pt, N);
-
-          // Set the values of the variables at this point
-          for ( int i = 0; i < vars_per_node; i++ ){
-            const TacsScalar *ue = &uelem[i];
-            TacsScalar *u = &uref[vars_per_node*(n + refined_order*m) + i];
-
-            for ( int k = 0; k < num_nodes; k++ ){
-              u[0] += N[k]*ue[0];
-              ue += vars_per_node;
-            }
-          }
-
           // Evaluate the enrichment functions and add them to the
           // solution
           double Nr[MAX_2D_ENRICH];
@@ -1465,6 +1462,7 @@ void addRefinedSolution2D( TMRQuadForest *forest,
   delete [] delem;
   delete [] ubar;
   delete [] uref;
+  delete [] work;
 }
 
 /*
@@ -1506,7 +1504,15 @@ void addRefinedSolution3D( TMROctForest *forest,
   TacsScalar *ubar = new TacsScalar[ vars_per_node*nenrich ];
 
   // Refined element solution
-  TacsScalar *uref = new TacsScalar[ vars_per_node*order*order*order ];
+  TacsScalar *uref = new TacsScalar[ vars_per_node*num_refined_nodes ];
+
+  // Temporary space for the sum-factorized interpolation
+  const int work_size = refined_order*order*(order + refined_order);
+  TacsScalar *work = new TacsScalar[ vars_per_node*work_size ];
+
+  // Get the shape functions at the refined knots
+  const double *Ntable;
+  forest->getInterpTable(refined_order, refined_knots, &Ntable);
 
   // The maximum number of nodes for any element
   TacsScalar Xpts[3*MAX_ORDER*MAX_ORDER*MAX_ORDER];
@@ -1601,6 +1607,10 @@ void addRefinedSolution3D( TMROctForest *forest,
       // Zero the refined element contribution
       memset(uref, 0, vars_per_node*num_refined_nodes*sizeof(TacsScalar));
 
+      // Interpolate the element solution to the refined knots
+      lagrange_tensor_interp_3d(order, refined_order, Ntable, Ntable, Ntable,
+                                vars_per_node, uelem, uref, work);
+
       for ( int p = 0; p < refined_order; p++ ){
         for ( int m = 0; m < refined_order; m++ ){
           for ( int n = 0; n < refined_order; n++ ){
@@ -1610,23 +1620,12 @@ void addRefinedSolution3D( TMROctForest *forest,
             pt[1] = refined_knots[m];
             pt[2] = refined_knots[p];
 
-            // Evaluate the shape functions and the enrichment
-            // functions at the new parametric point
-            double N[MAX_ORDER*MAX_ORDER*MAX_ORDER];
-            forest->evalInterp(pt, N);
-
-            // Add the portion from the enrichment functions
+            // Evaluate the enrichment functions at the new
+            // parametric point
             int offset = (n + refined_order*m +
                           refined_order*refined_order*p);
             TacsScalar *u = &uref[vars_per_node*offset];
 
-            for ( int i = 0; i < vars_per_node; i++ ){
-              const TacsScalar *ue = &uelem[i];
-              for ( int k = 0; k < order*order*order; k++ ){
-                u[i] += N[k]*ue[vars_per_node*k];
-              }
-            }
-
             double Nr[MAX_3D_ENRICH];
             if (order == 2){
               eval2ndEnrichmentFuncs3D(pt, Nr);
@@ -1666,6 +1665,7 @@ void addRefinedSolution3D( TMROctForest *forest,
   delete [] delem;
   delete [] ubar;
   delete [] uref;
+  delete [] work;
 }
 
 /*
@@ -28,6 +28,11 @@
 
 /*
   Create a TACS multigrid object
+
+  Adjacent forests in the hierarchy may differ by one level of
+  h-coarsening, from coarsen(), or by the mesh order, from
+  duplicate() with a lower order. The p-levels share the partition of
+  the forest they are copied from.
 */
 void TMR_CreateTACSMg( int nlevels, TACSAssembler *tacs[],
                        TMROctForest *forest[], TACSMg **_mg, 
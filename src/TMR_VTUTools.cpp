@@ -0,0 +1,507 @@
+/*
+  This file is part of the package TMR for adaptive mesh refinement.
+
+  Copyright (C) 2015 Georgia Tech Research Corporation.
+  Additional copyright (C) 2015 Graeme Kennedy.
+  All rights reserved.
+
+  TMR is licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this software except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include "TMR_VTUTools.h"
+#include <stdio.h>
+
+#ifdef TMR_USE_ZLIB
+#include <zlib.h>
+#endif // TMR_USE_ZLIB
+
+/*
+  A data array that is stored in the appended section of the file.
+
+  The encoded data is either the raw data preceded by its size in
+  bytes, or the zlib-compressed data preceded by the single-block
+  compression header used by vtkZLibDataCompressor.
+*/
+class TMRVTUArray {
+ public:
+  TMRVTUArray(){
+    type = NULL;
+    name = NULL;
+    num_components = 1;
+    size = 0;
+    data = NULL;
+  }
+  ~TMRVTUArray(){
+    if (data){ delete [] data; }
+  }
+
+  // Encode the data and take ownership of the encoded buffer
+  void encode( const char *_type, const char *_name, int _num_components,
+               const void *values, uint64_t nbytes, int compress ){
+    type = _type;
+    name = _name;
+    num_components = _num_components;
+
+#ifdef TMR_USE_ZLIB
+    if (compress){
+      uLongf csize = compressBound(nbytes);
+      data = new char[ 4*sizeof(uint64_t) + csize ];
+      if (nbytes > 0){
+        compress2((Bytef*)&data[4*sizeof(uint64_t)], &csize,
+                  (const Bytef*)values, nbytes, Z_DEFAULT_COMPRESSION);
+      }
+      else {
+        csize = 0;
+      }
+
+      // Set the header: number of blocks, the block size, the size
+      // of the last block and the compressed block size
+      uint64_t header[4];
+      header[0] = 1;
+      header[1] = nbytes;
+      header[2] = nbytes;
+      header[3] = csize;
+      memcpy(data, header, 4*sizeof(uint64_t));
+      size = 4*sizeof(uint64_t) + csize;
+      return;
+    }
+#endif // TMR_USE_ZLIB
+
+    data = new char[ sizeof(uint64_t) + nbytes ];
+    memcpy(data, &nbytes, sizeof(uint64_t));
+    if (nbytes > 0){
+      memcpy(&data[sizeof(uint64_t)], values, nbytes);
+    }
+    size = sizeof(uint64_t) + nbytes;
+  }
+
+  // Write the XML entry for the array at the given appended offset
+  void writeHeader( FILE *fp, uint64_t offset ){
+    fprintf(fp, "<DataArray type=\"%s\"", type);
+    if (name){
+      fprintf(fp, " Name=\"%s\"", name);
+    }
+    fprintf(fp, " NumberOfComponents=\"%d\" format=\"appended\" "
+            "offset=\"%llu\"/>\n", num_components,
+            (unsigned long long)offset);
+  }
+
+  // Write the parallel XML entry for the array
+  void writePHeader( FILE *fp ){
+    fprintf(fp, "<PDataArray type=\"%s\"", type);
+    if (name){
+      fprintf(fp, " Name=\"%s\"", name);
+    }
+    fprintf(fp, " NumberOfComponents=\"%d\"/>\n", num_components);
+  }
+
+  const char *type;
+  const char *name;
+  int num_components;
+  uint64_t size;
+  char *data;
+};
+
+/*
+  Get the byte order of this machine
+*/
+static const char *get_byte_order(){
+  const uint16_t test = 1;
+  if (*((const char*)&test) == 1){
+    return "LittleEndian";
+  }
+  return "BigEndian";
+}
+
+/*
+  Overloaded functions to access the forest-specific data
+*/
+static inline int get_elements( TMROctForest *forest,
+                                TMROctant **array ){
+  TMROctantArray *octants;
+  forest->getOctants(&octants);
+  int size = 0;
+  *array = NULL;
+  if (octants){
+    octants->getArray(array, &size);
+  }
+  return size;
+}
+
+static inline int get_elements( TMRQuadForest *forest,
+                                TMRQuadrant **array ){
+  TMRQuadrantArray *quadrants;
+  forest->getQuadrants(&quadrants);
+  int size = 0;
+  *array = NULL;
+  if (quadrants){
+    quadrants->getArray(array, &size);
+  }
+  return size;
+}
+
+static inline int get_owner( const TMROctant *oct ){
+  return oct->block;
+}
+
+static inline int get_owner( const TMRQuadrant *quad ){
+  return quad->face;
+}
+
+/*
+  Set the parametric location of the node with the given tensor index
+  within the element
+*/
+static inline void get_param_point( const TMROctant *oct,
+                                    const double *knots,
+                                    int ii, int jj, int kk,
+                                    TMRPoint *p ){
+  const int32_t hmax = 1 << TMR_MAX_LEVEL;
+  const double h = 1 << (TMR_MAX_LEVEL - oct->level);
+  p->x = (oct->x + 0.5*h*(1.0 + knots[ii]))/hmax;
+  p->y = (oct->y + 0.5*h*(1.0 + knots[jj]))/hmax;
+  p->z = (oct->z + 0.5*h*(1.0 + knots[kk]))/hmax;
+}
+
+static inline void get_param_point( const TMRQuadrant *quad,
+                                    const double *knots,
+                                    int ii, int jj, int kk,
+                                    TMRPoint *p ){
+  const int32_t hmax = 1 << TMR_MAX_LEVEL;
+  const double h = 1 << (TMR_MAX_LEVEL - quad->level);
+  p->x = (quad->x + 0.5*h*(1.0 + knots[ii]))/hmax;
+  p->y = (quad->y + 0.5*h*(1.0 + knots[jj]))/hmax;
+  p->z = 0.0;
+}
+
+/*
+  Write the element mesh of the forest to the VTU file for this
+  processor and write the PVTU index on the root processor.
+
+  The dimension of the forest is given by the template parameter dim.
+*/
+template <int dim, class ForestType, class ElemType>
+static int write_vtu( const char *filename, ForestType *forest,
+                      int num_elem, const char **elem_names,
+                      const double *elem_data,
+                      int num_node, const char **node_names,
+                      const double *node_data,
+                      int compress ){
+  MPI_Comm comm = forest->getMPIComm();
+  int mpi_rank, mpi_size;
+  MPI_Comm_rank(comm, &mpi_rank);
+  MPI_Comm_size(comm, &mpi_size);
+
+  // Get the element to node connectivity
+  const int *conn;
+  forest->getNodeConn(&conn);
+  if (!conn){
+    fprintf(stderr, "[%d] TMR_WriteVTU: Nodes must be created before "
+            "writing %s\n", mpi_rank, filename);
+    return 1;
+  }
+
+#ifndef TMR_USE_ZLIB
+  if (compress && mpi_rank == 0){
+    fprintf(stderr, "[%d] TMR_WriteVTU: TMR was compiled without zlib, "
+            "writing %s uncompressed\n", mpi_rank, filename);
+  }
+  compress = 0;
+#endif // TMR_USE_ZLIB
+  if (!elem_data){ num_elem = 0; }
+  if (!node_data){ num_node = 0; }
+
+  // Set the base name by removing the .pvtu extension
+  size_t len = strlen(filename);
+  char *base = new char[ len+1 ];
+  strcpy(base, filename);
+  if (len > 5 && strcmp(&base[len-5], ".pvtu") == 0){
+    base[len-5] = '\0';
+  }
+
+  // Get the elements and the nodes
+  ElemType *array;
+  int size = get_elements(forest, &array);
+  const int mesh_order = forest->getMeshOrder();
+  const double *knots;
+  forest->getInterpKnots(&knots);
+  const int *node_numbers;
+  int num_local_nodes = forest->getNodeNumbers(&node_numbers);
+  TMRPoint *X;
+  forest->getPoints(&X);
+
+  // Compute the local node numbers for each element
+  const int nodes_per_elem =
+    (dim == 3 ? mesh_order*mesh_order*mesh_order : mesh_order*mesh_order);
+  int *local_conn = new int[ nodes_per_elem*size ];
+  for ( int i = 0; i < nodes_per_elem*size; i++ ){
+    local_conn[i] = forest->getLocalNodeNumber(conn[i]);
+  }
+
+  // Set the node locations. Use the parametric locations if the
+  // physical locations are not defined by a topology.
+  double *pts = new double[ 3*num_local_nodes ];
+  if (X && forest->getTopology()){
+    for ( int i = 0; i < num_local_nodes; i++ ){
+      pts[3*i] = X[i].x;
+      pts[3*i+1] = X[i].y;
+      pts[3*i+2] = X[i].z;
+    }
+  }
+  else {
+    const int nk = (dim == 3 ? mesh_order : 1);
+    for ( int i = 0; i < size; i++ ){
+      const int *c = &local_conn[nodes_per_elem*i];
+      for ( int kk = 0; kk < nk; kk++ ){
+        for ( int jj = 0; jj < mesh_order; jj++ ){
+          for ( int ii = 0; ii < mesh_order; ii++, c++ ){
+            TMRPoint p;
+            get_param_point(&array[i], knots, ii, jj, kk, &p);
+            pts[3*c[0]] = p.x;
+            pts[3*c[0]+1] = p.y;
+            pts[3*c[0]+2] = p.z;
+          }
+        }
+      }
+    }
+  }
+
+  // Split each element into linear cells
+  const int nc = mesh_order-1;
+  const int cells_per_elem = (dim == 3 ? nc*nc*nc : nc*nc);
+  const int nodes_per_cell = (dim == 3 ? 8 : 4);
+  const int num_cells = cells_per_elem*size;
+  int32_t *cell_conn = new int32_t[ nodes_per_cell*num_cells ];
+  int32_t *cell_offsets = new int32_t[ num_cells ];
+  uint8_t *cell_types = new uint8_t[ num_cells ];
+  int32_t *cell_level = new int32_t[ num_cells ];
+  int32_t *cell_owner = new int32_t[ num_cells ];
+  int32_t *cell_rank = new int32_t[ num_cells ];
+  double *cell_data = new double[ num_cells ];
+
+  int32_t *cc = cell_conn;
+  for ( int i = 0, n = 0; i < size; i++ ){
+    const int *c = &local_conn[nodes_per_elem*i];
+    const int nk = (dim == 3 ? nc : 1);
+    for ( int kk = 0; kk < nk; kk++ ){
+      for ( int jj = 0; jj < nc; jj++ ){
+        for ( int ii = 0; ii < nc; ii++, n++ ){
+          const int offset = ii + jj*mesh_order +
+            kk*mesh_order*mesh_order;
+          cc[0] = c[offset];
+          cc[1] = c[offset+1];
+          cc[2] = c[offset+mesh_order+1];
+          cc[3] = c[offset+mesh_order];
+          if (dim == 3){
+            const int off = offset + mesh_order*mesh_order;
+            cc[4] = c[off];
+            cc[5] = c[off+1];
+            cc[6] = c[off+mesh_order+1];
+            cc[7] = c[off+mesh_order];
+          }
+          cc += nodes_per_cell;
+
+          cell_offsets[n] = nodes_per_cell*(n+1);
+          cell_types[n] = (dim == 3 ? 12 : 9);
+          cell_level[n] = array[i].level;
+          cell_owner[n] = get_owner(&array[i]);
+          cell_rank[n] = mpi_rank;
+        }
+      }
+    }
+  }
+  delete [] local_conn;
+
+  // Encode all of the data arrays
+  const int num_arrays = 7 + num_elem + num_node;
+  TMRVTUArray *arrays = new TMRVTUArray[ num_arrays ];
+  TMRVTUArray *point_arrays = &arrays[0];
+  TMRVTUArray *cell_arrays = &arrays[num_node];
+  TMRVTUArray *points = &arrays[num_node + 3 + num_elem];
+  TMRVTUArray *cells = &arrays[num_node + 4 + num_elem];
+
+  double *values = new double[ num_local_nodes ];
+  for ( int k = 0; k < num_node; k++ ){
+    for ( int i = 0; i < num_local_nodes; i++ ){
+      values[i] = node_data[num_node*i + k];
+    }
+    point_arrays[k].encode("Float64", node_names[k], 1, values,
+                           num_local_nodes*sizeof(double), compress);
+  }
+  delete [] values;
+
+  cell_arrays[0].encode("Int32", "level", 1, cell_level,
+                        num_cells*sizeof(int32_t), compress);
+  cell_arrays[1].encode("Int32", (dim == 3 ? "block" : "face"), 1,
+                        cell_owner, num_cells*sizeof(int32_t), compress);
+  cell_arrays[2].encode("Int32", "rank", 1, cell_rank,
+                        num_cells*sizeof(int32_t), compress);
+  for ( int k = 0; k < num_elem; k++ ){
+    for ( int i = 0; i < num_cells; i++ ){
+      cell_data[i] = elem_data[num_elem*(i/cells_per_elem) + k];
+    }
+    cell_arrays[3+k].encode("Float64", elem_names[k], 1, cell_data,
+                            num_cells*sizeof(double), compress);
+  }
+
+  points->encode("Float64", NULL, 3, pts,
+                 3*num_local_nodes*sizeof(double), compress);
+  cells[0].encode("Int32", "connectivity", 1, cell_conn,
+                  nodes_per_cell*num_cells*sizeof(int32_t), compress);
+  cells[1].encode("Int32", "offsets", 1, cell_offsets,
+                  num_cells*sizeof(int32_t), compress);
+  cells[2].encode("UInt8", "types", 1, cell_types,
+                  num_cells*sizeof(uint8_t), compress);
+
+  delete [] pts;
+  delete [] cell_conn;
+  delete [] cell_offsets;
+  delete [] cell_types;
+  delete [] cell_level;
+  delete [] cell_owner;
+  delete [] cell_rank;
+  delete [] cell_data;
+
+  // Write out the piece for this processor
+  int fail = 0;
+  char *piece = new char[ len+32 ];
+  sprintf(piece, "%s_%d.vtu", base, mpi_rank);
+  FILE *fp = fopen(piece, "wb");
+  if (fp){
+    const char *byte_order = get_byte_order();
+    fprintf(fp, "<?xml version=\"1.0\"?>\n");
+    fprintf(fp, "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" "
+            "byte_order=\"%s\" header_type=\"UInt64\"", byte_order);
+    if (compress){
+      fprintf(fp, " compressor=\"vtkZLibDataCompressor\"");
+    }
+    fprintf(fp, ">\n<UnstructuredGrid>\n");
+    fprintf(fp, "<Piece NumberOfPoints=\"%d\" NumberOfCells=\"%d\">\n",
+            num_local_nodes, num_cells);
+
+    // Write the array headers in the order of the appended data
+    uint64_t offset = 0;
+    fprintf(fp, "<PointData>\n");
+    for ( int k = 0; k < num_node; k++ ){
+      point_arrays[k].writeHeader(fp, offset);
+      offset += point_arrays[k].size;
+    }
+    fprintf(fp, "</PointData>\n<CellData>\n");
+    for ( int k = 0; k < 3 + num_elem; k++ ){
+      cell_arrays[k].writeHeader(fp, offset);
+      offset += cell_arrays[k].size;
+    }
+    fprintf(fp, "</CellData>\n<Points>\n");
+    points->writeHeader(fp, offset);
+    offset += points->size;
+    fprintf(fp, "</Points>\n<Cells>\n");
+    for ( int k = 0; k < 3; k++ ){
+      cells[k].writeHeader(fp, offset);
+      offset += cells[k].size;
+    }
+    fprintf(fp, "</Cells>\n</Piece>\n</UnstructuredGrid>\n");
+
+    // Write the appended data
+    fprintf(fp, "<AppendedData encoding=\"raw\">\n_");
+    for ( int k = 0; k < num_arrays; k++ ){
+      if (fwrite(arrays[k].data, 1, arrays[k].size, fp) != arrays[k].size){
+        fail = 1;
+      }
+    }
+    fprintf(fp, "\n</AppendedData>\n</VTKFile>\n");
+    fclose(fp);
+  }
+  else {
+    fail = 1;
+  }
+  if (fail){
+    fprintf(stderr, "[%d] TMR_WriteVTU: Could not write file %s\n",
+            mpi_rank, piece);
+  }
+
+  // Write the index file on the root processor
+  if (mpi_rank == 0){
+    sprintf(piece, "%s.pvtu", base);
+    fp = fopen(piece, "w");
+    if (fp){
+      // The pieces are referenced relative to the index file
+      const char *name = strrchr(base, '/');
+      name = (name ? &name[1] : base);
+
+      fprintf(fp, "<?xml version=\"1.0\"?>\n");
+      fprintf(fp, "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\" "
+              "byte_order=\"%s\" header_type=\"UInt64\">\n",
+              get_byte_order());
+      fprintf(fp, "<PUnstructuredGrid GhostLevel=\"0\">\n");
+      fprintf(fp, "<PPointData>\n");
+      for ( int k = 0; k < num_node; k++ ){
+        point_arrays[k].writePHeader(fp);
+      }
+      fprintf(fp, "</PPointData>\n<PCellData>\n");
+      for ( int k = 0; k < 3 + num_elem; k++ ){
+        cell_arrays[k].writePHeader(fp);
+      }
+      fprintf(fp, "</PCellData>\n<PPoints>\n");
+      points->writePHeader(fp);
+      fprintf(fp, "</PPoints>\n");
+      for ( int k = 0; k < mpi_size; k++ ){
+        fprintf(fp, "<Piece Source=\"%s_%d.vtu\"/>\n", name, k);
+      }
+      fprintf(fp, "</PUnstructuredGrid>\n</VTKFile>\n");
+      fclose(fp);
+    }
+    else {
+      fprintf(stderr, "[%d] TMR_WriteVTU: Could not write file %s\n",
+              mpi_rank, piece);
+      fail = 1;
+    }
+  }
+
+  delete [] piece;
+  delete [] base;
+  delete [] arrays;
+
+  int any_fail = 0;
+  MPI_Allreduce(&fail, &any_fail, 1, MPI_INT, MPI_MAX, comm);
+  return any_fail;
+}
+
+/*
+  Write the forest of octrees to a set of VTU files
+*/
+int TMR_WriteVTU( const char *filename, TMROctForest *forest,
+                  int num_elem, const char **elem_names,
+                  const double *elem_data,
+                  int num_node, const char **node_names,
+                  const double *node_data, int compress ){
+  return write_vtu<3, TMROctForest, TMROctant>(filename, forest,
+                                               num_elem, elem_names,
+                                               elem_data, num_node,
+                                               node_names, node_data,
+                                               compress);
+}
+
+/*
+  Write the forest of quadtrees to a set of VTU files
+*/
+int TMR_WriteVTU( const char *filename, TMRQuadForest *forest,
+                  int num_elem, const char **elem_names,
+                  const double *elem_data,
+                  int num_node, const char **node_names,
+                  const double *node_data, int compress ){
+  return write_vtu<2, TMRQuadForest, TMRQuadrant>(filename, forest,
+                                                  num_elem, elem_names,
+                                                  elem_data, num_node,
+                                                  node_names, node_data,
+                                                  compress);
+}
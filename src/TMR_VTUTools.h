@@ -0,0 +1,77 @@
+/*
+  This file is part of the package TMR for adaptive mesh refinement.
+
+  Copyright (C) 2015 Georgia Tech Research Corporation.
+  Additional copyright (C) 2015 Graeme Kennedy.
+  All rights reserved.
+
+  TMR is licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this software except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef TMR_VTU_TOOLS_H
+#define TMR_VTU_TOOLS_H
+
+#include "TMROctForest.h"
+#include "TMRQuadForest.h"
+
+/*
+  The following functions write the element mesh of a forest to the
+  binary VTK XML unstructured grid format for visualization.
+
+  Each processor writes its own piece to the file base_<rank>.vtu,
+  where base is the filename with the .pvtu extension removed, and
+  the root processor writes the index file base.pvtu that references
+  all the pieces. The data arrays are stored in the raw appended
+  binary format. When TMR is compiled with TMR_USE_ZLIB, the arrays
+  can also be compressed with zlib.
+
+  Each element of order p is written as (p-1)^d linear cells that
+  reference the local nodes of the forest, so the nodes must be
+  created before calling these functions. The nodal locations are
+  used when the forest has a topology, otherwise the parametric
+  locations of the nodes within their owner are written.
+
+  The refinement level, the owner (block or face) index and the
+  processor rank are always written as cell data.
+
+  input:
+  filename:     the name of the .pvtu file (same on all processors)
+  forest:       the forest
+  num_elem:     the number of element fields
+  elem_names:   the names of the element fields
+  elem_data:    the element values (num_elem values per local element)
+  num_node:     the number of node fields
+  node_names:   the names of the node fields
+  node_data:    the node values (num_node values per local node in the
+                order returned by getNodeNumbers())
+  compress:     flag to indicate whether to use zlib compression
+
+  returns:      non-zero on failure on any processor
+*/
+extern int TMR_WriteVTU( const char *filename,
+                         TMROctForest *forest,
+                         int num_elem=0, const char **elem_names=NULL,
+                         const double *elem_data=NULL,
+                         int num_node=0, const char **node_names=NULL,
+                         const double *node_data=NULL,
+                         int compress=0 );
+
+extern int TMR_WriteVTU( const char *filename,
+                         TMRQuadForest *forest,
+                         int num_elem=0, const char **elem_names=NULL,
+                         const double *elem_data=NULL,
+                         int num_node=0, const char **node_names=NULL,
+                         const double *node_data=NULL,
+                         int compress=0 );
+
+#endif // TMR_VTU_TOOLS_H
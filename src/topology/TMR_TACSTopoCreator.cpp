@@ -19,6 +19,7 @@
 */
 
 #include "TMR_TACSTopoCreator.h"
+#include "TMRInterpolation.h"
 #include "TMROctStiffness.h"
 #include "TMRQuadStiffness.h"
 #include "FElibrary.h"
@@ -32,6 +33,52 @@ static int compare_integers( const void *a, const void *b ){
   return (*(int*)a - *(int*)b);
 }
 
+/*
+  Compute the 1D filter shape functions at the i-th knot of an
+  element with edge length h that lies within a filter element with
+  edge length hfilter.
+
+  When the element and filter element are the same size or the
+  element is a child of the filter element, the shape functions are
+  copied from the cached table. Otherwise they are computed directly.
+
+  input:
+  order:         the order of the filter
+  filter_knots:  the knots of the filter
+  Ntable:        the filter table at the lagrange_child_knots() points
+  mesh_order:    the number of knots in the element
+  knots:         the element knots
+  i:             the knot index
+  h:             the edge length of the element
+  hfilter:       the edge length of the filter element
+  offset:        the offset of the element within the filter element
+
+  output:
+  N:             the shape functions
+*/
+static void computeFilterShapeFuncs( const int order,
+                                     const double *filter_knots,
+                                     const double *Ntable,
+                                     const int mesh_order,
+                                     const double *knots,
+                                     const int i,
+                                     const int32_t h,
+                                     const int32_t hfilter,
+                                     const int32_t offset,
+                                     double *N ){
+  if (hfilter == h || hfilter == 2*h){
+    int row = i;
+    if (hfilter == 2*h){
+      row += mesh_order*(1 + offset/h);
+    }
+    memcpy(N, &Ntable[order*row], order*sizeof(double));
+  }
+  else {
+    double u = -1.0 + 2.0*(offset + 0.5*h*(1.0 + knots[i]))/hfilter;
+    lagrange_shape_functions(order, u, filter_knots, N);
+  }
+}
+
 /*
   Set up a creator class for the given filter problem
 */
@@ -86,6 +133,7 @@ void TMROctTACSTopoCreator::getIndices( TACSBVecIndices **_indices ){
 
 void TMROctTACSTopoCreator::computeWeights( const int mesh_order,
                                             const double *knots,
+                                            const double *Ntable,
                                             TMROctant *node,
                                             TMROctant *oct,
                                             TMRIndexWeight *weights,
@@ -100,23 +148,25 @@ void TMROctTACSTopoCreator::computeWeights( const int mesh_order,
   const int j = (node->info % (mesh_order*mesh_order))/mesh_order;
   const int k = node->info/(mesh_order*mesh_order);
 
-  // Get the u/v/w values within the filter octant
-  double pt[3];
-  pt[0] = -1.0 + 2.0*((node->x % hoct) + 0.5*h*(1.0 + knots[i]))/hoct;
-  pt[1] = -1.0 + 2.0*((node->y % hoct) + 0.5*h*(1.0 + knots[j]))/hoct;
-  pt[2] = -1.0 + 2.0*((node->z % hoct) + 0.5*h*(1.0 + knots[k]))/hoct;
-
-  // Get the Lagrange shape functions
-  double *N = tmp;
-  filter->evalInterp(pt, N);
+  // Get the filter knots
+  const double *filter_knots;
+  const int order = filter->getInterpKnots(&filter_knots);
+
+  // Get the Lagrange shape functions in each direction
+  double *Nu = &tmp[0];
+  double *Nv = &tmp[order];
+  double *Nw = &tmp[2*order];
+  computeFilterShapeFuncs(order, filter_knots, Ntable, mesh_order, knots,
+                          i, h, hoct, node->x % hoct, Nu);
+  computeFilterShapeFuncs(order, filter_knots, Ntable, mesh_order, knots,
+                          j, h, hoct, node->y % hoct, Nv);
+  computeFilterShapeFuncs(order, filter_knots, Ntable, mesh_order, knots,
+                          k, h, hoct, node->z % hoct, Nw);
     
   // Get the dependent node information for this mesh
   const int *dep_ptr, *dep_conn;
   const double *dep_weights;
   filter->getDepNodeConn(&dep_ptr, &dep_conn, &dep_weights);
-
-  // Get the mesh order
-  const int order = filter->getMeshOrder();
   
   // Get the connectivity
   const int *conn;
@@ -130,7 +180,7 @@ void TMROctTACSTopoCreator::computeWeights( const int mesh_order,
       for ( int ii = 0; ii < order; ii++ ){
         // Set the weights
         int offset = ii + jj*order + kk*order*order;
-        double weight = N[offset];
+        double weight = Nu[ii]*Nv[jj]*Nw[kk];
 
         // Get the tag number
         if (c[offset] >= 0){
@@ -196,31 +246,47 @@ void TMROctTACSTopoCreator::createElements( int order,
   const int node_info = 13;
   const double node_knots[] = {-1.0, 0.0, 1.0};
   const int node_order = 3;
-    
+
+  // Look up the filter shape functions at the child knots of the
+  // nodes once for all of the elements
+  const double *Ntable;
+  double pts[3*TMROctForest::MAX_ORDER];
+  lagrange_child_knots(node_order, node_knots, pts);
+  filter->getInterpTable(3*node_order, pts, &Ntable);
+
+  // Set the central nodes of the original octants from the forest
+  TMROctant *centers = new TMROctant[ num_octs ];
   for ( int i = 0; i < num_octs; i++ ){
-    // Get the original octant from the forest
-    TMROctant node = octs[i];
-    node.info = node_info;
-    
-    // Find the enclosing central node
-    int mpi_owner = 0;
-    TMROctant *oct = filter->findEnclosing(node_order, node_knots,
-                                           &node, &mpi_owner);
+    centers[i] = octs[i];
+    centers[i].info = node_info;
+  }
 
+  // Find all the enclosing central nodes in a single pass
+  TMROctant **enclosing = new TMROctant*[ num_octs ];
+  int *mpi_owners = new int[ num_octs ];
+  filter->findEnclosing(node_order, node_knots, num_octs, centers,
+                        enclosing, mpi_owners);
+    
+  for ( int i = 0; i < num_octs; i++ ){
+    TMROctant *oct = enclosing[i];
     if (!oct){
       // Push the octant to the external queue. We will handle these
       // cases seperately after a collective communication.
-      node.tag = mpi_owner;
-      queue->push(&node);
+      centers[i].tag = mpi_owners[i];
+      queue->push(&centers[i]);
       weights[nweights*i].index = -1;
     }
     else {
-      computeWeights(node_order, node_knots, &node,
+      computeWeights(node_order, node_knots, Ntable, &centers[i],
                      oct, wtmp, tmp);
       memcpy(&weights[nweights*i], wtmp, nweights*sizeof(TMRIndexWeight));
     }
   }
 
+  delete [] centers;
+  delete [] enclosing;
+  delete [] mpi_owners;
+
   // Create a list of octants that are external
   TMROctantArray *nodes = queue->toArray();
   delete queue;
@@ -240,11 +306,13 @@ void TMROctTACSTopoCreator::createElements( int order,
 
   // Create the distributed weights
   TMRIndexWeight *dist_weights = new TMRIndexWeight[ nweights*dist_size ];
+  enclosing = new TMROctant*[ dist_size ];
+  filter->findEnclosing(node_order, node_knots, dist_size, dist_array,
+                        enclosing);
   for ( int i = 0; i < dist_size; i++ ){
-    TMROctant *oct = filter->findEnclosing(node_order, node_knots,
-                                           &dist_array[i]);
+    TMROctant *oct = enclosing[i];
     if (oct){
-      computeWeights(node_order, node_knots, &dist_array[i],
+      computeWeights(node_order, node_knots, Ntable, &dist_array[i],
                      oct, wtmp, tmp);
       memcpy(&dist_weights[nweights*i], wtmp, nweights*sizeof(TMRIndexWeight));
     }
@@ -252,6 +320,7 @@ void TMROctTACSTopoCreator::createElements( int order,
       fprintf(stderr, "[%d] TMROctTACSTopoCreator: Node not found\n", mpi_rank);
     }
   }
+  delete [] enclosing;
 
   // Free the temporary space
   delete [] wtmp;
@@ -471,6 +540,7 @@ void TMRQuadTACSTopoCreator::getIndices( TACSBVecIndices **_indices ){
 */
 void TMRQuadTACSTopoCreator::computeWeights( const int mesh_order,
                                              const double *knots,
+                                             const double *Ntable,
                                              TMRQuadrant *node,
                                              TMRQuadrant *quad,
                                              TMRIndexWeight *weights,
@@ -484,22 +554,22 @@ void TMRQuadTACSTopoCreator::computeWeights( const int mesh_order,
   const int i = node->info % mesh_order;
   const int j = node->info/mesh_order;
   
-  // Get the u/v values within the filter octant
-  double pt[3];
-  pt[0] = -1.0 + 2.0*((node->x % hquad) + 0.5*h*(1.0 + knots[i]))/hquad;
-  pt[1] = -1.0 + 2.0*((node->y % hquad) + 0.5*h*(1.0 + knots[j]))/hquad;
-
-  // Get the Lagrange shape functions
-  double *N = tmp;
-  filter->evalInterp(pt, N);
+  // Get the filter knots
+  const double *filter_knots;
+  const int order = filter->getInterpKnots(&filter_knots);
+
+  // Get the Lagrange shape functions in each direction
+  double *Nu = &tmp[0];
+  double *Nv = &tmp[order];
+  computeFilterShapeFuncs(order, filter_knots, Ntable, mesh_order, knots,
+                          i, h, hquad, node->x % hquad, Nu);
+  computeFilterShapeFuncs(order, filter_knots, Ntable, mesh_order, knots,
+                          j, h, hquad, node->y % hquad, Nv);
     
   // Get the dependent node information for this mesh
   const int *dep_ptr, *dep_conn;
   const double *dep_weights;
   filter->getDepNodeConn(&dep_ptr, &dep_conn, &dep_weights);
-
-  // Get the mesh order
-  const int order = filter->getMeshOrder();
   
   // Get the connectivity
   const int *conn;
@@ -512,7 +582,7 @@ void TMRQuadTACSTopoCreator::computeWeights( const int mesh_order,
     for ( int ii = 0; ii < order; ii++ ){
       // Set the weights
       int offset = ii + jj*order;
-      double weight = N[offset];
+      double weight = Nu[ii]*Nv[jj];
 
       // Get the tag number
       if (c[offset] >= 0){
@@ -578,30 +648,46 @@ void TMRQuadTACSTopoCreator::createElements( int order,
   const double node_knots[] = {-1.0, 0.0, 1.0};
   const int node_order = 3;
 
+  // Look up the filter shape functions at the child knots of the
+  // nodes once for all of the elements
+  const double *Ntable;
+  double pts[3*TMRQuadForest::MAX_ORDER];
+  lagrange_child_knots(node_order, node_knots, pts);
+  filter->getInterpTable(3*node_order, pts, &Ntable);
+
+  // Set the central nodes of the original quadrants from the forest
+  TMRQuadrant *centers = new TMRQuadrant[ num_quads ];
   for ( int i = 0; i < num_quads; i++ ){
-    // Get the original quadrant from the forest    
-    TMRQuadrant node = quads[i];
-    node.info = node_info;
-    
-    // Find the central node
-    int mpi_owner = 0;
-    TMRQuadrant *quad = filter->findEnclosing(node_order, node_knots,
-                                              &node, &mpi_owner);
+    centers[i] = quads[i];
+    centers[i].info = node_info;
+  }
 
+  // Find all the enclosing central nodes in a single pass
+  TMRQuadrant **enclosing = new TMRQuadrant*[ num_quads ];
+  int *mpi_owners = new int[ num_quads ];
+  filter->findEnclosing(node_order, node_knots, num_quads, centers,
+                        enclosing, mpi_owners);
+
+  for ( int i = 0; i < num_quads; i++ ){
+    TMRQuadrant *quad = enclosing[i];
     if (!quad){
       // Push the quadrant to the external queue. We will handle these
       // cases seperately after a collective communication.
-      node.tag = mpi_owner;
-      queue->push(&node);
+      centers[i].tag = mpi_owners[i];
+      queue->push(&centers[i]);
       weights[nweights*i].index = -1;
     }
     else {
-      computeWeights(node_order, node_knots, &node,
+      computeWeights(node_order, node_knots, Ntable, &centers[i],
                      quad, wtmp, tmp);
       memcpy(&weights[nweights*i], wtmp, nweights*sizeof(TMRIndexWeight));
     }
   }
 
+  delete [] centers;
+  delete [] enclosing;
+  delete [] mpi_owners;
+
   // Create a list of quadrants that are external
   TMRQuadrantArray *nodes = queue->toArray();
   delete queue;
@@ -621,15 +707,18 @@ void TMRQuadTACSTopoCreator::createElements( int order,
 
   // Create the distributed weights
   TMRIndexWeight *dist_weights = new TMRIndexWeight[ nweights*dist_size ];
+  enclosing = new TMRQuadrant*[ dist_size ];
+  filter->findEnclosing(node_order, node_knots, dist_size, dist_array,
+                        enclosing);
   for ( int i = 0; i < dist_size; i++ ){
-    TMRQuadrant *quad = filter->findEnclosing(node_order, node_knots,
-                                              &dist_array[i]);
+    TMRQuadrant *quad = enclosing[i];
     if (quad){
-      computeWeights(node_order, node_knots, &dist_array[i],
+      computeWeights(node_order, node_knots, Ntable, &dist_array[i],
                      quad, wtmp, tmp);
       memcpy(&dist_weights[nweights*i], wtmp, nweights*sizeof(TMRIndexWeight));
     }
   }
+  delete [] enclosing;
 
   // Free the tmporary space
   delete [] wtmp;
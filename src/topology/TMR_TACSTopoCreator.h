@@ -57,6 +57,7 @@ class TMROctTACSTopoCreator : public TMROctTACSCreator {
  private:
   // Compute the weights for a given point
   void computeWeights( const int mesh_order, const double *knots,
+                       const double *Ntable,
                        TMROctant *node, TMROctant *oct,
                        TMRIndexWeight *weights, double *tmp );
 
@@ -103,6 +104,7 @@ class TMRQuadTACSTopoCreator : public TMRQuadTACSCreator {
  private:
   // Compute the weights for a given point
   void computeWeights( const int mesh_order, const double *knots,
+                       const double *Ntable,
                        TMRQuadrant *node, TMRQuadrant *quad,
                        TMRIndexWeight *weights, double *tmp );
 
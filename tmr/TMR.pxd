@@ -59,14 +59,23 @@ cdef extern from "TMRBase.h":
 
     void TMRInitialize()
     void TMRFinalize()
+    void TMRSetPerfTimers(int)
+    void TMRResetPerfTimers()
+    int TMRWritePerfReport(MPI_Comm, const char*)
 
     enum TMRInterpolationType:
         TMR_UNIFORM_POINTS
         TMR_GAUSS_LOBATTO_POINTS
 
 cdef extern from "TMRTopology.h":
+    enum TMRReorderType:
+        TMR_REORDER_DEFAULT
+        TMR_REORDER_RCM
+        TMR_REORDER_METIS
+        TMR_REORDER_SFC
+
     cdef cppclass TMRTopology(TMREntity):
-        TMRTopology(MPI_Comm, TMRModel*)
+        TMRTopology(MPI_Comm, TMRModel*, TMRReorderType, const int*)
         void getVolume(int, TMRVolume**)
         void getFace(int, TMRFace**)
         void getEdge(int, TMREdge**)
@@ -223,6 +232,8 @@ cdef extern from "TMRMesh.h":
         TMRMesh(MPI_Comm, TMRModel*)
         void mesh(TMRMeshOptions, double)
         void mesh(TMRMeshOptions, TMRElementFeatureSize*)
+        void remesh(TMRMeshOptions, TMRElementFeatureSize*)
+        void setCacheDirectory(const char*)
         int getMeshPoints(TMRPoint**)
         int getQuadConnectivity(int*, const int**)
         int getTriConnectivity(int*, const int**)
@@ -247,6 +258,7 @@ cdef extern from "TMRMesh.h":
         int triangularize_print_level
         int triangularize_print_iter
         int write_mesh_quality_histogram
+        int write_mesh_cache_statistics
         int num_smoothing_steps
         double frontal_quality_factor
         int write_init_domain_triangle
@@ -257,6 +269,7 @@ cdef extern from "TMRMesh.h":
         int write_pre_smooth_quad
         int write_post_smooth_quad
         int write_quad_dual
+        int num_threads
 
 cdef extern from "TMRQuadrant.h":
     cdef cppclass TMRQuadrant:
@@ -290,13 +303,17 @@ cdef extern from "TMRQuadForest.h":
         void repartition()
         void createTrees(int)
         void createRandomTrees(int, int, int)
+        void createRefinedTrees(TMRElementFeatureSize*, int, int, int)
         void refine(int*, int, int)
         TMRQuadForest *duplicate()
+        TMRQuadForest *duplicate(int, TMRInterpolationType)
         TMRQuadForest *coarsen()
         void balance(int)
         void createNodes()
         int getMeshOrder()
+        TMRInterpolationType getInterpType()
         void setMeshOrder(int, TMRInterpolationType)
+        void setNumThreads(int)
         void getNodeConn(const int**, int*)
         int getDepNodeConn(const int**, const int**, const double**)
         TMRQuadrantArray* getQuadsWithAttribute(const char*)
@@ -307,6 +324,8 @@ cdef extern from "TMRQuadForest.h":
         int getPoints(TMRPoint**)
         void writeToVTK(const char*)
         void writeForestToVTK(const char*)
+        int writeToFile(const char*, int, const double*, int, const double*)
+        int readFromFile(const char*, int*, double**, int*, double**)
 
 cdef extern from "TMROctant.h":
     cdef cppclass TMROctant:
@@ -342,13 +361,17 @@ cdef extern from "TMROctForest.h":
         void repartition()
         void createTrees(int)
         void createRandomTrees(int, int, int)
+        void createRefinedTrees(TMRElementFeatureSize*, int, int, int)
         void refine(int*, int, int)
         TMROctForest *duplicate()
+        TMROctForest *duplicate(int, TMRInterpolationType)
         TMROctForest *coarsen()
         void balance(int)
         void createNodes()
         int getMeshOrder()
+        TMRInterpolationType getInterpType()
         void setMeshOrder(int, TMRInterpolationType)
+        void setNumThreads(int)
         void getNodeConn(const int**, int*)
         int getDepNodeConn(const int**, const int**, const double**)
         TMROctantArray* getOctsWithAttribute(const char*)
@@ -359,6 +382,8 @@ cdef extern from "TMROctForest.h":
         int getPoints(TMRPoint**)
         void writeToVTK(const char*)
         void writeForestToVTK(const char*)
+        int writeToFile(const char*, int, const double*, int, const double*)
+        int readFromFile(const char*, int*, double**, int*, double**)
 
 cdef extern from "TMR_TACSCreator.h":
     cdef cppclass TMRBoundaryConditions(TMREntity):
@@ -513,3 +538,9 @@ cdef extern from "TMRTopoProblem.h":
 cdef extern from "TMR_STLTools.h":
     int TMR_GenerateBinFile(const char*, TMROctForest*,
                             TACSBVec*, int, double)
+
+cdef extern from "TMR_VTUTools.h":
+    int TMR_WriteVTU(const char*, TMROctForest*, int, const char**,
+                     const double*, int, const char**, const double*, int)
+    int TMR_WriteVTU(const char*, TMRQuadForest*, int, const char**,
+                     const double*, int, const char**, const double*, int)
@@ -63,6 +63,12 @@ TRIANGLE = TMR_TRIANGLE
 UNIFORM_POINTS = TMR_UNIFORM_POINTS
 GAUSS_LOBATTO_POINTS = TMR_GAUSS_LOBATTO_POINTS
 
+# Set the type of reordering for the topology
+REORDER_DEFAULT = TMR_REORDER_DEFAULT
+REORDER_RCM = TMR_REORDER_RCM
+REORDER_METIS = TMR_REORDER_METIS
+REORDER_SFC = TMR_REORDER_SFC
+
 cdef class Vertex:
     cdef TMRVertex *ptr
     def __cinit__(self):
@@ -892,6 +898,12 @@ cdef class MeshOptions:
         def __set__(self, value):
             self.ptr.write_mesh_quality_histogram = value
 
+    property write_mesh_cache_statistics:
+        def __get__(self):
+            return self.ptr.write_mesh_cache_statistics
+        def __set__(self, value):
+            self.ptr.write_mesh_cache_statistics = value
+
     property write_init_domain_triangle:
         def __get__(self):
             return self.ptr.write_init_domain_triangle
@@ -940,6 +952,12 @@ cdef class MeshOptions:
         def __set__(self, value):
             self.ptr.write_quad_dual = value
 
+    property num_threads:
+        def __get__(self):
+            return self.ptr.num_threads
+        def __set__(self, int value):
+            self.ptr.num_threads = value
+
    # @property for cython 0.26 and above
    # def num_smoothing_steps(self):
    #    return self.ptr.num_smoothing_steps
@@ -1022,6 +1040,27 @@ cdef class Mesh:
             else:
                 self.ptr.mesh(opts.ptr, h)
 
+    def remesh(self, double h=1.0, MeshOptions opts=None,
+               ElementFeatureSize fs=None):
+        cdef TMRMeshOptions default
+        cdef TMRElementFeatureSize *size = NULL
+        if fs is not None:
+            size = fs.ptr
+        else:
+            size = new TMRElementFeatureSize(h)
+        size.incref()
+        if opts is None:
+            self.ptr.remesh(default, size)
+        else:
+            self.ptr.remesh(opts.ptr, size)
+        size.decref()
+
+    def setCacheDirectory(self, dirname=None):
+        cdef char *dname = NULL
+        if dirname is not None:
+            dname = tmr_convert_to_chars(dirname)
+        self.ptr.setCacheDirectory(dname)
+
     def getMeshPoints(self):
         cdef TMRPoint *X
         cdef int npts = 0
@@ -1148,14 +1187,31 @@ cdef class FaceMesh:
 
 cdef class Topology:
     cdef TMRTopology *ptr
-    def __cinit__(self, MPI.Comm comm=None, Model m=None):
+    def __cinit__(self, MPI.Comm comm=None, Model m=None,
+                  TMRReorderType reorder_type=TMR_REORDER_DEFAULT,
+                  np.ndarray[int, ndim=1, mode='c'] weights=None):
         cdef MPI_Comm c_comm = NULL
         cdef TMRModel *model = NULL
+        cdef const int *w = NULL
+        cdef int nfaces = 0
+        cdef int nvolumes = 0
+        cdef TMRFace **f = NULL
+        cdef TMRVolume **v = NULL
         self.ptr = NULL
         if comm is not None and m is not None:
             c_comm = comm.ob_mpi
             model = m.ptr
-            self.ptr = new TMRTopology(c_comm, model)
+            if weights is not None:
+                # One weight per volume, or per face without volumes
+                model.getFaces(&nfaces, &f)
+                model.getVolumes(&nvolumes, &v)
+                if nvolumes > 0:
+                    nfaces = nvolumes
+                if weights.shape[0] != nfaces:
+                    errmsg = 'Topology: weights must have length %d'%(nfaces)
+                    raise ValueError(errmsg)
+                w = <int*>weights.data
+            self.ptr = new TMRTopology(c_comm, model, reorder_type, w)
             self.ptr.incref()
 
     def __dealloc__(self):
@@ -1317,6 +1373,9 @@ cdef class QuadForest:
     def getMeshOrder(self):
         return self.ptr.getMeshOrder()
 
+    def setNumThreads(self, int num_threads):
+        self.ptr.setNumThreads(num_threads)
+
     def setTopology(self, Topology topo):
         self.ptr.setTopology(topo.ptr)
 
@@ -1329,6 +1388,10 @@ cdef class QuadForest:
     def createRandomTrees(self, int nrand=10, int min_lev=0, int max_lev=8):
         self.ptr.createRandomTrees(nrand, min_lev, max_lev)
 
+    def createRefinedTrees(self, ElementFeatureSize fs, int min_lev=0,
+                           int max_lev=MAX_LEVEL, int balance_corner=0):
+        self.ptr.createRefinedTrees(fs.ptr, min_lev, max_lev, balance_corner)
+
     def refine(self, np.ndarray[int, ndim=1, mode='c'] refine=None,
                int min_lev=0, int max_lev=MAX_LEVEL):
         if refine is not None:
@@ -1337,9 +1400,17 @@ cdef class QuadForest:
             self.ptr.refine(NULL, min_lev, max_lev)
         return
 
-    def duplicate(self):
+    def duplicate(self, int order=-1, interp=None):
         cdef TMRQuadForest *dup = NULL
-        dup = self.ptr.duplicate()
+        cdef TMRInterpolationType itype
+        if order < 0:
+            dup = self.ptr.duplicate()
+        else:
+            # Keep the interpolation type of this forest by default
+            itype = self.ptr.getInterpType()
+            if interp is not None:
+                itype = interp
+            dup = self.ptr.duplicate(order, itype)
         return _init_QuadForest(dup)
 
     def coarsen(self):
@@ -1428,6 +1499,19 @@ cdef class QuadForest:
     def writeForestToVTK(self, fname):
         cdef char *filename = tmr_convert_to_chars(fname)
         self.ptr.writeForestToVTK(filename)
+
+    def writeToVTU(self, fname, compress=False):
+        cdef char *filename = tmr_convert_to_chars(fname)
+        return TMR_WriteVTU(filename, self.ptr, 0, NULL, NULL,
+                            0, NULL, NULL, int(compress))
+
+    def writeToFile(self, fname):
+        cdef char *filename = tmr_convert_to_chars(fname)
+        return self.ptr.writeToFile(filename, 0, NULL, 0, NULL)
+
+    def readFromFile(self, fname):
+        cdef char *filename = tmr_convert_to_chars(fname)
+        return self.ptr.readFromFile(filename, NULL, NULL, NULL, NULL)
         
     def createInterpolation(self, QuadForest forest, VecInterp vec):
         self.ptr.createInterpolation(forest.ptr, vec.ptr)
@@ -1583,6 +1667,9 @@ cdef class OctForest:
     def getMeshOrder(self):
         return self.ptr.getMeshOrder()
 
+    def setNumThreads(self, int num_threads):
+        self.ptr.setNumThreads(num_threads)
+
     def setTopology(self, Topology topo):
         self.ptr.setTopology(topo.ptr)
 
@@ -1606,6 +1693,10 @@ cdef class OctForest:
     def createRandomTrees(self, int nrand=10, int min_lev=0, int max_lev=8):
         self.ptr.createRandomTrees(nrand, min_lev, max_lev)
 
+    def createRefinedTrees(self, ElementFeatureSize fs, int min_lev=0,
+                           int max_lev=MAX_LEVEL, int balance_corner=0):
+        self.ptr.createRefinedTrees(fs.ptr, min_lev, max_lev, balance_corner)
+
     def refine(self, np.ndarray[int, ndim=1, mode='c'] refine=None,
                int min_lev=0, int max_lev=MAX_LEVEL):
         if refine is not None:
@@ -1614,9 +1705,17 @@ cdef class OctForest:
             self.ptr.refine(NULL, min_lev, max_lev)
         return
 
-    def duplicate(self):
+    def duplicate(self, int order=-1, interp=None):
         cdef TMROctForest *dup = NULL
-        dup = self.ptr.duplicate()
+        cdef TMRInterpolationType itype
+        if order < 0:
+            dup = self.ptr.duplicate()
+        else:
+            # Keep the interpolation type of this forest by default
+            itype = self.ptr.getInterpType()
+            if interp is not None:
+                itype = interp
+            dup = self.ptr.duplicate(order, itype)
         return _init_OctForest(dup)
 
     def coarsen(self):
@@ -1706,6 +1805,19 @@ cdef class OctForest:
         cdef char *filename = tmr_convert_to_chars(fname)
         self.ptr.writeForestToVTK(filename)
 
+    def writeToVTU(self, fname, compress=False):
+        cdef char *filename = tmr_convert_to_chars(fname)
+        return TMR_WriteVTU(filename, self.ptr, 0, NULL, NULL,
+                            0, NULL, NULL, int(compress))
+
+    def writeToFile(self, fname):
+        cdef char *filename = tmr_convert_to_chars(fname)
+        return self.ptr.writeToFile(filename, 0, NULL, 0, NULL)
+
+    def readFromFile(self, fname):
+        cdef char *filename = tmr_convert_to_chars(fname)
+        return self.ptr.readFromFile(filename, NULL, NULL, NULL, NULL)
+
     def createInterpolation(self, OctForest forest, VecInterp vec):
         self.ptr.createInterpolation(forest.ptr, vec.ptr)
 
@@ -2204,6 +2316,20 @@ def writeSTLToBin(fname, OctForest forest,
     TMR_GenerateBinFile(filename, forest.ptr, x.ptr, offset, cutoff)
     return
 
+def setPerfTimers(int flag=1):
+    TMRSetPerfTimers(flag)
+    return
+
+def resetPerfTimers():
+    TMRResetPerfTimers()
+    return
+
+def writePerfReport(MPI.Comm comm, fname=None):
+    cdef char *filename = NULL
+    if fname is not None:
+        filename = tmr_convert_to_chars(fname)
+    return TMRWritePerfReport(comm.ob_mpi, filename)
+
 cdef class StressConstraint:
     cdef TMRStressConstraint *ptr
     def __cinit__(self, OctForest oct, Assembler assembler,